@@ -0,0 +1,26 @@
+/****************************************************************************
+Module: CollisionPredictor.h
+Description:
+	Predicts collisions with the other Karts by projecting every Kart's
+	trajectory a short horizon ahead from the DRS positions. Posts an early
+	warning with the time-to-collision so SM_Racing can slow down before
+	contact instead of recovering from a bump.
+Author: Kyle Moy, 3/4/15
+****************************************************************************/
+
+#ifndef CollisionPredictor_H
+#define CollisionPredictor_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "DRS.h"
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void UpdateCollisionPrediction(uint8_t KartNumber, Kart_t Kart);
+bool IsCollisionPredicted(void);
+uint16_t GetTimeToCollision(void);
+uint8_t GetCollisionSpeedBias(void);
+uint8_t GetCollisionThreatKart(void);
+
+#endif /* CollisionPredictor_H */
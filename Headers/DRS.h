@@ -41,6 +41,25 @@ typedef struct {
 	GamefieldPosition_t GamefieldPosition;
 } Kart_t;
 
+// DRS link quality record
+typedef struct {
+	uint32_t	GoodFrames;
+	uint32_t	InvalidFrames;		// All 0xFF, the DRS didn't answer
+	uint32_t	EchoErrors;				// Header bytes weren't the expected echo
+	uint32_t	RangeErrors;			// Position or heading off the field
+	uint32_t	StuckFrames;			// Same bytes as the last frame of another query
+	uint32_t	PoseJumps;				// Kart moved further than it could since the last frame
+	uint32_t	SendFailures;			// Transmit FIFO was busy
+	uint32_t	Timeouts;					// No EOT interrupt
+	uint32_t	Retries;
+	uint32_t	AbandonedQueries;	// Gave up after the maximum number of retries
+	uint32_t	LastLatencyUS;		// Query sent to EOT
+	uint32_t	AvgLatencyUS;
+	uint32_t	MaxLatencyUS;
+	uint32_t	PosesPublished;		// E_DRS_UPDATED posted for our Kart
+	uint32_t	PosesSuppressed;	// Our pose hadn't changed enough to post
+} DRSLinkStats_t;
+
 
 /*----------------------- Public Function Prototypes ----------------------*/
 void InitializeDRS(void);
@@ -51,5 +70,11 @@ Kart_t GetKartData(uint8_t KartNumber);
 void PrintKartData(void);
 void PrintKartDataTableFormat(void);
 Kart_t GetMyKart(void);
+uint8_t GetMyKartNumber(void);
+void RecordDRSTimeout(void);
+void RecordDRSRetry(void);
+void RecordDRSAbandoned(void);
+DRSLinkStats_t GetDRSLinkStats(void);
+void PrintDRSLinkStats(void);
 
 #endif /* DRS_H */
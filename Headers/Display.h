@@ -30,6 +30,9 @@ Author: Kyle Moy, 2/19/15
 	
 // Display what the motor is doing
 #define DisplayMotorInfo true
+
+// Display the predicted collisions with the other Karts
+#define DisplayCollisionPrediction true
 	
 	
 /*----------------------------- Module Defines ----------------------------*/
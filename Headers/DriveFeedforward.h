@@ -0,0 +1,51 @@
+/****************************************************************************
+Module: DriveFeedforward.h
+Description:
+	Measured duty to steady-state RPM map of a drive motor, looked up
+	backwards for a feedforward duty, a model of how fast the wheel gets
+	there for the PID to follow, and the sweep that measures them.
+	Hardware free, the control ISR runs one sweep per wheel.
+Author: Kyle Moy, 3/12/15
+****************************************************************************/
+
+#ifndef DriveFeedforward_H
+#define DriveFeedforward_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// The map has the RPM at every FF_DUTY_STEP of duty up to 100%, 0 duty is
+// taken as 0 RPM
+#define FF_DUTY_STEP		10
+#define FF_POINTS				(100 / FF_DUTY_STEP)
+
+// One wheel in one direction. All zeros is no map, the feedforward is 0
+typedef struct {
+	uint16_t	RPM[FF_POINTS];		// Steady-state RPM at (n + 1) * FF_DUTY_STEP duty
+	uint16_t	TimeConstantMS;		// Of the measured speed's response to a duty step
+} FeedforwardMap_t;
+
+// State of one wheel's sweep
+typedef struct {
+	bool			Running;
+	FeedforwardMap_t	*Map;		// Filled in as the sweep goes
+	uint8_t		Point;
+	uint16_t	Time;					// ms at this point's duty
+	uint32_t	SumRPM;
+	uint16_t	Samples;
+	uint32_t	SumSettleRPM;			// Over the settling time, for the time constant
+	uint32_t	SumArea;					// RPM ms
+	uint32_t	SumRise;					// RPM
+} FeedforwardSweep_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+int32_t GetFeedforwardDuty(const FeedforwardMap_t *Map, int32_t TargetRPM);
+void ResetReferenceModel(int32_t *Model, int32_t RPM);
+int32_t UpdateReferenceModel(const FeedforwardMap_t *Map, int32_t *Model, int32_t TargetRPM);
+void StartFeedforwardSweep(FeedforwardSweep_t *Sweep, FeedforwardMap_t *Map);
+uint8_t UpdateFeedforwardSweep(FeedforwardSweep_t *Sweep, int32_t RPM);
+bool IsFeedforwardSweepRunning(const FeedforwardSweep_t *Sweep);
+
+#endif /* DriveFeedforward_H */
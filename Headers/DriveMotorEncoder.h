@@ -3,14 +3,25 @@
 
 #include <stdint.h>
 
+// Uncomment to decode both channels of each encoder with the QEI modules,
+// for real direction and no capture interrupts (rewire first, the pins
+// are listed in DriveMotorsEncoder.c)
+//#define USE_QEI
+
 void InitInputCapturePeriod( void );
 void RDriveCaptureResponse( void );
 void LDriveCaptureResponse( void );
+void UpdateRPMEstimates( void );
 uint32_t GetPeriodR( void );
 uint32_t GetPeriodL( void );
 uint32_t GetRPMR(void);
 uint32_t GetRPML(void);
-void SetTargetTickCount(uint32_t NumberOfTicksL, uint32_t NumberOfTicksR);
+uint32_t GetRPMVarianceR(void);
+uint32_t GetRPMVarianceL(void);
+int32_t GetVelocityR(void);
+int32_t GetVelocityL(void);
+int32_t GetOdometerR(void);
+int32_t GetOdometerL(void);
 
 
 
@@ -7,12 +7,28 @@
 #define FORWARD 0
 #define REVERSE 1
 
+// Kinds of drive command, each has its own row of the gain schedule
+typedef enum {
+	MANEUVER_DRIVE,			// Driving at an RPM, timed or until told otherwise
+	MANEUVER_DISTANCE,	// Distance moves through the position loop
+	MANEUVER_TURN,			// Rotates and pivots
+	NUM_MANEUVERS
+} Maneuver_t;
+
 void InitPeriodicInt( void );
 void SetRPMResponse( void );
 void SetTargetRPM (float SetRPMR, float SetRPML);
+void SetManeuverRPM(Maneuver_t Maneuver, float SetRPMR, float SetRPML);
 void EnablePIDcontrol(void);
 void DisablePIDcontrol(void);
 void ClearSumError(void);
-void SetPIDgains(double p, double i, double d);
+void ScheduleGains(Maneuver_t Maneuver, int32_t RPM);
+void StartPIDAutotune(void);
+void FinishPIDAutotune(void);
+void StartFeedforwardCalibration(void);
+void FinishFeedforwardCalibration(void);
+void SetSpeedBias(uint8_t Percent);
+void GetPIDCycles(uint32_t *Last, uint32_t *Max);
+void PrintPIDCycles(void);
 
 #endif //_IntSample_H_
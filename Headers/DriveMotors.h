@@ -24,13 +24,20 @@ void InitializeDriveMotors(void);
 
 // Functions to control the motor
 // Motor parameter should be RIGHT_MOTOR or LEFT_MOTOR
+// These stage a command, the control interrupt puts both motors' duty
+// cycles and directions out together with ApplyMotorCommand
 void SetMotorPWM(uint8_t Motor, uint8_t DutyCycle);
+void SetMotorPWMs(uint8_t DutyCycleL, uint8_t DutyCycleR);
 void SetMotorDirection(uint8_t Motor, uint8_t Direction);
+void SetMotorDirections(uint8_t DirectionL, uint8_t DirectionR);
+void ApplyMotorCommand(void);
+uint8_t GetMotorDirection(uint8_t Motor);
 
 // Functions for specific robot movements
 void StopMotors(void);
 void RotateCW(uint16_t TargetRPM, uint16_t Duration);
 void RotateCCW(uint16_t TargetRPM, uint16_t Duration);
+void RotateAtRPM(int16_t TargetRPM);
 void DriveForward(uint16_t TargetRPM, uint16_t Duration);
 void DriveForwardWithBias(uint16_t TargetRPML, uint16_t TargetRPMR, uint16_t Duration);
 void DriveBackward(uint16_t TargetRPM, uint16_t Duration);
@@ -0,0 +1,33 @@
+/****************************************************************************
+Module: DriveMotorsPosition.h
+Description:
+	Outer position loop for the drive motors. Runs distance moves on the
+	encoder ticks of each wheel, feeding RPM targets to the inner PID loop,
+	and posts E_MOTOR_SETTLED when the move has come to rest.
+Author: Kyle Moy, 3/8/15
+****************************************************************************/
+
+#ifndef DriveMotorsPosition_H
+#define DriveMotorsPosition_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// EventParam of E_MOTOR_SETTLED
+#define MOVE_ARRIVED		0		// Both wheels reached their ticks
+#define MOVE_STALLED		1		// The wheels stopped turning short of the target, or past it
+// GetPositionMoveResult while the move is still on its way
+#define MOVE_IN_PROGRESS	2
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void StartPositionMove(uint32_t TicksL, uint32_t TicksR, uint16_t CruiseL, uint16_t CruiseR);
+void StartPositionStep(uint32_t TicksL, uint32_t TicksR, uint16_t CruiseL, uint16_t CruiseR);
+void StopPositionMove(void);
+bool IsPositionMoveActive(void);
+uint8_t GetPositionMoveResult(void);
+bool UpdatePositionControl(int32_t *TargetRPMR, int32_t *TargetRPML);
+void PrintPositionMove(void);
+
+#endif /* DriveMotorsPosition_H */
@@ -0,0 +1,28 @@
+/****************************************************************************
+Module: EEPROMStorage.h
+Description:
+	Versioned, CRC checked records in the TM4C's on-chip EEPROM, for
+	settings that should survive a power cycle.
+Author: Kyle Moy, 3/11/15
+****************************************************************************/
+
+#ifndef EEPROMStorage_H
+#define EEPROMStorage_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// Each slot is one 64 byte EEPROM block, a record takes 8 bytes of header
+// and as many blocks as its data needs, so leave room after the longer ones
+#define EEPROM_SLOT_PID_GAINS		0		// 6 floats, DriveMotorsPID.c
+#define EEPROM_SLOT_FEEDFORWARD		1		// 2 blocks, DriveMotorsPID.c
+#define EEPROM_SLOT_FIELD_GEOMETRY	3		// 15 uint16_ts, FieldCalibration.c
+
+/*----------------------- Public Function Prototypes ----------------------*/
+bool InitializeEEPROMStorage(void);
+bool ReadEEPROMRecord(uint8_t Slot, uint16_t Version, void *Data, uint16_t Length);
+bool WriteEEPROMRecord(uint8_t Slot, uint16_t Version, const void *Data, uint16_t Length);
+
+#endif /* EEPROMStorage_H */
@@ -293,12 +293,20 @@ typedef enum {  ES_NO_EVENT = 0,
 										
 										// Motor Events
 										E_MOTOR_TIMEOUT,
-										E_MOTOR_TICK_TIMEOUT,
+										E_MOTOR_SETTLED,
+										E_MOTION_SEQUENCE_DONE,
+										E_PID_AUTOTUNE_DONE,
+										E_FEEDFORWARD_CAL_DONE,
 										//E_MOTOR_L_TICK_TIMEOUT,
 										//E_MOTOR_R_TICK_TIMEOUT,
 										
 										// Navigation Events
 										E_DRS_UPDATED,
+										E_HEADING_REACHED,
+										
+										// Collision Prediction Events
+										E_COLLISION_WARNING,
+										E_COLLISION_CLEARED,
 										
 										// Other Events
 										E_BUMP_DETECTED
@@ -355,7 +363,7 @@ typedef enum {  ES_NO_EVENT = 0,
 #define TIMER2_RESP_FUNC PostDriveMotorsService
 #define TIMER3_RESP_FUNC TIMER_UNUSED
 #define TIMER4_RESP_FUNC TIMER_UNUSED
-#define TIMER5_RESP_FUNC TIMER_UNUSED
+#define TIMER5_RESP_FUNC PostMasterSM
 #define TIMER6_RESP_FUNC TIMER_UNUSED
 #define TIMER7_RESP_FUNC TIMER_UNUSED
 #define TIMER8_RESP_FUNC TIMER_UNUSED
@@ -379,5 +387,6 @@ typedef enum {  ES_NO_EVENT = 0,
 #define DRIVE_MOTOR_TIMER 2
 #define BALL_MOTOR_READY_TIMER 3
 #define BALL_LOADER_READY_TIMER 4
+#define HEADING_TIMER 5
 
 #endif /* CONFIGURE_H */
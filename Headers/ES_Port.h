@@ -9,6 +9,9 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 03/15/15       km      added _HW_DelayTick for fault injection
+ 03/15/15       km      host keystrokes come from _HW_PushKey
+ 03/05/15       km      added the HOST_SIM port for running on a PC
  01/18/15 13:24 jec     clean up and adapt to use TI driver lib functions
                         for implementing EnterCritical & ExitCritical
  03/13/14		joa		      Updated files to use with Cortex M4 processor core.
@@ -61,8 +64,15 @@ uint32_t CPUgetPRIMASK_cpsid(void);
 void CPUsetPRIMASK(uint32_t newPRIMASK);
 
 
+#ifdef HOST_SIM
+// On the host the simulated interrupts are called from the framework loop,
+// so they can never preempt a queue operation
+#define EnterCritical()
+#define ExitCritical()
+#else
 #define EnterCritical()	{ _PRIMASK_temp = CPUgetPRIMASK_cpsid(); }
 #define ExitCritical() { CPUsetPRIMASK(_PRIMASK_temp); }
+#endif
 
 
 /* Rate constants for programming the SysTick Period to generate tick interrupts.
@@ -90,8 +100,13 @@ typedef enum {	ES_Timer_RATE_OFF  	=   (0),
 // map the generic functions for testing the serial port to actual functions 
 // for this platform. If the C compiler does not provide functions to test
 // and retrieve serial characters, you should write them in ES_Port.c
+#ifdef HOST_SIM
+#define IsNewKeyReady()  _HW_IsNewKeyReady()
+#define GetNewKey()      _HW_GetNewKey()
+#else
 #define IsNewKeyReady()  ( kbhit() != 0 )
 #define GetNewKey()      getchar()
+#endif
 
 // prototypes for the hardware specific routines
 void _HW_Timer_Init(TimerRate_t Rate);
@@ -99,4 +114,20 @@ bool _HW_Process_Pending_Ints( void );
 uint16_t _HW_GetTickCount(void);
 void ConsoleInit(void);
 
+#ifdef HOST_SIM
+// The host port runs on a virtual clock that advances on every pass of the
+// framework loop. The step hook is called on each advance so the simulators
+// can raise their interrupts.
+typedef void (*HostStepHook_t)(uint32_t NowUS);
+uint32_t _HW_GetMicros(void);
+void _HW_SetStepHook(HostStepHook_t Hook);
+// Holds the next tick off, as masked interrupts would. A tick held past
+// the one after it is lost, SysTick only keeps one pending.
+void _HW_DelayTick(uint32_t DelayUS);
+// The keyboard, one keystroke waiting at most, a replay pushes them in
+void _HW_PushKey(char Key);
+bool _HW_IsNewKeyReady(void);
+char _HW_GetNewKey(void);
+#endif
+
 #endif
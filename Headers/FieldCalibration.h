@@ -0,0 +1,42 @@
+/****************************************************************************
+Module: FieldCalibration.h
+Description:
+	Measures the gamefield's geometry on race day. The Kart is walked to
+	a few reference points while the DRS tracks it, the bounding lines
+	and triggers (GamefieldPositions.h) are worked out from where it saw
+	them, and kept in the EEPROM for every power up after.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+#ifndef FieldCalibration_H
+#define FieldCalibration_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// DRS frames of our Kart averaged at each reference point
+#define FIELD_CAL_FRAMES		10
+
+// The reference points, in the order the Kart is walked to them
+typedef enum {
+	FIELD_POINT_CORNER1 = 0,		// The inside corner, where Straight1 meets Straight2
+	FIELD_POINT_CORNER2,				// Straight2 and Straight3
+	FIELD_POINT_CORNER3,				// Straight3 and Straight4
+	FIELD_POINT_CORNER4,				// Straight4 and Straight1
+	FIELD_POINT_DIVIDER,				// Between the ball launching and obstacle areas
+	FIELD_POINT_STRAIGHT2_MID,	// Halfway along Straight2
+	FIELD_POINT_STRAIGHT3_MID,	// Halfway along Straight3
+	NUM_FIELD_POINTS
+} FieldPoint_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void InitializeFieldCalibration(void);
+void StartFieldCalibration(void);
+void MarkFieldPoint(void);
+void RecordFieldCalibrationPose(uint16_t X, uint16_t Y);
+void ClearFieldCalibration(void);
+void PrintFieldGeometry(void);
+
+#endif /* FieldCalibration_H */
@@ -31,11 +31,13 @@ typedef enum {
 
 
 /* THESE ARE THE IMPORTANT TRIGGERS */
-#define Straight2CenterY 93	// Calibrate this value
+// These and the bounding lines are the defaults, StartFieldCalibration
+// measures the gamefield for its own (FieldCalibration.c)
+#define Straight2CenterY 93	// Default, FieldCalibration.c measures it
 #define BallLaunchingYOffset 60	// This offset should be constant
 #define BallLaunchingEntryYBound (Straight2CenterY - BallLaunchingYOffset)
 
-#define Straight3CenterX	156	// Calibrate this value
+#define Straight3CenterX	156	// Default, FieldCalibration.c measures it
 #define ObstacleEntryXOffset 40	// This offset should be constant
 #define ObstacleEntryXBound (Straight3CenterX - ObstacleEntryXOffset)
 
@@ -55,6 +57,30 @@ typedef enum {
 #define Straight4XBound 214
 #define BallLaunchingObstacleBound  163
 
+// The gamefield's geometry, the bounding lines and the triggers
+typedef struct {
+	uint16_t	Corner1X, Corner1Y, Corner2X, Corner2Y;
+	uint16_t	Corner3X, Corner3Y, Corner4X, Corner4Y;
+	uint16_t	Straight1Y, Straight2X, Straight3Y, Straight4X;
+	uint16_t	BallLaunchingObstacleX;
+	uint16_t	Straight2MidY, Straight3MidX;		// Straight2CenterY, Straight3CenterX
+} FieldGeometry_t;
+
+#define FIELD_GEOMETRY_DEFAULTS { \
+	Corner1XBound, Corner1YBound, Corner2XBound, Corner2YBound, \
+	Corner3XBound, Corner3YBound, Corner4XBound, Corner4YBound, \
+	Straight1YBound, Straight2XBound, Straight3YBound, Straight4XBound, \
+	BallLaunchingObstacleBound, Straight2CenterY, Straight3CenterX }
+
+// The zone grid (GamefieldZoneTable.h), cells of 2^ZONE_CELL_SHIFT DRS units
+// a side over 0 to 255. The table in flash is for the default bounds,
+// regenerate it if these or they change. A calibrated geometry gets its
+// grid built in RAM.
+#define ZONE_CELL_SHIFT		3
+#define ZONE_GRID_CELLS		(256 >> ZONE_CELL_SHIFT)
+#define ZONE_TABLE_BYTES	(ZONE_GRID_CELLS * ZONE_GRID_CELLS / 2)
+#define ZONE_SPLIT				0x0F	// A bound crosses the cell
+
 
 /* OUTDATED CODE */
 // We no longer use these, since we're using bumpers to trigger corners
@@ -67,6 +93,9 @@ typedef enum {
 
 /*----------------------- Public Function Prototypes ----------------------*/
 GamefieldPosition_t GetGamefieldPosition(uint16_t Xcoord, uint16_t Ycoord);
+GamefieldPosition_t GetGamefieldPositionByBounds(uint16_t Xcoord, uint16_t Ycoord);
+const FieldGeometry_t *GetFieldGeometry(void);
+void SetFieldGeometry(const FieldGeometry_t *NewGeometry);
 const char * GamefieldPositionString(GamefieldPosition_t GamefieldPosition);
 //double GetAngle(uint8_t Xcoord, uint8_t Ycoord, uint8_t Xtarget, uint8_t Ytarget);
 
@@ -0,0 +1,53 @@
+/****************************************************************************
+Module: GamefieldZoneTable.h
+Description: The zone of each cell of the gamefield grid, for
+						 GetGamefieldPosition. Generated by Host/ZoneGenMain.c from
+						 Host/GamefieldZones.txt, don't edit.
+						 Cells are 8 DRS units a side, a row of the grid to a line
+						 from Y = 0, two cells to a byte, the lower X in the low
+						 nybble. ZONE_SPLIT where a bound crosses the cell.
+****************************************************************************/
+
+#ifndef GamefieldZoneTable_H
+#define GamefieldZoneTable_H
+
+#if ZONE_CELL_SHIFT != 3
+#error The zone table is for another grid, run zonegen
+#endif
+
+static const uint8_t GamefieldZoneTable[ZONE_TABLE_BYTES] = {
+	0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0xF1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x77, 0x77,
+	0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0xF1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x77, 0x77,
+	0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0xF1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x77, 0x77,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x77, 0x77,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0xFF, 0xFF, 0xFF,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0x88, 0x88, 0x88, 0x9F, 0x99, 0x99, 0x6F, 0x66, 0x66,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x6F, 0x66, 0x66,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0xFF, 0xFF,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55,
+	0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0xF3, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0xFF, 0x55, 0x55
+};
+
+#endif /* GamefieldZoneTable_H */
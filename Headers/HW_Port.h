@@ -0,0 +1,107 @@
+/****************************************************************************
+Module: HW_Port.h
+Description:
+	Maps the peripheral register accesses made by the drivers onto either
+	the TM4C123 registers, or the host-side simulators in Host/ when the
+	project is compiled with HOST_SIM defined. Only the peripherals that
+	have a simulator are routed through here, everything else still uses
+	HWREG directly.
+Author: Kyle Moy, 3/5/15
+****************************************************************************/
+
+#ifndef HW_Port_H
+#define HW_Port_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// Resolution of HW_TIMESTAMP(), the 40MHz system clock
+#define HW_TICKS_PER_US							40
+
+#ifdef HOST_SIM
+// SSI0 (DRS) is served by the DRS simulator
+#include "DRSSim.h"
+#define SSI0_READ(Offset)						DRSSim_ReadReg(Offset)
+#define SSI0_WRITE(Offset, Value)		DRSSim_WriteReg((Offset), (Value))
+
+// Timestamps come from the virtual clock
+#include "ES_Port.h"
+#define HW_TIMESTAMP()							(_HW_GetMicros() * HW_TICKS_PER_US)
+
+// The drive encoders are served by the motor simulator, which latches the
+// capture and calls the capture ISR itself, on the same virtual clock
+#include "MotorSim.h"
+#define ENCODER_CAPTURE_R()					MotorSim_GetCapture(RIGHT_MOTOR)
+#define ENCODER_CAPTURE_L()					MotorSim_GetCapture(LEFT_MOTOR)
+#define ENCODER_TIMER_R()						HW_TIMESTAMP()
+#define ENCODER_TIMER_L()						HW_TIMESTAMP()
+#define ENCODER_CLEAR_R()						((void)0)
+#define ENCODER_CLEAR_L()						((void)0)
+
+// The simulation calls the control ISR itself, and has no cycle counter
+#define CONTROL_INT_CLEAR()					((void)0)
+#define HW_CYCLES()									0
+
+// The bump switch, Kart switch, race LED and shooter motor pins, the IR
+// beacon capture and PWM0, the drive's and the ball launcher's, are served
+// by the race simulator, which calls the beacon capture ISR itself
+#include "RaceSim.h"
+#define GPIO_READ(Base)							RaceSim_ReadGPIO(Base)
+#define GPIO_WRITE(Base, Value)			RaceSim_WriteGPIO((Base), (Value))
+#define BEACON_CAPTURE()						RaceSim_GetBeaconCapture()
+#define BEACON_TIMER()							HW_TIMESTAMP()
+#define BEACON_CLEAR()							((void)0)
+#define PWM0_READ(Offset)						RaceSim_ReadPWM(Offset)
+#define PWM0_WRITE(Offset, Value)		RaceSim_WritePWM((Offset), (Value))
+
+#else
+// SSI0 (DRS) registers on the Tiva
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#define SSI0_READ(Offset)						HWREG(SSI0_BASE + (Offset))
+#define SSI0_WRITE(Offset, Value)		(HWREG(SSI0_BASE + (Offset)) = (Value))
+
+// Free running 40MHz timestamp, Wide Timer 0B is left counting up by the
+// right drive encoder input capture (see DriveMotorsEncoder.c)
+#include "inc/hw_timer.h"
+#define HW_TIMESTAMP()							HWREG(WTIMER0_BASE + TIMER_O_TBV)
+
+// Drive encoder input captures, right on Wide Timer 0B and left on 1A
+#define ENCODER_CAPTURE_R()					HWREG(WTIMER0_BASE + TIMER_O_TBR)
+#define ENCODER_CAPTURE_L()					HWREG(WTIMER1_BASE + TIMER_O_TAR)
+#define ENCODER_TIMER_R()						HWREG(WTIMER0_BASE + TIMER_O_TBV)
+#define ENCODER_TIMER_L()						HWREG(WTIMER1_BASE + TIMER_O_TAV)
+#define ENCODER_CLEAR_R()						(HWREG(WTIMER0_BASE + TIMER_O_ICR) = TIMER_ICR_CBECINT)
+#define ENCODER_CLEAR_L()						(HWREG(WTIMER1_BASE + TIMER_O_ICR) = TIMER_ICR_CAECINT)
+
+// Control interrupt, the Wide Timer 1B timeout, and the DWT cycle counter
+// it times itself with (enabled in InitPeriodicInt)
+#define CONTROL_INT_CLEAR()					(HWREG(WTIMER1_BASE + TIMER_O_ICR) = TIMER_ICR_TBTOCINT)
+#define HW_CYCLES()									HWREG(0xE0001004)
+
+// GPIO data, all eight pins of a port through the data register's mask
+#include "inc/hw_gpio.h"
+#define GPIO_READ(Base)							HWREG((Base) + GPIO_O_DATA + (0xff << 2))
+#define GPIO_WRITE(Base, Value)			(HWREG((Base) + GPIO_O_DATA + (0xff << 2)) = (Value))
+
+// IR beacon input capture on Wide Timer 5A
+#define BEACON_CAPTURE()						HWREG(WTIMER5_BASE + TIMER_O_TAR)
+#define BEACON_TIMER()							HWREG(WTIMER5_BASE + TIMER_O_TAV)
+#define BEACON_CLEAR()							(HWREG(WTIMER5_BASE + TIMER_O_ICR) = TIMER_ICR_CAECINT)
+
+// PWM0, whose generators 0 and 1 drive the wheels, 2 and 3 the shooter
+// and the ball servo
+#define PWM0_READ(Offset)						HWREG(PWM0_BASE + (Offset))
+#define PWM0_WRITE(Offset, Value)		(HWREG(PWM0_BASE + (Offset)) = (Value))
+#endif
+
+// Read-modify-write helpers
+#define SSI0_SET(Offset, Bits)			SSI0_WRITE(Offset, SSI0_READ(Offset) | (Bits))
+#define SSI0_CLEAR(Offset, Bits)		SSI0_WRITE(Offset, SSI0_READ(Offset) & ~(Bits))
+#define GPIO_SET(Base, Bits)				GPIO_WRITE(Base, GPIO_READ(Base) | (Bits))
+#define GPIO_CLEAR(Base, Bits)			GPIO_WRITE(Base, GPIO_READ(Base) & ~(Bits))
+#define PWM0_SET(Offset, Bits)			PWM0_WRITE(Offset, PWM0_READ(Offset) | (Bits))
+#define PWM0_CLEAR(Offset, Bits)		PWM0_WRITE(Offset, PWM0_READ(Offset) & ~(Bits))
+
+#endif /* HW_Port_H */
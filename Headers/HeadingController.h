@@ -0,0 +1,50 @@
+/****************************************************************************
+Module: HeadingController.h
+Description:
+	PD control of the Kart's heading for turning on the spot, from the
+	fused pose heading and the encoder yaw rate to a wheel RPM.
+Author: Kyle Moy, 3/13/15
+****************************************************************************/
+
+#ifndef HeadingController_H
+#define HeadingController_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// Wheel RPM per degree of heading error, and per degree/s of yaw rate.
+// Both wheels turning at 1 RPM spins the Kart at about 2.8 degrees/s.
+#define HEADING_KP						4.0f
+#define HEADING_KD						0.15f
+// Slowest and fastest the wheels are asked to turn the Kart. Much under
+// MIN_TURN_RPM the encoders can't time the wheels and the PID stalls.
+#define MIN_TURN_RPM					25
+#define MAX_TURN_RPM					150
+// Time constant of the Kart's spin dying away with the motors off. Too
+// short and turns end past the target, too long and they end short.
+#define HEADING_COAST_MS			90.0f
+
+// How a turn is going
+typedef enum {
+	HEADING_TURNING,
+	HEADING_ARRIVED,
+	HEADING_TIMED_OUT
+} HeadingResult_t;
+
+// State of a turn
+typedef struct {
+	float			TargetTheta;	// Degrees, 0-360, same frame as the DRS
+	float			Tolerance;		// Degrees either side of TargetTheta
+	uint16_t	TimeLimitMS;
+	uint16_t	ElapsedMS;
+} HeadingController_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void StartHeadingController(HeadingController_t *Heading, float TargetTheta, float Tolerance, uint16_t TimeLimitMS);
+HeadingResult_t UpdateHeadingController(HeadingController_t *Heading, float Theta, float YawRate, \
+	uint16_t PeriodMS, int16_t *TurnRPM);
+float GetHeadingError(float TargetTheta, float Theta);
+
+#endif /* HeadingController_H */
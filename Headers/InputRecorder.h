@@ -0,0 +1,79 @@
+/****************************************************************************
+Module: InputRecorder.h
+Description:
+	Records every input from outside the Kart, DRS frames, encoder and
+	beacon captures, bump switch edges, keystrokes and the Kart switch, with
+	when it came in, into a compact log in RAM that can be dumped over the
+	UART and replayed on a PC (Host/ReplayMain.c).
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+#ifndef InputRecorder_H
+#define InputRecorder_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// Comment out to build the Kart without the recorder
+#define RECORD_INPUTS
+
+// The log, in bytes. About 4 bytes an encoder edge or beacon edge and 10 a
+// DRS frame, so a few seconds of driving on the Kart.
+#ifdef HOST_SIM
+#define INPUT_LOG_SIZE		(1 << 20)
+#else
+#define INPUT_LOG_SIZE		8192
+#endif
+
+// Once the log is full, true keeps recording over the oldest records, to
+// see what led up to a problem, until FreezeInputRecorder. false stops, so
+// the log replays from reset. The Kart's few seconds are only any use as
+// the ones before the problem, the simulations' log holds a whole race.
+#ifdef HOST_SIM
+#define INPUT_LOG_WRAP		false
+#else
+#define INPUT_LOG_WRAP		true
+#endif
+
+// What came in, the record's payload follows from it
+typedef enum {
+	INPUT_DRS_FRAME = 0,	// The 8 bytes read in EOTIntHandler
+	INPUT_ENCODER_R,			// Ticks from the right wheel's edge to its ISR
+	INPUT_ENCODER_L,			// Ticks from the left wheel's edge to its ISR
+	INPUT_BEACON,					// Ticks from the beacon's edge to its ISR
+	INPUT_BUMP,						// The bump switch, 1 pressed
+	INPUT_KEY,						// A keystroke
+	INPUT_KART_SWITCH,		// The Kart switch's pins
+	NUM_INPUT_TYPES
+} InputType_t;
+
+// Longest record, the type and time, then the payload
+#define INPUT_RECORD_MAX	14
+#define INPUT_PAYLOAD_MAX	8
+
+// One record, decoded
+typedef struct {
+	InputType_t	Type;
+	uint32_t		DeltaUS;			// Since the record before
+	uint32_t		Age;					// The capture types
+	uint8_t			Payload[INPUT_PAYLOAD_MAX];
+} InputRecord_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void InitializeInputRecorder(void);
+#ifdef RECORD_INPUTS
+void RecordCapture(InputType_t Type, uint32_t Age);
+void RecordInput(InputType_t Type, const uint8_t *Payload);
+#else
+#define RecordCapture(Type, Age)			((void)0)
+#define RecordInput(Type, Payload)		((void)0)
+#endif
+void StopInputRecorder(void);
+void FreezeInputRecorder(void);
+uint32_t GetInputLog(uint8_t *Log, uint32_t Length);
+void PrintInputLog(void);
+uint8_t DecodeInputRecord(const uint8_t *Bytes, uint32_t Length, InputRecord_t *Record);
+
+#endif /* InputRecorder_H */
@@ -0,0 +1,41 @@
+/****************************************************************************
+Module: MotionProfile.h
+Description:
+	Acceleration and jerk limited (S-curve) ramps between RPM targets for
+	the drive motors, run every control interrupt ahead of the PID.
+Author: Kyle Moy, 3/9/15
+****************************************************************************/
+
+#ifndef MotionProfile_H
+#define MotionProfile_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// Limits on the wheel speed targets. Raise the acceleration until the
+// wheels start to slip, then back off, every bit is lap time. Slowing down
+// the motors only coast, so PROFILE_MAX_DECEL is as fast as the target
+// falls, not how fast the wheels do.
+// These are the defaults, SetMotionProfileLimits can change them.
+#define PROFILE_MAX_ACCEL			4000		// RPM per second
+#define PROFILE_MAX_DECEL			3000		// RPM per second
+#define PROFILE_MAX_JERK			80000		// RPM per second per second
+// How fast the wheels coast down with the drive off, what distance moves
+// plan their stops on. The motor model (Host/MotorSim.c) coasts down from
+// 200 RPM at about 470 RPM per second, this leaves a margin under that.
+#define PROFILE_COAST_DECEL		400			// RPM per second
+
+// State of one wheel's profile
+typedef struct {
+	int32_t		Velocity;		// RPM, Q16.16, never negative
+	int32_t		Accel;			// RPM per control interrupt, Q16.16
+} MotionProfile_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void ResetMotionProfile(MotionProfile_t *Profile, int32_t RPM);
+int32_t UpdateMotionProfile(MotionProfile_t *Profile, int32_t GoalRPM);
+uint32_t GetStoppingRPM(uint32_t Ticks);
+void SetMotionProfileLimits(uint32_t Accel, uint32_t Decel, uint32_t Jerk);
+
+#endif /* MotionProfile_H */
@@ -0,0 +1,39 @@
+/****************************************************************************
+Module: MotionSequencer.h
+Description:
+	Runs a const table of drive motor primitives back to back from the
+	control interrupt, and posts E_MOTION_SEQUENCE_DONE once at the end.
+Author: Kyle Moy, 3/10/15
+****************************************************************************/
+
+#ifndef MotionSequencer_H
+#define MotionSequencer_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+typedef enum {
+	MOTION_END,					// Ends the sequence, every table needs one
+	MOTION_STOP,				// PWM off and coast for Amount ms
+	MOTION_FORWARD,			// Both wheels forward at RPML, RPMR for Amount ms
+	MOTION_BACKWARD,		// Both wheels backward at RPML, RPMR for Amount ms
+	MOTION_PIVOT_CW,		// Left wheel forward at RPML for Amount ticks
+	MOTION_PIVOT_CCW		// Left wheel backward at RPML for Amount ticks
+} MotionPrimitive_t;
+
+typedef struct {
+	MotionPrimitive_t	Primitive;
+	uint16_t					RPML;
+	uint16_t					RPMR;
+	uint16_t					Amount;		// ms for timed steps, encoder ticks for pivots
+} MotionStep_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void StartMotionSequence(const MotionStep_t *Sequence);
+void StopMotionSequence(void);
+bool IsMotionSequenceRunning(void);
+bool UpdateMotionSequence(int32_t *TargetRPMR, int32_t *TargetRPML);
+
+#endif /* MotionSequencer_H */
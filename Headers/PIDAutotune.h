@@ -0,0 +1,49 @@
+/****************************************************************************
+Module: PIDAutotune.h
+Description:
+	Relay feedback (Astrom-Hagglund) experiment for tuning a drive motor PID.
+	Hardware free, the control ISR runs one per wheel.
+Author: Kyle Moy, 3/11/15
+****************************************************************************/
+
+#ifndef PIDAutotune_H
+#define PIDAutotune_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+typedef enum {
+	AUTOTUNE_IDLE,
+	AUTOTUNE_RAMPING,		// Finding the duty that holds the set point
+	AUTOTUNE_RELAY,			// Switching the duty either side of it
+	AUTOTUNE_DONE,
+	AUTOTUNE_FAILED
+} AutotuneState_t;
+
+// State of one wheel's experiment
+typedef struct {
+	AutotuneState_t	State;
+	int32_t		SetpointRPM;
+	int32_t		HysteresisRPM;
+	int32_t		RelayDuty;				// Duty % either side of the bias
+	int32_t		BiasDuty;					// Duty %
+	bool			High;							// Relay on the high side
+	uint32_t	Time;							// ms since the start
+	uint32_t	RiseTime;					// When the relay last went high
+	uint32_t	FallTime;					// When the relay last went low
+	int32_t		Max, Min;					// RPM extremes this cycle
+	uint8_t		Cycles;
+	uint32_t	SumPeriod;				// ms, over the measured cycles
+	int32_t		SumPeakToPeak;		// RPM, over the measured cycles
+} RelayAutotune_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void StartRelayAutotune(RelayAutotune_t *Tune, int32_t SetpointRPM, int32_t RelayDuty);
+uint8_t UpdateRelayAutotune(RelayAutotune_t *Tune, int32_t RPM);
+bool IsRelayAutotuneFinished(const RelayAutotune_t *Tune);
+bool GetRelayAutotuneResult(const RelayAutotune_t *Tune, float *Ku, float *TuMS);
+void RelayAutotuneGains(float Ku, float TuMS, float *p, float *i, float *d);
+
+#endif /* PIDAutotune_H */
@@ -0,0 +1,50 @@
+/****************************************************************************
+Module: PIDController.h
+Description:
+	Fixed-point PID for the 1kHz drive motor loop. No floating point in the
+	update, gains are converted once when they are set.
+Author: Kyle Moy, 3/7/15
+****************************************************************************/
+
+#ifndef PIDController_H
+#define PIDController_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// Gains are Q8.24, the output and integrator are duty cycle in Q16.16
+#define PID_GAIN_SHIFT			24
+#define PID_OUTPUT_SHIFT		16
+#define PID_DUTY_MAX				100
+// Errors within this many standard deviations of the RPM measurement are
+// taken as noise, the loop neither acts nor integrates on them
+#define PID_DEADBAND_SIGMAS	2
+
+// Gains converted ahead of time, for switching between from the ISR
+typedef struct {
+	int32_t		Kp;					// Duty % per RPM of error, Q8.24
+	int32_t		Ki;					// Duty % per RPM of error per sample, Q8.24
+	int32_t		Kd;					// Duty % per RPM of change per sample, Q8.24
+} PIDGains_t;
+
+// State of one PID loop
+typedef struct {
+	int32_t		Kp;					// Duty % per RPM of error, Q8.24
+	int32_t		Ki;					// Duty % per RPM of error per sample, Q8.24
+	int32_t		Kd;					// Duty % per RPM of change per sample, Q8.24
+	int32_t		Integral;		// Integral term, duty % in Q16.16
+	int32_t		LastRPM;		// For the derivative on measurement
+	int32_t		LastError;	// For bumpless gain changes
+} PIDController_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void SetPIDControllerGains(PIDController_t *PID, float p, float i, float d);
+void ConvertPIDGains(PIDGains_t *Gains, float p, float i, float d);
+void SwitchPIDGains(PIDController_t *PID, const PIDGains_t *Gains);
+void ResetPIDController(PIDController_t *PID);
+uint8_t UpdatePIDController(PIDController_t *PID, int32_t TargetRPM, int32_t RPM, uint32_t RPMVariance, \
+	int32_t FeedforwardDuty);
+
+#endif /* PIDController_H */
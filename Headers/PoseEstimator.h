@@ -0,0 +1,37 @@
+/****************************************************************************
+Module: PoseEstimator.h
+Description:
+	Pose for our Kart, dead reckoned from the drive encoders at 100Hz and
+	pulled toward each DRS pose by a complementary filter. Each DRS frame is
+	stamped at the EOT interrupt along with the encoder odometers, so it is
+	compared with the estimate at that stamp rather than the latest one.
+Author: Kyle Moy, 3/6/15
+****************************************************************************/
+
+#ifndef PoseEstimator_H
+#define PoseEstimator_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "DRS.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// An estimated pose, in DRS units and degrees (0-360, same frame as the DRS,
+// Theta growing clockwise)
+typedef struct {
+	float	X;
+	float	Y;
+	float	Theta;
+} Pose_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void UpdateOdometry(void);
+void SetPoseFix(Kart_t Kart, uint32_t Timestamp, int32_t TicksL, int32_t TicksR);
+bool HasPoseFix(void);
+Pose_t GetPoseAtTime(uint32_t Timestamp);
+Pose_t GetCurrentPose(void);
+float GetYawRate(void);
+void PrintPoseEstimate(void);
+
+#endif /* PoseEstimator_H */
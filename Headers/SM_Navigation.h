@@ -4,7 +4,7 @@ Description:
 	A sub-level state machine for our robot that controls the point-destination
 	driving navigation system. Used in the RACING state machine to get from
 	corner to corner.
-	Contains eight states: ORIENTING, DRIVING
+	Contains three states: ORIENTING, DRIVING, WAITING
 	
 Author: Kyle Moy, 2/24/15
 ****************************************************************************/
@@ -14,6 +14,7 @@ Author: Kyle Moy, 2/24/15
 
 /*----------------------------- Include Files -----------------------------*/
 #include <stdint.h>
+#include "HeadingController.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 // States of the SM_Navigation state machine
@@ -24,8 +25,11 @@ typedef enum {ORIENTING, DRIVING, WAITING} NavigationState_t;
 ES_Event RunNavigationSM(ES_Event CurrentEvent);
 void StartNavigationSM(ES_Event CurrentEvent);
 NavigationState_t QueryNavigationSM(void);
+HeadingResult_t QueryHeadingResult(void);
 void SetTargetPosition(uint8_t X, uint8_t Y);
 void SetTargetTheta(uint16_t Theta);
+uint16_t GetTargetTheta(void);
+void SetHeadingTolerance(uint8_t Degrees);
 
 #endif /*SM_NAVIGATION_H */
 
@@ -0,0 +1,261 @@
+/****************************************************************************
+Module: AutotuneMain.c
+Description:
+	Host run of the relay autotuner (PIDAutotune.c). Each wheel is the
+	motor simulator's (MotorSim.c), on the floor, as motorsim and
+	motorsweep drive them, read through its encoder captures from the last
+	edge period the way DriveMotorsEncoder.c times them. The autotuner runs
+	at 1kHz on each wheel, then the
+	feedforward sweep (DriveFeedforward.c) maps its duty to speed. The
+	hand tuned maneuver gains and the tuned gains, each without and with
+	the feedforward, are given the same speed steps through the motion
+	profile (MotionProfile.c) and the fixed-point PID (PIDController.c),
+	as SetRPMResponse runs them.
+
+	Build from the project directory on a PC with TivaWare checked out:
+		gcc -std=gnu99 -O2 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o autotune \
+			Host/AutotuneMain.c Host/MotorSim.c Host/FaultSim.c \
+			Source/PIDAutotune.c Source/PIDController.c Source/DriveFeedforward.c \
+			Source/MotionProfile.c -lm
+
+	Usage:
+		autotune [set point RPM] [relay duty %]
+Author: Kyle Moy, 3/11/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Framework Libraries
+#include "ES_Port.h"
+
+// Module Libraries
+#include "MotorSim.h"
+#include "HW_Port.h"
+#include "DriveMotors.h"
+#include "DriveMotorEncoder.h"
+#include "PIDAutotune.h"
+#include "PIDController.h"
+#include "DriveFeedforward.h"
+#include "MotionProfile.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define DEFAULT_SETPOINT_RPM	150
+#define DEFAULT_RELAY_DUTY		10
+#define PulsesPerRev					28
+#define CONTROL_PERIOD_US			1000
+// The encoder reports a stopped wheel after 150ms without an edge
+#define STOPPED_TICKS					(150000 * HW_TICKS_PER_US)
+#define MODEL_SEED						1
+
+// The hand tuned maneuver gains
+#define HAND_P								0.05f
+#define HAND_I								0.02f
+#define HAND_D								0.0f
+
+/*---------------------------- Module Functions ---------------------------*/
+static void ResetModel(void);
+static int32_t StepWheel(uint8_t Wheel, uint8_t Duty);
+static void CaptureEdge(uint8_t Wheel);
+static void StepTest(uint8_t Wheel, const char *Name, float p, float i, float d, \
+	const FeedforwardMap_t *Map);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint32_t NowUS;
+static const char *WheelNames[2] = {"Right", "Left"};
+
+// Each wheel's encoder, from the captures the model latches
+typedef struct {
+	bool				Seen;				// An edge since the reset
+	uint32_t		LastCapture;
+	uint32_t		LastPeriod;	// Ticks, 0 until there have been two edges
+} Encoder_t;
+
+static Encoder_t Encoders[2];
+
+// Speed steps for the comparison, ms and RPM
+typedef struct {
+	uint16_t	DurationMS;
+	uint16_t	TargetRPM;
+} Step_t;
+
+static const Step_t Steps[] = {
+	{1000, 150},
+	{1000, 250},
+	{1000, 100},
+	{1000, 200}
+};
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	int32_t Setpoint = DEFAULT_SETPOINT_RPM;
+	int32_t RelayDuty = DEFAULT_RELAY_DUTY;
+	if (argc > 1) Setpoint = strtol(argv[1], NULL, 0);
+	if (argc > 2) RelayDuty = strtol(argv[2], NULL, 0);
+
+	for (uint8_t Wheel = 0; Wheel < 2; Wheel++) {
+		RelayAutotune_t Tune;
+		ResetModel();
+		StartRelayAutotune(&Tune, Setpoint, RelayDuty);
+		uint8_t Duty = 0;
+		uint32_t Time = 0;
+		while (!IsRelayAutotuneFinished(&Tune)) {
+			Duty = UpdateRelayAutotune(&Tune, StepWheel(Wheel, Duty));
+			Time++;
+		}
+
+		float Ku, TuMS, p, i, d;
+		if (!GetRelayAutotuneResult(&Tune, &Ku, &TuMS)) {
+			printf("%s: autotune failed after %lu ms\r\n", WheelNames[Wheel], (unsigned long)Time);
+			continue;
+		}
+		RelayAutotuneGains(Ku, TuMS, &p, &i, &d);
+		printf("%s: Ku = %.4f duty%%/RPM, Tu = %.1f ms, bias %ld%% -> p %.4f, i %.4f, d %.4f (%lu ms)\r\n", \
+			WheelNames[Wheel], Ku, TuMS, (long)Tune.BiasDuty, p, i, d, (unsigned long)Time);
+
+		FeedforwardMap_t Map = {{0}};
+		FeedforwardSweep_t Sweep;
+		ResetModel();
+		StartFeedforwardSweep(&Sweep, &Map);
+		Duty = 0;
+		while (IsFeedforwardSweepRunning(&Sweep)) {
+			Duty = UpdateFeedforwardSweep(&Sweep, StepWheel(Wheel, Duty));
+		}
+		printf("  map:");
+		for (uint8_t n = 0; n < FF_POINTS; n++) printf(" %d%%=%u", (n + 1) * FF_DUTY_STEP, Map.RPM[n]);
+		printf(", time constant %u ms\r\n", Map.TimeConstantMS);
+
+		StepTest(Wheel, "hand", HAND_P, HAND_I, HAND_D, NULL);
+		StepTest(Wheel, "hand+ff", HAND_P, HAND_I, HAND_D, &Map);
+		StepTest(Wheel, "tuned", p, i, d, NULL);
+		StepTest(Wheel, "tuned+ff", p, i, d, &Map);
+	}
+	return 0;
+}
+
+// Host port, the virtual clock is kept here rather than by ES_Port.c
+uint32_t _HW_GetMicros(void) { return NowUS; }
+// No SysTick, FaultSim.c's tick delay has nothing to hold off
+uint16_t _HW_GetTickCount(void) { return 0; }
+void _HW_DelayTick(uint32_t DelayUS) {}
+
+// The capture ISRs, the model calls them on each edge
+void RDriveCaptureResponse(void) { CaptureEdge(RIGHT_MOTOR); }
+void LDriveCaptureResponse(void) { CaptureEdge(LEFT_MOTOR); }
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ResetModel
+Parameters:		void
+Returns:			void
+Description:	Both wheels back to a standstill on the same model, so every
+							run starts alike
+****************************************************************************/
+static void ResetModel(void) {
+	MotorSim_Init(MotorSimDefaultWheel, MotorSimFloor, MotorSimDefaultBattery, MODEL_SEED);
+	MotorSim_Step(NowUS);
+	for (uint8_t Wheel = RIGHT_MOTOR; Wheel <= LEFT_MOTOR; Wheel++) {
+		Encoders[Wheel].Seen = false;
+		Encoders[Wheel].LastPeriod = 0;
+	}
+}
+
+/****************************************************************************
+Function:			StepWheel
+Parameters:		uint8_t Wheel
+							uint8_t Duty, the duty cycle applied for the next 1ms
+Returns:			int32_t, the RPM the encoder reports at the end of the 1ms
+Description:	Runs the model on 1ms with the wheel driven forward, the speed
+							measured from the last edge period, or the time since the
+							last edge once that is longer, as DriveMotorsEncoder.c does
+****************************************************************************/
+static int32_t StepWheel(uint8_t Wheel, uint8_t Duty) {
+	MotorSim_SetDrive(Wheel, Duty, FORWARD);
+	NowUS += CONTROL_PERIOD_US;
+	MotorSim_Step(NowUS);
+
+	Encoder_t *E = &Encoders[Wheel];
+	uint32_t Since = HW_TIMESTAMP() - E->LastCapture;
+	if (!E->Seen || E->LastPeriod == 0 || Since >= STOPPED_TICKS) return 0;
+	uint32_t Period = (Since > E->LastPeriod) ? Since : E->LastPeriod;
+	return (int32_t)(60000000ull * HW_TICKS_PER_US / ((uint64_t)Period * PulsesPerRev));
+}
+
+/****************************************************************************
+Function:			CaptureEdge
+Parameters:		uint8_t Wheel
+Returns:			void
+Description:	Times an edge from the model's capture
+****************************************************************************/
+static void CaptureEdge(uint8_t Wheel) {
+	Encoder_t *E = &Encoders[Wheel];
+	uint32_t Capture = MotorSim_GetCapture(Wheel);
+	if (E->Seen) E->LastPeriod = Capture - E->LastCapture;
+	E->LastCapture = Capture;
+	E->Seen = true;
+}
+
+/****************************************************************************
+Function:			StepTest
+Parameters:		uint8_t Wheel
+							const char *Name, what to call the gains
+							float p, i, d, the gains
+							const FeedforwardMap_t *Map, the feedforward, NULL for none
+Returns:			void
+Description:	Runs the speed steps through the fixed-point PID and prints
+							rise time, overshoot, settling time and RMS error
+****************************************************************************/
+static void StepTest(uint8_t Wheel, const char *Name, float p, float i, float d, \
+	const FeedforwardMap_t *Map) {
+	PIDController_t PID;
+	ResetModel();
+	ResetPIDController(&PID);
+	SetPIDControllerGains(&PID, p, i, d);
+
+	float SumSquares = 0;
+	uint32_t Samples = 0;
+	float SumRise = 0, SumSettle = 0, MaxOvershoot = 0;
+	int32_t RPM = 0;
+	int32_t LastTarget = 0;
+	MotionProfile_t Profile;
+	int32_t Model;
+	FeedforwardMap_t NoMap = {{0}};
+	if (Map == NULL) Map = &NoMap;
+	ResetMotionProfile(&Profile, 0);
+	ResetReferenceModel(&Model, 0);
+	for (uint8_t s = 0; s < sizeof(Steps)/sizeof(Steps[0]); s++) {
+		int32_t Target = Steps[s].TargetRPM;
+		float Span = fabsf((float)Target - LastTarget);
+		int32_t RiseMS = -1, SettleMS = 0;
+		float Overshoot = 0;
+		for (uint16_t t = 0; t < Steps[s].DurationMS; t++) {
+			int32_t Ramp = UpdateMotionProfile(&Profile, Target);
+			int32_t Reference = UpdateReferenceModel(Map, &Model, Ramp);
+			uint8_t Duty = UpdatePIDController(&PID, Reference, RPM, 0, GetFeedforwardDuty(Map, Ramp));
+			RPM = StepWheel(Wheel, Duty);
+			float Truth = MotorSim_GetRPM(Wheel);
+			float Done = (Target > LastTarget) ? (Truth - LastTarget) / Span : (LastTarget - Truth) / Span;
+			if (RiseMS < 0 && Done >= 0.9f) RiseMS = t;
+			if (Done > 1 && (Done - 1) * 100 > Overshoot) Overshoot = (Done - 1) * 100;
+			if (fabsf(Truth - Target) > 0.05f * Target) SettleMS = t + 1;
+			SumSquares += (Truth - Target) * (Truth - Target);
+			Samples++;
+		}
+		SumRise += (RiseMS < 0) ? Steps[s].DurationMS : RiseMS;
+		SumSettle += SettleMS;
+		if (Overshoot > MaxOvershoot) MaxOvershoot = Overshoot;
+		LastTarget = Target;
+	}
+	uint8_t Count = sizeof(Steps)/sizeof(Steps[0]);
+	printf("  %-8s gains: rise %.0f ms, settle %.0f ms (mean), overshoot %.1f%% (max), RMS error %.1f RPM\r\n", \
+		Name, SumRise / Count, SumSettle / Count, MaxOvershoot, sqrtf(SumSquares / Samples));
+}
+
+/*------------------------------ End of file ------------------------------*/
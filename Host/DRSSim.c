@@ -0,0 +1,602 @@
+/****************************************************************************
+Module: DRSSim.c
+Description:
+	Host-side model of the Dynamic Race System.
+	SSI0 side: the firmware writes the 8 byte query through DRSSim_WriteReg
+	as it would to SSI_O_DR. Once all 8 bytes are in, the transfer completes
+	after the configured latency (plus jitter) and the response frame is
+	loaded into the receive FIFO and EOTIntHandler is called, just like the
+	SSI0 interrupt would on the Tiva. Frames can be dropped (no EOT, so the
+	SM_DRS timeout is exercised) or corrupted.
+	Race side: the three Karts drive laps around a rectangle through all of
+	the gamefield zones while the flag is dropped, the flag follows a script,
+	and the lap, obstacle and target bits are reported the same way the
+	real DRS packs them. A Kart can instead be driven from outside, by a
+	simulation of its own, which sets its pose and refereed status.
+Author: Kyle Moy, 3/5/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <math.h>
+
+// Hardware Libraries (register offsets and bit names only)
+#include "inc/hw_ssi.h"
+
+// Module Libraries
+#include "DRSSim.h"
+#include "DRS.h"
+#include "FaultSim.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define NUM_KARTS				3
+#define FRAME_LENGTH		8
+#define FIFO_DEPTH			8
+#define REG_SPACE				0x1000	// SSI register block size
+
+// Game status byte layout, as the DRS sends it
+#define LAPS_REMAINING_MASK		0x07	// Bits 0-2
+#define FLAG_STATUS_SHIFT			3			// Bits 3-4
+#define OBSTACLE_STATUS_BIT		0x40	// Bit 6
+#define TARGET_STATUS_BIT			0x80	// Bit 7
+
+// Bytes clocked back while the query byte and the next byte go out
+#define RESPONSE_BYTE0			0xFF
+#define RESPONSE_BYTE1			0x00
+// What the DRS returns when it has nothing valid to say
+#define INVALID_BYTE				0xFF
+
+// The simulated track, a rectangle through every gamefield zone, driven in
+// the race direction: Straight1 (-X), Straight2 (+Y), Straight3 (+X), Straight4 (-Y)
+#define TRACK_LEFT					55
+#define TRACK_RIGHT					265
+#define TRACK_BOTTOM				16
+#define TRACK_TOP						160
+#define TRACK_WIDTH					(TRACK_RIGHT - TRACK_LEFT)
+#define TRACK_HEIGHT				(TRACK_TOP - TRACK_BOTTOM)
+#define TRACK_LENGTH				(2*TRACK_WIDTH + 2*TRACK_HEIGHT)
+// Distance along the track at the middle of Straight2 and Straight3, where
+// the target and obstacle are "completed"
+#define TARGET_DISTANCE			(TRACK_WIDTH + TRACK_HEIGHT/2)
+#define OBSTACLE_DISTANCE		(TRACK_WIDTH + TRACK_HEIGHT + TRACK_WIDTH/2)
+
+#define MAX_SCRIPT_LENGTH		16
+// Spacing of the finished Karts parked along Straight1
+#define PARKING_SPACING			15
+// Each Kart drives its own lane, offset toward the infield, so two Karts
+// passing each other never report the exact same pose
+#define LANE_WIDTH					4
+
+/*---------------------------- Module Functions ---------------------------*/
+static void StartTransfer(void);
+static void CompleteTransfer(void);
+static void BuildResponse(uint8_t Query, uint8_t *Frame);
+static void CorruptFrame(uint8_t *Frame);
+static void AdvanceRace(uint32_t ElapsedUS);
+static uint8_t StatusByte(uint8_t KartNumber);
+static void KartPose(uint8_t KartNumber, uint16_t *X, uint16_t *Y, uint16_t *Theta);
+static void SnapshotPoses(void);
+static uint32_t Random(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static DRSSimConfig_t Config;
+static DRSSimStats_t Stats;
+static uint32_t RandomState;
+static uint32_t NowUS;
+
+// SSI0 register file, the FIFOs are modeled separately
+static uint32_t Regs[REG_SPACE/4];
+static uint8_t TxFIFO[FIFO_DEPTH];
+static uint8_t TxCount;
+static uint8_t RxFIFO[FIFO_DEPTH];
+static uint8_t RxHead;
+static uint8_t RxCount;
+static bool TransferPending;
+static uint32_t TransferDoneUS;
+
+// The positions as last refreshed by the DRS, which is what the queries see
+typedef struct {
+	uint16_t	X;
+	uint16_t	Y;
+	uint16_t	Theta;
+} SimPose_t;
+
+// Race state
+typedef struct {
+	uint32_t	Distance;		// Distance along the track this lap, in 1/1000 units
+	uint32_t	Travelled;	// Total distance driven, in 1/1000 units
+	uint16_t	Speed;			// Units per second while the flag is dropped
+	uint8_t		Laps;
+	bool			ObstacleCompleted;
+	bool			TargetSuccess;
+	bool			Driven;			// Pose and status set from outside, not scripted
+	SimPose_t	Pose;				// Where the driven Kart is
+} SimKart_t;
+
+static SimKart_t Karts[NUM_KARTS];
+static Flag_t RaceFlag;
+static DRSSimFlagEvent_t FlagScript[MAX_SCRIPT_LENGTH];
+static uint8_t FlagScriptLength;
+static uint8_t FlagScriptIndex;
+static uint32_t LastStepUS;
+
+static SimPose_t Reported[NUM_KARTS];
+static uint32_t NextSnapshotUS;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			DRSSim_Init
+Parameters:		DRSSimConfig_t Config, the link behavior to simulate
+Returns:			void
+Description:	Resets the simulated DRS, the race and the statistics
+****************************************************************************/
+void DRSSim_Init(DRSSimConfig_t NewConfig) {
+	Config = NewConfig;
+	RandomState = Config.Seed ? Config.Seed : 1;
+	Stats = (DRSSimStats_t){0};
+	for (uint32_t i = 0; i < REG_SPACE/4; i++) Regs[i] = 0;
+	TxCount = 0;
+	RxHead = 0;
+	RxCount = 0;
+	TransferPending = false;
+	NowUS = 0;
+	LastStepUS = 0;
+	NextSnapshotUS = 0;
+	RaceFlag = Flag_Waiting;
+	FlagScriptLength = 0;
+	FlagScriptIndex = 0;
+	// Default race, three laps with the Karts staggered on Straight1
+	for (uint8_t KartNumber = 1; KartNumber <= NUM_KARTS; KartNumber++)
+		DRSSim_SetKart(KartNumber, 60 - 5*KartNumber, 20*(KartNumber - 1), 3);
+}
+
+/****************************************************************************
+Function:			DRSSim_SetFlagScript
+Parameters:		const DRSSimFlagEvent_t *Script, flag changes in time order
+							uint8_t Length, the number of entries
+Returns:			void
+Description:	Sets the race flag changes to play back
+****************************************************************************/
+void DRSSim_SetFlagScript(const DRSSimFlagEvent_t *Script, uint8_t Length) {
+	if (Length > MAX_SCRIPT_LENGTH) Length = MAX_SCRIPT_LENGTH;
+	for (uint8_t i = 0; i < Length; i++) FlagScript[i] = Script[i];
+	FlagScriptLength = Length;
+	FlagScriptIndex = 0;
+}
+
+/****************************************************************************
+Function:			DRSSim_SetKart
+Parameters:		uint8_t KartNumber, 1-3
+							uint16_t Speed, in DRS units per second
+							uint16_t StartDistance, distance along the track from the start
+							uint8_t Laps, the number of laps to race
+Returns:			void
+Description:	Configures a simulated Kart
+****************************************************************************/
+void DRSSim_SetKart(uint8_t KartNumber, uint16_t Speed, uint16_t StartDistance, uint8_t Laps) {
+	if (KartNumber < 1 || KartNumber > NUM_KARTS) return;
+	SimKart_t *Kart = &Karts[KartNumber - 1];
+	Kart->Distance = (uint32_t)(StartDistance % TRACK_LENGTH) * 1000;
+	Kart->Travelled = 0;
+	Kart->Speed = Speed;
+	Kart->Laps = Laps & LAPS_REMAINING_MASK;
+	Kart->ObstacleCompleted = false;
+	Kart->TargetSuccess = false;
+	Kart->Driven = false;
+}
+
+/****************************************************************************
+Function:			DRSSim_SetKartPose
+Parameters:		uint8_t KartNumber, 1-3
+							uint16_t X, Y, Theta, where the Kart is now
+Returns:			void
+Description:	Hands the Kart over to an outside simulation, it stops driving
+							its scripted laps and is reported where it is put
+****************************************************************************/
+void DRSSim_SetKartPose(uint8_t KartNumber, uint16_t X, uint16_t Y, uint16_t Theta) {
+	if (KartNumber < 1 || KartNumber > NUM_KARTS) return;
+	SimKart_t *Kart = &Karts[KartNumber - 1];
+	if (Kart->Driven) {
+		Kart->Travelled += (uint32_t)(1000 * hypotf((float)X - Kart->Pose.X, (float)Y - Kart->Pose.Y));
+	}
+	Kart->Driven = true;
+	Kart->Pose.X = X;
+	Kart->Pose.Y = Y;
+	Kart->Pose.Theta = Theta;
+}
+
+/****************************************************************************
+Function:			DRSSim_SetKartStatus
+Parameters:		uint8_t KartNumber, 1-3
+							uint8_t Laps, the laps left
+							bool ObstacleCompleted, bool TargetSuccess
+Returns:			void
+Description:	What the outside simulation refereed for a driven Kart
+****************************************************************************/
+void DRSSim_SetKartStatus(uint8_t KartNumber, uint8_t Laps, bool ObstacleCompleted, bool TargetSuccess) {
+	if (KartNumber < 1 || KartNumber > NUM_KARTS) return;
+	SimKart_t *Kart = &Karts[KartNumber - 1];
+	Kart->Laps = Laps & LAPS_REMAINING_MASK;
+	Kart->ObstacleCompleted = ObstacleCompleted;
+	Kart->TargetSuccess = TargetSuccess;
+}
+
+/****************************************************************************
+Function:			DRSSim_Step
+Parameters:		uint32_t Now, the virtual time in microseconds
+Returns:			void
+Description:	Advances the race and completes any transfer that is due.
+							Called from the host port on every advance of the clock.
+****************************************************************************/
+void DRSSim_Step(uint32_t Now) {
+	NowUS = Now;
+
+	// Play back the flag script
+	while (FlagScriptIndex < FlagScriptLength &&
+				 FlagScript[FlagScriptIndex].TimeMS * 1000 <= NowUS) {
+		RaceFlag = FlagScript[FlagScriptIndex].Flag;
+		FlagScriptIndex++;
+	}
+
+	AdvanceRace(NowUS - LastStepUS);
+	LastStepUS = NowUS;
+
+	// The DRS only refreshes the positions periodically
+	if ((int32_t)(NowUS - NextSnapshotUS) >= 0) {
+		SnapshotPoses();
+		NextSnapshotUS = NowUS + Config.PoseUpdateUS;
+	}
+
+	if (TransferPending && (int32_t)(NowUS - TransferDoneUS) >= 0) {
+		CompleteTransfer();
+	}
+}
+
+/****************************************************************************
+Function:			DRSSim_ReadReg
+Parameters:		uint32_t Offset, the SSI register offset (SSI_O_xx)
+Returns:			uint32_t, the register value
+Description:	Reads a simulated SSI0 register
+****************************************************************************/
+uint32_t DRSSim_ReadReg(uint32_t Offset) {
+	switch (Offset) {
+		case SSI_O_SR: {
+			uint32_t Status = 0;
+			if (!TransferPending && TxCount == 0) Status |= SSI_SR_TFE;
+			if (TxCount < FIFO_DEPTH) Status |= SSI_SR_TNF;
+			if (RxCount > 0) Status |= SSI_SR_RNE;
+			if (TransferPending) Status |= SSI_SR_BSY;
+			return Status;
+		}
+		case SSI_O_DR: {
+			// Reading an empty FIFO just returns 0
+			if (RxCount == 0) return 0;
+			uint8_t Byte = RxFIFO[RxHead];
+			RxHead = (RxHead + 1) % FIFO_DEPTH;
+			RxCount--;
+			return Byte;
+		}
+		default:
+			return (Offset < REG_SPACE) ? Regs[Offset/4] : 0;
+	}
+}
+
+/****************************************************************************
+Function:			DRSSim_WriteReg
+Parameters:		uint32_t Offset, the SSI register offset (SSI_O_xx)
+							uint32_t Value, the value to write
+Returns:			void
+Description:	Writes a simulated SSI0 register
+****************************************************************************/
+void DRSSim_WriteReg(uint32_t Offset, uint32_t Value) {
+	switch (Offset) {
+		case SSI_O_DR:
+			// Nothing goes out while the SSI is disabled
+			if ((Regs[SSI_O_CR1/4] & SSI_CR1_SSE) == 0) return;
+			// Writing while a transfer is in progress or the FIFO is full is lost
+			if (TransferPending || TxCount >= FIFO_DEPTH) {
+				Stats.Overruns++;
+				return;
+			}
+			TxFIFO[TxCount++] = (uint8_t)Value;
+			if (TxCount == FRAME_LENGTH) StartTransfer();
+			break;
+		case SSI_O_ICR:
+			// Write 1 to clear
+			Regs[SSI_O_RIS/4] &= ~Value;
+			break;
+		case SSI_O_SR:
+		case SSI_O_RIS:
+		case SSI_O_MIS:
+			// Read only
+			break;
+		default:
+			if (Offset < REG_SPACE) Regs[Offset/4] = Value;
+			break;
+	}
+}
+
+/****************************************************************************
+Function:			DRSSim_GetTruePose
+Parameters:		uint8_t KartNumber, 1-3
+							uint16_t *X, *Y, *Theta, the pose to fill in
+Returns:			void
+Description:	Where the Kart really is right now, not what the DRS last reported
+****************************************************************************/
+void DRSSim_GetTruePose(uint8_t KartNumber, uint16_t *X, uint16_t *Y, uint16_t *Theta) {
+	KartPose(KartNumber, X, Y, Theta);
+}
+
+/****************************************************************************
+Function:			DRSSim_GetTravelled
+Parameters:		uint8_t KartNumber, 1-3
+Returns:			uint32_t, total distance the Kart has driven, in 1/1000 units
+Description:	Drives the simulated encoders
+****************************************************************************/
+uint32_t DRSSim_GetTravelled(uint8_t KartNumber) {
+	return Karts[KartNumber - 1].Travelled;
+}
+
+/****************************************************************************
+Function:			DRSSim_GetFlag
+Parameters:		void
+Returns:			Flag_t, the race flag now
+Description:	For timing the race from the drop of the flag
+****************************************************************************/
+Flag_t DRSSim_GetFlag(void) {
+	return RaceFlag;
+}
+
+/****************************************************************************
+Function:			DRSSim_GetStats
+Parameters:		void
+Returns:			DRSSimStats_t, the counters since DRSSim_Init
+Description:	Returns the link counters
+****************************************************************************/
+DRSSimStats_t DRSSim_GetStats(void) {
+	return Stats;
+}
+
+/****************************************************************************
+Function:			DRSSim_PrintStats
+Parameters:		void
+Returns:			void
+Description:	Prints the link counters and the race state
+****************************************************************************/
+void DRSSim_PrintStats(void) {
+	printf("DRS Sim: %lu queries, %lu delivered, %lu dropped, %lu corrupted, %lu overruns, %lu unknown\r\n", \
+		(unsigned long)Stats.Queries, (unsigned long)Stats.Delivered, (unsigned long)Stats.Dropped, \
+		(unsigned long)Stats.Corrupted, (unsigned long)Stats.Overruns, (unsigned long)Stats.UnknownQueries);
+	for (uint8_t KartNumber = 1; KartNumber <= NUM_KARTS; KartNumber++) {
+		uint16_t X, Y, Theta;
+		KartPose(KartNumber, &X, &Y, &Theta);
+		printf("DRS Sim: Kart %d at (%d, %d, %d), %d laps left, status 0x%02x\r\n", \
+			KartNumber, X, Y, Theta, Karts[KartNumber - 1].Laps, StatusByte(KartNumber));
+	}
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			StartTransfer
+Parameters:		void
+Returns:			void
+Description:	All 8 bytes of a query are in, schedule the end of transfer
+****************************************************************************/
+static void StartTransfer(void) {
+	uint32_t Latency = Config.LatencyUS;
+	if (Config.JitterUS > 0) Latency += Random() % (Config.JitterUS + 1);
+	TransferDoneUS = NowUS + Latency;
+	TransferPending = true;
+	Stats.Queries++;
+}
+
+/****************************************************************************
+Function:			CompleteTransfer
+Parameters:		void
+Returns:			void
+Description:	Loads the response into the receive FIFO and raises EOT
+****************************************************************************/
+static void CompleteTransfer(void) {
+	uint8_t Frame[FRAME_LENGTH];
+	BuildResponse(TxFIFO[0], Frame);
+	TxCount = 0;
+	TransferPending = false;
+
+	// A dropped frame never raises the interrupt, so SM_DRS has to time out
+	if ((Random() % 100) < Config.DropPercent || FaultSim_Inject(FAULT_DRS_DROP)) {
+		Stats.Dropped++;
+		return;
+	}
+	if ((Random() % 100) < Config.CorruptPercent || FaultSim_Inject(FAULT_DRS_CORRUPT)) {
+		CorruptFrame(Frame);
+		Stats.Corrupted++;
+	}
+
+	RxHead = 0;
+	RxCount = FRAME_LENGTH;
+	for (uint8_t i = 0; i < FRAME_LENGTH; i++) RxFIFO[i] = Frame[i];
+
+	Regs[SSI_O_RIS/4] |= SSI_RIS_TXRIS;
+	if (Regs[SSI_O_IM/4] & SSI_IM_TXIM) {
+		Stats.Delivered++;
+		EOTIntHandler();
+	}
+}
+
+/****************************************************************************
+Function:			BuildResponse
+Parameters:		uint8_t Query, the query byte that was sent
+							uint8_t *Frame, the 8 byte frame to fill
+Returns:			void
+Description:	Builds the DRS response to a query
+****************************************************************************/
+static void BuildResponse(uint8_t Query, uint8_t *Frame) {
+	uint16_t X, Y, Theta;
+	uint8_t KartNumber = 0;
+
+	Frame[0] = RESPONSE_BYTE0;
+	Frame[1] = RESPONSE_BYTE1;
+	for (uint8_t i = 2; i < FRAME_LENGTH; i++) Frame[i] = 0x00;
+
+	switch (Query) {
+		case GAME_STATUS_QUERY:
+			Frame[3] = StatusByte(1);
+			Frame[4] = StatusByte(2);
+			Frame[5] = StatusByte(3);
+			return;
+		case KART1_QUERY: KartNumber = 1; break;
+		case KART2_QUERY: KartNumber = 2; break;
+		case KART3_QUERY: KartNumber = 3; break;
+		default:
+			Stats.UnknownQueries++;
+			for (uint8_t i = 0; i < FRAME_LENGTH; i++) Frame[i] = INVALID_BYTE;
+			return;
+	}
+	X = Reported[KartNumber - 1].X;
+	Y = Reported[KartNumber - 1].Y;
+	Theta = Reported[KartNumber - 1].Theta;
+	Frame[2] = X >> 8;
+	Frame[3] = X & 0xFF;
+	Frame[4] = Y >> 8;
+	Frame[5] = Y & 0xFF;
+	Frame[6] = Theta >> 8;
+	Frame[7] = Theta & 0xFF;
+}
+
+/****************************************************************************
+Function:			CorruptFrame
+Parameters:		uint8_t *Frame, the frame to corrupt
+Returns:			void
+Description:	Either blanks the whole frame to 0xFF, as when the DRS misses
+							the query, or flips a single bit in the payload
+****************************************************************************/
+static void CorruptFrame(uint8_t *Frame) {
+	if (Random() % 2) {
+		for (uint8_t i = 0; i < FRAME_LENGTH; i++) Frame[i] = INVALID_BYTE;
+	} else {
+		uint8_t Byte = 2 + Random() % (FRAME_LENGTH - 2);
+		Frame[Byte] ^= 1 << (Random() % 8);
+	}
+}
+
+/****************************************************************************
+Function:			AdvanceRace
+Parameters:		uint32_t ElapsedUS, time since the last step
+Returns:			void
+Description:	Moves the Karts along the track while the flag is dropped
+****************************************************************************/
+static void AdvanceRace(uint32_t ElapsedUS) {
+	if (RaceFlag != Flag_Dropped) return;
+	for (uint8_t i = 0; i < NUM_KARTS; i++) {
+		SimKart_t *Kart = &Karts[i];
+		if (Kart->Driven) continue;
+		if (Kart->Laps == 0) {
+			// Pull over on Straight1 when finished, each Kart in its own spot
+			uint32_t Parking = (uint32_t)(i + 1) * PARKING_SPACING * 1000;
+			if (Kart->Distance < Parking) {
+				uint32_t Step = (uint32_t)Kart->Speed * ElapsedUS / 1000;
+				if (Kart->Distance + Step > Parking) Step = Parking - Kart->Distance;
+				Kart->Distance += Step;
+				Kart->Travelled += Step;
+			}
+			continue;
+		}
+
+		uint32_t Before = Kart->Distance / 1000;
+		// Units/s * us / 1000 = 1/1000 units
+		Kart->Distance += (uint32_t)Kart->Speed * ElapsedUS / 1000;
+		Kart->Travelled += (uint32_t)Kart->Speed * ElapsedUS / 1000;
+		uint32_t After = Kart->Distance / 1000;
+
+		if (Before < TARGET_DISTANCE && After >= TARGET_DISTANCE)
+			Kart->TargetSuccess = true;
+		if (Before < OBSTACLE_DISTANCE && After >= OBSTACLE_DISTANCE)
+			Kart->ObstacleCompleted = true;
+		if (After >= TRACK_LENGTH) {
+			Kart->Distance -= TRACK_LENGTH * 1000;
+			Kart->Laps--;
+		}
+	}
+}
+
+/****************************************************************************
+Function:			StatusByte
+Parameters:		uint8_t KartNumber, 1-3
+Returns:			uint8_t, the game status byte for the Kart
+Description:	Packs the laps, flag, obstacle and target status
+****************************************************************************/
+static uint8_t StatusByte(uint8_t KartNumber) {
+	SimKart_t *Kart = &Karts[KartNumber - 1];
+	// A Kart that has finished its laps sees the race as over
+	Flag_t Flag = (Kart->Laps == 0) ? Flag_Finished : RaceFlag;
+	uint8_t Status = Kart->Laps & LAPS_REMAINING_MASK;
+	Status |= (uint8_t)Flag << FLAG_STATUS_SHIFT;
+	if (Kart->ObstacleCompleted) Status |= OBSTACLE_STATUS_BIT;
+	if (Kart->TargetSuccess) Status |= TARGET_STATUS_BIT;
+	return Status;
+}
+
+/****************************************************************************
+Function:			KartPose
+Parameters:		uint8_t KartNumber, 1-3
+							uint16_t *X, *Y, *Theta, the pose to fill in
+Returns:			void
+Description:	Converts the distance along the track to a field position
+****************************************************************************/
+static void KartPose(uint8_t KartNumber, uint16_t *X, uint16_t *Y, uint16_t *Theta) {
+	if (Karts[KartNumber - 1].Driven) {
+		*X = Karts[KartNumber - 1].Pose.X;
+		*Y = Karts[KartNumber - 1].Pose.Y;
+		*Theta = Karts[KartNumber - 1].Pose.Theta;
+		return;
+	}
+	uint32_t D = Karts[KartNumber - 1].Distance / 1000;
+	uint16_t Lane = LANE_WIDTH * (KartNumber - 1);
+	if (D < TRACK_WIDTH) {
+		// Straight1, heading -X
+		*X = TRACK_RIGHT - D; *Y = TRACK_BOTTOM + Lane; *Theta = 180;
+	} else if ((D -= TRACK_WIDTH) < TRACK_HEIGHT) {
+		// Straight2, heading +Y
+		*X = TRACK_LEFT + Lane; *Y = TRACK_BOTTOM + D; *Theta = 90;
+	} else if ((D -= TRACK_HEIGHT) < TRACK_WIDTH) {
+		// Straight3, heading +X
+		*X = TRACK_LEFT + D; *Y = TRACK_TOP - Lane; *Theta = 0;
+	} else {
+		// Straight4, heading -Y
+		D -= TRACK_WIDTH;
+		*X = TRACK_RIGHT - Lane; *Y = TRACK_TOP - D; *Theta = 270;
+	}
+}
+
+/****************************************************************************
+Function:			SnapshotPoses
+Parameters:		void
+Returns:			void
+Description:	Refreshes the positions the DRS reports
+****************************************************************************/
+static void SnapshotPoses(void) {
+	for (uint8_t KartNumber = 1; KartNumber <= NUM_KARTS; KartNumber++) {
+		SimPose_t *Pose = &Reported[KartNumber - 1];
+		KartPose(KartNumber, &Pose->X, &Pose->Y, &Pose->Theta);
+	}
+}
+
+/****************************************************************************
+Function:			Random
+Parameters:		void
+Returns:			uint32_t, a pseudo random number
+Description:	Small LCG so a run only depends on the configured seed
+****************************************************************************/
+static uint32_t Random(void) {
+	RandomState = RandomState * 1103515245u + 12345u;
+	return RandomState >> 8;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
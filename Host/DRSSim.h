@@ -0,0 +1,61 @@
+/****************************************************************************
+Module: DRSSim.h
+Description:
+	Host-side model of the Dynamic Race System. Stands in for the SSI0
+	registers when the firmware is compiled with HOST_SIM (see HW_Port.h),
+	answers the GAME_STATUS and KARTn queries, and runs a simple race so the
+	DRS.c / SM_DRS polling path can be exercised and load-tested on a PC.
+Author: Kyle Moy, 3/5/15
+****************************************************************************/
+
+#ifndef DRSSim_H
+#define DRSSim_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "DRS.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// Link behavior of the simulated DRS
+typedef struct {
+	uint32_t	LatencyUS;			// Time from the last byte written to the EOT interrupt
+	uint32_t	JitterUS;				// Extra latency, uniformly random from 0 to JitterUS
+	uint8_t		DropPercent;		// Chance that a transfer never raises EOT
+	uint8_t		CorruptPercent;	// Chance that a delivered frame is corrupted
+	uint32_t	Seed;						// Random seed, runs are repeatable for a given seed
+	uint32_t	PoseUpdateUS;		// How often the DRS refreshes the positions it reports
+} DRSSimConfig_t;
+
+// A scripted change of the race flag
+typedef struct {
+	uint32_t	TimeMS;
+	Flag_t		Flag;
+} DRSSimFlagEvent_t;
+
+// Counters for the load test report
+typedef struct {
+	uint32_t	Queries;
+	uint32_t	Delivered;
+	uint32_t	Dropped;
+	uint32_t	Corrupted;
+	uint32_t	Overruns;
+	uint32_t	UnknownQueries;
+} DRSSimStats_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void DRSSim_Init(DRSSimConfig_t Config);
+void DRSSim_SetFlagScript(const DRSSimFlagEvent_t *Script, uint8_t Length);
+void DRSSim_SetKart(uint8_t KartNumber, uint16_t Speed, uint16_t StartDistance, uint8_t Laps);
+void DRSSim_SetKartPose(uint8_t KartNumber, uint16_t X, uint16_t Y, uint16_t Theta);
+void DRSSim_SetKartStatus(uint8_t KartNumber, uint8_t Laps, bool ObstacleCompleted, bool TargetSuccess);
+void DRSSim_Step(uint32_t NowUS);
+uint32_t DRSSim_ReadReg(uint32_t Offset);
+void DRSSim_WriteReg(uint32_t Offset, uint32_t Value);
+void DRSSim_GetTruePose(uint8_t KartNumber, uint16_t *X, uint16_t *Y, uint16_t *Theta);
+uint32_t DRSSim_GetTravelled(uint8_t KartNumber);
+Flag_t DRSSim_GetFlag(void);
+DRSSimStats_t DRSSim_GetStats(void);
+void DRSSim_PrintStats(void);
+
+#endif /* DRSSim_H */
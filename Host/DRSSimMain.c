@@ -0,0 +1,184 @@
+/****************************************************************************
+Module: DRSSimMain.c
+Description:
+	Host load test for the DRS polling path. Runs the real DRS.c and
+	SM_DRS.c on the ES framework against the DRS simulator, with the rest
+	of the services stubbed out, and reports how many frames made it
+	through the link for the configured latency, jitter, drop and
+	corruption rates.
+
+	Build from the project directory on a PC with TivaWare checked out:
+		gcc -std=gnu99 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o drssim \
+			Host/DRSSimMain.c Host/DRSSim.c Host/FaultSim.c Host/HostStubs.c \
+			Source/DRS.c Source/SM_DRS.c Source/CollisionPredictor.c \
+			Source/PoseEstimator.c Source/GamefieldPositions.c Source/ES_Framework.c Source/ES_Queue.c \
+			Source/ES_Timers.c Source/ES_PostList.c Source/ES_LookupTables.c \
+			Source/ES_CheckEvents.c Source/ES_Port.c Source/InputRecorder.c -lm
+
+	Usage:
+		drssim [seconds] [latency us] [jitter us] [drop %] [corrupt %] [seed]
+Author: Kyle Moy, 3/5/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+// Module Libraries
+#include "DRS.h"
+#include "DRSSim.h"
+#include "PoseEstimator.h"
+#include "HostStubs.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// 8 bytes at 66us per bit is about 4.2ms on the wire
+#define DEFAULT_LATENCY_US		4300
+#define DEFAULT_JITTER_US			500
+#define DEFAULT_SECONDS				60
+// The DRS refreshes the positions at 10Hz
+#define POSE_UPDATE_US				100000
+// How often our pose is checked against the truth
+#define POSE_CHECK_US					1000
+// The control interrupt, which samples the odometry
+#define CONTROL_PERIOD_US			1000
+
+/*---------------------------- Module Functions ---------------------------*/
+static void Step(uint32_t NowUS);
+static void CheckPose(void);
+static void Report(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint32_t RunTimeUS;
+static uint32_t NextPoseCheckUS;
+static uint32_t NextControlUS;
+
+// Position error of the raw DRS pose and the estimate while we move
+static uint32_t PoseChecks;
+static float DRSPoseError;
+static float EstimatedPoseError;
+static float EstimatedHeadingError;
+static uint32_t LastTravelled;
+
+// Flag dropped after a second, a caution in the middle of the race
+static const DRSSimFlagEvent_t FlagScript[] = {
+	{1000, Flag_Dropped},
+	{20000, Flag_Caution},
+	{23000, Flag_Dropped}
+};
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	DRSSimConfig_t Config = {DEFAULT_LATENCY_US, DEFAULT_JITTER_US, 0, 0, 1, POSE_UPDATE_US};
+	uint32_t Seconds = DEFAULT_SECONDS;
+
+	if (argc > 1) Seconds = strtoul(argv[1], NULL, 0);
+	if (argc > 2) Config.LatencyUS = strtoul(argv[2], NULL, 0);
+	if (argc > 3) Config.JitterUS = strtoul(argv[3], NULL, 0);
+	if (argc > 4) Config.DropPercent = strtoul(argv[4], NULL, 0);
+	if (argc > 5) Config.CorruptPercent = strtoul(argv[5], NULL, 0);
+	if (argc > 6) Config.Seed = strtoul(argv[6], NULL, 0);
+	RunTimeUS = Seconds * 1000000;
+
+	printf("DRS host simulation: %lu s, latency %lu us, jitter %lu us, drop %d%%, corrupt %d%%, seed %lu\r\n", \
+		(unsigned long)Seconds, (unsigned long)Config.LatencyUS, (unsigned long)Config.JitterUS, \
+		Config.DropPercent, Config.CorruptPercent, (unsigned long)Config.Seed);
+
+	DRSSim_Init(Config);
+	DRSSim_SetFlagScript(FlagScript, sizeof(FlagScript)/sizeof(FlagScript[0]));
+	HostStubs_SetKartNumber(1);
+	InitializeDRS();
+	_HW_SetStepHook(Step);
+
+	// ES_Run only returns on an error, Step ends the run when time is up
+	ES_Return_t ErrorType = ES_Initialize(ES_Timer_RATE_10mS);
+	if (ErrorType == Success) {
+		ErrorType = ES_Run();
+	}
+	printf("Framework error %d\r\n", ErrorType);
+	return 1;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			Step
+Parameters:		uint32_t NowUS, the virtual time
+Returns:			void
+Description:	Host port step hook, runs the simulator and ends the run
+****************************************************************************/
+static void Step(uint32_t NowUS) {
+	DRSSim_Step(NowUS);
+	if (NowUS >= NextControlUS) {
+		NextControlUS += CONTROL_PERIOD_US;
+		UpdateOdometry();
+	}
+	if (NowUS >= NextPoseCheckUS) {
+		NextPoseCheckUS += POSE_CHECK_US;
+		CheckPose();
+	}
+	if (NowUS >= RunTimeUS) {
+		Report();
+		exit(0);
+	}
+}
+
+/****************************************************************************
+Function:			CheckPose
+Parameters:		void
+Returns:			void
+Description:	Compares our raw DRS pose and estimate with the true pose
+****************************************************************************/
+static void CheckPose(void) {
+	uint8_t MyKartNumber = GetMyKartNumber();
+	uint32_t Travelled = DRSSim_GetTravelled(MyKartNumber);
+	bool Moving = (Travelled != LastTravelled);
+	LastTravelled = Travelled;
+	if (!Moving || !HasPoseFix()) return;
+
+	uint16_t X, Y, Theta;
+	DRSSim_GetTruePose(MyKartNumber, &X, &Y, &Theta);
+	Kart_t MyKart = GetMyKart();
+	Pose_t Pose = GetCurrentPose();
+	DRSPoseError += hypotf((float)MyKart.KartX - X, (float)MyKart.KartY - Y);
+	EstimatedPoseError += hypotf(Pose.X - X, Pose.Y - Y);
+	float HeadingError = fabsf(fmodf(Pose.Theta - Theta + 540.0f, 360.0f) - 180.0f);
+	EstimatedHeadingError += HeadingError;
+	PoseChecks++;
+}
+
+/****************************************************************************
+Function:			Report
+Parameters:		void
+Returns:			void
+Description:	Prints the link and event counts for the run
+****************************************************************************/
+static void Report(void) {
+	DRSSimStats_t Stats = DRSSim_GetStats();
+	float Seconds = RunTimeUS / 1000000.0f;
+	printf("\r\n");
+	DRSSim_PrintStats();
+	printf("Frames per second: %.1f sent, %.1f delivered\r\n", \
+		Stats.Queries / Seconds, Stats.Delivered / Seconds);
+	printf("Master SM: %lu E_DRS_UPDATED, %lu posts lost to a full queue\r\n", \
+		(unsigned long)HostStubs_GetMasterEventCount(E_DRS_UPDATED), \
+		(unsigned long)HostStubs_GetMasterPostFailures());
+	PrintDRSLinkStats();
+	if (PoseChecks > 0) {
+		printf("Pose error while moving: DRS %.2f units, estimate %.2f units and %.2f degrees (mean over %lu checks)\r\n", \
+			DRSPoseError / PoseChecks, EstimatedPoseError / PoseChecks, EstimatedHeadingError / PoseChecks, \
+			(unsigned long)PoseChecks);
+	}
+	PrintKartDataTableFormat();
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,141 @@
+/****************************************************************************
+Module: EventLog.c
+Description:
+	Counts, and can trace, every event posted to a service in a host
+	simulation, by wrapping ES_PostToService at link time. Posts made from
+	inside ES_Framework.c itself don't go through the wrap, the firmware's
+	all come through the services' Post functions, which do. A post can be
+	refused here as if the queue were full, for FAULT_QUEUE_FULL.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+// Module Libraries
+#include "EventLog.h"
+#include "FaultSim.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define NUM_EVENTS			(E_BUMP_DETECTED + 1)
+
+/*---------------------------- Module Variables ---------------------------*/
+// Posts to each service by event type
+static uint32_t Posts[NUM_SERVICES][NUM_EVENTS];
+static uint32_t PostFailures;
+static uint32_t PostsRefused;
+static FILE *TraceOut;
+static uint16_t TraceServices;
+
+static const char *EventNames[NUM_EVENTS] = {
+	[ES_NO_EVENT] = "ES_NO_EVENT", [ES_ERROR] = "ES_ERROR",
+	[ES_INIT] = "ES_INIT", [ES_NEW_KEY] = "ES_NEW_KEY", [ES_TIMEOUT] = "ES_TIMEOUT",
+	[ES_ENTRY] = "ES_ENTRY", [ES_ENTRY_HISTORY] = "ES_ENTRY_HISTORY", [ES_EXIT] = "ES_EXIT",
+	[E_RACE_STARTED] = "E_RACE_STARTED", [E_RACE_CAUTION] = "E_RACE_CAUTION",
+	[E_RACE_FINISHED] = "E_RACE_FINISHED",
+	[E_BALL_LAUNCHING_ENTRY] = "E_BALL_LAUNCHING_ENTRY", [E_BALL_LAUNCHING_EXIT] = "E_BALL_LAUNCHING_EXIT",
+	[E_OBSTACLE_CROSSING_ENTRY] = "E_OBSTACLE_CROSSING_ENTRY", [E_OBSTACLE_CROSSING_EXIT] = "E_OBSTACLE_CROSSING_EXIT",
+	[E_CORNER1_ENTRY] = "E_CORNER1_ENTRY", [E_CORNER1_EXIT] = "E_CORNER1_EXIT",
+	[E_CORNER2_ENTRY] = "E_CORNER2_ENTRY", [E_CORNER2_EXIT] = "E_CORNER2_EXIT",
+	[E_CORNER3_ENTRY] = "E_CORNER3_ENTRY", [E_CORNER3_EXIT] = "E_CORNER3_EXIT",
+	[E_CORNER4_ENTRY] = "E_CORNER4_ENTRY", [E_CORNER4_EXIT] = "E_CORNER4_EXIT",
+	[E_BALL_LAUNCHING_COMPLETE] = "E_BALL_LAUNCHING_COMPLETE", [E_TARGET_SUCCESS] = "E_TARGET_SUCCESS",
+	[E_IR_BEACON_DETECTED] = "E_IR_BEACON_DETECTED", [E_IR_BEACON_LOST] = "E_IR_BEACON_LOST",
+	[E_OBSTACLE_COMPLETED] = "E_OBSTACLE_COMPLETED",
+	[E_NEW_DRS_QUERY] = "E_NEW_DRS_QUERY", [E_DRS_EOT] = "E_DRS_EOT",
+	[E_MOTOR_TIMEOUT] = "E_MOTOR_TIMEOUT", [E_MOTOR_SETTLED] = "E_MOTOR_SETTLED",
+	[E_MOTION_SEQUENCE_DONE] = "E_MOTION_SEQUENCE_DONE", [E_PID_AUTOTUNE_DONE] = "E_PID_AUTOTUNE_DONE",
+	[E_FEEDFORWARD_CAL_DONE] = "E_FEEDFORWARD_CAL_DONE", [E_DRS_UPDATED] = "E_DRS_UPDATED",
+	[E_HEADING_REACHED] = "E_HEADING_REACHED",
+	[E_COLLISION_WARNING] = "E_COLLISION_WARNING", [E_COLLISION_CLEARED] = "E_COLLISION_CLEARED",
+	[E_BUMP_DETECTED] = "E_BUMP_DETECTED"
+};
+
+static const char *ServiceNames[] = {"MapKeys", "Master", "DRS", "Display", "DriveMotors"};
+
+
+/*------------------------------ Module Code ------------------------------*/
+// Every post to a service goes through here on its way to the queue
+bool __real_ES_PostToService(uint8_t WhichService, ES_Event TheEvent);
+bool __wrap_ES_PostToService(uint8_t WhichService, ES_Event TheEvent) {
+	if (WhichService < NUM_SERVICES && TheEvent.EventType < NUM_EVENTS) {
+		Posts[WhichService][TheEvent.EventType]++;
+	}
+	if (TraceOut != NULL && WhichService < NUM_SERVICES && (TraceServices & (1 << WhichService))) {
+		fprintf(TraceOut, "%10.1f ms  %-12s %-26s %u\n", _HW_GetMicros() / 1000.0f, \
+			ServiceNames[WhichService], EventLog_Name(TheEvent.EventType), TheEvent.EventParam);
+	}
+	if (FaultSim_InjectPost(WhichService)) {
+		PostsRefused++;
+		return false;
+	}
+	bool Posted = __real_ES_PostToService(WhichService, TheEvent);
+	if (!Posted) PostFailures++;
+	return Posted;
+}
+
+/****************************************************************************
+Function:			EventLog_Name
+Parameters:		ES_EventTyp_t EventType
+Returns:			const char *, its name
+Description:	For the reports
+****************************************************************************/
+const char *EventLog_Name(ES_EventTyp_t EventType) {
+	if (EventType >= NUM_EVENTS || EventNames[EventType] == NULL) return "?";
+	return EventNames[EventType];
+}
+
+/****************************************************************************
+Function:			EventLog_SetTrace
+Parameters:		FILE *Out, where to print each post, NULL for none
+							uint16_t ServiceMask, bit n set traces service n
+Returns:			void
+Description:	Prints the time, service, event and parameter of each post
+****************************************************************************/
+void EventLog_SetTrace(FILE *Out, uint16_t ServiceMask) {
+	TraceOut = Out;
+	TraceServices = ServiceMask;
+}
+
+/****************************************************************************
+Function:			EventLog_GetPosts
+Parameters:		void
+Returns:			uint32_t, all the posts so far, each one a dispatch
+Description:	For the CPU estimate
+****************************************************************************/
+uint32_t EventLog_GetPosts(void) {
+	uint32_t Total = 0;
+	for (uint8_t Service = 0; Service < NUM_SERVICES; Service++) {
+		for (uint8_t Event = 0; Event < NUM_EVENTS; Event++) Total += Posts[Service][Event];
+	}
+	return Total;
+}
+
+/****************************************************************************
+Function:			EventLog_PrintCounts
+Parameters:		void
+Returns:			void
+Description:	The posts to each service by event type, and those lost
+****************************************************************************/
+void EventLog_PrintCounts(void) {
+	printf("Events posted:\r\n");
+	for (uint8_t Service = 0; Service < NUM_SERVICES; Service++) {
+		for (uint8_t Event = 0; Event < NUM_EVENTS; Event++) {
+			if (Posts[Service][Event] == 0) continue;
+			printf("  %-12s %-26s %8lu\r\n", ServiceNames[Service], EventLog_Name(Event), \
+				(unsigned long)Posts[Service][Event]);
+		}
+	}
+	printf("  %lu posts lost to a full queue\r\n", (unsigned long)PostFailures);
+	if (PostsRefused > 0) printf("  %lu posts refused by fault injection\r\n", (unsigned long)PostsRefused);
+}
+
+/*------------------------------ End of file ------------------------------*/
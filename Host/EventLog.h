@@ -0,0 +1,24 @@
+/****************************************************************************
+Module: EventLog.h
+Description:
+	Counts, and can trace, every event posted to a service in a host
+	simulation. Link with -Wl,--wrap=ES_PostToService so the posts go
+	through here on their way to the queues.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+#ifndef EventLog_H
+#define EventLog_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include "ES_Configure.h"
+
+/*----------------------- Public Function Prototypes ----------------------*/
+const char *EventLog_Name(ES_EventTyp_t EventType);
+void EventLog_SetTrace(FILE *Out, uint16_t ServiceMask);
+uint32_t EventLog_GetPosts(void);
+void EventLog_PrintCounts(void);
+
+#endif /* EventLog_H */
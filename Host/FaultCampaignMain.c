@@ -0,0 +1,375 @@
+/****************************************************************************
+Module: FaultCampaignMain.c
+Description:
+	Host fault injection campaign. Races the whole firmware in racesim
+	(RaceSimMain.c) under each of the fault scenarios below, over a number
+	of seeds, and reports which of them cost laps, left the Kart stuck,
+	threw its pose estimate off or ended ES_Run, against the same seeds
+	with no faults. A scenario is one fault, either over the whole race
+	from the flag or in short bursts at random times, the bursts placed
+	afresh for each seed.
+	Each run is racesim itself, forked and exec'd with the faults as
+	FaultSim_Describe writes them, so a run that went wrong can be run
+	again on its own, with the firmware's printing, from the command line
+	in the runs file. The runs go on WorkerPool.c's workers, each reading
+	racesim's report for the laps it did.
+	Every run is written to <prefix>_runs.csv, and a summary of each
+	scenario printed: the runs that finished, finished with the pose
+	estimate drifted, timed out, got stuck, failed or crashed, the share of
+	the laps asked for that were done, and the mean time of the races that
+	finished against the baseline's. The baseline doesn't finish every seed
+	either, so each scenario's finish rate is printed with its spread (one
+	standard error) beside the baseline's, and a fault only costs races
+	where the two are further apart than their spreads. The default seeds
+	keep the baseline's spread near BASELINE_SPREAD_PERCENT, a warning is
+	printed if it's wider.
+
+	Build from the project directory on a Linux PC, racesim as its header
+	says, then:
+		gcc -std=gnu99 -O2 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o faultcampaign \
+			Host/FaultCampaignMain.c Host/WorkerPool.c Host/FaultSim.c -lm
+
+	Usage:
+		faultcampaign <racesim> [seeds] [laps] [workers, 0 for one per core] [output prefix]
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Module Libraries
+#include "FaultSim.h"
+#include "RaceSim.h"
+#include "WorkerPool.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// The baseline finishes about four seeds in five, 64 of them put its finish
+// rate within about 5% either way
+#define DEFAULT_SEEDS					64
+#define BASELINE_SPREAD_PERCENT	5.0f
+#define DEFAULT_LAPS					3
+#define DEFAULT_PREFIX				"faultcampaign"
+#define KART_NUMBER						"1"
+// The flag drops a second in, the faults start from there
+#define FLAG_MS								1000
+// Time limit for the race, a generous lap each and a bit
+#define LIMIT_PER_LAP_S				60
+#define LIMIT_EXTRA_S					30
+// Bursts start anywhere in the time a clean race takes
+#define CLEAN_LAP_MS					50000
+#define REPORT_LENGTH					8192
+#define ARGUMENT_LENGTH				1024
+// Outcomes besides racesim's exit codes
+#define OUTCOME_CRASHED				100
+#define OUTCOME_NOT_RUN				101
+#define NUM_OUTCOMES					7
+
+/*---------------------------- Module Functions ---------------------------*/
+static void RunJob(uint32_t Job);
+static void MakeFaults(uint32_t Job, char *Faults, uint32_t Length);
+static uint32_t Spread(uint32_t *State, uint32_t Range);
+static uint8_t OutcomeIndex(int Outcome);
+static float FinishSpread(uint32_t Finished);
+static bool WriteResults(const char *Prefix);
+
+/*---------------------------- Module Variables ---------------------------*/
+// A scenario, one fault in windows of LengthMS, or the whole race for 0
+typedef struct {
+	const char	*Name;
+	Fault_t			Fault;				// NUM_FAULTS for none
+	uint8_t			Percent;
+	uint32_t		Param;
+	uint32_t		LengthMS;
+	uint8_t			Bursts;
+} Scenario_t;
+
+static const Scenario_t Scenarios[] = {
+	{"baseline",								NUM_FAULTS,						0,		0,			0,		0},
+	{"DRS drop 10%",						FAULT_DRS_DROP,				10,		0,			0,		0},
+	{"DRS drop 30%",						FAULT_DRS_DROP,				30,		0,			0,		0},
+	{"DRS blackout 2s x5",			FAULT_DRS_DROP,				100,	0,			2000,	5},
+	{"DRS corrupt 10%",					FAULT_DRS_CORRUPT,		10,		0,			0,		0},
+	{"DRS corrupt 30%",					FAULT_DRS_CORRUPT,		30,		0,			0,		0},
+	{"right encoder 10%",				FAULT_ENCODER_R,			10,		0,			0,		0},
+	{"left encoder 10%",				FAULT_ENCODER_L,			10,		0,			0,		0},
+	{"right encoder dead 1s x5",FAULT_ENCODER_R,			100,	0,			1000,	5},
+	{"bump stuck 2s x3",				FAULT_BUMP_STUCK,			100,	0,			2000,	3},
+	{"bump chatter 1%",					FAULT_BUMP_STUCK,			1,		0,			0,		0},
+	{"beacon glitch 5%",				FAULT_BEACON_GLITCH,	5,		0,			0,		0},
+	{"beacon glitch 20%",				FAULT_BEACON_GLITCH,	20,		0,			0,		0},
+	{"SysTick 5ms late 10%",		FAULT_SYSTICK_DELAY,	10,		5000,		0,		0},
+	{"SysTick 25ms late 10%",		FAULT_SYSTICK_DELAY,	10,		25000,	0,		0},
+	{"queue full 1%",						FAULT_QUEUE_FULL,			1,		0,			0,		0},
+	{"queue full 100ms x3",			FAULT_QUEUE_FULL,			100,	0,			100,	3},
+};
+#define NUM_SCENARIOS					(sizeof(Scenarios)/sizeof(Scenarios[0]))
+
+static const char *OutcomeNames[NUM_OUTCOMES] = {
+	"finished", "timed out", "stuck", "failed run", "crashed", "not run", "pose drifted"
+};
+
+// What a run did, written by its worker
+typedef struct {
+	bool			Done;
+	int				Outcome;			// racesim's exit code, or OUTCOME_
+	uint8_t		LapsDone;
+	float			RaceS;				// The laps' times added up
+	char			Faults[ARGUMENT_LENGTH];
+} CampaignResult_t;
+
+// Shared between the processes
+static CampaignResult_t *Results;
+static const char *RaceSim;
+static uint32_t Seeds = DEFAULT_SEEDS;
+static uint32_t Laps = DEFAULT_LAPS;
+static uint32_t Jobs;
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	long Workers = 0;
+	const char *Prefix = DEFAULT_PREFIX;
+	if (argc < 2) {
+		printf("Usage: faultcampaign <racesim> [seeds] [laps] [workers] [output prefix]\r\n");
+		return 1;
+	}
+	RaceSim = argv[1];
+	if (argc > 2) Seeds = strtoul(argv[2], NULL, 0);
+	if (argc > 3) Laps = strtoul(argv[3], NULL, 0);
+	if (argc > 4) Workers = strtol(argv[4], NULL, 0);
+	if (argc > 5) Prefix = argv[5];
+	if (Seeds == 0) Seeds = 1;
+	if (Laps < 1 || Laps > RACESIM_MAX_LAPS) Laps = DEFAULT_LAPS;
+	Workers = WorkerPool_Count(Workers);
+	Jobs = NUM_SCENARIOS * Seeds;
+
+	Results = WorkerPool_Share(Jobs * sizeof(CampaignResult_t));
+	if (Results == NULL) return 1;
+	printf("%u fault scenarios over %lu seeds, %lu laps each, %lu races on %ld workers\r\n", \
+		(unsigned)NUM_SCENARIOS, (unsigned long)Seeds, (unsigned long)Laps, (unsigned long)Jobs, Workers);
+	// Each race is racesim's own process already, the workers needn't fork
+	float Seconds = WorkerPool_Run(Jobs, Workers, false, RunJob);
+	if (Seconds < 0) return 1;
+	printf("%lu races in %.1f s\r\n", (unsigned long)Jobs, Seconds);
+	return WriteResults(Prefix) ? 0 : 1;
+}
+
+// FaultSim.c only builds the fault text here, there is no framework
+uint32_t _HW_GetMicros(void) { return 0; }
+uint16_t _HW_GetTickCount(void) { return 0; }
+void _HW_DelayTick(uint32_t DelayUS) {}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			RunJob
+Parameters:		uint32_t Job, the scenario times Seeds plus the seed
+Returns:			void
+Description:	Runs racesim on the job's faults and reads back its report
+****************************************************************************/
+static void RunJob(uint32_t Job) {
+	CampaignResult_t *Result = &Results[Job];
+	char Seed[16], Limit[16], LapsArg[16];
+	snprintf(Seed, sizeof(Seed), "%lu", (unsigned long)(Job % Seeds + 1));
+	snprintf(Limit, sizeof(Limit), "%lu", (unsigned long)(Laps * LIMIT_PER_LAP_S + LIMIT_EXTRA_S));
+	snprintf(LapsArg, sizeof(LapsArg), "%lu", (unsigned long)Laps);
+	MakeFaults(Job, Result->Faults, sizeof(Result->Faults));
+	Result->Outcome = OUTCOME_NOT_RUN;
+
+	int Pipe[2];
+	if (pipe(Pipe) != 0) return;
+	pid_t Pid = fork();
+	if (Pid == 0) {
+		dup2(Pipe[1], STDOUT_FILENO);
+		close(Pipe[0]);
+		close(Pipe[1]);
+		execl(RaceSim, RaceSim, LapsArg, KART_NUMBER, Limit, Seed, "quiet", "-", Result->Faults, (char *)NULL);
+		_exit(127);
+	}
+	close(Pipe[1]);
+	if (Pid < 0) {
+		close(Pipe[0]);
+		return;
+	}
+
+	// The report, only the laps are wanted from it
+	char Report[REPORT_LENGTH];
+	size_t Used = 0;
+	ssize_t Count;
+	while ((Count = read(Pipe[0], Report + Used, sizeof(Report) - 1 - Used)) > 0) {
+		Used += Count;
+		if (Used == sizeof(Report) - 1) {
+			char Discard[256];
+			while (read(Pipe[0], Discard, sizeof(Discard)) > 0)
+				;
+			break;
+		}
+	}
+	Report[Used] = '\0';
+	close(Pipe[0]);
+	int Status;
+	waitpid(Pid, &Status, 0);
+
+	if (WIFEXITED(Status) && WEXITSTATUS(Status) != 127) Result->Outcome = WEXITSTATUS(Status);
+	else if (WIFSIGNALED(Status)) Result->Outcome = OUTCOME_CRASHED;
+	const char *Line = strstr(Report, "Race Sim: Kart ");
+	unsigned Kart, LapsDone, LapsAsked;
+	int Length = 0;
+	if (Line != NULL && sscanf(Line, "Race Sim: Kart %u, %u of %u laps%n", &Kart, &LapsDone, &LapsAsked, &Length) == 3) {
+		Result->LapsDone = LapsDone;
+		const char *Time = Line + Length;
+		for (unsigned Lap = 0; Lap < LapsDone; Lap++) {
+			float LapS;
+			int Size = 0;
+			if (sscanf(Time, "%*[:, ]%f s%n", &LapS, &Size) != 1) break;
+			Result->RaceS += LapS;
+			Time += Size;
+		}
+	}
+	Result->Done = true;
+}
+
+/****************************************************************************
+Function:			MakeFaults
+Parameters:		uint32_t Job
+							char *Faults, uint32_t Length, where to write them
+Returns:			void
+Description:	The job's scenario as FaultSim_Parse reads it, the bursts
+							placed at random for the job's seed
+****************************************************************************/
+static void MakeFaults(uint32_t Job, char *Faults, uint32_t Length) {
+	const Scenario_t *Scenario = &Scenarios[Job / Seeds];
+	uint32_t State = (Job % Seeds + 1) * 2654435761u + Job / Seeds;
+	FaultSim_Init(0);
+	if (Scenario->Fault < NUM_FAULTS && Scenario->LengthMS == 0) {
+		FaultWindow_t Window = {Scenario->Fault, FLAG_MS, \
+			(Laps * LIMIT_PER_LAP_S + LIMIT_EXTRA_S) * 1000, Scenario->Percent, Scenario->Param};
+		FaultSim_AddWindow(Window);
+	}
+	for (uint8_t Burst = 0; Scenario->Fault < NUM_FAULTS && Burst < Scenario->Bursts; Burst++) {
+		FaultWindow_t Window = {Scenario->Fault, FLAG_MS + Spread(&State, Laps * CLEAN_LAP_MS), \
+			Scenario->LengthMS, Scenario->Percent, Scenario->Param};
+		FaultSim_AddWindow(Window);
+	}
+	FaultSim_Describe(Faults, Length);
+}
+
+/****************************************************************************
+Function:			Spread
+Parameters:		uint32_t *State, the generator
+							uint32_t Range
+Returns:			uint32_t, uniformly random from 0 to Range - 1
+Description:	Linear congruential generator, repeatable for a job
+****************************************************************************/
+static uint32_t Spread(uint32_t *State, uint32_t Range) {
+	*State = *State * 1103515245u + 12345u;
+	return (Range > 0) ? (*State >> 8) % Range : 0;
+}
+
+/****************************************************************************
+Function:			OutcomeIndex
+Parameters:		int Outcome, racesim's exit code or OUTCOME_
+Returns:			uint8_t, into OutcomeNames
+Description:	Anything racesim shouldn't exit with counts as a crash
+****************************************************************************/
+static uint8_t OutcomeIndex(int Outcome) {
+	switch (Outcome) {
+		case RACESIM_FINISHED:		return 0;
+		case RACESIM_TIMED_OUT:		return 1;
+		case RACESIM_STUCK:				return 2;
+		case RACESIM_FAILED_RUN:	return 3;
+		case OUTCOME_NOT_RUN:			return 5;
+		case RACESIM_POSE_DRIFTED:	return 6;
+		default:									return 4;
+	}
+}
+
+/****************************************************************************
+Function:			FinishSpread
+Parameters:		uint32_t Finished, of Seeds
+Returns:			float, the finish rate's standard error in percent
+Description:	How far the rate would move with other seeds, from the
+							binomial, at least one seed's worth when all or none finished
+****************************************************************************/
+static float FinishSpread(uint32_t Finished) {
+	float Rate = (float)Finished / Seeds;
+	float Spread = 100.0f * sqrtf(Rate * (1 - Rate) / Seeds);
+	return (Spread > 0) ? Spread : 100.0f / Seeds;
+}
+
+/****************************************************************************
+Function:			WriteResults
+Parameters:		const char *Prefix, for the file name
+Returns:			bool, true if the runs file was written
+Description:	Every run to <Prefix>_runs.csv, with the command to repeat
+							it, and each scenario's summary printed
+****************************************************************************/
+static bool WriteResults(const char *Prefix) {
+	char Name[256];
+	snprintf(Name, sizeof(Name), "%s_runs.csv", Prefix);
+	FILE *Runs = fopen(Name, "w");
+	if (Runs == NULL) {
+		perror(Name);
+		return false;
+	}
+	fprintf(Runs, "scenario,seed,outcome,laps_done,race_s,command\n");
+	for (uint32_t Job = 0; Job < Jobs; Job++) {
+		const CampaignResult_t *Result = &Results[Job];
+		fprintf(Runs, "\"%s\",%lu,%s,%u,%.2f,\"%s %lu %s %lu %lu verbose - %s\"\n", \
+			Scenarios[Job / Seeds].Name, (unsigned long)(Job % Seeds + 1), \
+			OutcomeNames[OutcomeIndex(Result->Outcome)], Result->LapsDone, Result->RaceS, \
+			RaceSim, (unsigned long)Laps, KART_NUMBER, (unsigned long)(Laps * LIMIT_PER_LAP_S + LIMIT_EXTRA_S), \
+			(unsigned long)(Job % Seeds + 1), Result->Faults);
+	}
+	fclose(Runs);
+
+	float BaselineS = 0, BaselineRate = 0, BaselineSpread = 0;
+	printf("%-26s %8s %6s %6s %6s %6s %6s %6s %6s %11s %11s %9s %8s\r\n", "Scenario", "finished", "drift", \
+		"timed", "stuck", "failed", "crash", "laps", "done", "finish %", "base %", "race s", "vs base");
+	for (uint32_t Scenario = 0; Scenario < NUM_SCENARIOS; Scenario++) {
+		uint32_t Outcomes[NUM_OUTCOMES] = {0};
+		uint32_t LapsDone = 0;
+		float RaceS = 0;
+		for (uint32_t Seed = 0; Seed < Seeds; Seed++) {
+			const CampaignResult_t *Result = &Results[Scenario * Seeds + Seed];
+			Outcomes[OutcomeIndex(Result->Outcome)]++;
+			LapsDone += Result->LapsDone;
+			if (Result->Outcome == RACESIM_FINISHED) RaceS += Result->RaceS;
+		}
+		if (Outcomes[0] > 0) RaceS /= Outcomes[0];
+		float Rate = 100.0f * Outcomes[0] / Seeds;
+		float RateSpread = FinishSpread(Outcomes[0]);
+		if (Scenario == 0) {
+			BaselineS = RaceS;
+			BaselineRate = Rate;
+			BaselineSpread = RateSpread;
+		}
+		// A fault that costs races beyond the two spreads is marked
+		bool Costly = (Scenario > 0) && (BaselineRate - Rate > BaselineSpread + RateSpread);
+		printf("%-26s %8lu %6lu %6lu %6lu %6lu %6lu %6lu %5.0f%% %4.0f%% +-%3.0f %4.0f%% +-%3.0f %9.1f", \
+			Scenarios[Scenario].Name, (unsigned long)Outcomes[0], (unsigned long)Outcomes[6], \
+			(unsigned long)Outcomes[1], (unsigned long)Outcomes[2], (unsigned long)Outcomes[3], \
+			(unsigned long)(Outcomes[4] + Outcomes[5]), (unsigned long)LapsDone, \
+			100.0f * LapsDone / (Laps * Seeds), Rate, RateSpread, BaselineRate, BaselineSpread, RaceS);
+		if (Outcomes[0] > 0 && BaselineS > 0) printf(" %+7.1f%%", (RaceS / BaselineS - 1) * 100);
+		else printf(" %8s", "");
+		printf("%s\r\n", Costly ? " *" : "");
+	}
+	if (BaselineSpread > BASELINE_SPREAD_PERCENT) {
+		printf("The baseline's finish rate is only good to %.0f%% either way, run more seeds\r\n", \
+			BaselineSpread);
+	}
+	printf("* finishes fewer races than the baseline, beyond the spreads\r\n");
+	printf("Wrote %s_runs.csv, each run with its racesim command\r\n", Prefix);
+	return true;
+}
+
+/*------------------------------ End of file ------------------------------*/
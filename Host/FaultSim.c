@@ -0,0 +1,245 @@
+/****************************************************************************
+Module: FaultSim.c
+Description:
+	Fault injection for the host simulations. The schedule is a list of
+	windows, each a fault, when it starts and how long it lasts, and the
+	percent of the fault's chances it takes. They are added one at a time
+	or parsed from the same text FaultSim_Describe writes, which is how
+	FaultCampaignMain.c hands them to racesim:
+		name@start ms+length ms:percent[:param],...
+	e.g. drs_drop@20000+5000:50,systick_delay@0+180000:10:25000
+	The faults are taken where the hardware would go wrong, by the
+	simulators that stand in for it: DRSSim.c for the DRS link, MotorSim.c
+	for the encoders, RaceSim.c for the bump switch and the IR beacon,
+	EventLog.c for the posts, and FaultSim_Step, from the step hook, holds
+	SysTick off through the host port. The random numbers are FaultSim's
+	own, and only drawn inside a window, so without one a run is the same
+	as without fault injection.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Framework Libraries
+#include "ES_Port.h"
+
+// Module Libraries
+#include "FaultSim.h"
+
+/*---------------------------- Module Functions ---------------------------*/
+static const FaultWindow_t *ActiveWindow(Fault_t Fault);
+static bool Roll(const FaultWindow_t *Window);
+static uint32_t Random(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static FaultWindow_t Windows[FAULTSIM_MAX_WINDOWS];
+static uint8_t NumWindows;
+static uint32_t Injected[NUM_FAULTS];
+static uint32_t RandomState;
+static uint16_t LastTickCount;
+
+static const char *FaultNames[NUM_FAULTS] = {
+	[FAULT_DRS_DROP] = "drs_drop", [FAULT_DRS_CORRUPT] = "drs_corrupt",
+	[FAULT_ENCODER_R] = "encoder_r", [FAULT_ENCODER_L] = "encoder_l",
+	[FAULT_BUMP_STUCK] = "bump_stuck", [FAULT_BEACON_GLITCH] = "beacon_glitch",
+	[FAULT_SYSTICK_DELAY] = "systick_delay", [FAULT_QUEUE_FULL] = "queue_full"
+};
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			FaultSim_Init
+Parameters:		uint32_t Seed, runs are repeatable for a given seed
+Returns:			void
+Description:	Clears the schedule and the counts
+****************************************************************************/
+void FaultSim_Init(uint32_t Seed) {
+	NumWindows = 0;
+	memset(Injected, 0, sizeof(Injected));
+	RandomState = Seed;
+	LastTickCount = 0;
+}
+
+/****************************************************************************
+Function:			FaultSim_AddWindow
+Parameters:		FaultWindow_t Window
+Returns:			bool, false if the schedule is full
+Description:	Schedules a window of a fault
+****************************************************************************/
+bool FaultSim_AddWindow(FaultWindow_t Window) {
+	if (NumWindows >= FAULTSIM_MAX_WINDOWS || Window.Fault >= NUM_FAULTS) return false;
+	Windows[NumWindows++] = Window;
+	return true;
+}
+
+/****************************************************************************
+Function:			FaultSim_Parse
+Parameters:		const char *Spec, windows as FaultSim_Describe writes them
+Returns:			bool, false if a window didn't parse, those before it are
+							scheduled
+Description:	Schedules the windows in Spec, see the top of the file
+****************************************************************************/
+bool FaultSim_Parse(const char *Spec) {
+	if (strcmp(Spec, "none") == 0) return true;
+	while (*Spec != '\0') {
+		char Name[32];
+		unsigned long Start, Length, Percent, Param = 0;
+		int Used = 0;
+		if (sscanf(Spec, "%31[a-z_]@%lu+%lu:%lu%n", Name, &Start, &Length, &Percent, &Used) != 4) return false;
+		Spec += Used;
+		if (*Spec == ':') {
+			if (sscanf(Spec, ":%lu%n", &Param, &Used) != 1) return false;
+			Spec += Used;
+		}
+		Fault_t Fault = NUM_FAULTS;
+		for (uint8_t i = 0; i < NUM_FAULTS; i++) {
+			if (strcmp(Name, FaultNames[i]) == 0) Fault = (Fault_t)i;
+		}
+		FaultWindow_t Window = {Fault, Start, Length, (Percent > 100) ? 100 : Percent, Param};
+		if (!FaultSim_AddWindow(Window)) return false;
+		if (*Spec == ',') Spec++;
+		else if (*Spec != '\0') return false;
+	}
+	return true;
+}
+
+/****************************************************************************
+Function:			FaultSim_Inject
+Parameters:		Fault_t Fault
+Returns:			bool, true to go wrong this time
+Description:	Asked by the simulators at each of the fault's chances
+****************************************************************************/
+bool FaultSim_Inject(Fault_t Fault) {
+	return Roll(ActiveWindow(Fault));
+}
+
+/****************************************************************************
+Function:			FaultSim_InjectPost
+Parameters:		uint8_t Service, the post's service
+Returns:			bool, true to refuse the post
+Description:	FAULT_QUEUE_FULL, for the services in the window's mask
+****************************************************************************/
+bool FaultSim_InjectPost(uint8_t Service) {
+	const FaultWindow_t *Window = ActiveWindow(FAULT_QUEUE_FULL);
+	if (Window == NULL || (Window->Param != 0 && !(Window->Param & (1u << Service)))) return false;
+	return Roll(Window);
+}
+
+/****************************************************************************
+Function:			FaultSim_Step
+Parameters:		uint32_t NowUS, the virtual time
+Returns:			void
+Description:	Call from the step hook. Holds off the tick after one that
+							just happened, for FAULT_SYSTICK_DELAY.
+****************************************************************************/
+void FaultSim_Step(uint32_t NowUS) {
+	uint16_t TickCount = _HW_GetTickCount();
+	if (TickCount == LastTickCount) return;
+	LastTickCount = TickCount;
+	const FaultWindow_t *Window = ActiveWindow(FAULT_SYSTICK_DELAY);
+	if (Roll(Window)) _HW_DelayTick(Window->Param);
+}
+
+/****************************************************************************
+Function:			FaultSim_GetCount
+Parameters:		Fault_t Fault
+Returns:			uint32_t, times it was injected
+Description:	For the reports
+****************************************************************************/
+uint32_t FaultSim_GetCount(Fault_t Fault) {
+	return (Fault < NUM_FAULTS) ? Injected[Fault] : 0;
+}
+
+/****************************************************************************
+Function:			FaultSim_Name
+Parameters:		Fault_t Fault
+Returns:			const char *, as FaultSim_Parse reads it
+Description:	For the reports
+****************************************************************************/
+const char *FaultSim_Name(Fault_t Fault) {
+	return (Fault < NUM_FAULTS) ? FaultNames[Fault] : "?";
+}
+
+/****************************************************************************
+Function:			FaultSim_Describe
+Parameters:		char *Out, uint32_t Length, where to write it
+Returns:			void
+Description:	The schedule, as FaultSim_Parse reads it, "none" if empty
+****************************************************************************/
+void FaultSim_Describe(char *Out, uint32_t Length) {
+	uint32_t Used = snprintf(Out, Length, "%s", (NumWindows == 0) ? "none" : "");
+	for (uint8_t i = 0; i < NumWindows && Used < Length; i++) {
+		const FaultWindow_t *Window = &Windows[i];
+		Used += snprintf(Out + Used, Length - Used, "%s%s@%lu+%lu:%u", (i > 0) ? "," : "", \
+			FaultNames[Window->Fault], (unsigned long)Window->StartMS, (unsigned long)Window->LengthMS, \
+			Window->Percent);
+		if (Window->Param != 0 && Used < Length) {
+			Used += snprintf(Out + Used, Length - Used, ":%lu", (unsigned long)Window->Param);
+		}
+	}
+}
+
+/****************************************************************************
+Function:			FaultSim_PrintStats
+Parameters:		void
+Returns:			void
+Description:	How many of each fault went in
+****************************************************************************/
+void FaultSim_PrintStats(void) {
+	if (NumWindows == 0) return;
+	printf("Faults injected:");
+	for (uint8_t Fault = 0; Fault < NUM_FAULTS; Fault++) {
+		if (Injected[Fault] > 0) printf(" %s %lu", FaultNames[Fault], (unsigned long)Injected[Fault]);
+	}
+	printf("\r\n");
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ActiveWindow
+Parameters:		Fault_t Fault
+Returns:			const FaultWindow_t *, the first of its windows open now,
+							NULL if none is
+Description:	Looks up the schedule at the virtual time
+****************************************************************************/
+static const FaultWindow_t *ActiveWindow(Fault_t Fault) {
+	uint32_t NowMS = _HW_GetMicros() / 1000;
+	for (uint8_t i = 0; i < NumWindows; i++) {
+		if (Windows[i].Fault == Fault && NowMS >= Windows[i].StartMS && \
+			NowMS - Windows[i].StartMS < Windows[i].LengthMS) return &Windows[i];
+	}
+	return NULL;
+}
+
+/****************************************************************************
+Function:			Roll
+Parameters:		const FaultWindow_t *Window, NULL for none open
+Returns:			bool, true at the window's percent
+Description:	Takes a chance, and counts the fault if it goes in
+****************************************************************************/
+static bool Roll(const FaultWindow_t *Window) {
+	if (Window == NULL || Window->Percent == 0) return false;
+	if (Window->Percent < 100 && (Random() % 100) >= Window->Percent) return false;
+	Injected[Window->Fault]++;
+	return true;
+}
+
+/****************************************************************************
+Function:			Random
+Parameters:		void
+Returns:			uint32_t, 24 random bits
+Description:	Linear congruential generator, as DRSSim.c's
+****************************************************************************/
+static uint32_t Random(void) {
+	RandomState = RandomState * 1103515245u + 12345u;
+	return RandomState >> 8;
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,58 @@
+/****************************************************************************
+Module: FaultSim.h
+Description:
+	Fault injection for the host simulations. Faults are scheduled in
+	windows of virtual time, and inside its window each chance the fault
+	has (a DRS frame, an encoder edge, a post...) is taken at the window's
+	percent. The simulators ask FaultSim_Inject at each chance, with no
+	windows scheduled nothing is injected and the runs are as before.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+#ifndef FaultSim_H
+#define FaultSim_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define FAULTSIM_MAX_WINDOWS	32
+
+// The faults, and each one's chances
+typedef enum {
+	FAULT_DRS_DROP = 0,			// A DRS transfer never raises EOT, per transfer
+	FAULT_DRS_CORRUPT,			// A DRS frame comes back corrupted, per frame
+	FAULT_ENCODER_R,				// A right encoder edge isn't captured, per edge
+	FAULT_ENCODER_L,				// A left encoder edge isn't captured, per edge
+	FAULT_BUMP_STUCK,				// The bump switch reads pressed, per read
+	FAULT_BEACON_GLITCH,		// The IR sensor misses a beacon edge it sees or
+													// captures one it doesn't, per edge period
+	FAULT_SYSTICK_DELAY,		// The next SysTick is held off Param us, per tick
+	FAULT_QUEUE_FULL,				// A post is refused as if the queue were full,
+													// per post to the services in Param's mask, 0 all
+	NUM_FAULTS
+} Fault_t;
+
+// A window of a fault
+typedef struct {
+	Fault_t		Fault;
+	uint32_t	StartMS;
+	uint32_t	LengthMS;
+	uint8_t		Percent;			// Chance of each of its chances in the window
+	uint32_t	Param;				// FAULT_SYSTICK_DELAY and FAULT_QUEUE_FULL
+} FaultWindow_t;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void FaultSim_Init(uint32_t Seed);
+bool FaultSim_AddWindow(FaultWindow_t Window);
+bool FaultSim_Parse(const char *Spec);
+bool FaultSim_Inject(Fault_t Fault);
+bool FaultSim_InjectPost(uint8_t Service);
+void FaultSim_Step(uint32_t NowUS);
+uint32_t FaultSim_GetCount(Fault_t Fault);
+const char *FaultSim_Name(Fault_t Fault);
+void FaultSim_Describe(char *Out, uint32_t Length);
+void FaultSim_PrintStats(void);
+
+#endif /* FaultSim_H */
@@ -0,0 +1,210 @@
+/****************************************************************************
+Module: HeadingCompareMain.c
+Description:
+	Host comparison of SM_Navigation's ORIENTING turns, the old fixed speed
+	rotate stopped by the DRS heading against the heading controller
+	(HeadingController.c). The Kart's wheels follow their RPM targets as a
+	first order lag, the closed speed loop, and coast down when stopped.
+	The old turn checks the heading on every E_DRS_UPDATED, a DRS frame
+	stale by its latency. The heading controller runs off the pose
+	estimate, taken as the true heading to within a degree, and the
+	encoder yaw rate from the wheel speeds. Headings are the DRS's, growing
+	clockwise, as are the wheel RPM and the turns.
+	This is the controller against a model of itself, racesim runs it in
+	the corners of a race and reports how close the turns end.
+
+	Build from the project directory on a PC:
+		gcc -std=gnu99 -O2 -IHeaders -o headingcompare Host/HeadingCompareMain.c \
+			Source/HeadingController.c -lm
+
+	Usage:
+		headingcompare [old rotate RPM] [tolerance degrees] [Kart coast ms]
+	The coast time constant is the Kart's, try it away from HEADING_COAST_MS
+	to see what a wrong one costs.
+Author: Kyle Moy, 3/13/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Module Libraries
+#include "HeadingController.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define DEFAULT_OLD_RPM				60
+#define DEFAULT_TOLERANCE			5
+// Old ORIENTING stopped within this of the target
+#define OLD_TOLERANCE					15
+
+// Kart, degrees/s of yaw for both wheels at 1 RPM the opposite ways
+#define DEG_PER_S_PER_RPM			2.82f
+// Closed loop wheel speed and coasting time constants
+#define KART_WHEEL_MS					70.0f
+#define DEFAULT_KART_COAST_MS	90.0f
+
+// DRS frames of our Kart, how often and how stale
+#define DRS_PERIOD_MS					60
+#define DRS_LATENCY_MS				50
+// Heading loop period
+#define HEADING_PERIOD_MS			20
+#define TIME_LIMIT_MS					3000
+// Time to let the Kart come to rest after the turn ends
+#define REST_MS								500
+#define HISTORY_MS						128
+
+/*---------------------------- Module Functions ---------------------------*/
+static void ResetKart(void);
+static void StepKart(float TargetRPM, bool Coasting);
+static void RunOldTurn(float Turn, int32_t RPM, uint32_t *TimeMS, float *Error);
+static void RunHeadingTurn(float Turn, float Tolerance, uint32_t *TimeMS, float *Error, bool *TimedOut);
+
+/*---------------------------- Module Variables ---------------------------*/
+// Heading in degrees, unwrapped, and the wheel speed in RPM (+ for clockwise)
+static float Theta;
+static float WheelRPM;
+// Heading at each ms, for the stale DRS
+static float History[HISTORY_MS];
+static uint32_t Now;
+static float KartCoastMS = DEFAULT_KART_COAST_MS;
+
+// Turns between corners, degrees, + for clockwise
+static const float Turns[] = {90, -90, 45, -135, 180, 20, -10};
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	int32_t OldRPM = DEFAULT_OLD_RPM;
+	float Tolerance = DEFAULT_TOLERANCE;
+	if (argc > 1) OldRPM = strtol(argv[1], NULL, 0);
+	if (argc > 2) Tolerance = strtof(argv[2], NULL);
+	if (argc > 3) KartCoastMS = strtof(argv[3], NULL);
+
+	printf("Turn     old %ld RPM, %d deg          PD, %.0f deg\r\n", (long)OldRPM, OLD_TOLERANCE, Tolerance);
+	uint32_t SumOld = 0, SumNew = 0;
+	float WorstOld = 0, WorstNew = 0;
+	for (uint8_t n = 0; n < sizeof(Turns)/sizeof(Turns[0]); n++) {
+		uint32_t OldMS, NewMS;
+		float OldError, NewError;
+		bool TimedOut;
+		RunOldTurn(Turns[n], OldRPM, &OldMS, &OldError);
+		RunHeadingTurn(Turns[n], Tolerance, &NewMS, &NewError, &TimedOut);
+		printf("%5.0f    %5lu ms, error %6.1f deg   %5lu ms, error %6.1f deg%s\r\n", Turns[n], \
+			(unsigned long)OldMS, OldError, (unsigned long)NewMS, NewError, TimedOut ? " (timed out)" : "");
+		SumOld += OldMS;
+		SumNew += NewMS;
+		if (fabsf(OldError) > WorstOld) WorstOld = fabsf(OldError);
+		if (fabsf(NewError) > WorstNew) WorstNew = fabsf(NewError);
+	}
+	printf("Total    %5lu ms, worst %5.1f deg    %5lu ms, worst %5.1f deg\r\n", \
+		(unsigned long)SumOld, WorstOld, (unsigned long)SumNew, WorstNew);
+	return 0;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ResetKart
+Parameters:		void
+Returns:			void
+Description:	Stops the Kart at heading 0
+****************************************************************************/
+static void ResetKart(void) {
+	Theta = 0;
+	WheelRPM = 0;
+	Now = 0;
+	for (uint16_t i = 0; i < HISTORY_MS; i++) History[i] = 0;
+}
+
+/****************************************************************************
+Function:			StepKart
+Parameters:		float TargetRPM, the wheel target, + for clockwise
+							bool Coasting, true with the motors off
+Returns:			void
+Description:	Moves the Kart on 1ms
+****************************************************************************/
+static void StepKart(float TargetRPM, bool Coasting) {
+	if (Coasting) {
+		WheelRPM -= WheelRPM / KartCoastMS;
+	} else {
+		// The speed loop can't brake, slowing down is coasting
+		float TimeConstant = (fabsf(TargetRPM) < fabsf(WheelRPM) && TargetRPM * WheelRPM >= 0) ? \
+			KartCoastMS : KART_WHEEL_MS;
+		WheelRPM += (TargetRPM - WheelRPM) / TimeConstant;
+	}
+	Theta += WheelRPM * DEG_PER_S_PER_RPM / 1000;
+	Now++;
+	History[Now % HISTORY_MS] = Theta;
+}
+
+/****************************************************************************
+Function:			RunOldTurn
+Parameters:		float Turn, degrees to turn, + for clockwise
+							int32_t RPM, the rotate speed
+							uint32_t *TimeMS, set to when the motors were stopped
+							float *Error, set to the error once the Kart is at rest
+Returns:			void
+Description:	Rotates at RPM until a DRS heading is within OLD_TOLERANCE
+****************************************************************************/
+static void RunOldTurn(float Turn, int32_t RPM, uint32_t *TimeMS, float *Error) {
+	ResetKart();
+	float Target = (Turn > 0) ? RPM : -RPM;
+	bool Stopped = false;
+	*TimeMS = TIME_LIMIT_MS;
+	while (Now < TIME_LIMIT_MS + REST_MS) {
+		if (!Stopped && Now % DRS_PERIOD_MS == 0 && Now >= DRS_LATENCY_MS) {
+			// The DRS reports whole degrees
+			float Seen = roundf(History[(Now - DRS_LATENCY_MS) % HISTORY_MS]);
+			if (fabsf(GetHeadingError(Turn, Seen)) < OLD_TOLERANCE) {
+				Stopped = true;
+				*TimeMS = Now;
+			}
+		}
+		if (Stopped && Now >= *TimeMS + REST_MS) break;
+		StepKart(Stopped ? 0 : Target, Stopped);
+	}
+	*Error = GetHeadingError(Turn, Theta);
+}
+
+/****************************************************************************
+Function:			RunHeadingTurn
+Parameters:		float Turn, degrees to turn, + for clockwise
+							float Tolerance, the controller's tolerance
+							uint32_t *TimeMS, set to when the turn ended
+							float *Error, set to the error once the Kart is at rest
+							bool *TimedOut, set if the turn hit its time limit
+Returns:			void
+Description:	Runs the heading controller every HEADING_PERIOD_MS
+****************************************************************************/
+static void RunHeadingTurn(float Turn, float Tolerance, uint32_t *TimeMS, float *Error, bool *TimedOut) {
+	HeadingController_t Heading;
+	ResetKart();
+	StartHeadingController(&Heading, fmodf(Turn + 360, 360), Tolerance, TIME_LIMIT_MS);
+	int16_t TurnRPM = 0;
+	bool Stopped = false;
+	*TimedOut = false;
+	*TimeMS = TIME_LIMIT_MS;
+	while (true) {
+		if (!Stopped && Now % HEADING_PERIOD_MS == 0) {
+			// The pose estimate is good to about a degree, the yaw rate is
+			// the wheel speeds', as GetYawRate works it out
+			float Pose = fmodf(Theta + 360 + ((int32_t)(Now / HEADING_PERIOD_MS % 3) - 1) * 0.5f, 360);
+			float YawRate = WheelRPM * DEG_PER_S_PER_RPM;
+			HeadingResult_t Result = UpdateHeadingController(&Heading, Pose, YawRate, HEADING_PERIOD_MS, &TurnRPM);
+			if (Result != HEADING_TURNING) {
+				Stopped = true;
+				*TimeMS = Now;
+				*TimedOut = (Result == HEADING_TIMED_OUT);
+			}
+		}
+		if (Stopped && Now >= *TimeMS + REST_MS) break;
+		StepKart(TurnRPM, Stopped || TurnRPM == 0);
+	}
+	*Error = GetHeadingError(Turn, Theta);
+}
+
+/*------------------------------ End of file ------------------------------*/
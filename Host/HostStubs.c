@@ -0,0 +1,190 @@
+/****************************************************************************
+Module: HostStubs.c
+Description:
+	Stand-ins for the services, event checkers and hardware modules that
+	are not part of a host simulation. The ES_Configure.h service list is
+	shared with the firmware, so every service still needs an Init, Run and
+	Post function. The Master SM stand-in counts the events it is sent so
+	the simulation can report on them.
+Author: Kyle Moy, 3/5/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <math.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+
+// Module Libraries
+#include "HostStubs.h"
+#include "MapKeys.h"
+#include "SM_Master.h"
+#include "Display.h"
+#include "DriveMotorsService.h"
+#include "EventCheckers.h"
+#include "KartSwitchAndLED.h"
+#include "DriveMotorEncoder.h"
+#include "FieldCalibration.h"
+#include "DRSSim.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define MAX_EVENT_TYPES		64
+
+// Encoder model, same geometry as PoseEstimator.c
+#define MM_PER_TICK				(3.141592f * 94 / 28)
+#define MM_PER_DRS_UNIT		8.0f
+#define WHEEL_BASE_MM			200.0f
+// The right tire reads a little long, like a worn or softer one, so the
+// odometry drifts the way it does on the real Kart
+#define ENCODER_SCALE_L		1.00f
+#define ENCODER_SCALE_R		1.02f
+
+/*---------------------------- Module Functions ---------------------------*/
+static void UpdateEncoders(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t MapKeysPriority;
+static uint8_t MasterPriority;
+static uint8_t DisplayPriority;
+static uint8_t DriveMotorsPriority;
+
+static uint32_t MasterEventCounts[MAX_EVENT_TYPES];
+static uint32_t MasterPostFailures;
+static uint8_t HostKartNumber = 1;
+
+// Simulated wheel travel in ticks, and the true pose it was last updated to
+static bool EncodersStarted = false;
+static float EncoderL, EncoderR;
+static uint32_t EncoderTravelled;
+static uint16_t EncoderTheta;
+
+
+/*------------------------------ Module Code ------------------------------*/
+// MapKeys, no keyboard on the host
+bool InitMapKeys(uint8_t Priority) { MapKeysPriority = Priority; return true; }
+bool PostMapKeys(ES_Event ThisEvent) { return ES_PostToService(MapKeysPriority, ThisEvent); }
+ES_Event RunMapKeys(ES_Event ThisEvent) { ES_Event ReturnEvent = {ES_NO_EVENT}; return ReturnEvent; }
+
+// Master SM, counts the events it receives
+bool InitMasterSM(uint8_t Priority) { MasterPriority = Priority; return true; }
+
+bool PostMasterSM(ES_Event ThisEvent) {
+	if (!ES_PostToService(MasterPriority, ThisEvent)) {
+		MasterPostFailures++;
+		return false;
+	}
+	return true;
+}
+
+ES_Event RunMasterSM(ES_Event ThisEvent) {
+	ES_Event ReturnEvent = {ES_NO_EVENT};
+	if (ThisEvent.EventType < MAX_EVENT_TYPES) MasterEventCounts[ThisEvent.EventType]++;
+	switch (ThisEvent.EventType) {
+		case E_RACE_STARTED: printf("(HOST) E_RACE_STARTED\r\n"); break;
+		case E_RACE_CAUTION: printf("(HOST) E_RACE_CAUTION\r\n"); break;
+		case E_RACE_FINISHED: printf("(HOST) E_RACE_FINISHED\r\n"); break;
+		case E_OBSTACLE_COMPLETED: printf("(HOST) E_OBSTACLE_COMPLETED\r\n"); break;
+		case E_TARGET_SUCCESS: printf("(HOST) E_TARGET_SUCCESS\r\n"); break;
+		default: break;
+	}
+	return ReturnEvent;
+}
+
+// Display, the firmware display service drives the console on the Tiva
+bool InitDisplay(uint8_t Priority) { DisplayPriority = Priority; return true; }
+bool PostDisplay(ES_Event ThisEvent) { return ES_PostToService(DisplayPriority, ThisEvent); }
+ES_Event RunDisplay(ES_Event ThisEvent) { ES_Event ReturnEvent = {ES_NO_EVENT}; return ReturnEvent; }
+
+// Drive motors, no motors on the host
+bool InitDriveMotorsService(uint8_t Priority) { DriveMotorsPriority = Priority; return true; }
+bool PostDriveMotorsService(ES_Event ThisEvent) { return ES_PostToService(DriveMotorsPriority, ThisEvent); }
+ES_Event RunDriveMotorsService(ES_Event ThisEvent) { ES_Event ReturnEvent = {ES_NO_EVENT}; return ReturnEvent; }
+
+// Event checkers, nothing to check on the host
+bool Check4Keystroke(void) { return false; }
+bool CheckBumpSensor(void) { return false; }
+bool CheckIRSensor(void) { return false; }
+
+// Kart switch
+uint8_t ReadKartSwitch(void) { return HostKartNumber; }
+
+// Field calibration, the zones stay on the default bounds
+void RecordFieldCalibrationPose(uint16_t X, uint16_t Y) {}
+
+// Encoders, the wheels follow our simulated Kart along the track
+int32_t GetOdometerL(void) { UpdateEncoders(); return (int32_t)floorf(EncoderL); }
+int32_t GetOdometerR(void) { UpdateEncoders(); return (int32_t)floorf(EncoderR); }
+// Wheel speeds, only GetYawRate reads them and nothing here turns on the spot
+int32_t GetVelocityL(void) { return 0; }
+int32_t GetVelocityR(void) { return 0; }
+
+/****************************************************************************
+Function:			HostStubs_SetKartNumber
+Parameters:		uint8_t KartNumber, the Kart the switch reports (1-3)
+Returns:			void
+Description:	Selects which Kart we are, call before InitializeDRS
+****************************************************************************/
+void HostStubs_SetKartNumber(uint8_t KartNumber) {
+	HostKartNumber = KartNumber;
+}
+
+/****************************************************************************
+Function:			HostStubs_GetMasterEventCount
+Parameters:		ES_EventTyp_t EventType
+Returns:			uint32_t, how many of this event the Master SM has run
+Description:	Returns the event count for the simulation report
+****************************************************************************/
+uint32_t HostStubs_GetMasterEventCount(ES_EventTyp_t EventType) {
+	return (EventType < MAX_EVENT_TYPES) ? MasterEventCounts[EventType] : 0;
+}
+
+/****************************************************************************
+Function:			HostStubs_GetMasterPostFailures
+Parameters:		void
+Returns:			uint32_t, how many posts to the Master SM found its queue full
+Description:	Returns the queue overflow count for the simulation report
+****************************************************************************/
+uint32_t HostStubs_GetMasterPostFailures(void) {
+	return MasterPostFailures;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			UpdateEncoders
+Parameters:		void
+Returns:			void
+Description:	Turns the distance and heading change of our simulated Kart
+							since the last call into wheel travel. The corners of the
+							simulated track are a pivot on the spot, the wheels turn
+							opposite ways by half the wheel base times the turn. Theta
+							grows clockwise, as the DRS has it, so the left wheel leads.
+****************************************************************************/
+static void UpdateEncoders(void) {
+	uint16_t X, Y, Theta;
+	uint32_t Travelled = DRSSim_GetTravelled(HostKartNumber);
+	DRSSim_GetTruePose(HostKartNumber, &X, &Y, &Theta);
+	if (!EncodersStarted) {
+		EncodersStarted = true;
+		EncoderTravelled = Travelled;
+		EncoderTheta = Theta;
+		return;
+	}
+
+	float Distance = (Travelled - EncoderTravelled) / 1000.0f * MM_PER_DRS_UNIT;
+	int16_t Turn = (int16_t)Theta - (int16_t)EncoderTheta;
+	if (Turn > 180) Turn -= 360;
+	if (Turn < -180) Turn += 360;
+	float Sweep = (WHEEL_BASE_MM / 2) * Turn * 3.141592f / 180;
+	EncoderL += (Distance + Sweep) * ENCODER_SCALE_L / MM_PER_TICK;
+	EncoderR += (Distance - Sweep) * ENCODER_SCALE_R / MM_PER_TICK;
+	EncoderTravelled = Travelled;
+	EncoderTheta = Theta;
+}
+
+/*------------------------------ End of file ------------------------------*/
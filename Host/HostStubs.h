@@ -0,0 +1,21 @@
+/****************************************************************************
+Module: HostStubs.h
+Description:
+	Stand-ins for the services, event checkers and hardware modules that
+	are not part of a host simulation.
+Author: Kyle Moy, 3/5/15
+****************************************************************************/
+
+#ifndef HostStubs_H
+#define HostStubs_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include "ES_Configure.h"
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void HostStubs_SetKartNumber(uint8_t KartNumber);
+uint32_t HostStubs_GetMasterEventCount(ES_EventTyp_t EventType);
+uint32_t HostStubs_GetMasterPostFailures(void);
+
+#endif /* HostStubs_H */
@@ -0,0 +1,350 @@
+/****************************************************************************
+Module: MotorSim.c
+Description:
+	Host-side model of the two drive wheels.
+	Drive side: ApplyMotorCommand hands each motor's duty cycle and
+	direction to MotorSim_SetDrive in place of the PWM and GPIO writes. The
+	H-bridge is taken as drive/brake, so over a 100us PWM period the motor
+	sees the duty times the battery voltage, and a 0% duty (output
+	disabled) lets it coast with no current.
+	Motor side: armature current through the resistance and inductance
+	against the back EMF, torque through the gearbox to the wheel, which
+	carries its share of the Kart's mass. Friction is a static and a
+	Coulomb torque in the motor and gearbox, a viscous term, and the rolling
+	resistance of the surface. Both motors draw from one battery, whose
+	voltage sags with the current through its internal resistance, so a
+	hard start on one wheel slows the other.
+	Encoder side: 28 pulses a wheel turn, spaced a little unevenly the way
+	the real encoder's are. Each edge is timed to within the step it falls
+	in, latched as the capture the way the wide timer would, and the capture
+	ISR (RDriveCaptureResponse / LDriveCaptureResponse) is called.
+	The model is stepped every SUBSTEP_US, well inside the electrical time
+	constant, and runs hundreds of times faster than real time.
+	The parameters are estimates for our motors, fit them to a duty step on
+	the Kart before trusting the absolute numbers.
+Author: Kyle Moy, 3/14/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+// Module Libraries
+#include "MotorSim.h"
+#include "HW_Port.h"
+#include "DriveMotorEncoder.h"
+#include "FaultSim.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define SUBSTEP_US					10
+#define PULSES_PER_REV			28
+#define WHEEL_RADIUS_M			0.047f
+#define GRAVITY							9.81f
+#define TWO_PI							6.2831853f
+
+/*---------------------------- Module Functions ---------------------------*/
+static void StepWheel(uint8_t Motor, float BatteryVolts, uint32_t StartUS);
+static void FireEdge(uint8_t Motor, uint32_t StartUS, float Fraction);
+static double EdgePosition(uint8_t Motor, int32_t Pulse);
+static uint32_t Random(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+// Defaults, the right motor is a little quicker and freer than the left
+const MotorSimWheel_t MotorSimDefaultWheel[2] = {
+	// Ohms	Henries	BackEMF		Ratio	Eff.	Rotor		Wheel		Static	Coulomb	Viscous	Edges
+	{0.8f,	0.0008f, 0.0135f,	10,		0.8f,	2.0e-6f, 6.0e-5f, 0.012f, 0.008f, 3.0e-6f, 0.03f},
+	{0.8f,	0.0008f, 0.0145f,	10,		0.8f,	2.0e-6f, 6.0e-5f, 0.015f, 0.010f, 3.5e-6f, 0.04f}
+};
+const MotorSimSurface_t MotorSimFloor = {1.5f, 0.03f};
+const MotorSimSurface_t MotorSimBlocks = {0, 0};
+const MotorSimBattery_t MotorSimDefaultBattery = {12.0f, 0.2f};
+
+// One wheel's state, RIGHT_MOTOR and LEFT_MOTOR
+typedef struct {
+	MotorSimWheel_t	Params;
+	float			Inertia;				// At the wheel, kg m^2
+	float			FrictionStatic;	// At the wheel, Nm
+	float			FrictionCoulomb;
+	float			FrictionViscous;
+	float			EdgeOffset[PULSES_PER_REV];
+	// Drive
+	uint8_t		DutyCycle;
+	uint8_t		Direction;
+	// State
+	float			Amps;
+	float			Speed;					// Wheel rad/s, + turning the way FORWARD drives it
+	double		Position;				// Wheel pulses
+	int32_t		Pulse;					// The last edge passed, EdgePosition(Pulse) <= Position
+	uint32_t	Capture;
+} SimWheel_t;
+
+static SimWheel_t Wheels[2];
+static MotorSimSurface_t Surface;
+static MotorSimBattery_t Battery;
+static float BatteryVolts;
+static uint32_t RandomState;
+static bool Started;
+static uint32_t LastUS;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			MotorSim_Init
+Parameters:		const MotorSimWheel_t Wheels[2], by RIGHT_MOTOR and LEFT_MOTOR
+							MotorSimSurface_t Surface, what the Kart is on
+							MotorSimBattery_t Battery
+							uint32_t Seed, for the encoder edge spacing
+Returns:			void
+Description:	Resets both wheels to a standstill with the motors off
+****************************************************************************/
+void MotorSim_Init(const MotorSimWheel_t NewWheels[2], MotorSimSurface_t NewSurface, \
+	MotorSimBattery_t NewBattery, uint32_t Seed) {
+	Surface = NewSurface;
+	Battery = NewBattery;
+	BatteryVolts = Battery.Volts;
+	RandomState = Seed ? Seed : 1;
+	Started = false;
+
+	for (uint8_t Motor = RIGHT_MOTOR; Motor <= LEFT_MOTOR; Motor++) {
+		SimWheel_t *Wheel = &Wheels[Motor];
+		const MotorSimWheel_t *p = &NewWheels[Motor];
+		Wheel->Params = *p;
+		// Everything referred to the wheel, the Kart's mass shared between them
+		float Mass = Surface.KartMassKg / 2;
+		float Rolling = Surface.RollingResistance * Mass * GRAVITY * WHEEL_RADIUS_M;
+		Wheel->Inertia = p->WheelInertia + Mass * WHEEL_RADIUS_M * WHEEL_RADIUS_M + \
+			p->RotorInertia * p->GearRatio * p->GearRatio;
+		Wheel->FrictionStatic = p->StaticTorque * p->GearRatio + Rolling;
+		Wheel->FrictionCoulomb = p->CoulombTorque * p->GearRatio + Rolling;
+		Wheel->FrictionViscous = p->ViscousTorque * p->GearRatio * p->GearRatio;
+		for (uint8_t n = 0; n < PULSES_PER_REV; n++) {
+			Wheel->EdgeOffset[n] = p->EdgeSpacingError * ((float)(Random() % 2001) / 1000 - 1);
+		}
+		Wheel->DutyCycle = 0;
+		Wheel->Direction = FORWARD;
+		Wheel->Amps = 0;
+		Wheel->Speed = 0;
+		Wheel->Position = 0;
+		Wheel->Pulse = 0;
+		Wheel->Capture = 0;
+	}
+}
+
+/****************************************************************************
+Function:			MotorSim_Step
+Parameters:		uint32_t NowUS, the virtual time
+Returns:			void
+Description:	Runs both wheels up to NowUS, calling the capture ISRs for
+							the edges on the way
+****************************************************************************/
+void MotorSim_Step(uint32_t NowUS) {
+	if (!Started) {
+		Started = true;
+		LastUS = NowUS;
+		return;
+	}
+	while ((int32_t)(NowUS - LastUS) >= SUBSTEP_US) {
+		// The battery current, each motor draws its current for the duty
+		// it's on, and gives it back braking
+		float BatteryAmps = 0;
+		for (uint8_t Motor = RIGHT_MOTOR; Motor <= LEFT_MOTOR; Motor++) {
+			float Amps = Wheels[Motor].Amps * Wheels[Motor].DutyCycle / 100;
+			BatteryAmps += (Wheels[Motor].Direction == BACKWARD) ? -Amps : Amps;
+		}
+		BatteryVolts = Battery.Volts - BatteryAmps * Battery.InternalOhms;
+		StepWheel(RIGHT_MOTOR, BatteryVolts, LastUS);
+		StepWheel(LEFT_MOTOR, BatteryVolts, LastUS);
+		LastUS += SUBSTEP_US;
+	}
+}
+
+/****************************************************************************
+Function:			MotorSim_SetDrive
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+							uint8_t DutyCycle, 0-100
+							uint8_t Direction, FORWARD or BACKWARD
+Returns:			void
+Description:	What ApplyMotorCommand puts out, held until the next one
+****************************************************************************/
+void MotorSim_SetDrive(uint8_t Motor, uint8_t DutyCycle, uint8_t Direction) {
+	Wheels[Motor].DutyCycle = (DutyCycle > 100) ? 100 : DutyCycle;
+	Wheels[Motor].Direction = Direction;
+}
+
+/****************************************************************************
+Function:			MotorSim_SetRPM
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+							float RPM, + turning FORWARD
+Returns:			void
+Description:	An outside force sets the wheel's speed, the Kart meeting a
+							wall. The motor carries on from there on the next step.
+****************************************************************************/
+void MotorSim_SetRPM(uint8_t Motor, float RPM) {
+	Wheels[Motor].Speed = RPM * TWO_PI / 60;
+}
+
+/****************************************************************************
+Function:			MotorSim_GetCapture
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+Returns:			uint32_t, the wheel's last edge in HW_TIMESTAMP() ticks
+Description:	The capture register, read by the capture ISR
+****************************************************************************/
+uint32_t MotorSim_GetCapture(uint8_t Motor) {
+	return Wheels[Motor].Capture;
+}
+
+/****************************************************************************
+Function:			MotorSim_GetRPM
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+Returns:			float, the true wheel speed, + turning FORWARD
+Description:	For scoring the speed loop against, not what the encoder sees
+****************************************************************************/
+float MotorSim_GetRPM(uint8_t Motor) {
+	return Wheels[Motor].Speed * 60 / TWO_PI;
+}
+
+/****************************************************************************
+Function:			MotorSim_GetAmps
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+Returns:			float, the armature current, + driving FORWARD
+Description:	For the report
+****************************************************************************/
+float MotorSim_GetAmps(uint8_t Motor) {
+	return Wheels[Motor].Amps;
+}
+
+/****************************************************************************
+Function:			MotorSim_GetBatteryVolts
+Parameters:		void
+Returns:			float, the battery voltage under the present load
+Description:	For the report
+****************************************************************************/
+float MotorSim_GetBatteryVolts(void) {
+	return BatteryVolts;
+}
+
+/****************************************************************************
+Function:			MotorSim_GetEdges
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+Returns:			int32_t, the true travel in encoder edges, + FORWARD
+Description:	To check the odometer against
+****************************************************************************/
+int32_t MotorSim_GetEdges(uint8_t Motor) {
+	return Wheels[Motor].Pulse;
+}
+
+/****************************************************************************
+Function:			MotorSim_GetDistanceMM
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+Returns:			float, the true travel of the wheel's rim, + FORWARD
+Description:	To score distance moves against, between the encoder's edges
+****************************************************************************/
+float MotorSim_GetDistanceMM(uint8_t Motor) {
+	return (float)(Wheels[Motor].Position * TWO_PI * WHEEL_RADIUS_M * 1000 / PULSES_PER_REV);
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			StepWheel
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+							float BatteryVolts, the supply this step
+							uint32_t StartUS, the time at the start of the step
+Returns:			void
+Description:	Moves one wheel on SUBSTEP_US. The motor's signs are its own,
+							+ driving FORWARD, so BACKWARD is just a negative voltage.
+****************************************************************************/
+static void StepWheel(uint8_t Motor, float BatteryVolts, uint32_t StartUS) {
+	SimWheel_t *Wheel = &Wheels[Motor];
+	const MotorSimWheel_t *p = &Wheel->Params;
+	const float dt = SUBSTEP_US * 1e-6f;
+
+	// Armature current, none with the output off
+	float EMF = p->BackEMF * p->GearRatio * Wheel->Speed;
+	if (Wheel->DutyCycle == 0) {
+		Wheel->Amps = 0;
+	} else {
+		float Volts = BatteryVolts * Wheel->DutyCycle / 100;
+		if (Wheel->Direction == BACKWARD) Volts = -Volts;
+		Wheel->Amps += (Volts - p->ArmatureOhms * Wheel->Amps - EMF) * dt / p->ArmatureHenries;
+	}
+
+	// The wheel, held by static friction until the drive beats it, and
+	// stopped rather than reversed by friction alone
+	float Drive = p->BackEMF * Wheel->Amps * p->GearRatio * p->GearEfficiency;
+	float Speed = Wheel->Speed;
+	if (Speed == 0) {
+		if (fabsf(Drive) > Wheel->FrictionStatic) {
+			float Friction = (Drive > 0) ? Wheel->FrictionCoulomb : -Wheel->FrictionCoulomb;
+			Speed = (Drive - Friction) * dt / Wheel->Inertia;
+		}
+	} else {
+		float Friction = (Speed > 0) ? Wheel->FrictionCoulomb : -Wheel->FrictionCoulomb;
+		float NewSpeed = Speed + (Drive - Friction - Wheel->FrictionViscous * Speed) * dt / Wheel->Inertia;
+		if (NewSpeed * Speed < 0 && fabsf(Drive) <= Wheel->FrictionStatic) NewSpeed = 0;
+		Speed = NewSpeed;
+	}
+
+	// The encoder, every edge passed this step, timed along it
+	double Start = Wheel->Position;
+	double End = Start + (double)(Wheel->Speed + Speed) / 2 * dt * PULSES_PER_REV / TWO_PI;
+	Wheel->Speed = Speed;
+	Wheel->Position = End;
+	while (End >= EdgePosition(Motor, Wheel->Pulse + 1)) {
+		Wheel->Pulse++;
+		FireEdge(Motor, StartUS, (float)((EdgePosition(Motor, Wheel->Pulse) - Start) / (End - Start)));
+	}
+	while (End < EdgePosition(Motor, Wheel->Pulse)) {
+		FireEdge(Motor, StartUS, (float)((EdgePosition(Motor, Wheel->Pulse) - Start) / (End - Start)));
+		Wheel->Pulse--;
+	}
+}
+
+/****************************************************************************
+Function:			FireEdge
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+							uint32_t StartUS, the time at the start of the step
+							float Fraction, how far into the step the edge came
+Returns:			void
+Description:	Latches the capture and runs the capture ISR. Only the one
+							channel is wired, so an edge is an edge whichever way the
+							wheel turns, the ISR goes by the driven direction.
+****************************************************************************/
+static void FireEdge(uint8_t Motor, uint32_t StartUS, float Fraction) {
+	if (Fraction < 0) Fraction = 0;
+	if (Fraction > 1) Fraction = 1;
+	// A dropout loses the edge before the timer sees it
+	if (FaultSim_Inject((Motor == RIGHT_MOTOR) ? FAULT_ENCODER_R : FAULT_ENCODER_L)) return;
+	Wheels[Motor].Capture = StartUS * HW_TICKS_PER_US + (uint32_t)(Fraction * SUBSTEP_US * HW_TICKS_PER_US);
+	if (Motor == RIGHT_MOTOR) RDriveCaptureResponse(); else LDriveCaptureResponse();
+}
+
+/****************************************************************************
+Function:			EdgePosition
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+							int32_t Pulse, which edge
+Returns:			double, where on the wheel it is, in pulses
+Description:	Nominally Pulse, moved by the edge's spacing error
+****************************************************************************/
+static double EdgePosition(uint8_t Motor, int32_t Pulse) {
+	int32_t Index = Pulse % PULSES_PER_REV;
+	if (Index < 0) Index += PULSES_PER_REV;
+	return Pulse + Wheels[Motor].EdgeOffset[Index];
+}
+
+/****************************************************************************
+Function:			Random
+Parameters:		void
+Returns:			uint32_t, pseudo-random, repeatable for a seed
+Description:	Linear congruential generator, good enough for a simulation
+****************************************************************************/
+static uint32_t Random(void) {
+	RandomState = RandomState * 1103515245u + 12345u;
+	return RandomState >> 8;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,67 @@
+/****************************************************************************
+Module: MotorSim.h
+Description:
+	Host-side model of the two drive wheels, motor, gearbox, wheel and
+	encoder, on a shared battery. Stands in for the PWM outputs and the
+	encoder input captures when the firmware is compiled with HOST_SIM
+	(see HW_Port.h), so the real DriveMotors.c, DriveMotorsEncoder.c and
+	DriveMotorsPID.c can be run and regression tested on a PC.
+Author: Kyle Moy, 3/14/15
+****************************************************************************/
+
+#ifndef MotorSim_H
+#define MotorSim_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "DriveMotors.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// One drive motor, its gearbox and wheel. Torques and speeds are at the
+// motor shaft unless they say wheel.
+typedef struct {
+	float		ArmatureOhms;
+	float		ArmatureHenries;
+	float		BackEMF;						// V per rad/s, the torque constant in Nm/A too
+	float		GearRatio;					// Motor turns per wheel turn
+	float		GearEfficiency;
+	float		RotorInertia;				// kg m^2
+	float		WheelInertia;				// kg m^2, the wheel itself
+	float		StaticTorque;				// Nm, to get the motor and gearbox turning
+	float		CoulombTorque;			// Nm, once they are
+	float		ViscousTorque;			// Nm per rad/s
+	float		EdgeSpacingError;		// Of a pulse, how uneven the encoder's edges are
+} MotorSimWheel_t;
+
+// What the wheels drive on
+typedef struct {
+	float		KartMassKg;					// Shared between the wheels, 0 up on blocks
+	float		RollingResistance;	// Coefficient, of the Kart's weight
+} MotorSimSurface_t;
+
+// The battery, its voltage sags with the current both motors draw
+typedef struct {
+	float		Volts;
+	float		InternalOhms;
+} MotorSimBattery_t;
+
+// Defaults, estimates for our motors, fit them to a duty step on the Kart
+extern const MotorSimWheel_t MotorSimDefaultWheel[2];
+extern const MotorSimSurface_t MotorSimFloor;
+extern const MotorSimSurface_t MotorSimBlocks;
+extern const MotorSimBattery_t MotorSimDefaultBattery;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void MotorSim_Init(const MotorSimWheel_t Wheels[2], MotorSimSurface_t Surface, MotorSimBattery_t Battery, uint32_t Seed);
+void MotorSim_Step(uint32_t NowUS);
+void MotorSim_SetDrive(uint8_t Motor, uint8_t DutyCycle, uint8_t Direction);
+void MotorSim_SetRPM(uint8_t Motor, float RPM);
+uint32_t MotorSim_GetCapture(uint8_t Motor);
+float MotorSim_GetRPM(uint8_t Motor);
+float MotorSim_GetAmps(uint8_t Motor);
+float MotorSim_GetBatteryVolts(void);
+int32_t MotorSim_GetEdges(uint8_t Motor);
+float MotorSim_GetDistanceMM(uint8_t Motor);
+
+#endif /* MotorSim_H */
@@ -0,0 +1,399 @@
+/****************************************************************************
+Module: MotorSimMain.c
+Description:
+	Host regression test for the drive speed loop. Runs the real
+	DriveMotors.c, DriveMotorsEncoder.c and DriveMotorsPID.c, and what the
+	control ISR calls, against the motor simulator (MotorSim.c): the ISR's
+	duty goes to the model through ApplyMotorCommand, and the model's
+	encoder edges come back through the capture ISRs. The control ISR is
+	called every 1ms of virtual time, the thread side of the autotune and
+	the feedforward calibration is done here in place of the
+	DriveMotorsService.
+	Both wheels are given a set of speed steps on the hand tuned gains, then
+	autotuned and calibrated the way MapKeys 'T' and 'Y' do it on the Kart,
+	and given the same steps again. Each step is scored on the model's true
+	wheel speed: the 10-90% rise time, the overshoot, the time to settle
+	within SETTLE_BAND_PERCENT of the change, and the steady-state error
+	over the end of the step. The run fails if any step is outside the
+	limits below, so a change to the speed loop can be checked before it
+	goes on the Kart. Steps to the fast band are only reported: its gains
+	were tuned by hand on the Kart, which the model hasn't been fit to, so
+	a miss there says as much about the model as about the gains.
+	Then the distance moves (DriveMotorsPosition.c): forward and backward
+	from rest and a fast and a slow CCW pivot have to settle MOVE_ARRIVED,
+	and one started a few ticks out with the wheels at full speed, which
+	can't stop in time, has to come out MOVE_STALLED rather than count its
+	overshoot as arrived. The backward wheels run on negative encoder velocities.
+	Each move prints how long it took and how far each wheel went.
+
+	Build from the project directory on a PC with TivaWare checked out:
+		gcc -std=gnu99 -O2 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o motorsim \
+			Host/MotorSimMain.c Host/MotorSim.c Host/FaultSim.c Source/DriveMotors.c \
+			Source/DriveMotorsEncoder.c Source/DriveMotorsPID.c Source/PIDController.c \
+			Source/MotionProfile.c Source/DriveFeedforward.c Source/PIDAutotune.c \
+			Source/MotionSequencer.c Source/DriveMotorsPosition.c Source/PoseEstimator.c \
+			Source/InputRecorder.c -lm
+
+	Usage:
+		motorsim [floor|blocks] [battery volts] [seed]
+	Exits with 1 if any step is outside the limits.
+Author: Kyle Moy, 3/14/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+// Module Libraries
+#include "MotorSim.h"
+#include "DriveMotors.h"
+#include "DriveMotorPID.h"
+#include "DriveMotorsService.h"
+#include "DriveMotorsPosition.h"
+#include "EEPROMStorage.h"
+#include "DRS.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define CONTROL_PERIOD_US			1000
+// Steady-state error is averaged over the end of each step
+#define SETTLE_WINDOW_MS			250
+// Settled for good once within this of the change, reported only
+#define SETTLE_BAND_PERCENT		5.0f
+// Longest the autotune and the calibration are given
+#define CALIBRATION_LIMIT_MS	30000
+#define MAX_STEP_MS						2000
+
+// Regression limits, every step of both runs has to meet them
+#define MAX_RISE_MS						400
+#define MAX_OVERSHOOT_PERCENT	15.0f
+#define MAX_STEADY_ERROR_RPM	6.0f
+// DriveMotorsPID.c's fast band, on the hand tuned gains, reported only
+#define FAST_BAND_RPM					300
+
+// The distance moves, and how long they are given to settle
+#define MOVE_MM								300
+#define MOVE_RPM							200
+#define MOVE_TICKS						28		// MOVE_MM on 94mm wheels, 28 pulses a turn
+#define OVERSHOOT_RPM					400
+#define OVERSHOOT_TICKS				2
+// Faster and longer than the maneuvers' pivots, so the wheel gets up to
+// a speed it has to coast down from
+#define PIVOT_RPM							300
+#define PIVOT_TICKS						40
+// The maneuvers' own, MapKeys 'A', in the slow band
+#define SLOW_PIVOT_RPM				150
+#define SLOW_PIVOT_TICKS			18
+#define MOVE_LIMIT_MS					3000
+
+/*---------------------------- Module Functions ---------------------------*/
+static void Run(uint32_t DurationMS);
+static bool RunCalibration(void (*Start)(void), ES_EventTyp_t DoneEvent);
+static bool RunSteps(const char *Name);
+static bool ScoreStep(uint8_t Motor, float StartRPM, float TargetRPM, uint16_t DurationMS);
+static bool RunMoves(void);
+static uint8_t RunMove(void);
+static bool ReportMove(const char *Name, uint8_t Result, uint8_t Expected);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint32_t NowUS;
+static ES_EventTyp_t LastServiceEvent = ES_NO_EVENT;
+// The last move, how long it ran and where the wheels started
+static uint32_t MoveMS;
+static float MoveStartMM[2];
+
+// Speed steps, ms and RPM, - drives backward
+typedef struct {
+	uint16_t	DurationMS;
+	int16_t		TargetRPM;
+} Step_t;
+
+static const Step_t Steps[] = {
+	{1000, 150},
+	{1000, 250},
+	{1000, 100},
+	{1000, 400},
+	{1000, 200},
+	{1500, -150},
+	{1000, 0}
+};
+
+// The model's true speed through the step, per wheel
+static float History[2][MAX_STEP_MS];
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	MotorSimSurface_t Surface = MotorSimFloor;
+	MotorSimBattery_t Battery = MotorSimDefaultBattery;
+	uint32_t Seed = 1;
+	if (argc > 1 && strcmp(argv[1], "blocks") == 0) Surface = MotorSimBlocks;
+	if (argc > 2) Battery.Volts = strtof(argv[2], NULL);
+	if (argc > 3) Seed = strtoul(argv[3], NULL, 0);
+
+	printf("Drive motor host simulation: %s, %.1f V, seed %lu\r\n", \
+		(Surface.KartMassKg > 0) ? "floor" : "blocks", Battery.Volts, (unsigned long)Seed);
+	clock_t Started = clock();
+	MotorSim_Init(MotorSimDefaultWheel, Surface, Battery, Seed);
+	MotorSim_Step(NowUS);
+	InitializeDriveMotors();
+
+	bool Pass = RunSteps("hand tuned");
+	if (RunCalibration(StartPIDAutotune, E_PID_AUTOTUNE_DONE) && \
+		RunCalibration(StartFeedforwardCalibration, E_FEEDFORWARD_CAL_DONE)) {
+		Pass = RunSteps("autotuned + feedforward") && Pass;
+	} else {
+		printf("Calibration didn't finish\r\n");
+		Pass = false;
+	}
+	Pass = RunMoves() && Pass;
+
+	float Seconds = (float)(clock() - Started) / CLOCKS_PER_SEC;
+	printf("%.1f s simulated in %.2f s, %s\r\n", NowUS / 1e6f, Seconds, Pass ? "PASS" : "FAIL");
+	return Pass ? 0 : 1;
+}
+
+// Host port, the virtual clock is kept here rather than by ES_Port.c
+uint32_t _HW_GetMicros(void) { return NowUS; }
+// No SysTick, FaultSim.c's tick delay has nothing to hold off
+uint16_t _HW_GetTickCount(void) { return 0; }
+void _HW_DelayTick(uint32_t DelayUS) {}
+
+// The DriveMotorsService, only the events the speed loop sends
+bool PostDriveMotorsService(ES_Event ThisEvent) {
+	LastServiceEvent = ThisEvent.EventType;
+	return true;
+}
+
+// No timers, the maneuvers under test are given no duration
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime) { return ES_Timer_OK; }
+ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num) { return ES_Timer_OK; }
+
+// No EEPROM, every run starts from the hand tuned gains
+bool ReadEEPROMRecord(uint8_t Slot, uint16_t Version, void *Data, uint16_t Length) { return false; }
+bool WriteEEPROMRecord(uint8_t Slot, uint16_t Version, const void *Data, uint16_t Length) { return true; }
+
+// No DRS, the pose estimate runs on odometry alone
+Kart_t GetMyKart(void) { Kart_t Kart = {0}; return Kart; }
+
+// No race simulator, the drive's PWM0 writes go nowhere, the motor model
+// takes the duty cycles from ApplyMotorCommand
+uint32_t RaceSim_ReadPWM(uint32_t Offset) { return 0; }
+void RaceSim_WritePWM(uint32_t Offset, uint32_t Value) {}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			Run
+Parameters:		uint32_t DurationMS
+Returns:			void
+Description:	Runs the model and the control ISR for DurationMS
+****************************************************************************/
+static void Run(uint32_t DurationMS) {
+	for (uint32_t n = 0; n < DurationMS; n++) {
+		NowUS += CONTROL_PERIOD_US;
+		MotorSim_Step(NowUS);
+		SetRPMResponse();
+	}
+}
+
+/****************************************************************************
+Function:			RunCalibration
+Parameters:		void (*Start)(void), StartPIDAutotune or StartFeedforwardCalibration
+							ES_EventTyp_t DoneEvent, what it posts when it's done
+Returns:			bool, true if it finished
+Description:	Runs it from a standstill and finishes it as the
+							DriveMotorsService does
+****************************************************************************/
+static bool RunCalibration(void (*Start)(void), ES_EventTyp_t DoneEvent) {
+	LastServiceEvent = ES_NO_EVENT;
+	Start();
+	for (uint32_t Time = 0; Time < CALIBRATION_LIMIT_MS; Time++) {
+		Run(1);
+		if (LastServiceEvent == DoneEvent) {
+			StopMotors();
+			if (DoneEvent == E_PID_AUTOTUNE_DONE) FinishPIDAutotune(); else FinishFeedforwardCalibration();
+			Run(MAX_STEP_MS);
+			return true;
+		}
+	}
+	StopMotors();
+	return false;
+}
+
+/****************************************************************************
+Function:			RunSteps
+Parameters:		const char *Name, the gains, for the report
+Returns:			bool, true if every step was inside the limits
+Description:	Drives both wheels through Steps and scores each one
+****************************************************************************/
+static bool RunSteps(const char *Name) {
+	bool Pass = true;
+	int16_t StartRPM = 0;
+	printf("\r\n%s\r\n", Name);
+	printf("Step          Wheel   rise ms  overshoot  settle ms  steady error   battery\r\n");
+	for (uint8_t n = 0; n < sizeof(Steps)/sizeof(Steps[0]); n++) {
+		int16_t Target = Steps[n].TargetRPM;
+		if (Target > 0) DriveForward(Target, 0);
+		else if (Target < 0) DriveBackward(-Target, 0);
+		else StopMotors();
+
+		float LowestVolts = MotorSimDefaultBattery.Volts * 2;
+		for (uint16_t Time = 0; Time < Steps[n].DurationMS; Time++) {
+			Run(1);
+			History[RIGHT_MOTOR][Time] = MotorSim_GetRPM(RIGHT_MOTOR);
+			History[LEFT_MOTOR][Time] = MotorSim_GetRPM(LEFT_MOTOR);
+			if (MotorSim_GetBatteryVolts() < LowestVolts) LowestVolts = MotorSim_GetBatteryVolts();
+		}
+		bool FastBand = abs(Target) >= FAST_BAND_RPM;
+		for (uint8_t Motor = RIGHT_MOTOR; Motor <= LEFT_MOTOR; Motor++) {
+			printf("%4d -> %4d  %-6s", StartRPM, Target, (Motor == RIGHT_MOTOR) ? "Right" : "Left");
+			if (!ScoreStep(Motor, StartRPM, Target, Steps[n].DurationMS) && !FastBand) Pass = false;
+			printf(Motor == RIGHT_MOTOR ? "  %5.2f V" : "", LowestVolts);
+			printf(FastBand ? "  fast band, not held to the limits\r\n" : "\r\n");
+		}
+		StartRPM = Target;
+	}
+	return Pass;
+}
+
+/****************************************************************************
+Function:			ScoreStep
+Parameters:		uint8_t Motor, RIGHT_MOTOR or LEFT_MOTOR
+							float StartRPM, TargetRPM, the step
+							uint16_t DurationMS, how much of History it filled
+Returns:			bool, true if it was inside the limits
+Description:	Prints the rise time, overshoot, settling time and steady-state
+							error, the settling time isn't held to a limit. A step
+							to a stop is only held to the steady-state error, the speed
+							loop coasts down rather than driving to 0.
+****************************************************************************/
+static bool ScoreStep(uint8_t Motor, float StartRPM, float TargetRPM, uint16_t DurationMS) {
+	const float *Speed = History[Motor];
+	float Change = TargetRPM - StartRPM;
+	float Direction = (Change > 0) ? 1 : -1;
+
+	// Rise from 10% to 90% of the change
+	int32_t Rise10 = -1, Rise90 = -1;
+	float Peak = 0;
+	uint16_t SettleMS = 0;
+	for (uint16_t Time = 0; Time < DurationMS; Time++) {
+		float Progress = (Speed[Time] - StartRPM) / Change;
+		if (Rise10 < 0 && Progress >= 0.1f) Rise10 = Time;
+		if (Rise90 < 0 && Progress >= 0.9f) Rise90 = Time;
+		float Beyond = (Speed[Time] - TargetRPM) * Direction;
+		if (Beyond > Peak) Peak = Beyond;
+		if (fabsf(Speed[Time] - TargetRPM) * 100 > SETTLE_BAND_PERCENT * fabsf(Change)) SettleMS = Time + 1;
+	}
+	float Sum = 0;
+	for (uint16_t Time = DurationMS - SETTLE_WINDOW_MS; Time < DurationMS; Time++) Sum += Speed[Time];
+	float SteadyError = Sum / SETTLE_WINDOW_MS - TargetRPM;
+	float Overshoot = Peak * 100 / fabsf(Change);
+
+	bool Pass = fabsf(SteadyError) <= MAX_STEADY_ERROR_RPM;
+	if (TargetRPM == 0) {
+		printf("      -          -           -  ");
+	} else {
+		int32_t RiseMS = (Rise10 >= 0 && Rise90 >= 0) ? Rise90 - Rise10 : -1;
+		if (RiseMS < 0 || RiseMS > MAX_RISE_MS || Overshoot > MAX_OVERSHOOT_PERCENT) Pass = false;
+		if (RiseMS < 0) printf("  never"); else printf("  %5ld", (long)RiseMS);
+		printf("     %5.1f%%", Overshoot);
+		if (SettleMS >= DurationMS) printf("      never"); else printf("      %5u", SettleMS);
+	}
+	printf("   %+8.1f RPM%s", SteadyError, Pass ? "" : " *");
+	return Pass;
+}
+
+/****************************************************************************
+Function:			RunMoves
+Parameters:		void
+Returns:			bool, true if all the moves ended the way they should
+Description:	Moves from rest forward, backward and pivoting that arrive,
+							and one that overshoots
+****************************************************************************/
+static bool RunMoves(void) {
+	printf("\r\nDistance moves\r\n");
+	StopMotors();
+	Run(MAX_STEP_MS);
+	DriveForwardWithSetDistance(MOVE_RPM, MOVE_MM);
+	bool Pass = ReportMove("forward from rest", RunMove(), MOVE_ARRIVED);
+
+	// DriveMotors.c has no backward distance move, this is the forward one
+	// with the directions turned round
+	StopMotors();
+	Run(MAX_STEP_MS);
+	EnablePIDcontrol();
+	SetMotorDirections(BACKWARD, BACKWARD);
+	SetManeuverRPM(MANEUVER_DISTANCE, MOVE_RPM, MOVE_RPM);
+	StartPositionMove(MOVE_TICKS, MOVE_TICKS, MOVE_RPM, MOVE_RPM);
+	Pass = ReportMove("backward from rest", RunMove(), MOVE_ARRIVED) && Pass;
+
+	// The left wheel turns backward and counts the ticks
+	StopMotors();
+	Run(MAX_STEP_MS);
+	PivotCCWwithSetTicks(PIVOT_RPM, PIVOT_TICKS);
+	Pass = ReportMove("CCW pivot from rest", RunMove(), MOVE_ARRIVED) && Pass;
+	StopMotors();
+	Run(MAX_STEP_MS);
+	PivotCCWwithSetTicks(SLOW_PIVOT_RPM, SLOW_PIVOT_TICKS);
+	Pass = ReportMove("slow CCW pivot from rest", RunMove(), MOVE_ARRIVED) && Pass;
+
+	// Too close to stop from full speed, the wheels run past
+	DriveForward(OVERSHOOT_RPM, 0);
+	Run(MAX_STEP_MS);
+	float StartMM = MotorSim_GetDistanceMM(RIGHT_MOTOR);
+	StartPositionMove(OVERSHOOT_TICKS, OVERSHOOT_TICKS, OVERSHOOT_RPM, OVERSHOOT_RPM);
+	uint8_t Result = RunMove();
+	bool Overshot = (Result == MOVE_STALLED);
+	printf("%d ticks at %d RPM: %s after %.0f mm%s\r\n", OVERSHOOT_TICKS, OVERSHOOT_RPM, \
+		(Result == MOVE_ARRIVED) ? "arrived" : (Result == MOVE_STALLED) ? "stalled" : "never settled", \
+		MotorSim_GetDistanceMM(RIGHT_MOTOR) - StartMM, Overshot ? "" : " *");
+	StopMotors();
+	return Pass && Overshot;
+}
+
+/****************************************************************************
+Function:			RunMove
+Parameters:		void
+Returns:			uint8_t, how the move ended, MOVE_IN_PROGRESS if it didn't
+Description:	Runs a started move until it posts E_MOTOR_SETTLED
+****************************************************************************/
+static uint8_t RunMove(void) {
+	LastServiceEvent = ES_NO_EVENT;
+	MoveStartMM[RIGHT_MOTOR] = MotorSim_GetDistanceMM(RIGHT_MOTOR);
+	MoveStartMM[LEFT_MOTOR] = MotorSim_GetDistanceMM(LEFT_MOTOR);
+	for (MoveMS = 1; MoveMS <= MOVE_LIMIT_MS; MoveMS++) {
+		Run(1);
+		if (LastServiceEvent == E_MOTOR_SETTLED) return GetPositionMoveResult();
+	}
+	return MOVE_IN_PROGRESS;
+}
+
+/****************************************************************************
+Function:			ReportMove
+Parameters:		const char *Name, the move
+							uint8_t Result, how it ended
+							uint8_t Expected, how it should have
+Returns:			bool, true if it ended as expected
+Description:	Prints how a move ended, how long it took and how far the
+							wheels went
+****************************************************************************/
+static bool ReportMove(const char *Name, uint8_t Result, uint8_t Expected) {
+	printf("%s: %s in %lu ms, right %+.0f mm, left %+.0f mm%s\r\n", Name, \
+		(Result == MOVE_ARRIVED) ? "arrived" : (Result == MOVE_STALLED) ? "stalled" : "never settled", \
+		(unsigned long)MoveMS, MotorSim_GetDistanceMM(RIGHT_MOTOR) - MoveStartMM[RIGHT_MOTOR], \
+		MotorSim_GetDistanceMM(LEFT_MOTOR) - MoveStartMM[LEFT_MOTOR], (Result == Expected) ? "" : " *");
+	return Result == Expected;
+}
+
+/*------------------------------ End of file ------------------------------*/
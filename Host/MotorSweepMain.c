@@ -0,0 +1,433 @@
+/****************************************************************************
+Module: MotorSweepMain.c
+Description:
+	Host Monte Carlo sweep of the speed loop's gains and the motion
+	profile's limits. Every parameter set in the grid below is run against
+	the same randomized plants, the motor simulator (MotorSim.c) with each
+	motor's resistance, back EMF, friction and inertia, the Kart's mass and
+	the battery voltage drawn from around the defaults. Each run is the real
+	DriveMotors.c, DriveMotorsEncoder.c, DriveMotorsPID.c and
+	DriveMotorsPosition.c under HOST_SIM, as MotorSimMain.c runs them:
+	- a speed step from rest to STEP_RPM, for the time to settle inside
+		SETTLE_BAND_PERCENT, the overshoot, and the steady-state error
+	- a DriveForwardWithSetDistance move, for the time to E_MOTOR_SETTLED
+		and how far the wheels really went against what was asked
+	The gains go in through the EEPROM record InitPeriodicInt loads, so they
+	are the AUTOTUNED entries of the gain schedule, the slow band.
+	The firmware keeps its state in module statics, so each run is its own
+	forked process, a fresh copy of them, on WorkerPool.c's workers. The
+	results come back through shared memory.
+	Every run is written to <prefix>_runs.csv, and the parameter sets are
+	ranked by their mean cost over the plants into <prefix>_ranked.csv, the
+	best few printed. The cost weighs 100ms of settling, 5% of overshoot and
+	10mm of distance error the same, and a move that never arrives heavily.
+
+	Build from the project directory on a Linux PC with TivaWare checked out:
+		gcc -std=gnu99 -O2 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o motorsweep \
+			Host/MotorSweepMain.c Host/WorkerPool.c Host/MotorSim.c Host/FaultSim.c Source/DriveMotors.c \
+			Source/DriveMotorsEncoder.c Source/DriveMotorsPID.c Source/PIDController.c \
+			Source/MotionProfile.c Source/DriveFeedforward.c Source/PIDAutotune.c \
+			Source/MotionSequencer.c Source/DriveMotorsPosition.c Source/PoseEstimator.c \
+			Source/InputRecorder.c -lm
+
+	Usage:
+		motorsweep [plants per set] [workers, 0 for one per core] [output prefix]
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+// Module Libraries
+#include "MotorSim.h"
+#include "WorkerPool.h"
+#include "DriveMotors.h"
+#include "DriveMotorPID.h"
+#include "DriveMotorsPosition.h"
+#include "DriveMotorsService.h"
+#include "MotionProfile.h"
+#include "EEPROMStorage.h"
+#include "DRS.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define DEFAULT_PLANTS				8
+#define DEFAULT_PREFIX				"motorsweep"
+#define CONTROL_PERIOD_US			1000
+
+// The speed step, slow band, scored on both wheels' true speed
+#define STEP_RPM							200
+#define STEP_MS								1500
+#define SETTLE_BAND_PERCENT		5.0f
+#define STEADY_WINDOW_MS			250
+// Time to coast to rest between the tests
+#define REST_MS								1000
+
+// The distance move
+#define MOVE_RPM							200
+#define MOVE_MM								1000
+#define MOVE_LIMIT_MS					8000
+
+// Plants, each parameter scaled by up to PLANT_SPREAD either way
+#define PLANT_SPREAD					0.15f
+#define MIN_KART_KG						1.2f
+#define MAX_KART_KG						1.8f
+#define MIN_BATTERY_VOLTS			10.8f
+#define MAX_BATTERY_VOLTS			12.6f
+
+// Cost of a run, each term is one point at its scale
+#define SETTLE_SCALE_MS				100.0f
+#define OVERSHOOT_SCALE				5.0f
+#define DISTANCE_SCALE_MM			10.0f
+#define NOT_ARRIVED_COST			50.0f
+#define FAILED_COST						1000.0f
+#define TOP_SETS							10
+
+/*---------------------------- Module Functions ---------------------------*/
+static void RunJob(uint32_t Job);
+static void Run(uint32_t DurationMS);
+static void MakePlant(uint32_t Plant, MotorSimWheel_t Wheels[2], MotorSimSurface_t *Surface, \
+	MotorSimBattery_t *Battery);
+static float Spread(uint32_t *State, float Low, float High);
+static float Cost(uint32_t Job);
+static int CompareSets(const void *a, const void *b);
+static bool WriteResults(const char *Prefix);
+
+/*---------------------------- Module Variables ---------------------------*/
+// The grid, every combination is a parameter set
+static const float SweepP[] = {0.02f, 0.05f, 0.1f, 0.15f};
+static const float SweepI[] = {0.005f, 0.01f, 0.02f, 0.04f};
+static const uint32_t SweepAccel[] = {2000, 4000, 6000};
+static const uint32_t SweepJerk[] = {40000, 80000, 160000};
+#define COUNT(Array)					(sizeof(Array)/sizeof(Array[0]))
+#define NUM_SETS							(COUNT(SweepP) * COUNT(SweepI) * COUNT(SweepAccel) * COUNT(SweepJerk))
+
+// A parameter set
+typedef struct {
+	float			p, i;
+	uint32_t	Accel, Jerk;
+} SweepSet_t;
+
+// What a run measured, written by the run's own process
+typedef struct {
+	bool			Done;
+	float			SettleMS;				// Slowest wheel, STEP_MS if it never settled
+	float			Overshoot;			// Percent, worst wheel
+	float			SteadyError;		// RPM, worst wheel
+	float			MoveMS;
+	float			DistanceError;	// mm, mean of the wheels
+	bool			Arrived;
+} SweepResult_t;
+
+// Shared between the processes
+static SweepResult_t *Results;
+static uint32_t Plants = DEFAULT_PLANTS;
+static uint32_t Jobs;
+
+// The run's state, each process has its own
+static uint32_t NowUS;
+static ES_EventTyp_t LastServiceEvent = ES_NO_EVENT;
+static float JobGains[6];
+
+// Ranking
+static float SetCost[NUM_SETS];
+static uint32_t SetOrder[NUM_SETS];
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	long Workers = 0;
+	const char *Prefix = DEFAULT_PREFIX;
+	if (argc > 1) Plants = strtoul(argv[1], NULL, 0);
+	if (argc > 2) Workers = strtol(argv[2], NULL, 0);
+	if (argc > 3) Prefix = argv[3];
+	if (Plants == 0) Plants = 1;
+	Workers = WorkerPool_Count(Workers);
+	Jobs = NUM_SETS * Plants;
+
+	Results = WorkerPool_Share(Jobs * sizeof(SweepResult_t));
+	if (Results == NULL) return 1;
+	printf("Sweeping %u parameter sets over %lu plants, %lu runs on %ld workers\r\n", \
+		(unsigned)NUM_SETS, (unsigned long)Plants, (unsigned long)Jobs, Workers);
+	// Each run in a fresh process so it starts from the firmware's initial
+	// state, a run that crashes is left not Done
+	float Seconds = WorkerPool_Run(Jobs, Workers, true, RunJob);
+	if (Seconds < 0) return 1;
+
+	uint32_t Failed = 0;
+	for (uint32_t Job = 0; Job < Jobs; Job++) if (!Results[Job].Done) Failed++;
+	printf("%lu runs in %.1f s, %lu failed\r\n", (unsigned long)Jobs, Seconds, (unsigned long)Failed);
+	return WriteResults(Prefix) ? 0 : 1;
+}
+
+// Host port, the virtual clock is kept here rather than by ES_Port.c
+uint32_t _HW_GetMicros(void) { return NowUS; }
+// No SysTick, FaultSim.c's tick delay has nothing to hold off
+uint16_t _HW_GetTickCount(void) { return 0; }
+void _HW_DelayTick(uint32_t DelayUS) {}
+
+// The DriveMotorsService, only the events the speed loop sends
+bool PostDriveMotorsService(ES_Event ThisEvent) {
+	LastServiceEvent = ThisEvent.EventType;
+	return true;
+}
+
+// No timers, the maneuvers under test are given no duration
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime) { return ES_Timer_OK; }
+ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num) { return ES_Timer_OK; }
+
+// The run's gains are the stored autotune, laid out as DriveMotorsPID.c
+// keeps them (pR, iR, dR, pL, iL, dL). No feedforward maps.
+bool ReadEEPROMRecord(uint8_t Slot, uint16_t Version, void *Data, uint16_t Length) {
+	if (Slot != EEPROM_SLOT_PID_GAINS || Length != sizeof(JobGains)) return false;
+	memcpy(Data, JobGains, sizeof(JobGains));
+	return true;
+}
+bool WriteEEPROMRecord(uint8_t Slot, uint16_t Version, const void *Data, uint16_t Length) { return true; }
+
+// No DRS, the pose estimate runs on odometry alone
+Kart_t GetMyKart(void) { Kart_t Kart = {0}; return Kart; }
+
+// No race simulator, the drive's PWM0 writes go nowhere, the motor model
+// takes the duty cycles from ApplyMotorCommand
+uint32_t RaceSim_ReadPWM(uint32_t Offset) { return 0; }
+void RaceSim_WritePWM(uint32_t Offset, uint32_t Value) {}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			RunJob
+Parameters:		uint32_t Job, the parameter set times Plants plus the plant
+Returns:			void
+Description:	One run, the speed step then the distance move, in its own
+							process
+****************************************************************************/
+static void RunJob(uint32_t Job) {
+	// The firmware's console output isn't wanted here
+	if (freopen("/dev/null", "w", stdout) == NULL) return;
+	SweepResult_t *Result = &Results[Job];
+	uint32_t Set = Job / Plants;
+	SweepSet_t Params = {SweepP[Set % COUNT(SweepP)], SweepI[Set / COUNT(SweepP) % COUNT(SweepI)], \
+		SweepAccel[Set / (COUNT(SweepP) * COUNT(SweepI)) % COUNT(SweepAccel)], \
+		SweepJerk[Set / (COUNT(SweepP) * COUNT(SweepI) * COUNT(SweepAccel))]};
+	MotorSimWheel_t Wheels[2];
+	MotorSimSurface_t Surface;
+	MotorSimBattery_t Battery;
+	MakePlant(Job % Plants, Wheels, &Surface, &Battery);
+
+	JobGains[0] = JobGains[3] = Params.p;
+	JobGains[1] = JobGains[4] = Params.i;
+	JobGains[2] = JobGains[5] = 0;
+	MotorSim_Init(Wheels, Surface, Battery, Job % Plants + 1);
+	MotorSim_Step(NowUS);
+	InitializeDriveMotors();
+	SetMotionProfileLimits(Params.Accel, PROFILE_MAX_DECEL, Params.Jerk);
+
+	// Speed step, settled once both wheels stay inside the band
+	DriveForward(STEP_RPM, 0);
+	float Band = STEP_RPM * SETTLE_BAND_PERCENT / 100;
+	float Peak = 0, Sum[2] = {0, 0};
+	uint32_t Settled = 0;
+	for (uint32_t Time = 1; Time <= STEP_MS; Time++) {
+		Run(1);
+		for (uint8_t Motor = RIGHT_MOTOR; Motor <= LEFT_MOTOR; Motor++) {
+			float RPM = MotorSim_GetRPM(Motor);
+			if (fabsf(RPM - STEP_RPM) > Band) Settled = Time;
+			if (RPM - STEP_RPM > Peak) Peak = RPM - STEP_RPM;
+			if (Time > STEP_MS - STEADY_WINDOW_MS) Sum[Motor] += RPM;
+		}
+	}
+	Result->SettleMS = Settled;
+	Result->Overshoot = Peak * 100 / STEP_RPM;
+	float ErrorR = Sum[RIGHT_MOTOR] / STEADY_WINDOW_MS - STEP_RPM;
+	float ErrorL = Sum[LEFT_MOTOR] / STEADY_WINDOW_MS - STEP_RPM;
+	Result->SteadyError = (fabsf(ErrorR) > fabsf(ErrorL)) ? ErrorR : ErrorL;
+	StopMotors();
+	Run(REST_MS);
+
+	// Distance move, finished as the DriveMotorsService does
+	float StartR = MotorSim_GetDistanceMM(RIGHT_MOTOR);
+	float StartL = MotorSim_GetDistanceMM(LEFT_MOTOR);
+	LastServiceEvent = ES_NO_EVENT;
+	DriveForwardWithSetDistance(MOVE_RPM, MOVE_MM);
+	uint32_t Time = 0;
+	while (LastServiceEvent != E_MOTOR_SETTLED && Time < MOVE_LIMIT_MS) {
+		Run(1);
+		Time++;
+	}
+	Result->MoveMS = Time;
+	Result->Arrived = (LastServiceEvent == E_MOTOR_SETTLED && GetPositionMoveResult() == MOVE_ARRIVED);
+	StopMotors();
+	Run(REST_MS);
+	Result->DistanceError = (MotorSim_GetDistanceMM(RIGHT_MOTOR) - StartR + \
+		MotorSim_GetDistanceMM(LEFT_MOTOR) - StartL) / 2 - MOVE_MM;
+	Result->Done = true;
+}
+
+/****************************************************************************
+Function:			Run
+Parameters:		uint32_t DurationMS
+Returns:			void
+Description:	Runs the model and the control ISR for DurationMS
+****************************************************************************/
+static void Run(uint32_t DurationMS) {
+	for (uint32_t n = 0; n < DurationMS; n++) {
+		NowUS += CONTROL_PERIOD_US;
+		MotorSim_Step(NowUS);
+		SetRPMResponse();
+	}
+}
+
+/****************************************************************************
+Function:			MakePlant
+Parameters:		uint32_t Plant, which of the random plants
+							MotorSimWheel_t Wheels[2], MotorSimSurface_t *Surface,
+							MotorSimBattery_t *Battery, set to the plant
+Returns:			void
+Description:	The same Plant is the same plant for every parameter set, so
+							the sets are compared on equal terms
+****************************************************************************/
+static void MakePlant(uint32_t Plant, MotorSimWheel_t Wheels[2], MotorSimSurface_t *Surface, \
+	MotorSimBattery_t *Battery) {
+	uint32_t State = Plant * 2654435761u + 1;
+	for (uint8_t Motor = RIGHT_MOTOR; Motor <= LEFT_MOTOR; Motor++) {
+		MotorSimWheel_t *Wheel = &Wheels[Motor];
+		*Wheel = MotorSimDefaultWheel[Motor];
+		Wheel->ArmatureOhms *= Spread(&State, 1 - PLANT_SPREAD, 1 + PLANT_SPREAD);
+		Wheel->BackEMF *= Spread(&State, 1 - PLANT_SPREAD, 1 + PLANT_SPREAD);
+		Wheel->RotorInertia *= Spread(&State, 1 - PLANT_SPREAD, 1 + PLANT_SPREAD);
+		Wheel->StaticTorque *= Spread(&State, 1 - PLANT_SPREAD, 1 + PLANT_SPREAD);
+		Wheel->CoulombTorque *= Spread(&State, 1 - PLANT_SPREAD, 1 + PLANT_SPREAD);
+		Wheel->ViscousTorque *= Spread(&State, 1 - PLANT_SPREAD, 1 + PLANT_SPREAD);
+		// Static friction can't be less than sliding
+		if (Wheel->StaticTorque < Wheel->CoulombTorque) Wheel->StaticTorque = Wheel->CoulombTorque;
+	}
+	*Surface = MotorSimFloor;
+	Surface->KartMassKg = Spread(&State, MIN_KART_KG, MAX_KART_KG);
+	*Battery = MotorSimDefaultBattery;
+	Battery->Volts = Spread(&State, MIN_BATTERY_VOLTS, MAX_BATTERY_VOLTS);
+}
+
+/****************************************************************************
+Function:			Spread
+Parameters:		uint32_t *State, the generator
+							float Low, High
+Returns:			float, uniformly random from Low to High
+Description:	Linear congruential generator, repeatable for a plant
+****************************************************************************/
+static float Spread(uint32_t *State, float Low, float High) {
+	*State = *State * 1103515245u + 12345u;
+	return Low + (High - Low) * (float)((*State >> 8) & 0xffff) / 0xffff;
+}
+
+/****************************************************************************
+Function:			Cost
+Parameters:		uint32_t Job
+Returns:			float, lower is better
+Description:	Settling, overshoot and distance error, one point at each's
+							scale, and a move that didn't arrive costs NOT_ARRIVED_COST
+****************************************************************************/
+static float Cost(uint32_t Job) {
+	const SweepResult_t *Result = &Results[Job];
+	if (!Result->Done) return FAILED_COST;
+	return Result->SettleMS / SETTLE_SCALE_MS + Result->Overshoot / OVERSHOOT_SCALE + \
+		fabsf(Result->DistanceError) / DISTANCE_SCALE_MM + (Result->Arrived ? 0 : NOT_ARRIVED_COST);
+}
+
+/****************************************************************************
+Function:			CompareSets
+Parameters:		const void *a, *b, indexes into SetCost
+Returns:			int, for qsort, cheapest first
+Description:	Orders the parameter sets by their mean cost
+****************************************************************************/
+static int CompareSets(const void *a, const void *b) {
+	float CostA = SetCost[*(const uint32_t *)a];
+	float CostB = SetCost[*(const uint32_t *)b];
+	return (CostA > CostB) - (CostA < CostB);
+}
+
+/****************************************************************************
+Function:			WriteResults
+Parameters:		const char *Prefix, for the file names
+Returns:			bool, true if both files were written
+Description:	Every run to <Prefix>_runs.csv, the sets ranked by mean cost
+							to <Prefix>_ranked.csv, and the best TOP_SETS printed
+****************************************************************************/
+static bool WriteResults(const char *Prefix) {
+	char Name[256];
+	snprintf(Name, sizeof(Name), "%s_runs.csv", Prefix);
+	FILE *Runs = fopen(Name, "w");
+	snprintf(Name, sizeof(Name), "%s_ranked.csv", Prefix);
+	FILE *Ranked = fopen(Name, "w");
+	if (Runs == NULL || Ranked == NULL) {
+		perror(Name);
+		return false;
+	}
+
+	fprintf(Runs, "set,plant,p,i,accel,jerk,done,settle_ms,overshoot_pct,steady_error_rpm,"
+		"move_ms,distance_error_mm,arrived,cost\n");
+	for (uint32_t Set = 0; Set < NUM_SETS; Set++) {
+		float p = SweepP[Set % COUNT(SweepP)];
+		float i = SweepI[Set / COUNT(SweepP) % COUNT(SweepI)];
+		uint32_t Accel = SweepAccel[Set / (COUNT(SweepP) * COUNT(SweepI)) % COUNT(SweepAccel)];
+		uint32_t Jerk = SweepJerk[Set / (COUNT(SweepP) * COUNT(SweepI) * COUNT(SweepAccel))];
+		SetCost[Set] = 0;
+		SetOrder[Set] = Set;
+		for (uint32_t Plant = 0; Plant < Plants; Plant++) {
+			uint32_t Job = Set * Plants + Plant;
+			const SweepResult_t *Result = &Results[Job];
+			fprintf(Runs, "%lu,%lu,%.4f,%.4f,%lu,%lu,%d,%.0f,%.2f,%.2f,%.0f,%.1f,%d,%.3f\n", \
+				(unsigned long)Set, (unsigned long)Plant, p, i, (unsigned long)Accel, (unsigned long)Jerk, \
+				Result->Done, Result->SettleMS, Result->Overshoot, Result->SteadyError, \
+				Result->MoveMS, Result->DistanceError, Result->Arrived, Cost(Job));
+			SetCost[Set] += Cost(Job) / Plants;
+		}
+	}
+	fclose(Runs);
+
+	qsort(SetOrder, NUM_SETS, sizeof(SetOrder[0]), CompareSets);
+	fprintf(Ranked, "rank,set,p,i,accel,jerk,mean_cost,worst_cost,mean_settle_ms,worst_overshoot_pct,"
+		"worst_distance_error_mm,arrived\n");
+	printf("Rank  Set      p       i  accel    jerk   cost  worst  settle ms  overshoot  distance  arrived\r\n");
+	for (uint32_t Rank = 0; Rank < NUM_SETS; Rank++) {
+		uint32_t Set = SetOrder[Rank];
+		float Worst = 0, Settle = 0, Overshoot = 0, Distance = 0;
+		uint32_t Arrived = 0;
+		for (uint32_t Plant = 0; Plant < Plants; Plant++) {
+			uint32_t Job = Set * Plants + Plant;
+			const SweepResult_t *Result = &Results[Job];
+			if (Cost(Job) > Worst) Worst = Cost(Job);
+			Settle += Result->SettleMS / Plants;
+			if (Result->Overshoot > Overshoot) Overshoot = Result->Overshoot;
+			if (fabsf(Result->DistanceError) > fabsf(Distance)) Distance = Result->DistanceError;
+			if (Result->Arrived) Arrived++;
+		}
+		float p = SweepP[Set % COUNT(SweepP)];
+		float i = SweepI[Set / COUNT(SweepP) % COUNT(SweepI)];
+		uint32_t Accel = SweepAccel[Set / (COUNT(SweepP) * COUNT(SweepI)) % COUNT(SweepAccel)];
+		uint32_t Jerk = SweepJerk[Set / (COUNT(SweepP) * COUNT(SweepI) * COUNT(SweepAccel))];
+		fprintf(Ranked, "%lu,%lu,%.4f,%.4f,%lu,%lu,%.3f,%.3f,%.0f,%.2f,%.1f,%lu\n", (unsigned long)Rank + 1, \
+			(unsigned long)Set, p, i, (unsigned long)Accel, (unsigned long)Jerk, SetCost[Set], Worst, \
+			Settle, Overshoot, Distance, (unsigned long)Arrived);
+		if (Rank < TOP_SETS) {
+			printf("%4lu  %3lu  %.3f  %.4f  %5lu  %6lu  %5.2f  %5.2f  %9.0f  %8.1f%%  %5.1f mm  %4lu/%lu\r\n", \
+				(unsigned long)Rank + 1, (unsigned long)Set, p, i, (unsigned long)Accel, (unsigned long)Jerk, \
+				SetCost[Set], Worst, Settle, Overshoot, Distance, (unsigned long)Arrived, (unsigned long)Plants);
+		}
+	}
+	fclose(Ranked);
+	printf("Wrote %s_runs.csv and %s_ranked.csv\r\n", Prefix, Prefix);
+	return true;
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,253 @@
+/****************************************************************************
+Module: PIDCompareMain.c
+Description:
+	Host check of the fixed-point PID (PIDController.c). Three loops drive
+	the right wheel of the motor simulator (MotorSim.c) through the same
+	target and gain schedule at 1kHz, one after the other from the same
+	reset, as the model is the one every drive tool runs against:
+	- the float loop it replaced, as it was in DriveMotorsPID.c
+	- the new control law in float, as the numerical reference
+	- the fixed-point loop
+	The fixed-point loop has to match the float version of its law to a
+	duty cycle count given the same speeds, the float law shadowing it, and
+	run on its own to within MAX_SPEED_DIFFERENCE, and track at least as
+	well as the old loop, or the check fails and exits 1. The duties are
+	compared on the same speeds as the model's static friction and the
+	saturation turn a one RPM difference in what the loops read into a few
+	percent of duty.
+
+	Build from the project directory on a PC with TivaWare checked out:
+		gcc -std=gnu99 -O2 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o pidcompare \
+			Host/PIDCompareMain.c Host/MotorSim.c Host/FaultSim.c \
+			Source/PIDController.c -lm
+
+	Usage:
+		pidcompare
+	Exits 0 if the fixed-point loop is within the limits below, 1 if not.
+Author: Kyle Moy, 3/7/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Framework Libraries
+#include "ES_Port.h"
+
+// Module Libraries
+#include "MotorSim.h"
+#include "DriveMotors.h"
+#include "DriveMotorEncoder.h"
+#include "PIDController.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define CONTROL_PERIOD_US					1000
+#define MODEL_SEED								1
+// Room for the legs below
+#define MAX_RUN_MS								10000
+
+// The loops, each run on the model in turn
+typedef enum {
+	LOOP_OLD_FLOAT,				// The float loop it replaced
+	LOOP_NEW_FLOAT,				// The new law in float
+	LOOP_FIXED,						// PIDController.c
+	NUM_LOOPS
+} Loop_t;
+
+// Limits on the fixed-point loop against the float version of its law
+#define MAX_DUTY_DIFFERENCE				1
+#define MAX_SPEED_DIFFERENCE			2.0f
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t FloatPIDUpdate(float TargetRPM, float RPM);
+static uint8_t ReferencePIDUpdate(float TargetRPM, float RPM);
+static void RunLoop(Loop_t Loop);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint32_t NowUS;
+
+// The float loop as it was in DriveMotorsPID.c
+static float pGain, iGain, dGain;
+static float SumError, LastError;
+
+// The new law in float
+static float RefIntegral, RefLastRPM;
+
+// Target RPM and gains for each leg of the run, like a lap of SM_Racing
+typedef struct {
+	uint16_t	DurationMS;
+	uint16_t	TargetRPM;
+	float			p, i, d;
+} Leg_t;
+
+static const Leg_t Legs[] = {
+	{1500, 500, 0.1f, 0.5f, 0.0f},
+	{1000, 105, 0.05f, 0.02f, 0.0f},
+	{1000, 200, 0.05f, 0.02f, 0.0f},
+	{ 500,   0, 0.05f, 0.02f, 0.0f},
+	{1500, 500, 0.1f, 0.5f, 0.0f},
+	{1000, 300, 0.05f, 0.02f, 0.01f},
+	{1000,  40, 0.05f, 0.02f, 0.0f}
+};
+#define NUM_LEGS (sizeof(Legs)/sizeof(Legs[0]))
+
+// Each loop's run, its duty and the model's speed every ms, and the speed
+// at the end of each leg
+static uint8_t Duty[NUM_LOOPS][MAX_RUN_MS];
+static float Speed[NUM_LOOPS][MAX_RUN_MS];
+static float LegEndRPM[NUM_LOOPS][NUM_LEGS];
+// The new law in float on the fixed loop's speeds
+static uint8_t ShadowDuty[MAX_RUN_MS];
+static uint32_t Samples;
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(void) {
+	float MaxSpeedDifference = 0;
+	int MaxDutyDifference = 0;
+	uint32_t DutyMismatches = 0;
+	double FloatSquaredError = 0, ReferenceSquaredError = 0, FixedSquaredError = 0;
+
+	for (Loop_t Loop = LOOP_OLD_FLOAT; Loop < NUM_LOOPS; Loop++) RunLoop(Loop);
+	for (uint8_t Leg = 0; Leg < NUM_LEGS; Leg++) {
+		printf("Leg %d: target %3d RPM, p %.2f i %.2f d %.2f -> old float %5.1f, new float %5.1f, fixed %5.1f RPM\r\n", \
+			Leg + 1, Legs[Leg].TargetRPM, Legs[Leg].p, Legs[Leg].i, Legs[Leg].d, LegEndRPM[LOOP_OLD_FLOAT][Leg], \
+			LegEndRPM[LOOP_NEW_FLOAT][Leg], LegEndRPM[LOOP_FIXED][Leg]);
+	}
+
+	uint32_t ms = 0;
+	for (uint8_t Leg = 0; Leg < NUM_LEGS; Leg++) {
+		for (uint16_t t = 0; t < Legs[Leg].DurationMS; t++, ms++) {
+			int DutyDifference = abs((int)ShadowDuty[ms] - (int)Duty[LOOP_FIXED][ms]);
+			if (DutyDifference > MaxDutyDifference) MaxDutyDifference = DutyDifference;
+			if (DutyDifference != 0) DutyMismatches++;
+			float SpeedDifference = fabsf(Speed[LOOP_NEW_FLOAT][ms] - Speed[LOOP_FIXED][ms]);
+			if (SpeedDifference > MaxSpeedDifference) MaxSpeedDifference = SpeedDifference;
+			FloatSquaredError += pow(Legs[Leg].TargetRPM - Speed[LOOP_OLD_FLOAT][ms], 2);
+			ReferenceSquaredError += pow(Legs[Leg].TargetRPM - Speed[LOOP_NEW_FLOAT][ms], 2);
+			FixedSquaredError += pow(Legs[Leg].TargetRPM - Speed[LOOP_FIXED][ms], 2);
+		}
+	}
+
+	printf("Fixed vs new float: %lu samples, duty differed on %lu (max %d%%), max speed difference %.2f RPM\r\n", \
+		(unsigned long)Samples, (unsigned long)DutyMismatches, MaxDutyDifference, MaxSpeedDifference);
+	printf("RMS tracking error: old float %.2f RPM, new float %.2f RPM, fixed %.2f RPM\r\n", \
+		sqrt(FloatSquaredError / Samples), sqrt(ReferenceSquaredError / Samples), sqrt(FixedSquaredError / Samples));
+
+	bool Pass = true;
+	if (MaxDutyDifference > MAX_DUTY_DIFFERENCE) {
+		printf("Duty differed by more than %d%%\r\n", MAX_DUTY_DIFFERENCE);
+		Pass = false;
+	}
+	if (MaxSpeedDifference > MAX_SPEED_DIFFERENCE) {
+		printf("Speed differed by more than %.1f RPM\r\n", MAX_SPEED_DIFFERENCE);
+		Pass = false;
+	}
+	if (FixedSquaredError > FloatSquaredError) {
+		printf("Fixed point tracked worse than the old float loop\r\n");
+		Pass = false;
+	}
+	printf("%s\r\n", Pass ? "PASS" : "FAIL");
+	return Pass ? 0 : 1;
+}
+
+
+// Host port, the virtual clock is kept here rather than by ES_Port.c
+uint32_t _HW_GetMicros(void) { return NowUS; }
+// No SysTick, FaultSim.c's tick delay has nothing to hold off
+uint16_t _HW_GetTickCount(void) { return 0; }
+void _HW_DelayTick(uint32_t DelayUS) {}
+
+// The loops are given the model's speed, not its encoder edges
+void RDriveCaptureResponse(void) {}
+void LDriveCaptureResponse(void) {}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			RunLoop
+Parameters:		Loop_t Loop, which one
+Returns:			void
+Description:	Drives the right wheel through the legs from a standstill
+****************************************************************************/
+static void RunLoop(Loop_t Loop) {
+	PIDController_t PID;
+	MotorSim_Init(MotorSimDefaultWheel, MotorSimFloor, MotorSimDefaultBattery, MODEL_SEED);
+	MotorSim_Step(NowUS);
+	ResetPIDController(&PID);
+	SumError = LastError = 0;
+	RefIntegral = RefLastRPM = 0;
+	Samples = 0;
+	float RPM = 0;
+	for (uint8_t Leg = 0; Leg < NUM_LEGS; Leg++) {
+		pGain = Legs[Leg].p; iGain = Legs[Leg].i; dGain = Legs[Leg].d;
+		SetPIDControllerGains(&PID, Legs[Leg].p, Legs[Leg].i, Legs[Leg].d);
+		for (uint16_t ms = 0; ms < Legs[Leg].DurationMS && Samples < MAX_RUN_MS; ms++) {
+			// The encoder reports whole RPM
+			uint32_t Measured = (RPM > 0) ? (uint32_t)RPM : 0;
+			uint8_t LoopDuty;
+			switch (Loop) {
+				case LOOP_OLD_FLOAT: LoopDuty = FloatPIDUpdate(Legs[Leg].TargetRPM, Measured); break;
+				case LOOP_NEW_FLOAT: LoopDuty = ReferencePIDUpdate(Legs[Leg].TargetRPM, Measured); break;
+				default:
+					LoopDuty = UpdatePIDController(&PID, Legs[Leg].TargetRPM, Measured, 0, 0);
+					ShadowDuty[Samples] = ReferencePIDUpdate(Legs[Leg].TargetRPM, Measured);
+					break;
+			}
+			MotorSim_SetDrive(RIGHT_MOTOR, LoopDuty, FORWARD);
+			NowUS += CONTROL_PERIOD_US;
+			MotorSim_Step(NowUS);
+			RPM = MotorSim_GetRPM(RIGHT_MOTOR);
+			Duty[Loop][Samples] = LoopDuty;
+			Speed[Loop][Samples] = RPM;
+			Samples++;
+		}
+		LegEndRPM[Loop][Leg] = RPM;
+	}
+}
+
+/****************************************************************************
+Function:			FloatPIDUpdate
+Parameters:		float TargetRPM, float RPM
+Returns:			uint8_t, the duty cycle
+Description:	The float control law from SetRPMResponse, for reference
+****************************************************************************/
+static uint8_t FloatPIDUpdate(float TargetRPM, float RPM) {
+	float RPMError = TargetRPM - RPM;
+	SumError += RPMError;
+	int32_t RequestedDuty = (pGain * ((RPMError) + (iGain * SumError) + (dGain * (RPMError - LastError))));
+	if (RequestedDuty > 100) {
+		RequestedDuty = 100;
+		SumError -= RPMError; /* anti-windup */
+	} else if (RequestedDuty < 0) {
+		RequestedDuty = 0;
+		SumError -= RPMError; /* anti-windup */
+	}
+	LastError = RPMError;
+	return RequestedDuty;
+}
+
+/****************************************************************************
+Function:			ReferencePIDUpdate
+Parameters:		float TargetRPM, float RPM
+Returns:			uint8_t, the duty cycle
+Description:	The PIDController.c control law in float
+****************************************************************************/
+static uint8_t ReferencePIDUpdate(float TargetRPM, float RPM) {
+	float Error = TargetRPM - RPM;
+	float LastIntegral = RefIntegral;
+	RefIntegral = fmaxf(-100, fminf(100, RefIntegral + pGain * iGain * Error));
+	float Output = pGain * Error + RefIntegral - pGain * dGain * (RPM - RefLastRPM);
+	RefLastRPM = RPM;
+	if ((Output > 100 && Error > 0) || (Output < 0 && Error < 0)) {
+		Output -= RefIntegral - LastIntegral;
+		RefIntegral = LastIntegral;
+	}
+	return (uint8_t)fmaxf(0, fminf(100, Output));
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,568 @@
+/****************************************************************************
+Module: RaceSim.c
+Description:
+	Host-side model of the gamefield and our Kart on it.
+	Field: the outer walls of GamefieldPositions.h's track, with the infield
+	open the way the ball launching and obstacle crossing areas are. The
+	obstacle itself is not modeled, the Kart drives across it as if flat.
+	Frame: positions are DRS units and Theta is the DRS's. The firmware's
+	maneuvers only go round the DRS's Straight1-4 in order if the DRS's
+	Theta grows clockwise seen from above, the corner pivot is to the left
+	(PIVOT_CCW) and DriveForwardWithBias runs the left wheel faster to hold
+	the Kart to the outer wall on its right. So a left turn, the right
+	wheel further than the left, takes Theta down here.
+	Kart: the wheels are the motor simulator's, without slip, so each step
+	moves the Kart by what they turned. The body is a rectangle on the
+	axle. Where a corner of it meets a wall it is pushed back out, and the
+	wheels are held to the nearest speeds that don't drive it further in,
+	so the Kart stalls head on against a wall and squares up backing into
+	one the way the corner maneuvers expect.
+	Sensors: the bump switch on the front bumper, and the IR sensor, which
+	sees the beacon inside its half angle and range. Each beacon edge is
+	latched as the capture and BeaconSensedCaptureResponse is called, as the
+	wide timer would.
+	Ball launcher: with the shooter on for long enough, the servo going
+	forward launches a ball straight ahead, which hits if it passes inside
+	the target's half width.
+	Referee: laps, the obstacle and the target for our Kart, from the zones
+	it drives through, handed to the DRS simulator to report.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <math.h>
+
+// Hardware Libraries (register offsets and bit names only)
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_pwm.h"
+#include "driverlib/gpio.h"
+
+// Module Libraries
+#include "RaceSim.h"
+#include "HW_Port.h"
+#include "MotorSim.h"
+#include "DRSSim.h"
+#include "DriveMotors.h"
+#include "BeaconSensor.h"
+#include "GamefieldPositions.h"
+#include "FaultSim.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define MM_PER_UNIT					8.0f
+#define WHEEL_BASE_MM				200.0f
+#define WHEEL_DIAMETER_MM		94.0f
+#define PI									3.14159265f
+#define DEGREES							(180.0f / PI)
+
+// The body, from the middle of the axle, and how far the bumper moves
+// before the switch closes
+#define FRONT_MM						150.0f
+#define REAR_MM							100.0f
+#define HALF_WIDTH_MM				125.0f
+#define BUMPER_TRAVEL_MM		2.0f
+// Within this of a wall a corner is touching it
+#define CONTACT_MM					0.5f
+// Passes over the contacts, so one wheel speed meets them all
+#define CONTACT_PASSES			4
+#define NUM_CORNERS					4
+#define NUM_WALLS						4
+
+// The beacon's rising edges, which BeaconSensor.c reads as a 1550us period,
+// inside its window, and how far off the IR sensor sees it
+#define BEACON_EDGE_US			775
+#define BEACON_RANGE				400
+
+// The ball launcher. BallLauncher.c's servo pulse is 30us forward and 48us
+// in reverse, the compare is half the pulse in 40MHz ticks.
+#define SHOOTER_PIN					GPIO_PIN_7
+#define SHOOTER_SPINUP_MS		500
+#define SERVO_FORWARD_BELOW_US	39
+#define BALL_RANGE					300
+#define PWM_REG_SPACE				0x1000
+#define SHOOTER_LOAD				((40000 * HW_TICKS_PER_US) >> 1)
+
+// The pins, active low bump switch on D1 with its pull up, Kart switch on
+// E0-E2 and race LED on F2
+#define BUMP_PIN						GPIO_PIN_1
+#define RACE_LED_PIN				GPIO_PIN_2
+#define ALL_PINS						0xff
+
+/*---------------------------- Module Functions ---------------------------*/
+static void MoveKart(void);
+static void MeetWalls(uint32_t ElapsedUS);
+static void SenseBeacon(uint32_t NowUS);
+static void LaunchBall(void);
+static void Referee(uint32_t NowUS);
+static void ReportPose(void);
+static void CornerPoint(uint8_t Corner, float *PX, float *PY, float *Forward, float *Right);
+
+/*---------------------------- Module Variables ---------------------------*/
+const RaceSimField_t RaceSimDefaultField = {300, 180, 0, 150, 20, 6};
+
+static RaceSimField_t Field;
+static RaceSimKart_t MyKart;
+static RaceSimStats_t Stats;
+static uint32_t NowUS;
+static uint32_t LastUS;
+static uint32_t WallContactUS;
+static bool Started;
+
+// The Kart, units and degrees, and the wheels' travel when it was last moved
+static float KartX, KartY, KartTheta;
+static float LastWheelMM[2];
+
+// Corners of the body from the middle of the axle, + Forward and + Right
+static const float CornerForward[NUM_CORNERS] = {FRONT_MM, FRONT_MM, -REAR_MM, -REAR_MM};
+static const float CornerRight[NUM_CORNERS] = {-HALF_WIDTH_MM, HALF_WIDTH_MM, -HALF_WIDTH_MM, HALF_WIDTH_MM};
+#define FRONT_LEFT		0
+#define FRONT_RIGHT		1
+
+// The pins and registers the firmware drives
+static bool BumpPressed;
+static uint32_t PortA;
+static uint32_t PortF;
+static uint32_t PWMRegs[PWM_REG_SPACE/4];
+static uint32_t BeaconCapture;
+static uint32_t NextBeaconEdgeUS;
+static uint32_t ShooterOnUS;
+static bool ServoForward;
+
+// The referee
+static bool Racing;
+static uint32_t LapStartUS;
+static GamefieldPosition_t Zone;
+static bool PassedStraight2;
+static bool PassedStraight3;
+static bool OnObstacle;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			RaceSim_Init
+Parameters:		RaceSimField_t Field, the gamefield
+							RaceSimKart_t Kart, our Kart, where it starts and its laps
+Returns:			void
+Description:	Puts the Kart on the field and hands it over from the DRS
+							simulator's script. MotorSim_Init first.
+****************************************************************************/
+void RaceSim_Init(RaceSimField_t NewField, RaceSimKart_t Kart) {
+	Field = NewField;
+	MyKart = Kart;
+	if (MyKart.Laps > RACESIM_MAX_LAPS) MyKart.Laps = RACESIM_MAX_LAPS;
+	Stats = (RaceSimStats_t){0};
+	WallContactUS = 0;
+	Started = false;
+	KartX = Kart.X;
+	KartY = Kart.Y;
+	KartTheta = Kart.Theta;
+	BumpPressed = false;
+	PortA = 0;
+	PortF = 0;
+	for (uint32_t i = 0; i < PWM_REG_SPACE/4; i++) PWMRegs[i] = 0;
+	PWMRegs[PWM_O_2_LOAD/4] = SHOOTER_LOAD;
+	ServoForward = false;
+	BeaconCapture = 0;
+	NextBeaconEdgeUS = 0;
+	Racing = false;
+	Zone = GetGamefieldPosition((uint16_t)KartX, (uint16_t)KartY);
+	PassedStraight2 = false;
+	PassedStraight3 = false;
+	OnObstacle = false;
+	ReportPose();
+	DRSSim_SetKartStatus(MyKart.KartNumber, MyKart.Laps, false, false);
+}
+
+/****************************************************************************
+Function:			RaceSim_Step
+Parameters:		uint32_t NowUS, the virtual time
+Returns:			void
+Description:	Moves the Kart on what the wheels did since the last step,
+							after MotorSim_Step, and runs the sensors and the referee
+****************************************************************************/
+void RaceSim_Step(uint32_t Now) {
+	NowUS = Now;
+	if (!Started) {
+		Started = true;
+		LastUS = NowUS;
+		NextBeaconEdgeUS = NowUS + BEACON_EDGE_US;
+		LastWheelMM[RIGHT_MOTOR] = MotorSim_GetDistanceMM(RIGHT_MOTOR);
+		LastWheelMM[LEFT_MOTOR] = MotorSim_GetDistanceMM(LEFT_MOTOR);
+		return;
+	}
+	MoveKart();
+	MeetWalls(NowUS - LastUS);
+	SenseBeacon(NowUS);
+	Referee(NowUS);
+	ReportPose();
+	LastUS = NowUS;
+}
+
+/****************************************************************************
+Function:			RaceSim_StartRace
+Parameters:		uint32_t NowUS, when the flag dropped
+Returns:			void
+Description:	Starts the referee and the lap clock
+****************************************************************************/
+void RaceSim_StartRace(uint32_t Now) {
+	if (Racing) return;
+	Racing = true;
+	LapStartUS = Now;
+}
+
+/****************************************************************************
+Function:			RaceSim_GetPose
+Parameters:		float *X, *Y, *Theta, filled in with the true pose
+Returns:			void
+Description:	DRS units and degrees, Theta as the DRS reports it
+****************************************************************************/
+void RaceSim_GetPose(float *X, float *Y, float *Theta) {
+	*X = KartX;
+	*Y = KartY;
+	*Theta = KartTheta;
+}
+
+/****************************************************************************
+Function:			RaceSim_GetStats
+Parameters:		void
+Returns:			RaceSimStats_t, what has happened since RaceSim_Init
+Description:	For the race report
+****************************************************************************/
+RaceSimStats_t RaceSim_GetStats(void) {
+	return Stats;
+}
+
+/****************************************************************************
+Function:			RaceSim_PrintStats
+Parameters:		void
+Returns:			void
+Description:	Prints the laps and what the Kart did on the field
+****************************************************************************/
+void RaceSim_PrintStats(void) {
+	printf("Race Sim: Kart %d, %d of %d laps", MyKart.KartNumber, Stats.LapsDone, MyKart.Laps);
+	for (uint8_t Lap = 0; Lap < Stats.LapsDone; Lap++) {
+		printf("%s%.2f s", (Lap == 0) ? ": " : ", ", Stats.LapTimesMS[Lap] / 1000.0f);
+	}
+	printf("\r\n");
+	printf("Race Sim: obstacle %s, target %s, %lu of %lu balls hit\r\n", \
+		Stats.ObstacleCompleted ? "completed" : "not completed", \
+		Stats.TargetSuccess ? "hit" : "not hit", \
+		(unsigned long)Stats.TargetHits, (unsigned long)Stats.BallsLaunched);
+	printf("Race Sim: %.2f m driven, %lu bumps, %.1f s against a wall, %lu beacon edges\r\n", \
+		Stats.DistanceMM / 1000, (unsigned long)Stats.Bumps, Stats.WallContactMS / 1000.0f, \
+		(unsigned long)Stats.BeaconEdges);
+	printf("Race Sim: Kart at (%.1f, %.1f, %.1f), %s\r\n", KartX, KartY, KartTheta, \
+		GamefieldPositionString(GetGamefieldPosition((uint16_t)KartX, (uint16_t)KartY)));
+}
+
+/****************************************************************************
+Function:			RaceSim_ReadGPIO
+Parameters:		uint32_t Base, the port's base address
+Returns:			uint32_t, the port's pins
+Description:	The data register, all eight pins. Unused inputs read high
+							on their pull ups.
+****************************************************************************/
+uint32_t RaceSim_ReadGPIO(uint32_t Base) {
+	switch (Base) {
+		case GPIO_PORTA_BASE:
+			return PortA;
+		case GPIO_PORTD_BASE:
+			if (FaultSim_Inject(FAULT_BUMP_STUCK)) return ALL_PINS & ~BUMP_PIN;
+			return BumpPressed ? (ALL_PINS & ~BUMP_PIN) : ALL_PINS;
+		case GPIO_PORTE_BASE:
+			// The switch grounds the pins that ReadKartSwitch doesn't test high
+			if (MyKart.KartNumber == 2) return GPIO_PIN_0 | GPIO_PIN_1;
+			if (MyKart.KartNumber == 3) return GPIO_PIN_1 | GPIO_PIN_2;
+			return 0;
+		case GPIO_PORTF_BASE:
+			return PortF;
+		default:
+			return ALL_PINS;
+	}
+}
+
+/****************************************************************************
+Function:			RaceSim_WriteGPIO
+Parameters:		uint32_t Base, the port's base address
+							uint32_t Value, all eight pins
+Returns:			void
+Description:	The shooter motor on A7 and the race LED on F2
+****************************************************************************/
+void RaceSim_WriteGPIO(uint32_t Base, uint32_t Value) {
+	switch (Base) {
+		case GPIO_PORTA_BASE:
+			if ((Value & SHOOTER_PIN) && !(PortA & SHOOTER_PIN)) ShooterOnUS = NowUS;
+			PortA = Value;
+			break;
+		case GPIO_PORTF_BASE:
+			PortF = Value;
+			break;
+		default:
+			break;
+	}
+}
+
+/****************************************************************************
+Function:			RaceSim_GetBeaconCapture
+Parameters:		void
+Returns:			uint32_t, the last beacon edge in HW_TIMESTAMP() ticks
+Description:	The capture register, read by the beacon capture ISR
+****************************************************************************/
+uint32_t RaceSim_GetBeaconCapture(void) {
+	return BeaconCapture;
+}
+
+/****************************************************************************
+Function:			RaceSim_ReadPWM
+Parameters:		uint32_t Offset, the PWM0 register offset (PWM_O_xx)
+Returns:			uint32_t, the register value
+Description:	Reads back what was written
+****************************************************************************/
+uint32_t RaceSim_ReadPWM(uint32_t Offset) {
+	return (Offset < PWM_REG_SPACE) ? PWMRegs[Offset/4] : 0;
+}
+
+/****************************************************************************
+Function:			RaceSim_WritePWM
+Parameters:		uint32_t Offset, the PWM0 register offset (PWM_O_xx)
+							uint32_t Value, the value to write
+Returns:			void
+Description:	The servo's compare going to the forward pulse launches a ball
+****************************************************************************/
+void RaceSim_WritePWM(uint32_t Offset, uint32_t Value) {
+	if (Offset >= PWM_REG_SPACE) return;
+	PWMRegs[Offset/4] = Value;
+	if (Offset == PWM_O_3_CMPA) {
+		bool Forward = (Value * 2 / HW_TICKS_PER_US) < SERVO_FORWARD_BELOW_US;
+		if (Forward && !ServoForward) LaunchBall();
+		ServoForward = Forward;
+	}
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			MoveKart
+Parameters:		void
+Returns:			void
+Description:	Moves the Kart by the wheels' travel since the last step, along
+							the arc at the middle of the turn
+****************************************************************************/
+static void MoveKart(void) {
+	float WheelR = MotorSim_GetDistanceMM(RIGHT_MOTOR);
+	float WheelL = MotorSim_GetDistanceMM(LEFT_MOTOR);
+	float DistanceR = WheelR - LastWheelMM[RIGHT_MOTOR];
+	float DistanceL = WheelL - LastWheelMM[LEFT_MOTOR];
+	LastWheelMM[RIGHT_MOTOR] = WheelR;
+	LastWheelMM[LEFT_MOTOR] = WheelL;
+
+	float Distance = (DistanceR + DistanceL) / 2;
+	// A left turn, the right wheel further, takes the DRS's Theta down
+	float Turn = -(DistanceR - DistanceL) / WHEEL_BASE_MM;
+	float Heading = KartTheta / DEGREES + Turn / 2;
+	KartX += Distance * cosf(Heading) / MM_PER_UNIT;
+	KartY += Distance * sinf(Heading) / MM_PER_UNIT;
+	KartTheta = fmodf(KartTheta + Turn * DEGREES, 360.0f);
+	if (KartTheta < 0) KartTheta += 360.0f;
+	Stats.DistanceMM += fabsf(Distance);
+}
+
+/****************************************************************************
+Function:			MeetWalls
+Parameters:		uint32_t ElapsedUS, time since the last step
+Returns:			void
+Description:	Pushes the Kart back out of any wall it has driven into, holds
+							the wheels to speeds that don't drive it further in, and
+							works the bump switch. A wall is the half plane past one side
+							of the field, Normal . P >= Offset is clear of it.
+****************************************************************************/
+static void MeetWalls(uint32_t ElapsedUS) {
+	const float NormalX[NUM_WALLS] = {1, -1, 0, 0};
+	const float NormalY[NUM_WALLS] = {0, 0, 1, -1};
+	const float Offset[NUM_WALLS] = {0, -(float)Field.Width, 0, -(float)Field.Height};
+
+	// Out of the walls, deepest corner first
+	for (uint8_t Wall = 0; Wall < NUM_WALLS; Wall++) {
+		float Deepest = 0;
+		for (uint8_t Corner = 0; Corner < NUM_CORNERS; Corner++) {
+			float PX, PY, Forward, Right;
+			CornerPoint(Corner, &PX, &PY, &Forward, &Right);
+			float Depth = Offset[Wall] - (NormalX[Wall] * PX + NormalY[Wall] * PY);
+			if (Depth > Deepest) Deepest = Depth;
+		}
+		KartX += NormalX[Wall] * Deepest;
+		KartY += NormalY[Wall] * Deepest;
+	}
+
+	// Every corner touching a wall takes away the wheel speeds that would
+	// drive it in. Per wheel, Normal . (corner velocity) = AR*VR + AL*VL.
+	float Heading = KartTheta / DEGREES;
+	float HX = cosf(Heading), HY = sinf(Heading);
+	float VR = MotorSim_GetRPM(RIGHT_MOTOR) * PI * WHEEL_DIAMETER_MM / 60;
+	float VL = MotorSim_GetRPM(LEFT_MOTOR) * PI * WHEEL_DIAMETER_MM / 60;
+	float StartVR = VR, StartVL = VL;
+	bool Touching = false;
+	bool Bumper = false;
+	for (uint8_t Pass = 0; Pass < CONTACT_PASSES; Pass++) {
+		for (uint8_t Wall = 0; Wall < NUM_WALLS; Wall++) {
+			for (uint8_t Corner = 0; Corner < NUM_CORNERS; Corner++) {
+				float PX, PY, Forward, Right;
+				CornerPoint(Corner, &PX, &PY, &Forward, &Right);
+				float Gap = (NormalX[Wall] * PX + NormalY[Wall] * PY - Offset[Wall]) * MM_PER_UNIT;
+				if (Corner <= FRONT_RIGHT && Gap < BUMPER_TRAVEL_MM) Bumper = true;
+				if (Gap > CONTACT_MM) continue;
+				Touching = true;
+				// The corner's offset from the axle, in mm on the field, turned
+				// a quarter the way Theta grows
+				float RX = Forward * HX - Right * HY;
+				float RY = Forward * HY + Right * HX;
+				float Along = NormalX[Wall] * HX + NormalY[Wall] * HY;
+				float Across = NormalX[Wall] * -RY + NormalY[Wall] * RX;
+				// Theta's rate is -(VR - VL) / WHEEL_BASE_MM
+				float AR = Along / 2 - Across / WHEEL_BASE_MM;
+				float AL = Along / 2 + Across / WHEEL_BASE_MM;
+				float Into = AR * VR + AL * VL;
+				if (Into < 0) {
+					float Scale = Into / (AR * AR + AL * AL);
+					VR -= Scale * AR;
+					VL -= Scale * AL;
+				}
+			}
+		}
+	}
+	if (VR != StartVR) MotorSim_SetRPM(RIGHT_MOTOR, VR * 60 / (PI * WHEEL_DIAMETER_MM));
+	if (VL != StartVL) MotorSim_SetRPM(LEFT_MOTOR, VL * 60 / (PI * WHEEL_DIAMETER_MM));
+
+	if (Touching) {
+		WallContactUS += ElapsedUS;
+		Stats.WallContactMS = WallContactUS / 1000;
+	}
+	if (Bumper && !BumpPressed) Stats.Bumps++;
+	BumpPressed = Bumper;
+}
+
+/****************************************************************************
+Function:			SenseBeacon
+Parameters:		uint32_t NowUS, the virtual time
+Returns:			void
+Description:	Runs the beacon capture ISR for each edge up to NowUS that the
+							IR sensor, on the front of the Kart, can see
+****************************************************************************/
+static void SenseBeacon(uint32_t Now) {
+	float Heading = KartTheta / DEGREES;
+	float SensorX = KartX + FRONT_MM / MM_PER_UNIT * cosf(Heading);
+	float SensorY = KartY + FRONT_MM / MM_PER_UNIT * sinf(Heading);
+	float DX = Field.BeaconX - SensorX;
+	float DY = Field.BeaconY - SensorY;
+	float Off = fmodf(atan2f(DY, DX) * DEGREES - KartTheta + 540.0f, 360.0f) - 180.0f;
+	bool Seen = (fabsf(Off) <= Field.BeaconHalfAngle) && (hypotf(DX, DY) <= BEACON_RANGE);
+
+	while ((int32_t)(Now - NextBeaconEdgeUS) >= 0) {
+		// A glitch misses an edge in sight, or catches a reflection out of it
+		if (Seen != FaultSim_Inject(FAULT_BEACON_GLITCH)) {
+			BeaconCapture = NextBeaconEdgeUS * HW_TICKS_PER_US;
+			Stats.BeaconEdges++;
+			BeaconSensedCaptureResponse();
+		}
+		NextBeaconEdgeUS += BEACON_EDGE_US;
+	}
+}
+
+/****************************************************************************
+Function:			LaunchBall
+Parameters:		void
+Returns:			void
+Description:	The servo pushed a ball into the shooter. It only flies if the
+							shooter has spun up, then straight ahead from the front of
+							the Kart, and hits if it passes close enough to the beacon.
+****************************************************************************/
+static void LaunchBall(void) {
+	Stats.BallsLaunched++;
+	if (!(PortA & SHOOTER_PIN) || (NowUS - ShooterOnUS) < SHOOTER_SPINUP_MS * 1000u) return;
+
+	float Heading = KartTheta / DEGREES;
+	float HX = cosf(Heading), HY = sinf(Heading);
+	float DX = Field.BeaconX - (KartX + FRONT_MM / MM_PER_UNIT * HX);
+	float DY = Field.BeaconY - (KartY + FRONT_MM / MM_PER_UNIT * HY);
+	float Ahead = DX * HX + DY * HY;
+	float Aside = fabsf(DX * HY - DY * HX);
+	if (Ahead > 0 && Ahead <= BALL_RANGE && Aside <= Field.TargetHalfWidth) {
+		Stats.TargetHits++;
+		if (Racing) Stats.TargetSuccess = true;
+	}
+}
+
+/****************************************************************************
+Function:			Referee
+Parameters:		uint32_t NowUS, the virtual time
+Returns:			void
+Description:	Follows the Kart through the zones. A lap is back into
+							Straight1 having been down Straight2 and Straight3, the
+							obstacle is through the obstacle crossing area from Straight3
+							out to Straight1.
+****************************************************************************/
+static void Referee(uint32_t Now) {
+	GamefieldPosition_t NewZone = GetGamefieldPosition((uint16_t)KartX, (uint16_t)KartY);
+	if (NewZone == Zone || !Racing) {
+		Zone = NewZone;
+		return;
+	}
+
+	if (NewZone == Straight2) PassedStraight2 = true;
+	if (NewZone == Straight3) PassedStraight3 = true;
+	if (NewZone == ObstacleCrossingArea) {
+		if (Zone == Straight3) OnObstacle = true;
+	} else if (NewZone == Straight1) {
+		if (OnObstacle && Zone == ObstacleCrossingArea) Stats.ObstacleCompleted = true;
+		if (PassedStraight2 && PassedStraight3 && Stats.LapsDone < MyKart.Laps) {
+			Stats.LapTimesMS[Stats.LapsDone++] = (Now - LapStartUS) / 1000;
+			LapStartUS = Now;
+			PassedStraight2 = false;
+			PassedStraight3 = false;
+		}
+		OnObstacle = false;
+	} else {
+		OnObstacle = false;
+	}
+	Zone = NewZone;
+	DRSSim_SetKartStatus(MyKart.KartNumber, MyKart.Laps - Stats.LapsDone, \
+		Stats.ObstacleCompleted, Stats.TargetSuccess);
+}
+
+/****************************************************************************
+Function:			ReportPose
+Parameters:		void
+Returns:			void
+Description:	Tells the DRS simulator where our Kart is
+****************************************************************************/
+static void ReportPose(void) {
+	float X = (KartX < 0) ? 0 : KartX;
+	float Y = (KartY < 0) ? 0 : KartY;
+	DRSSim_SetKartPose(MyKart.KartNumber, (uint16_t)lroundf(X), (uint16_t)lroundf(Y), \
+		(uint16_t)lroundf(KartTheta) % 360);
+}
+
+/****************************************************************************
+Function:			CornerPoint
+Parameters:		uint8_t Corner, which corner of the body
+							float *PX, *PY, where it is on the field, units
+							float *Forward, *Right, its offset from the axle, mm
+Returns:			void
+Description:	Right of the Kart is a quarter turn the way Theta grows
+****************************************************************************/
+static void CornerPoint(uint8_t Corner, float *PX, float *PY, float *Forward, float *Right) {
+	float Heading = KartTheta / DEGREES;
+	float HX = cosf(Heading), HY = sinf(Heading);
+	*Forward = CornerForward[Corner];
+	*Right = CornerRight[Corner];
+	*PX = KartX + (*Forward * HX - *Right * HY) / MM_PER_UNIT;
+	*PY = KartY + (*Forward * HY + *Right * HX) / MM_PER_UNIT;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,84 @@
+/****************************************************************************
+Module: RaceSim.h
+Description:
+	Host-side model of the gamefield and our Kart's body on it: the walls,
+	the Kart's motion on the motor simulator's wheels, the bump switch, the
+	IR beacon and target, the ball launcher, the Kart switch and race LED,
+	and the DRS referee for our Kart. Stands in for the GPIO pins, the
+	beacon input capture and PWM0, the drive's and the ball launcher's,
+	when the firmware is compiled with HOST_SIM (see HW_Port.h), so the
+	whole Kart can be raced on a PC.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+#ifndef RaceSim_H
+#define RaceSim_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define RACESIM_MAX_LAPS		7
+
+// How racesim (RaceSimMain.c) exits, for FaultCampaignMain.c
+#define RACESIM_FINISHED		0		// The Kart did its laps
+#define RACESIM_TIMED_OUT		1		// It hadn't by the time limit
+#define RACESIM_STUCK			2		// It stopped moving part way
+#define RACESIM_FAILED_RUN		3		// ES_Run returned, a service failed
+#define RACESIM_BAD_ARGS		4
+#define RACESIM_POSE_DRIFTED	5		// It finished, but the pose estimate drifted
+
+// The gamefield, in DRS units, inside the outer walls at 0 and Width, 0
+// and Height. The zones are GamefieldPositions.h's.
+typedef struct {
+	uint16_t	Width;
+	uint16_t	Height;
+	uint16_t	BeaconX;				// The IR beacon, in the middle of the target
+	uint16_t	BeaconY;
+	uint16_t	TargetHalfWidth;	// How far either side of the beacon a ball still hits
+	uint16_t	BeaconHalfAngle;	// Degrees either side of straight ahead the IR sensor sees
+} RaceSimField_t;
+
+// Our Kart on the field, Theta the way the DRS reports it
+typedef struct {
+	uint8_t		KartNumber;			// 1-3, what the Kart switch is set to
+	float			X;
+	float			Y;
+	float			Theta;
+	uint8_t		Laps;
+} RaceSimKart_t;
+
+// What happened to our Kart, for the race report
+typedef struct {
+	uint8_t		LapsDone;
+	uint32_t	LapTimesMS[RACESIM_MAX_LAPS];	// Each lap, the first from the flag
+	bool			ObstacleCompleted;
+	bool			TargetSuccess;
+	uint32_t	Bumps;					// Times the bump switch closed
+	uint32_t	WallContactMS;	// Time any part of the Kart was against a wall
+	uint32_t	BeaconEdges;		// Beacon captures, each one a capture ISR
+	uint32_t	BallsLaunched;
+	uint32_t	TargetHits;
+	float			DistanceMM;			// Driven by the Kart's middle
+} RaceSimStats_t;
+
+// The default field, laid out around GamefieldPositions.h
+extern const RaceSimField_t RaceSimDefaultField;
+
+/*----------------------- Public Function Prototypes ----------------------*/
+void RaceSim_Init(RaceSimField_t Field, RaceSimKart_t Kart);
+void RaceSim_Step(uint32_t NowUS);
+void RaceSim_StartRace(uint32_t NowUS);
+void RaceSim_GetPose(float *X, float *Y, float *Theta);
+RaceSimStats_t RaceSim_GetStats(void);
+void RaceSim_PrintStats(void);
+
+// The HW_Port.h side, the GPIO data registers, the beacon capture and PWM0
+uint32_t RaceSim_ReadGPIO(uint32_t Base);
+void RaceSim_WriteGPIO(uint32_t Base, uint32_t Value);
+uint32_t RaceSim_GetBeaconCapture(void);
+uint32_t RaceSim_ReadPWM(uint32_t Offset);
+void RaceSim_WritePWM(uint32_t Offset, uint32_t Value);
+
+#endif /* RaceSim_H */
@@ -0,0 +1,503 @@
+/****************************************************************************
+Module: RaceSimMain.c
+Description:
+	Host race simulation. Runs the Kart's firmware as it is, the master,
+	playing, racing, ball launching, obstacle crossing and navigation state
+	machines, the DRS, the drive motors and the sensors, on the ES framework,
+	against the DRS simulator (DRSSim.c), the motor simulator (MotorSim.c)
+	and the gamefield (RaceSim.c), all on the virtual clock. The flag drops
+	a second in and the race runs until our Kart has done its laps or the
+	time limit is up, as fast as the PC goes.
+	Reports the lap times, the events posted to each service, the DRS link,
+	the pose estimate against the truth, and an estimate of the CPU time
+	the interrupts and the event dispatching would take on the Kart. The
+	cycle counts per call below are budgets, not measurements, replace them
+	with the Kart's figures ('M' in MapKeys for the control ISR).
+
+	The inputs are recorded as on the Kart (InputRecorder.c), give a log
+	file and the log is written to it at the end, for ReplayMain.c.
+	Faults can be injected into the simulators (FaultSim.c), the windows
+	given as FaultSim_Parse reads them. FaultCampaignMain.c runs racesim
+	over a set of them.
+
+	Build from the project directory on a PC with TivaWare checked out:
+		gcc -std=gnu99 -O2 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o racesim \
+			-Wl,--wrap=ES_PostToService \
+			Host/RaceSimMain.c Host/RaceSim.c Host/DRSSim.c Host/MotorSim.c Host/EventLog.c \
+			Host/FaultSim.c \
+			Source/SM_Master.c Source/SM_Playing.c Source/SM_Racing.c \
+			Source/SM_BallLaunching.c Source/SM_ObstacleCrossing.c \
+			Source/SM_Navigation.c Source/HeadingController.c Source/SM_DRS.c \
+			Source/DRS.c Source/CollisionPredictor.c Source/PoseEstimator.c \
+			Source/GamefieldPositions.c Source/FieldCalibration.c Source/MapKeys.c Source/Display.c \
+			Source/EventCheckers.c Source/BumpSensor.c Source/BeaconSensor.c \
+			Source/KartSwitchAndLED.c Source/BallLauncher.c \
+			Source/DriveMotors.c Source/DriveMotorsService.c Source/DriveMotorsEncoder.c \
+			Source/DriveMotorsPID.c Source/DriveMotorsPosition.c Source/PIDController.c \
+			Source/MotionProfile.c Source/MotionSequencer.c Source/DriveFeedforward.c \
+			Source/PIDAutotune.c Source/ES_Framework.c Source/ES_Queue.c \
+			Source/ES_Timers.c Source/ES_PostList.c Source/ES_LookupTables.c \
+			Source/ES_CheckEvents.c Source/ES_Port.c Source/InputRecorder.c -lm
+
+	Usage:
+		racesim [laps] [kart 1-3] [time limit s] [seed] [quiet|verbose] [log file|-] [faults]
+	quiet sends the firmware's printing to /dev/null, leaving the report.
+	Exits with RACESIM_FINISHED (0) if the Kart finished its laps, and
+	otherwise with why not, see RaceSim.h. A Kart whose wheels haven't
+	turned STUCK_MM between them in STUCK_US of the race is stuck, turning
+	on the spot to aim at the target counts. A Kart that finished but
+	whose pose estimate was more than POSE_DRIFT_UNITS or POSE_DRIFT_DEGREES
+	off the truth for more than POSE_DRIFT_PERCENT of the race exits with
+	RACESIM_POSE_DRIFTED. An estimate turning the wrong way between DRS
+	fixes is outside them for around 15% of a race. The checks made while
+	the Kart turns faster than TURNING_DEG_PER_S are reported apart, with
+	the DRS pose as it stands beside them, to see the latency compensation
+	holding up through the corners and not only along the straights.
+	The corner turns (SM_Navigation's ORIENTING under the heading
+	controller) are timed, and the true heading TURN_REST_US after each
+	one that arrived is checked against the heading it was aiming for.
+	Turns that timed out, where the Kart was wedged against a wall and
+	couldn't turn, are counted apart.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+// Module Libraries
+#include "RaceSim.h"
+#include "DRSSim.h"
+#include "MotorSim.h"
+#include "EventLog.h"
+#include "FaultSim.h"
+#include "InputRecorder.h"
+#include "FieldCalibration.h"
+#include "SM_Master.h"
+#include "SM_Racing.h"
+#include "SM_Navigation.h"
+#include "SM_DRS.h"
+#include "DRS.h"
+#include "DriveMotors.h"
+#include "DriveMotorPID.h"
+#include "BeaconSensor.h"
+#include "BallLauncher.h"
+#include "BumpSensor.h"
+#include "KartSwitchAndLED.h"
+#include "EEPROMStorage.h"
+#include "PoseEstimator.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define DEFAULT_LAPS					3
+#define DEFAULT_LIMIT_S				180
+// The control interrupt
+#define CONTROL_PERIOD_US			1000
+// The DRS link, as DRSSimMain.c has it
+#define LINK_LATENCY_US				4300
+#define LINK_JITTER_US				500
+#define POSE_UPDATE_US				100000
+// How long the run goes on once the Kart has finished
+#define FINISHED_US						1000000
+// Pose estimate checks, while the race is on
+#define POSE_CHECK_US					10000
+// How far off the estimate may be, and for how much of the race
+#define POSE_DRIFT_UNITS			10.0f
+#define POSE_DRIFT_DEGREES		20.0f
+#define POSE_DRIFT_PERCENT		5
+// Turning faster than this, the checks are also counted apart
+#define TURNING_DEG_PER_S			30.0f
+// Time for a corner turn's coast to die away before it's checked
+#define TURN_REST_US					200000
+// Stuck, the wheels not STUCK_MM on between them in STUCK_US of racing
+#define STUCK_US							30000000
+#define STUCK_MM							100.0f
+#define FAULTS_LENGTH					1024
+
+// Cycles per call on the Kart, budgets to replace with measurements
+#define CPU_HZ								40000000.0f
+#define CONTROL_ISR_CYCLES		2500
+#define ENCODER_EDGE_CYCLES		120
+#define SYSTICK_CYCLES				150
+#define SSI_EOT_CYCLES				400
+#define BEACON_EDGE_CYCLES		120
+#define DISPATCH_CYCLES				1500
+
+/*---------------------------- Module Functions ---------------------------*/
+static void Step(uint32_t NowUS);
+static void CheckPose(void);
+static void CheckTurn(void);
+static void Report(const char *Outcome);
+static void PrintCPU(float Seconds);
+static void WriteInputLog(const char *Path);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t Laps = DEFAULT_LAPS;
+static uint32_t LimitUS;
+static uint32_t NextControlUS;
+static uint32_t NextPoseCheckUS;
+static uint32_t FinishedUS;
+static bool Finished;
+static bool RaceStarted;
+static uint32_t NowUS;
+static uint32_t ControlCalls;
+static uint32_t EncoderEdges;
+static int32_t LastEdges[2];
+static clock_t WallStart;
+static int ReportFd = -1;
+static const char *LogFile;
+static char Faults[FAULTS_LENGTH];
+
+// Progress, for the stuck check
+static uint32_t ProgressUS;
+static float ProgressMM[2];
+
+// Pose estimate against the truth
+static uint32_t PoseChecks;
+static float PositionError;
+static float HeadingError;
+static float WorstHeadingError;
+static uint32_t PoseOffChecks;
+static bool PoseOff;
+static uint32_t PoseOffUS;
+static uint32_t LongestPoseOffUS;
+// The same while turning, against the DRS pose as it stands
+static float LastTheta;
+static uint32_t TurningChecks;
+static float TurningPositionError, TurningHeadingError;
+static float TurningDRSPositionError, TurningDRSHeadingError;
+// Corner turns, and the true heading's error at rest after them
+static bool Turning;
+static bool TurnResting;
+static uint32_t TurnStartUS, TurnEndUS;
+static uint32_t Turns, TurnsTimedOut;
+static uint32_t TurnsMS, LongestTurnMS;
+static float TurnError, WorstTurnError;
+
+// State names, for where a Kart that didn't finish was left
+static const char *MasterStates[] = {"WAITING_START", "PLAYING", "PAUSED", "WAITING_FINISHED"};
+static const char *RacingStates[] = {"STRAIGHT", "CORNER"};
+static const char *DRSStates[] = {"WAITING_FOR_QUERY", "QUERYING", "READING"};
+
+// Flag dropped after a second
+static const DRSSimFlagEvent_t FlagScript[] = {
+	{1000, Flag_Dropped}
+};
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	DRSSimConfig_t Config = {LINK_LATENCY_US, LINK_JITTER_US, 0, 0, 1, POSE_UPDATE_US};
+	RaceSimKart_t Kart = {1, 250, 20, 180, DEFAULT_LAPS};
+	uint32_t LimitS = DEFAULT_LIMIT_S;
+
+	if (argc > 1) Kart.Laps = strtoul(argv[1], NULL, 0);
+	if (argc > 2) Kart.KartNumber = strtoul(argv[2], NULL, 0);
+	if (argc > 3) LimitS = strtoul(argv[3], NULL, 0);
+	if (argc > 4) Config.Seed = strtoul(argv[4], NULL, 0);
+	if (argc > 5 && strcmp(argv[5], "quiet") == 0) {
+		fflush(stdout);
+		ReportFd = dup(STDOUT_FILENO);
+		int Null = open("/dev/null", O_WRONLY);
+		dup2(Null, STDOUT_FILENO);
+		close(Null);
+	}
+	if (argc > 6 && strcmp(argv[6], "-") != 0) LogFile = argv[6];
+	FaultSim_Init(Config.Seed);
+	if (argc > 7 && !FaultSim_Parse(argv[7])) {
+		if (ReportFd >= 0) dup2(ReportFd, STDOUT_FILENO);
+		printf("Bad fault windows: %s\r\n", argv[7]);
+		return RACESIM_BAD_ARGS;
+	}
+	FaultSim_Describe(Faults, sizeof(Faults));
+	if (Kart.KartNumber < 1 || Kart.KartNumber > 3) Kart.KartNumber = 1;
+	if (Kart.Laps < 1 || Kart.Laps > RACESIM_MAX_LAPS) Kart.Laps = DEFAULT_LAPS;
+	Laps = Kart.Laps;
+	LimitUS = LimitS * 1000000;
+
+	printf("Race host simulation: Kart %d, %d laps, %lu s limit, seed %lu, faults %s\r\n", \
+		Kart.KartNumber, Kart.Laps, (unsigned long)LimitS, (unsigned long)Config.Seed, Faults);
+	WallStart = clock();
+	DRSSim_Init(Config);
+	DRSSim_SetFlagScript(FlagScript, sizeof(FlagScript)/sizeof(FlagScript[0]));
+	MotorSim_Init(MotorSimDefaultWheel, MotorSimFloor, MotorSimDefaultBattery, Config.Seed);
+	RaceSim_Init(RaceSimDefaultField, Kart);
+	_HW_SetStepHook(Step);
+
+	// As Main.c does it on the Kart
+	InitializeInputRecorder();
+	InitializeKartSwitchAndLED();
+	InitializeEEPROMStorage();
+	InitializeFieldCalibration();
+	InitializeDRS();
+	InitBeaconSensingCapture();
+	InitializeDriveMotors();
+	InitializeBumpSensors();
+	InitializeBallLauncher();
+
+	// ES_Run only returns on an error, Step ends the run
+	ES_Return_t ErrorType = ES_Initialize(ES_Timer_RATE_10mS);
+	if (ErrorType == Success) {
+		ErrorType = ES_Run();
+	}
+	printf("Framework error %d\r\n", ErrorType);
+	Report("FAILED RUN");
+	return RACESIM_FAILED_RUN;
+}
+
+// No EEPROM on the PC, the Kart runs on its default gains
+bool InitializeEEPROMStorage(void) { return true; }
+bool ReadEEPROMRecord(uint8_t Slot, uint16_t Version, void *Data, uint16_t Length) { return false; }
+bool WriteEEPROMRecord(uint8_t Slot, uint16_t Version, const void *Data, uint16_t Length) { return true; }
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			Step
+Parameters:		uint32_t NowUS, the virtual time
+Returns:			void
+Description:	Host port step hook. The wheels, then the control ISR on
+							them, the DRS and the Kart on the field, and ends the run.
+****************************************************************************/
+static void Step(uint32_t Now) {
+	NowUS = Now;
+	MotorSim_Step(NowUS);
+	for (uint8_t Motor = 0; Motor < 2; Motor++) {
+		int32_t Edges = MotorSim_GetEdges(Motor);
+		EncoderEdges += abs(Edges - LastEdges[Motor]);
+		LastEdges[Motor] = Edges;
+	}
+	if (NowUS >= NextControlUS) {
+		NextControlUS += CONTROL_PERIOD_US;
+		SetRPMResponse();
+		ControlCalls++;
+		CheckTurn();
+	}
+	DRSSim_Step(NowUS);
+	RaceSim_Step(NowUS);
+	FaultSim_Step(NowUS);
+
+	if (!RaceStarted && DRSSim_GetFlag() == Flag_Dropped) {
+		RaceStarted = true;
+		RaceSim_StartRace(NowUS);
+		ProgressUS = NowUS;
+	}
+	if (RaceStarted && NowUS >= NextPoseCheckUS) {
+		NextPoseCheckUS = NowUS + POSE_CHECK_US;
+		CheckPose();
+	}
+	if (!Finished && RaceSim_GetStats().LapsDone >= Laps) {
+		Finished = true;
+		FinishedUS = NowUS;
+	}
+	if (RaceStarted && !Finished) {
+		float WheelR = MotorSim_GetDistanceMM(RIGHT_MOTOR);
+		float WheelL = MotorSim_GetDistanceMM(LEFT_MOTOR);
+		if (fabsf(WheelR - ProgressMM[RIGHT_MOTOR]) + fabsf(WheelL - ProgressMM[LEFT_MOTOR]) >= STUCK_MM) {
+			ProgressMM[RIGHT_MOTOR] = WheelR;
+			ProgressMM[LEFT_MOTOR] = WheelL;
+			ProgressUS = NowUS;
+		} else if (NowUS - ProgressUS >= STUCK_US) {
+			Report("STUCK");
+			if (LogFile != NULL) WriteInputLog(LogFile);
+			exit(RACESIM_STUCK);
+		}
+	}
+	if ((Finished && NowUS - FinishedUS >= FINISHED_US) || NowUS >= LimitUS) {
+		bool Drifted = (PoseOffChecks * 100 > PoseChecks * POSE_DRIFT_PERCENT);
+		Report(!Finished ? "DID NOT FINISH" : Drifted ? "FINISHED, POSE DRIFTED" : "FINISHED");
+		if (LogFile != NULL) WriteInputLog(LogFile);
+		exit(!Finished ? RACESIM_TIMED_OUT : Drifted ? RACESIM_POSE_DRIFTED : RACESIM_FINISHED);
+	}
+}
+
+/****************************************************************************
+Function:			CheckPose
+Parameters:		void
+Returns:			void
+Description:	Compares the pose estimate with where the Kart really is, and
+							counts and times it outside the drift bounds
+****************************************************************************/
+static void CheckPose(void) {
+	if (!HasPoseFix()) return;
+	float X, Y, Theta;
+	RaceSim_GetPose(&X, &Y, &Theta);
+	Pose_t Pose = GetCurrentPose();
+	float Position = hypotf(Pose.X - X, Pose.Y - Y);
+	float Heading = fabsf(fmodf(Pose.Theta - Theta + 540.0f, 360.0f) - 180.0f);
+	PositionError += Position;
+	HeadingError += Heading;
+	if (Heading > WorstHeadingError) WorstHeadingError = Heading;
+	PoseChecks++;
+
+	float Rate = fabsf(fmodf(Theta - LastTheta + 540.0f, 360.0f) - 180.0f) * 1e6f / POSE_CHECK_US;
+	LastTheta = Theta;
+	if (PoseChecks > 1 && Rate > TURNING_DEG_PER_S) {
+		Kart_t MyKart = GetMyKart();
+		TurningPositionError += Position;
+		TurningHeadingError += Heading;
+		TurningDRSPositionError += hypotf(MyKart.KartX - X, MyKart.KartY - Y);
+		TurningDRSHeadingError += fabsf(fmodf(MyKart.KartTheta - Theta + 540.0f, 360.0f) - 180.0f);
+		TurningChecks++;
+	}
+
+	if (Position <= POSE_DRIFT_UNITS && Heading <= POSE_DRIFT_DEGREES) {
+		PoseOff = false;
+		return;
+	}
+	PoseOffChecks++;
+	if (!PoseOff) {
+		PoseOff = true;
+		PoseOffUS = NowUS;
+	}
+	if (NowUS - PoseOffUS > LongestPoseOffUS) LongestPoseOffUS = NowUS - PoseOffUS;
+}
+
+/****************************************************************************
+Function:			CheckTurn
+Parameters:		void
+Returns:			void
+Description:	Times the corner turns, and once each has come to rest checks
+							the true heading against its target
+****************************************************************************/
+static void CheckTurn(void) {
+	bool InTurn = (QueryRacingSM() == CORNER && QueryNavigationSM() == ORIENTING);
+	if (InTurn && !Turning) TurnStartUS = NowUS;
+	if (!InTurn && Turning) {
+		uint32_t MS = (NowUS - TurnStartUS) / 1000;
+		TurnsMS += MS;
+		if (MS > LongestTurnMS) LongestTurnMS = MS;
+		TurnEndUS = NowUS;
+		TurnResting = (QueryHeadingResult() == HEADING_ARRIVED);
+		if (!TurnResting) TurnsTimedOut++;
+	}
+	Turning = InTurn;
+	if (!TurnResting || NowUS - TurnEndUS < TURN_REST_US) return;
+
+	float X, Y, Theta;
+	RaceSim_GetPose(&X, &Y, &Theta);
+	float Error = fabsf(GetHeadingError(GetTargetTheta(), Theta));
+	TurnError += Error;
+	if (Error > WorstTurnError) WorstTurnError = Error;
+	Turns++;
+	TurnResting = false;
+}
+
+/****************************************************************************
+Function:			Report
+Parameters:		const char *Outcome, how the run ended
+Returns:			void
+Description:	Prints the race, the events, the DRS link, the pose estimate,
+							the faults and the CPU estimate
+****************************************************************************/
+static void Report(const char *Outcome) {
+	float Seconds = NowUS / 1e6f;
+	float WallSeconds = (float)(clock() - WallStart) / CLOCKS_PER_SEC;
+	fflush(stdout);
+	if (ReportFd >= 0) dup2(ReportFd, STDOUT_FILENO);
+
+	printf("\r\n");
+	RaceSim_PrintStats();
+	EventLog_PrintCounts();
+	DRSSim_PrintStats();
+	if (PoseChecks > 0) {
+		printf("Pose estimate: %.2f units and %.2f degrees off (mean over %lu checks), %.1f degrees at worst\r\n", \
+			PositionError / PoseChecks, HeadingError / PoseChecks, (unsigned long)PoseChecks, WorstHeadingError);
+		printf("Pose estimate: more than %.0f units or %.0f degrees off %.1f%% of the time, %lu ms at the longest, %s\r\n", \
+			POSE_DRIFT_UNITS, POSE_DRIFT_DEGREES, 100.0f * PoseOffChecks / PoseChecks, \
+			(unsigned long)(LongestPoseOffUS / 1000), \
+			(PoseOffChecks * 100 > PoseChecks * POSE_DRIFT_PERCENT) ? "DRIFTED" : "within bounds");
+	}
+	if (TurningChecks > 0) {
+		printf("Turning over %.0f deg/s: DRS %.2f units and %.2f degrees off, estimate %.2f units and %.2f degrees (mean over %lu checks)\r\n", \
+			TURNING_DEG_PER_S, TurningDRSPositionError / TurningChecks, TurningDRSHeadingError / TurningChecks, \
+			TurningPositionError / TurningChecks, TurningHeadingError / TurningChecks, (unsigned long)TurningChecks);
+	}
+	if (Turns + TurnsTimedOut > 0) {
+		printf("Corner turns: %lu arrived, %lu timed out, %lu ms mean, %lu ms at the longest\r\n", \
+			(unsigned long)Turns, (unsigned long)TurnsTimedOut, (unsigned long)(TurnsMS / (Turns + TurnsTimedOut)), \
+			(unsigned long)LongestTurnMS);
+	}
+	if (Turns > 0) {
+		printf("Corner turns: %.1f degrees off the target at rest (mean), %.1f at worst\r\n", \
+			TurnError / Turns, WorstTurnError);
+	}
+	FaultSim_PrintStats();
+	PrintCPU(Seconds);
+	if (!Finished) {
+		printf("Left in master %s, racing %s, DRS %s\r\n", MasterStates[QueryMasterSM()], \
+			RacingStates[QueryRacingSM()], DRSStates[QueryDRS_SM()]);
+	}
+	printf("%.1f s simulated in %.2f s, %.0fx real time, %s\r\n", Seconds, WallSeconds, \
+		(WallSeconds > 0) ? Seconds / WallSeconds : 0.0f, Outcome);
+	fflush(stdout);
+}
+
+/****************************************************************************
+Function:			PrintCPU
+Parameters:		float Seconds, simulated
+Returns:			void
+Description:	The interrupts and events counted over the run, at the cycle
+							budgets above, as a share of the 40MHz core
+****************************************************************************/
+static void PrintCPU(float Seconds) {
+	uint32_t Dispatches = EventLog_GetPosts();
+	const struct {
+		const char	*Name;
+		float				Calls;
+		uint32_t		Cycles;
+	} Loads[] = {
+		{"control ISR", ControlCalls, CONTROL_ISR_CYCLES},
+		{"encoder edges", EncoderEdges, ENCODER_EDGE_CYCLES},
+		{"SysTick", Seconds * 100, SYSTICK_CYCLES},
+		{"SSI EOT", DRSSim_GetStats().Delivered, SSI_EOT_CYCLES},
+		{"beacon edges", RaceSim_GetStats().BeaconEdges, BEACON_EDGE_CYCLES},
+		{"event dispatch", Dispatches, DISPATCH_CYCLES}
+	};
+	float Total = 0;
+	printf("CPU estimate, at budgeted cycles per call:\r\n");
+	for (uint8_t i = 0; i < sizeof(Loads)/sizeof(Loads[0]); i++) {
+		float Share = Loads[i].Calls * Loads[i].Cycles / (CPU_HZ * Seconds) * 100;
+		Total += Share;
+		printf("  %-16s %10.0f calls, %5lu cycles each, %5.2f%%\r\n", Loads[i].Name, \
+			Loads[i].Calls, (unsigned long)Loads[i].Cycles, Share);
+	}
+	printf("  %-16s %5.2f%% of the core\r\n", "total", Total);
+}
+
+/****************************************************************************
+Function:			WriteInputLog
+Parameters:		const char *Path, the log file
+Returns:			void
+Description:	PrintInputLog, as the Kart dumps it over the UART, into a file
+****************************************************************************/
+static void WriteInputLog(const char *Path) {
+	fflush(stdout);
+	int SavedFd = dup(STDOUT_FILENO);
+	int LogFd = open(Path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (LogFd < 0) {
+		printf("Can't write %s\r\n", Path);
+		close(SavedFd);
+		return;
+	}
+	dup2(LogFd, STDOUT_FILENO);
+	close(LogFd);
+	PrintInputLog();
+	fflush(stdout);
+	dup2(SavedFd, STDOUT_FILENO);
+	close(SavedFd);
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,436 @@
+/****************************************************************************
+Module: ReplayMain.c
+Description:
+	Replays an input log (InputRecorder.c) through the Kart's firmware, as
+	RaceSimMain.c builds it but with the log standing in for the DRS, the
+	wheels and the gamefield. Each record is handed to the firmware the way
+	the hardware handed it over: the DRS frame to EOTIntHandler through the
+	SSI registers, the captures to their ISRs with the capture register
+	set back by the record's age, the bump switch and the Kart switch on
+	their pins and the keystrokes to the keyboard, each at the virtual time
+	it came in. The control ISR runs on the same 1ms beat as in the
+	simulations, after the encoder edges of its step and before anything
+	else, as RaceSimMain.c runs it.
+	A log from racesim replays exactly, to the same posts at the same times,
+	and the firmware records the same log back, which the replay checks. A
+	log from the Kart replays the same inputs, but the control ISR's phase,
+	a DRS query that found the SSI busy and the microseconds below the log's
+	resolution weren't recorded, so the events can come out a little
+	differently. A log that wrapped or lost records starts or ends part way
+	through and doesn't replay from reset.
+
+	Dump the log on the Kart with 'R' in MapKeys, which freezes the Kart's
+	wrapping log first, and save the terminal's output to a file, the lines
+	around it are skipped.
+
+	Build from the project directory on a PC with TivaWare checked out:
+		gcc -std=gnu99 -O2 -DHOST_SIM -IHost -IHeaders -I<TivaWare> -o replay \
+			-Wl,--wrap=ES_PostToService \
+			Host/ReplayMain.c Host/EventLog.c Host/FaultSim.c \
+			Source/SM_Master.c Source/SM_Playing.c Source/SM_Racing.c \
+			Source/SM_BallLaunching.c Source/SM_ObstacleCrossing.c \
+			Source/SM_Navigation.c Source/HeadingController.c Source/SM_DRS.c \
+			Source/DRS.c Source/CollisionPredictor.c Source/PoseEstimator.c \
+			Source/GamefieldPositions.c Source/FieldCalibration.c Source/MapKeys.c Source/Display.c \
+			Source/EventCheckers.c Source/BumpSensor.c Source/BeaconSensor.c \
+			Source/KartSwitchAndLED.c Source/BallLauncher.c \
+			Source/DriveMotors.c Source/DriveMotorsService.c Source/DriveMotorsEncoder.c \
+			Source/DriveMotorsPID.c Source/DriveMotorsPosition.c Source/PIDController.c \
+			Source/MotionProfile.c Source/MotionSequencer.c Source/DriveFeedforward.c \
+			Source/PIDAutotune.c Source/ES_Framework.c Source/ES_Queue.c \
+			Source/ES_Timers.c Source/ES_PostList.c Source/ES_LookupTables.c \
+			Source/ES_CheckEvents.c Source/ES_Port.c Source/InputRecorder.c -lm
+
+	Usage:
+		replay <log file> [quiet|trace|all]
+	quiet sends the firmware's printing to /dev/null, leaving the report,
+	trace also prints each post to the Master SM and all each post to every
+	service. Exits with 1 if the log can't be read or the firmware didn't
+	record it back the same.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+// Module Libraries
+#include "HW_Port.h"
+#include "EventLog.h"
+#include "InputRecorder.h"
+#include "FieldCalibration.h"
+#include "DRS.h"
+#include "DriveMotors.h"
+#include "DriveMotorPID.h"
+#include "DriveMotorEncoder.h"
+#include "BeaconSensor.h"
+#include "BallLauncher.h"
+#include "BumpSensor.h"
+#include "KartSwitchAndLED.h"
+#include "EEPROMStorage.h"
+
+// TivaWare register definitions
+#include "inc/hw_memmap.h"
+#include "inc/hw_ssi.h"
+#include "inc/hw_gpio.h"
+#include "driverlib/gpio.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// The control interrupt
+#define CONTROL_PERIOD_US			1000
+// How long the replay goes on past the last record
+#define FINISHED_US						1000000
+#define LINE_LENGTH						256
+#define ALL_PINS							0xff
+#define BUMP_PIN							GPIO_PIN_1
+#define PWM_REG_SPACE					0x100
+#define MASTER_SERVICE				1
+
+/*---------------------------- Module Functions ---------------------------*/
+static bool ReadLog(const char *Path);
+static bool NextRecord(void);
+static void Step(uint32_t NowUS);
+static void Deliver(const InputRecord_t *Record);
+static bool CheckRecordedBack(void);
+static void Report(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+// The log, and the next record in it
+static uint8_t Log[INPUT_LOG_SIZE];
+static uint32_t LogLength;
+static uint32_t LogRecords;
+static bool LogIncomplete;
+static uint32_t ReadIndex;
+static InputRecord_t Pending;
+static bool HavePending;
+static uint32_t PendingUS;
+static uint32_t Delivered;
+
+static uint32_t NowUS;
+static uint32_t NextControlUS;
+static uint32_t LastRecordUS;
+static int ReportFd = -1;
+static bool Identical;
+
+// The hardware, as the records left it
+static uint8_t DRSFrame[8];
+static uint8_t DRSIndex;
+static uint32_t Captures[2];
+static uint32_t BeaconCapture;
+static bool BumpPressed;
+static uint32_t KartSwitchPins;
+static uint32_t PortA;
+static uint32_t PortF;
+static uint32_t PWMRegs[PWM_REG_SPACE/4];
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printf("Usage: replay <log file> [quiet|trace|all]\r\n");
+		return 1;
+	}
+	if (!ReadLog(argv[1])) return 1;
+
+	printf("Replaying %s: %lu bytes, %lu records\r\n", argv[1], \
+		(unsigned long)LogLength, (unsigned long)LogRecords);
+	if (LogIncomplete) {
+		printf("The log wrapped or lost records, it won't replay from reset\r\n");
+	}
+	if (argc > 2) {
+		fflush(stdout);
+		ReportFd = dup(STDOUT_FILENO);
+		int Null = open("/dev/null", O_WRONLY);
+		dup2(Null, STDOUT_FILENO);
+		close(Null);
+		FILE *Trace = fdopen(dup(ReportFd), "w");
+		if (strcmp(argv[2], "trace") == 0) EventLog_SetTrace(Trace, 1 << MASTER_SERVICE);
+		if (strcmp(argv[2], "all") == 0) EventLog_SetTrace(Trace, 0xffff);
+	}
+
+	// The Kart switch is only read at reset, give the firmware the first one
+	// before it gets there
+	InputRecord_t Record;
+	uint32_t Index = 0;
+	while (Index < LogLength) {
+		uint8_t Length = DecodeInputRecord(&Log[Index], LogLength - Index, &Record);
+		if (Length == 0) break;
+		if (Record.Type == INPUT_KART_SWITCH) {
+			KartSwitchPins = Record.Payload[0];
+			break;
+		}
+		Index += Length;
+	}
+	NextRecord();
+	_HW_SetStepHook(Step);
+
+	// As Main.c does it on the Kart
+	InitializeInputRecorder();
+	InitializeKartSwitchAndLED();
+	InitializeEEPROMStorage();
+	InitializeFieldCalibration();
+	InitializeDRS();
+	InitBeaconSensingCapture();
+	InitializeDriveMotors();
+	InitializeBumpSensors();
+	InitializeBallLauncher();
+
+	// ES_Run only returns on an error, Step ends the replay
+	ES_Return_t ErrorType = ES_Initialize(ES_Timer_RATE_10mS);
+	if (ErrorType == Success) {
+		ErrorType = ES_Run();
+	}
+	printf("Framework error %d\r\n", ErrorType);
+	return 1;
+}
+
+// No EEPROM on the PC, the Kart runs on its default gains
+bool InitializeEEPROMStorage(void) { return true; }
+bool ReadEEPROMRecord(uint8_t Slot, uint16_t Version, void *Data, uint16_t Length) { return false; }
+bool WriteEEPROMRecord(uint8_t Slot, uint16_t Version, const void *Data, uint16_t Length) { return true; }
+
+// The DRS, through HW_Port.h. Never busy, reads back the record's frame.
+uint32_t DRSSim_ReadReg(uint32_t Offset) {
+	if (Offset == SSI_O_SR) return SSI_SR_TFE | SSI_SR_TNF;
+	if (Offset == SSI_O_DR) return (DRSIndex < sizeof(DRSFrame)) ? DRSFrame[DRSIndex++] : 0;
+	return 0;
+}
+void DRSSim_WriteReg(uint32_t Offset, uint32_t Value) {}
+
+// The encoders, the capture is set by the record
+uint32_t MotorSim_GetCapture(uint8_t Motor) { return Captures[Motor]; }
+void MotorSim_SetDrive(uint8_t Motor, uint8_t DutyCycle, uint8_t Direction) {}
+
+// The gamefield's pins, the IR beacon and the ball launcher's PWM
+uint32_t RaceSim_ReadGPIO(uint32_t Base) {
+	switch (Base) {
+		case GPIO_PORTA_BASE:
+			return PortA;
+		case GPIO_PORTD_BASE:
+			return BumpPressed ? (ALL_PINS & ~BUMP_PIN) : ALL_PINS;
+		case GPIO_PORTE_BASE:
+			return KartSwitchPins;
+		case GPIO_PORTF_BASE:
+			return PortF;
+		default:
+			return ALL_PINS;
+	}
+}
+void RaceSim_WriteGPIO(uint32_t Base, uint32_t Value) {
+	if (Base == GPIO_PORTA_BASE) PortA = Value;
+	if (Base == GPIO_PORTF_BASE) PortF = Value;
+}
+uint32_t RaceSim_GetBeaconCapture(void) { return BeaconCapture; }
+uint32_t RaceSim_ReadPWM(uint32_t Offset) {
+	return (Offset < PWM_REG_SPACE) ? PWMRegs[Offset/4] : 0;
+}
+void RaceSim_WritePWM(uint32_t Offset, uint32_t Value) {
+	if (Offset < PWM_REG_SPACE) PWMRegs[Offset/4] = Value;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ReadLog
+Parameters:		const char *Path, the log file
+Returns:			bool, false if there's no log in it
+Description:	Reads the hex between the INPUT LOG and END INPUT LOG lines
+****************************************************************************/
+static bool ReadLog(const char *Path) {
+	FILE *File = fopen(Path, "r");
+	if (File == NULL) {
+		printf("Can't open %s\r\n", Path);
+		return false;
+	}
+	char Line[LINE_LENGTH];
+	bool InLog = false;
+	bool Ended = false;
+	unsigned long Bytes, Records, Lost;
+	while (!Ended && fgets(Line, sizeof(Line), File) != NULL) {
+		if (!InLog) {
+			if (sscanf(Line, "INPUT LOG %lu bytes, %lu records, %lu lost", &Bytes, &Records, &Lost) == 3) {
+				InLog = true;
+				LogRecords = Records;
+				LogIncomplete = (Lost > 0) || (strstr(Line, "wrapped") != NULL);
+			}
+			continue;
+		}
+		if (strncmp(Line, "END INPUT LOG", 13) == 0) {
+			Ended = true;
+			continue;
+		}
+		for (char *Hex = Line; isxdigit((unsigned char)Hex[0]) && isxdigit((unsigned char)Hex[1]); Hex += 2) {
+			if (LogLength == INPUT_LOG_SIZE) break;
+			char Pair[3] = {Hex[0], Hex[1], 0};
+			Log[LogLength++] = strtoul(Pair, NULL, 16);
+		}
+	}
+	fclose(File);
+	if (!Ended) {
+		printf("No complete input log in %s\r\n", Path);
+		return false;
+	}
+	if (LogLength != Bytes) {
+		printf("%s has %lu bytes of its %lu\r\n", Path, (unsigned long)LogLength, Bytes);
+		return false;
+	}
+	return true;
+}
+
+/****************************************************************************
+Function:			NextRecord
+Parameters:		void
+Returns:			bool, false at the end of the log
+Description:	Decodes the next record, and when it came in
+****************************************************************************/
+static bool NextRecord(void) {
+	uint8_t Length = DecodeInputRecord(&Log[ReadIndex], LogLength - ReadIndex, &Pending);
+	HavePending = (Length > 0);
+	if (!HavePending) {
+		if (ReadIndex < LogLength) printf("Bad record at byte %lu\r\n", (unsigned long)ReadIndex);
+		return false;
+	}
+	ReadIndex += Length;
+	PendingUS += Pending.DeltaUS;
+	LastRecordUS = PendingUS;
+	return true;
+}
+
+/****************************************************************************
+Function:			Step
+Parameters:		uint32_t Now, the virtual time
+Returns:			void
+Description:	Host port step hook. Hands over the records that have come
+							in, with the control ISR after the encoder edges, and ends
+							the replay.
+****************************************************************************/
+static void Step(uint32_t Now) {
+	NowUS = Now;
+	bool ControlDue = (NowUS >= NextControlUS);
+	if (ControlDue) NextControlUS += CONTROL_PERIOD_US;
+
+	while (HavePending && PendingUS <= NowUS) {
+		if (ControlDue && Pending.Type != INPUT_ENCODER_R && Pending.Type != INPUT_ENCODER_L) {
+			SetRPMResponse();
+			ControlDue = false;
+		}
+		Deliver(&Pending);
+		NextRecord();
+	}
+	if (ControlDue) SetRPMResponse();
+
+	if (!HavePending && NowUS - LastRecordUS >= FINISHED_US) {
+		Identical = CheckRecordedBack();
+		Report();
+		exit(Identical ? 0 : 1);
+	}
+}
+
+/****************************************************************************
+Function:			Deliver
+Parameters:		const InputRecord_t *Record
+Returns:			void
+Description:	Hands a record to the firmware, as the hardware did
+****************************************************************************/
+static void Deliver(const InputRecord_t *Record) {
+	// The captures are set back from when the record came in, which on the
+	// Kart can be part way through the step
+	uint32_t RecordTicks = PendingUS * HW_TICKS_PER_US;
+	switch (Record->Type) {
+		case INPUT_DRS_FRAME:
+			memcpy(DRSFrame, Record->Payload, sizeof(DRSFrame));
+			DRSIndex = 0;
+			EOTIntHandler();
+			break;
+		case INPUT_ENCODER_R:
+			Captures[RIGHT_MOTOR] = RecordTicks - Record->Age;
+			RDriveCaptureResponse();
+			break;
+		case INPUT_ENCODER_L:
+			Captures[LEFT_MOTOR] = RecordTicks - Record->Age;
+			LDriveCaptureResponse();
+			break;
+		case INPUT_BEACON:
+			BeaconCapture = RecordTicks - Record->Age;
+			BeaconSensedCaptureResponse();
+			break;
+		case INPUT_BUMP:
+			BumpPressed = Record->Payload[0];
+			break;
+		case INPUT_KEY:
+			_HW_PushKey(Record->Payload[0]);
+			break;
+		case INPUT_KART_SWITCH:
+			KartSwitchPins = Record->Payload[0];
+			break;
+		default:
+			break;
+	}
+	Delivered++;
+}
+
+/****************************************************************************
+Function:			CheckRecordedBack
+Parameters:		void
+Returns:			bool, true if the firmware recorded the log back the same
+Description:	The firmware records its inputs in the replay too, if the
+							replay handed them over when the Kart got them the two logs
+							are the same
+****************************************************************************/
+static bool CheckRecordedBack(void) {
+	static uint8_t Recorded[INPUT_LOG_SIZE];
+	uint32_t Length = GetInputLog(Recorded, sizeof(Recorded));
+	uint32_t Index = 0;
+	while (Index < Length && Index < LogLength && Recorded[Index] == Log[Index]) Index++;
+	if (Index == Length && Length == LogLength) return true;
+
+	// Find the record it went wrong in
+	uint32_t Records = 0;
+	uint32_t RecordStart = 0;
+	uint32_t TimeUS = 0;
+	InputRecord_t Record;
+	while (RecordStart < Index) {
+		uint8_t Size = DecodeInputRecord(&Log[RecordStart], LogLength - RecordStart, &Record);
+		if (Size == 0 || RecordStart + Size > Index) break;
+		TimeUS += Record.DeltaUS;
+		RecordStart += Size;
+		Records++;
+	}
+	fflush(stdout);
+	if (ReportFd >= 0) dup2(ReportFd, STDOUT_FILENO);
+	printf("The firmware recorded %lu bytes back, differing from the log at byte %lu, " \
+		"record %lu, after %.3f s\r\n", (unsigned long)Length, (unsigned long)Index, \
+		(unsigned long)Records, TimeUS / 1e6f);
+	return false;
+}
+
+/****************************************************************************
+Function:			Report
+Parameters:		void
+Returns:			void
+Description:	Prints the replay and the events
+****************************************************************************/
+static void Report(void) {
+	fflush(NULL);
+	if (ReportFd >= 0) dup2(ReportFd, STDOUT_FILENO);
+
+	printf("\r\n");
+	printf("Replayed %lu records over %.1f s, %s\r\n", (unsigned long)Delivered, \
+		LastRecordUS / 1e6f, Identical ? "recorded back the same" : "NOT RECORDED BACK THE SAME");
+	EventLog_PrintCounts();
+	fflush(stdout);
+}
+
+/*------------------------------ End of file ------------------------------*/
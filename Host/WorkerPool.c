@@ -0,0 +1,123 @@
+/****************************************************************************
+Module: WorkerPool.c
+Description:
+	The fork worker pool the host campaigns share. WorkerPool_Run forks the
+	workers, each takes jobs off the shared counter until there are none
+	left, and the parent waits for them all. A tool whose jobs run the
+	firmware in the worker itself asks for ForkEachJob, so each job is a
+	fresh copy of the firmware's module statics.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+// Module Libraries
+#include "WorkerPool.h"
+
+/*---------------------------- Module Functions ---------------------------*/
+static void Worker(uint32_t Jobs, bool ForkEachJob, WorkerPoolJob_t *RunJob);
+
+/*---------------------------- Module Variables ---------------------------*/
+// The next job, shared between the workers
+static uint32_t *NextJob;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			WorkerPool_Count
+Parameters:		long Workers, as asked for, 0 or less for one per core
+Returns:			long, the workers WorkerPool_Run will fork
+Description:	For the tools to report before they start
+****************************************************************************/
+long WorkerPool_Count(long Workers) {
+	if (Workers <= 0) Workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if (Workers <= 0) Workers = 1;
+	return Workers;
+}
+
+/****************************************************************************
+Function:			WorkerPool_Share
+Parameters:		size_t Size
+Returns:			void *, zeroed memory the workers and parent all see, NULL
+							if it couldn't be mapped
+Description:	Where the jobs put their results
+****************************************************************************/
+void *WorkerPool_Share(size_t Size) {
+	void *Memory = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (Memory == MAP_FAILED) {
+		perror("mmap");
+		return NULL;
+	}
+	return Memory;
+}
+
+/****************************************************************************
+Function:			WorkerPool_Run
+Parameters:		uint32_t Jobs
+							long Workers, 0 or less for one per core
+							bool ForkEachJob, each job in a process of its own
+							WorkerPoolJob_t *RunJob
+Returns:			float, seconds the pool took, negative if it couldn't start
+Description:	Runs jobs 0 to Jobs - 1 on the pool and waits for them. A job
+							that crashes takes its worker with it unless ForkEachJob.
+****************************************************************************/
+float WorkerPool_Run(uint32_t Jobs, long Workers, bool ForkEachJob, WorkerPoolJob_t *RunJob) {
+	if (NextJob == NULL) NextJob = WorkerPool_Share(sizeof(*NextJob));
+	if (NextJob == NULL) return -1;
+	*NextJob = 0;
+	fflush(stdout);
+
+	struct timespec Start, End;
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	Workers = WorkerPool_Count(Workers);
+	for (long w = 0; w < Workers; w++) {
+		pid_t Pid = fork();
+		if (Pid == 0) {
+			Worker(Jobs, ForkEachJob, RunJob);
+			_exit(0);
+		}
+		if (Pid < 0) {
+			perror("fork");
+			break;
+		}
+	}
+	while (wait(NULL) > 0)
+		;
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	return (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9f;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			Worker
+Parameters:		uint32_t Jobs
+							bool ForkEachJob
+							WorkerPoolJob_t *RunJob
+Returns:			void
+Description:	Takes jobs off the shared counter until there are none left
+****************************************************************************/
+static void Worker(uint32_t Jobs, bool ForkEachJob, WorkerPoolJob_t *RunJob) {
+	while (true) {
+		uint32_t Job = __atomic_fetch_add(NextJob, 1, __ATOMIC_RELAXED);
+		if (Job >= Jobs) return;
+		if (!ForkEachJob) {
+			RunJob(Job);
+			continue;
+		}
+		pid_t Pid = fork();
+		if (Pid == 0) {
+			RunJob(Job);
+			_exit(0);
+		}
+		if (Pid > 0) waitpid(Pid, NULL, 0);
+	}
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,30 @@
+/****************************************************************************
+Module: WorkerPool.h
+Description:
+	Runs a campaign's jobs on a pool of forked workers, for the host tools
+	that run many independent simulations (FaultCampaignMain.c,
+	MotorSweepMain.c). A worker per core pulls the next job off a counter in
+	shared memory, so a worker that finishes early takes on more jobs rather
+	than sitting idle. The jobs write their results into memory from
+	WorkerPool_Share, which the parent reads once the pool is done.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+#ifndef WorkerPool_H
+#define WorkerPool_H
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// A job, run in a worker process (or a process of its own), by its number
+typedef void WorkerPoolJob_t(uint32_t Job);
+
+/*----------------------- Public Function Prototypes ----------------------*/
+long WorkerPool_Count(long Workers);
+void *WorkerPool_Share(size_t Size);
+float WorkerPool_Run(uint32_t Jobs, long Workers, bool ForkEachJob, WorkerPoolJob_t *RunJob);
+
+#endif /* WorkerPool_H */
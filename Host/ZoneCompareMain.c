@@ -0,0 +1,133 @@
+/****************************************************************************
+Module: ZoneCompareMain.c
+Description:
+	Host check of the gamefield zone grid (GamefieldZoneTable.h) against
+	the bounding lines in GamefieldPositions.h. Looks up every point the
+	DRS can send, X and Y 0 to 65535, both ways, GetGamefieldPosition and
+	GetGamefieldPositionByBounds, and fails on any point they don't agree
+	on, so a table out of step with the bounds or the description it was
+	generated from is caught. Then does the same with the gamefield moved,
+	as a calibration would, over X and Y 0 to CALIBRATED_UNITS - 1, for the
+	grid SetFieldGeometry builds in RAM. Also times the two lookups over
+	the gamefield.
+
+	Build from the project directory on a PC:
+		gcc -std=gnu99 -O2 -IHeaders -o zonecompare Host/ZoneCompareMain.c \
+			Source/GamefieldPositions.c -lm
+
+	Usage:
+		zonecompare [field passes to time]
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Module Libraries
+#include "GamefieldPositions.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define DEFAULT_PASSES				200
+#define FIELD_UNITS						256
+// Off the grid and back for the calibrated gamefield
+#define CALIBRATED_UNITS			1024
+// Mismatches to print before only counting them
+#define MAX_PRINTED						10
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint64_t CompareLookups(uint32_t Units);
+static float TimeLookups(GamefieldPosition_t (*Lookup)(uint16_t, uint16_t), uint32_t Passes);
+
+/*---------------------------- Module Variables ---------------------------*/
+static volatile uint32_t Sink;
+
+// A gamefield moved and stretched from the defaults, as calibrating might
+static const FieldGeometry_t Calibrated = {
+	Corner1XBound + 7, Corner1YBound - 5, Corner2XBound + 7, Corner2YBound + 9,
+	Corner3XBound - 3, Corner3YBound + 9, Corner4XBound - 3, Corner4YBound - 5,
+	Straight1YBound - 5, Straight2XBound + 7, Straight3YBound + 9, Straight4XBound - 3,
+	BallLaunchingObstacleBound + 11, Straight2CenterY + 2, Straight3CenterX + 2
+};
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	uint32_t Passes = DEFAULT_PASSES;
+	if (argc > 1) Passes = strtoul(argv[1], NULL, 0);
+
+	uint64_t Mismatches = CompareLookups(UINT16_MAX + 1);
+	uint32_t Counts[Undefined + 1] = {0};
+	for (uint16_t Y = 0; Y < FIELD_UNITS; Y++) {
+		for (uint16_t X = 0; X < FIELD_UNITS; X++) Counts[GetGamefieldPositionByBounds(X, Y)]++;
+	}
+	printf("Points on the gamefield in each zone:\r\n");
+	for (uint8_t Zone = 0; Zone <= Undefined; Zone++) {
+		printf("  %-22s %6lu\r\n", GamefieldPositionString((GamefieldPosition_t)Zone), (unsigned long)Counts[Zone]);
+	}
+
+	float GridNS = TimeLookups(GetGamefieldPosition, Passes);
+	float BoundsNS = TimeLookups(GetGamefieldPositionByBounds, Passes);
+	printf("Over the gamefield, grid %.2f ns, bounds %.2f ns a lookup\r\n", GridNS, BoundsNS);
+	printf("Default gamefield, %llu of 4294967296 points differ\r\n", (unsigned long long)Mismatches);
+
+	SetFieldGeometry(&Calibrated);
+	uint64_t CalibratedMismatches = CompareLookups(CALIBRATED_UNITS);
+	printf("Calibrated gamefield, %llu of %lu points differ\r\n", (unsigned long long)CalibratedMismatches, \
+		(unsigned long)CALIBRATED_UNITS * CALIBRATED_UNITS);
+	Mismatches += CalibratedMismatches;
+	printf("%s\r\n", (Mismatches == 0) ? "PASS" : "FAIL");
+	return (Mismatches == 0) ? 0 : 1;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			CompareLookups
+Parameters:		uint32_t Units, X and Y from 0 to Units - 1
+Returns:			uint64_t, the points the grid and the bounds differ on
+Description:	Looks every point up both ways, printing the first that differ
+****************************************************************************/
+static uint64_t CompareLookups(uint32_t Units) {
+	uint64_t Mismatches = 0;
+	for (uint32_t Y = 0; Y < Units; Y++) {
+		for (uint32_t X = 0; X < Units; X++) {
+			GamefieldPosition_t Grid = GetGamefieldPosition(X, Y);
+			GamefieldPosition_t Bounds = GetGamefieldPositionByBounds(X, Y);
+			if (Grid != Bounds) {
+				if (Mismatches < MAX_PRINTED) printf("(%lu, %lu): grid %s, bounds %s\r\n", (unsigned long)X, \
+					(unsigned long)Y, GamefieldPositionString(Grid), GamefieldPositionString(Bounds));
+				Mismatches++;
+			}
+		}
+	}
+	return Mismatches;
+}
+
+/****************************************************************************
+Function:			TimeLookups
+Parameters:		GamefieldPosition_t (*Lookup)(uint16_t, uint16_t), to time
+							uint32_t Passes, over the gamefield
+Returns:			float, ns a lookup
+Description:	Looks up every point of the gamefield Passes times
+****************************************************************************/
+static float TimeLookups(GamefieldPosition_t (*Lookup)(uint16_t, uint16_t), uint32_t Passes) {
+	struct timespec Start, End;
+	uint32_t Sum = 0;
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (uint32_t Pass = 0; Pass < Passes; Pass++) {
+		for (uint16_t Y = 0; Y < FIELD_UNITS; Y++) {
+			for (uint16_t X = 0; X < FIELD_UNITS; X++) Sum += Lookup(X, Y);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	Sink = Sum;
+	float NS = (End.tv_sec - Start.tv_sec) * 1e9f + (End.tv_nsec - Start.tv_nsec);
+	return NS / ((float)Passes * FIELD_UNITS * FIELD_UNITS);
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,195 @@
+/****************************************************************************
+Module: ZoneGenMain.c
+Description:
+	Host generator of the gamefield zone grid (GamefieldZoneTable.h) that
+	GetGamefieldPosition looks points up in. Reads the zones from a
+	description (Host/GamefieldZones.txt), a list of rectangles where a
+	point is in the first that holds it, and gives each cell of the grid
+	its zone, or ZONE_SPLIT if the cell's points aren't all in one.
+	The grid is GamefieldPositions.h's, ZONE_GRID_CELLS cells a side.
+	Check the table against the bounds with zonecompare after building it.
+
+	Build from the project directory on a PC:
+		gcc -std=gnu99 -O2 -IHeaders -o zonegen Host/ZoneGenMain.c
+
+	Usage:
+		zonegen [description] [table]
+	from Host/GamefieldZones.txt to Headers/GamefieldZoneTable.h if not given.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Module Libraries
+#include "GamefieldPositions.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define DEFAULT_DESCRIPTION		"Host/GamefieldZones.txt"
+#define DEFAULT_TABLE					"Headers/GamefieldZoneTable.h"
+#define MAX_ZONES							32
+#define LINE_LENGTH						256
+#define CELL_UNITS						(1 << ZONE_CELL_SHIFT)
+// Bytes of the table to a line, a row of the grid
+#define BYTES_PER_LINE				(ZONE_GRID_CELLS / 2)
+
+/*---------------------------- Module Functions ---------------------------*/
+static bool ReadZones(const char *Name);
+static int16_t ZoneAt(uint16_t X, uint16_t Y);
+static bool WriteTable(const char *Name, const char *Description);
+
+/*---------------------------- Module Variables ---------------------------*/
+// A zone's rectangle, inclusive
+typedef struct {
+	GamefieldPosition_t	Position;
+	uint16_t						XFrom, XTo, YFrom, YTo;
+} Zone_t;
+
+static Zone_t Zones[MAX_ZONES];
+static uint8_t NumZones;
+static uint8_t Table[ZONE_TABLE_BYTES];
+
+// The zones' names in the description, not GamefieldPositionString as
+// GamefieldPositions.c needs the table this makes to build
+static const char *PositionNames[] = {
+	[Straight1] = "Straight1", [Corner1] = "Corner1", [Straight2] = "Straight2",
+	[Corner2] = "Corner2", [Straight3] = "Straight3", [Corner3] = "Corner3",
+	[Straight4] = "Straight4", [Corner4] = "Corner4",
+	[BallLaunchingArea] = "BallLaunchingArea",
+	[ObstacleCrossingArea] = "ObstacleCrossingArea", [Undefined] = "Undefined"
+};
+
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[]) {
+	const char *Description = (argc > 1) ? argv[1] : DEFAULT_DESCRIPTION;
+	const char *TableName = (argc > 2) ? argv[2] : DEFAULT_TABLE;
+	if (!ReadZones(Description)) return 1;
+
+	uint16_t Split = 0;
+	for (uint16_t Cell = 0; Cell < ZONE_GRID_CELLS * ZONE_GRID_CELLS; Cell++) {
+		uint16_t X0 = (Cell % ZONE_GRID_CELLS) * CELL_UNITS;
+		uint16_t Y0 = (Cell / ZONE_GRID_CELLS) * CELL_UNITS;
+		int16_t Zone = ZoneAt(X0, Y0);
+		for (uint16_t Y = Y0; Y < Y0 + CELL_UNITS; Y++) {
+			for (uint16_t X = X0; X < X0 + CELL_UNITS; X++) {
+				int16_t Here = ZoneAt(X, Y);
+				if (Here < 0) {
+					printf("%s: no zone holds (%u, %u)\r\n", Description, X, Y);
+					return 1;
+				}
+				if (Here != Zone) Zone = ZONE_SPLIT;
+			}
+		}
+		if (Zone == ZONE_SPLIT) Split++;
+		Table[Cell >> 1] |= Zone << ((Cell & 1) << 2);
+	}
+	if (!WriteTable(TableName, Description)) return 1;
+	printf("%u zones, %u of %u cells split, %u bytes, to %s\r\n", NumZones, Split, \
+		ZONE_GRID_CELLS * ZONE_GRID_CELLS, ZONE_TABLE_BYTES, TableName);
+	return 0;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ReadZones
+Parameters:		const char *Name, the description
+Returns:			bool, false if it couldn't be read
+Description:	Reads the zones, skipping blank lines and # comments
+****************************************************************************/
+static bool ReadZones(const char *Name) {
+	FILE *File = fopen(Name, "r");
+	if (File == NULL) {
+		perror(Name);
+		return false;
+	}
+	char Line[LINE_LENGTH];
+	uint16_t LineNumber = 0;
+	bool Good = true;
+	while (Good && fgets(Line, sizeof(Line), File) != NULL) {
+		LineNumber++;
+		char Position[LINE_LENGTH];
+		unsigned XFrom, XTo, YFrom, YTo;
+		int Used = 0;
+		if (sscanf(Line, " %n", &Used) == 0 && (Line[Used] == '#' || Line[Used] == '\0')) continue;
+		if (sscanf(Line, "%255s %u %u %u %u", Position, &XFrom, &XTo, &YFrom, &YTo) != 5 || \
+			XFrom > XTo || YFrom > YTo || NumZones >= MAX_ZONES) {
+			printf("%s:%u: expected a zone and its X and Y ranges\r\n", Name, LineNumber);
+			Good = false;
+			break;
+		}
+		Zone_t *Zone = &Zones[NumZones];
+		for (Zone->Position = Straight1; Zone->Position <= Undefined; Zone->Position++) {
+			if (strcmp(PositionNames[Zone->Position], Position) == 0) break;
+		}
+		if (Zone->Position > Undefined) {
+			printf("%s:%u: no zone %s\r\n", Name, LineNumber, Position);
+			Good = false;
+			break;
+		}
+		Zone->XFrom = XFrom;
+		Zone->XTo = XTo;
+		Zone->YFrom = YFrom;
+		Zone->YTo = YTo;
+		NumZones++;
+	}
+	fclose(File);
+	return Good;
+}
+
+/****************************************************************************
+Function:			ZoneAt
+Parameters:		uint16_t X, uint16_t Y, the point
+Returns:			int16_t, its GamefieldPosition_t, -1 if no zone holds it
+Description:	The first zone in the description that holds the point
+****************************************************************************/
+static int16_t ZoneAt(uint16_t X, uint16_t Y) {
+	for (uint8_t i = 0; i < NumZones; i++) {
+		if (X >= Zones[i].XFrom && X <= Zones[i].XTo && Y >= Zones[i].YFrom && Y <= Zones[i].YTo) {
+			return Zones[i].Position;
+		}
+	}
+	return -1;
+}
+
+/****************************************************************************
+Function:			WriteTable
+Parameters:		const char *Name, the table
+							const char *Description, where it came from
+Returns:			bool, false if it couldn't be written
+Description:	Writes GamefieldZoneTable.h, a row of the grid to a line
+****************************************************************************/
+static bool WriteTable(const char *Name, const char *Description) {
+	FILE *File = fopen(Name, "wb");
+	if (File == NULL) {
+		perror(Name);
+		return false;
+	}
+	fprintf(File, "/****************************************************************************\n");
+	fprintf(File, "Module: GamefieldZoneTable.h\n");
+	fprintf(File, "Description: The zone of each cell of the gamefield grid, for\n");
+	fprintf(File, "						 GetGamefieldPosition. Generated by Host/ZoneGenMain.c from\n");
+	fprintf(File, "						 %s, don't edit.\n", Description);
+	fprintf(File, "						 Cells are %u DRS units a side, a row of the grid to a line\n", CELL_UNITS);
+	fprintf(File, "						 from Y = 0, two cells to a byte, the lower X in the low\n");
+	fprintf(File, "						 nybble. ZONE_SPLIT where a bound crosses the cell.\n");
+	fprintf(File, "****************************************************************************/\n\n");
+	fprintf(File, "#ifndef GamefieldZoneTable_H\n#define GamefieldZoneTable_H\n\n");
+	fprintf(File, "#if ZONE_CELL_SHIFT != %u\n", ZONE_CELL_SHIFT);
+	fprintf(File, "#error The zone table is for another grid, run zonegen\n#endif\n\n");
+	fprintf(File, "static const uint8_t GamefieldZoneTable[ZONE_TABLE_BYTES] = {\n");
+	for (uint16_t i = 0; i < ZONE_TABLE_BYTES; i++) {
+		fprintf(File, "%s0x%02X%s", (i % BYTES_PER_LINE == 0) ? "\t" : "", Table[i], \
+			(i == ZONE_TABLE_BYTES - 1) ? "\n" : (i % BYTES_PER_LINE == BYTES_PER_LINE - 1) ? ",\n" : ", ");
+	}
+	fprintf(File, "};\n\n#endif /* GamefieldZoneTable_H */\n");
+	return fclose(File) == 0;
+}
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,3 @@
+/* Host build shim: the firmware sources include "bitdefs.h", the header in
+   Headers/ is BITDEFS.H, which only matches on a case-insensitive file system. */
+#include "../Headers/BITDEFS.H"
@@ -27,6 +27,7 @@ Author: Alex Lin, 2/25/15
 #include "driverlib/sysctl.h"
 #include "termio.h"
 #include "ES_Port.h"
+#include "HW_Port.h"
 #include "driverlib/gpio.h"
 #include "driverlib/interrupt.h"
 #include "utils/uartstdio.h"
@@ -60,6 +61,7 @@ Returns:			void
 Description:	Initializes the ball launcher hardware (Motor on E4, Servo on C4)
 ***************************************************************************/
 void InitializeBallLauncher(void) {
+#ifndef HOST_SIM
 // Initialize PWM 2 for shooter motor (M4) and PWM 3 for shooter servo control (M6)
   volatile uint32_t Dummy; // use volatile to avoid over-optimization
 // start by enabling the clock to the PWM Module (PWM0)
@@ -116,15 +118,18 @@ void InitializeBallLauncher(void) {
 	// Set the up/down count mode and enable the PWM generator
   HWREG(PWM0_BASE+ PWM_O_2_CTL) |= (PWM_2_CTL_MODE | PWM_2_CTL_ENABLE);
   HWREG(PWM0_BASE+ PWM_O_3_CTL) |= (PWM_3_CTL_MODE | PWM_3_CTL_ENABLE);
+#endif
 	ServoReverse();
 	//SetShooterPWM(0);
 	TurnOffShooter();
 	
 	
 	// ENABLE BALL LAUNCHER MOTOR ON PIN A7
+#ifndef HOST_SIM
 	HWREG(SYSCTL_RCGCGPIO) |= SYSCTL_RCGCGPIO_R0; // Port A
 	HWREG(GPIO_PORTA_BASE+GPIO_O_DEN) |= GPIO_PIN_7; // Enable Pin A7 for Digital I/O
 	HWREG(GPIO_PORTA_BASE+GPIO_O_DIR) |= GPIO_PIN_7; // Enable Pin A7 as Output
+#endif
 }
 
 /****************************************************************************
@@ -138,23 +143,23 @@ void SetShooterPWM(uint8_t DutyCycle) {
 				// Set the Duty cycle on A to 0% by programming the compare value
 				// to 0. However, since the CmpADn action (set to one) wins, we also
 				// need to disable the output  
-				HWREG(PWM0_BASE+PWM_O_2_CMPA) = 0;
-        HWREG(PWM0_BASE+PWM_O_ENABLE) &= ~PWM_ENABLE_PWM4EN;
+				PWM0_WRITE(PWM_O_2_CMPA, 0);
+        PWM0_CLEAR(PWM_O_ENABLE, PWM_ENABLE_PWM4EN);
 				printf("Turning shooter motor off.\r\n");
       }
 			else if (DutyCycle == 100) {
         // Set the Duty cycle on A to 100% by programming the compare value
         // to the load value. Since the CmpBDn action (set to one) wins, we get 100%
-        HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM4EN;
-        HWREG(PWM0_BASE+PWM_O_2_CMPA) = HWREG(PWM0_BASE+PWM_O_2_LOAD);
+        PWM0_SET(PWM_O_ENABLE, PWM_ENABLE_PWM4EN);
+        PWM0_WRITE(PWM_O_2_CMPA, PWM0_READ(PWM_O_2_LOAD));
 				printf("Turning shooter motor on.\r\n");
 			} else {
-        HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM4EN;
+        PWM0_SET(PWM_O_ENABLE, PWM_ENABLE_PWM4EN);
         uint32_t DutyCycleTicks = ((PeriodInMicroSeconds * PWMTicksPerMicroSecond)/2 * DutyCycle / 100);
 				//uint32_t DutyCycleTicks = ((PeriodInMicroSeconds * PWMTicksPerMicroSecond)/2 * (100 - DutyCycle) / 100);
 				//uint32_t DutyCycleTicks = HWREG(PWM0_BASE+PWM_O_2_LOAD)*DutyCycle/100;
 				//printf("Period Ticks = %d , DutyCycleTicks = %d\n\r",PeriodInMicroSeconds*PWMTicksPerMicroSecond, DutyCycleTicks);
-        HWREG(PWM0_BASE+PWM_O_2_CMPA) = DutyCycleTicks;
+        PWM0_WRITE(PWM_O_2_CMPA, DutyCycleTicks);
 			}
 			ServoReverse();
 	return;
@@ -167,8 +172,8 @@ Returns:			void
 Description:	Moves the servo into the forward position to load a ballpopopop
 ****************************************************************************/
 void ServoForward(void){
-	HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM6EN;
-	HWREG(PWM0_BASE+PWM_O_3_CMPA) = ((SERVO_FORWARD_PULSE_WIDTH * PWMTicksPerMicroSecond)>>1);
+	PWM0_SET(PWM_O_ENABLE, PWM_ENABLE_PWM6EN);
+	PWM0_WRITE(PWM_O_3_CMPA, ((SERVO_FORWARD_PULSE_WIDTH * PWMTicksPerMicroSecond)>>1));
 	printf("Servo arm in forward position.\r\n");
 	return;
 }
@@ -180,20 +185,20 @@ Returns:			void
 Description:	Moves the servo into the forward position to load a ball
 ****************************************************************************/
 void ServoReverse(void){
-	HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM6EN;
-	HWREG(PWM0_BASE+PWM_O_3_CMPA) = ((SERVO_REVERSE_PULSE_WIDTH * PWMTicksPerMicroSecond)>>1);
+	PWM0_SET(PWM_O_ENABLE, PWM_ENABLE_PWM6EN);
+	PWM0_WRITE(PWM_O_3_CMPA, ((SERVO_REVERSE_PULSE_WIDTH * PWMTicksPerMicroSecond)>>1));
 	printf("Servo arm in reverse position.\r\n");
 	return;
 }
 
 void TurnOnShooter(void) {
 	printf("Turning on the shooter motor.\r\n");
-	HWREG(GPIO_PORTA_BASE+(GPIO_O_DATA + ALL_BITS)) |= GPIO_PIN_7;
+	GPIO_SET(GPIO_PORTA_BASE, GPIO_PIN_7);
 }
 
 void TurnOffShooter(void) {
 	printf("Turning off the shooter motor.\r\n");
-	HWREG(GPIO_PORTA_BASE+(GPIO_O_DATA + ALL_BITS)) &= ~GPIO_PIN_7;
+	GPIO_CLEAR(GPIO_PORTA_BASE, GPIO_PIN_7);
 }
 	
 
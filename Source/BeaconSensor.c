@@ -20,6 +20,8 @@
 #include "Display.h"
 
 #include "BeaconSensor.h"
+#include "HW_Port.h"
+#include "InputRecorder.h"
 
 // 40,000 ticks per mS assumes a 40Mhz clock
 #define TicksPerMS 40000
@@ -42,7 +44,7 @@ int arrayCounter = 0;
 // This code is templated from Lab 7, so Periodic Timer B has been commented out, but can be activated if necessary.
 
 void InitBeaconSensingCapture( void ){
-
+#ifndef HOST_SIM
   // start by enabling the clock to the timer (Wide Timer 5)
   HWREG(SYSCTL_RCGCWTIMER) |= SYSCTL_RCGCWTIMER_R5;
 	// enable the clock to Port D
@@ -109,6 +111,7 @@ void InitBeaconSensingCapture( void ){
 	// now kick timer b off by enabling it and enabling the timer to
 // stall while stopped by the debugger
   //HWREG(WTIMER0_BASE+TIMER_O_CTL) |= (TIMER_CTL_TBEN | TIMER_CTL_TBSTALL);
+#endif
 	Period = 0;
 }
 
@@ -116,9 +119,10 @@ void BeaconSensedCaptureResponse(void ){
 	//printf("INTERRUPT!");
   uint32_t ThisCapture;
 // start by clearing the source of the interrupt, the input capture event
-    HWREG(WTIMER5_BASE+TIMER_O_ICR) = TIMER_ICR_CAECINT;
+    BEACON_CLEAR();
 // now grab the captured value and calculate the period
-    ThisCapture = HWREG(WTIMER5_BASE+TIMER_O_TAR);
+    ThisCapture = BEACON_CAPTURE();
+    RecordCapture(INPUT_BEACON, BEACON_TIMER() - ThisCapture);
     Period = ThisCapture - LastCapture;
 		Period = Period << 1;
     
@@ -20,12 +20,14 @@ Author: Kyle Moy, 3/1/15
 #include "inc/hw_sysctl.h"
 #include "termio.h"
 #include "ES_Port.h"
+#include "HW_Port.h"
 #include "driverlib/gpio.h"
 #include "driverlib/interrupt.h"
 #include "utils/uartstdio.h"
 
 // Module Libraries
 #include "BumpSensor.h"
+#include "InputRecorder.h"
 #include "SM_Master.h"
 
 
@@ -41,11 +43,13 @@ Returns:			void
 Description:	Initializes the hardware for the bump sensors
 ****************************************************************************/
 void InitializeBumpSensors(void) {
+#ifndef HOST_SIM
 	// Initialization of the bump sensor
 	HWREG(SYSCTL_RCGCGPIO) |= SYSCTL_RCGCGPIO_R3; // Port D
 	HWREG(GPIO_PORTD_BASE+GPIO_O_DEN) |= GPIO_PIN_1; // Enable Pin D1 for Digital I/O
 	HWREG(GPIO_PORTD_BASE+GPIO_O_DIR) &= ~GPIO_PIN_1; // Enable Pin D1 as Input
 	HWREG(GPIO_PORTD_BASE+GPIO_O_PUR) |=  GPIO_PIN_1; // Enable Pull Up Resistor on Pin D1
+#endif
 }
 
 
@@ -56,7 +60,13 @@ Returns:			bool, true if bumped, false if not bumped
 Description:	Returns true if bump sensor is hit
 ****************************************************************************/
 bool BumpSensorDetected(void) {
-	return ~HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + ALL_BITS)) & GPIO_PIN_1;
+	static uint8_t LastBumped = 0;
+	uint8_t Bumped = (~GPIO_READ(GPIO_PORTD_BASE) & GPIO_PIN_1) ? 1 : 0;
+	if (Bumped != LastBumped) {
+		LastBumped = Bumped;
+		RecordInput(INPUT_BUMP, &Bumped);
+	}
+	return Bumped;
 }
 
 
@@ -0,0 +1,342 @@
+/****************************************************************************
+Module: CollisionPredictor.c
+Description:
+	Predicts collisions with the other Karts using the DRS positions.
+	Every time a Kart's position is updated, its velocity is estimated from
+	the previous position and a short time horizon is projected for each
+	opponent relative to our Kart. If the closest approach falls inside the
+	collision radius within the horizon, an E_COLLISION_WARNING is posted
+	with the time-to-collision (ms) as the parameter, along with a suggested
+	speed bias that SM_Racing can apply to the drive motors.
+Author: Kyle Moy, 3/4/15
+****************************************************************************/
+
+//#define TEST
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <math.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Timers.h"
+
+// Module Libraries
+#include "CollisionPredictor.h"
+#include "DRS.h"
+#include "SM_Master.h"
+#include "Display.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define NUM_KARTS						3
+#define MS_PER_TICK					10		// ES_Timer_RATE_10mS
+
+// Two Karts closer than this (DRS units, center to center) are in contact
+#define COLLISION_RADIUS		30
+// How far ahead to project the trajectories (ms)
+#define PREDICTION_HORIZON	1500
+// Velocity samples older than this are stale and the Kart is assumed stopped
+#define MAX_SAMPLE_AGE			500
+// The DRS refreshes its poses every 100ms and we poll faster, the same
+// position read again within this is the same measurement (as
+// PoseEstimator.c's FIX_REFRESH_US)
+#define POSE_REFRESH_MS			100
+// Low pass filter weight on each new velocity sample (0 to 1)
+#define VELOCITY_ALPHA			0.5f
+// The slowest we'll ask the motors to go when a collision is imminent (%)
+#define MIN_SPEED_BIAS			30
+// Re-post a warning only when the bias changes by at least this much (%)
+#define BIAS_REPOST_STEP		10
+
+/*---------------------------- Module Functions ---------------------------*/
+static void PredictCollisions(void);
+static uint8_t ComputeSpeedBias(uint16_t TimeToCollision);
+
+/*---------------------------- Module Variables ---------------------------*/
+// Per-Kart track of the last position and the filtered velocity (units/s)
+typedef struct {
+	float		X;
+	float		Y;
+	float		VX;
+	float		VY;
+	uint16_t	LastTime;
+	bool		HasPosition;
+} KartTrack_t;
+
+static KartTrack_t Tracks[NUM_KARTS];
+
+// The current prediction
+static bool CollisionPredicted = false;
+static uint16_t TimeToCollision = 0;
+static uint8_t SpeedBias = 100;
+static uint8_t ThreatKart = 0;
+static uint8_t LastPostedBias = 100;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			UpdateCollisionPrediction
+Parameters:		uint8_t KartNumber, the Kart (1-3) that was just updated
+							Kart_t Kart, the new Kart data
+Returns:			void
+Description:	Updates the velocity estimate for a Kart from its new DRS
+							position, then re-runs the collision prediction
+****************************************************************************/
+void UpdateCollisionPrediction(uint8_t KartNumber, Kart_t Kart) {
+	if (KartNumber < 1 || KartNumber > NUM_KARTS) return;
+	KartTrack_t *Track = &Tracks[KartNumber - 1];
+	uint16_t Now = ES_Timer_GetTime();
+
+	if (Track->HasPosition) {
+		// Unsigned subtraction handles the wrap of the free running timer
+		uint32_t ElapsedMS = (uint16_t)(Now - Track->LastTime) * MS_PER_TICK;
+
+		// Two updates in the same tick carry no velocity information, nor
+		// does the last pose read again before the DRS has refreshed it. The
+		// next new pose is differenced against the last one that changed,
+		// over the time since, rather than pulling the velocity toward zero
+		if (ElapsedMS == 0) return;
+		if (Kart.KartX == Track->X && Kart.KartY == Track->Y && ElapsedMS < POSE_REFRESH_MS) return;
+
+		if (ElapsedMS > MAX_SAMPLE_AGE) {
+			// Too long since the last sample, start the estimate over
+			Track->VX = 0;
+			Track->VY = 0;
+		} else {
+			float NewVX = (Kart.KartX - Track->X) * 1000.0f / ElapsedMS;
+			float NewVY = (Kart.KartY - Track->Y) * 1000.0f / ElapsedMS;
+			Track->VX += VELOCITY_ALPHA * (NewVX - Track->VX);
+			Track->VY += VELOCITY_ALPHA * (NewVY - Track->VY);
+		}
+	}
+	Track->X = Kart.KartX;
+	Track->Y = Kart.KartY;
+	Track->LastTime = Now;
+	Track->HasPosition = true;
+
+	PredictCollisions();
+}
+
+/****************************************************************************
+Function:			IsCollisionPredicted
+Parameters:		void
+Returns:			bool, true if a collision is predicted within the horizon
+Description:	Returns the current prediction
+****************************************************************************/
+bool IsCollisionPredicted(void) {
+	return CollisionPredicted;
+}
+
+/****************************************************************************
+Function:			GetTimeToCollision
+Parameters:		void
+Returns:			uint16_t, the predicted time to collision (ms)
+Description:	Only valid when IsCollisionPredicted() is true
+****************************************************************************/
+uint16_t GetTimeToCollision(void) {
+	return TimeToCollision;
+}
+
+/****************************************************************************
+Function:			GetCollisionSpeedBias
+Parameters:		void
+Returns:			uint8_t, the suggested speed as a percent of normal (0-100)
+Description:	100 when no collision is predicted, dropping towards
+							MIN_SPEED_BIAS as the time to collision shrinks
+****************************************************************************/
+uint8_t GetCollisionSpeedBias(void) {
+	return SpeedBias;
+}
+
+/****************************************************************************
+Function:			GetCollisionThreatKart
+Parameters:		void
+Returns:			uint8_t, the Kart number we are predicted to hit, 0 if none
+Description:	Returns the opponent closest to colliding with us
+****************************************************************************/
+uint8_t GetCollisionThreatKart(void) {
+	return ThreatKart;
+}
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			PredictCollisions
+Parameters:		void
+Returns:			void
+Description:	Projects each opponent relative to our Kart assuming constant
+							velocity. With relative position d and relative velocity v, the
+							closest approach is at t = -(d.v)/|v|^2. A collision is predicted
+							if that distance is inside COLLISION_RADIUS within the horizon.
+							Posts E_COLLISION_WARNING / E_COLLISION_CLEARED on changes.
+****************************************************************************/
+static void PredictCollisions(void) {
+	uint8_t MyKartNumber = GetMyKartNumber();
+	KartTrack_t *Me = &Tracks[MyKartNumber - 1];
+	uint16_t Now = ES_Timer_GetTime();
+	bool Predicted = false;
+	float SoonestTime = PREDICTION_HORIZON;
+	uint8_t SoonestKart = 0;
+
+	if (Me->HasPosition) {
+		for (uint8_t KartNumber = 1; KartNumber <= NUM_KARTS; KartNumber++) {
+			KartTrack_t *Them = &Tracks[KartNumber - 1];
+			if (KartNumber == MyKartNumber || !Them->HasPosition) continue;
+
+			// Ignore Karts that haven't been seen in a while (e.g. off the field)
+			if ((uint16_t)(Now - Them->LastTime) * MS_PER_TICK > MAX_SAMPLE_AGE) continue;
+
+			float DX = Them->X - Me->X;
+			float DY = Them->Y - Me->Y;
+			float VX = Them->VX - Me->VX;
+			float VY = Them->VY - Me->VY;
+			float RadiusSquared = COLLISION_RADIUS * COLLISION_RADIUS;
+			float DistanceSquared = DX*DX + DY*DY;
+			float SpeedSquared = VX*VX + VY*VY;
+			float Closing = DX*VX + DY*VY;
+			float T; // seconds
+
+			// Not closing in on each other, even in contact we're pulling apart
+			if (SpeedSquared == 0 || Closing >= 0) continue;
+
+			if (DistanceSquared <= RadiusSquared) {
+				// Already in contact
+				T = 0;
+			} else {
+
+				// Closest approach, skip if it misses us
+				float TClosest = -Closing / SpeedSquared;
+				float MissX = DX + VX*TClosest;
+				float MissY = DY + VY*TClosest;
+				float MissSquared = MissX*MissX + MissY*MissY;
+				if (MissSquared > RadiusSquared) continue;
+
+				// Time at which the separation first reaches the collision radius
+				T = TClosest - sqrtf((RadiusSquared - MissSquared) / SpeedSquared);
+				if (T < 0) T = 0;
+			}
+
+			if (T * 1000.0f < SoonestTime) {
+				SoonestTime = T * 1000.0f;
+				SoonestKart = KartNumber;
+				Predicted = true;
+			}
+		}
+	}
+
+	if (Predicted) {
+		bool NewThreat = !CollisionPredicted || SoonestKart != ThreatKart;
+		CollisionPredicted = true;
+		TimeToCollision = (uint16_t)SoonestTime;
+		ThreatKart = SoonestKart;
+		SpeedBias = ComputeSpeedBias(TimeToCollision);
+
+		// Post on a new threat, or when the suggested bias has moved enough
+		// to be worth acting on, to avoid flooding the Master SM every DRS read
+		int8_t BiasChange = SpeedBias - LastPostedBias;
+		if (BiasChange >= BIAS_REPOST_STEP || BiasChange <= -BIAS_REPOST_STEP || NewThreat) {
+			ES_Event Event = {E_COLLISION_WARNING, TimeToCollision};
+			PostMasterSM(Event);
+			LastPostedBias = SpeedBias;
+			if (DisplayCollisionPrediction)
+				printf("Collision predicted with Kart %d in %d ms, speed bias %d%%\r\n", \
+					ThreatKart, TimeToCollision, SpeedBias);
+		}
+	} else if (CollisionPredicted) {
+		CollisionPredicted = false;
+		TimeToCollision = 0;
+		ThreatKart = 0;
+		SpeedBias = 100;
+		LastPostedBias = 100;
+		ES_Event Event = {E_COLLISION_CLEARED};
+		PostMasterSM(Event);
+		if (DisplayCollisionPrediction)
+			printf("Collision cleared\r\n");
+	}
+}
+
+/****************************************************************************
+Function:			ComputeSpeedBias
+Parameters:		uint16_t TimeToCollision, in ms
+Returns:			uint8_t, the suggested speed as a percent of normal
+Description:	Scales linearly from MIN_SPEED_BIAS at contact up to 100 at
+							the edge of the prediction horizon
+****************************************************************************/
+static uint8_t ComputeSpeedBias(uint16_t TimeToCollision) {
+	if (TimeToCollision >= PREDICTION_HORIZON) return 100;
+	// Keep at least 1% headroom below 100 so a warning always changes the bias
+	uint8_t Bias = MIN_SPEED_BIAS +
+		((uint32_t)(100 - MIN_SPEED_BIAS) * TimeToCollision) / PREDICTION_HORIZON;
+	return (Bias > 99) ? 99 : Bias;
+}
+
+
+/*------------------------------ Test Harness -----------------------------*/
+#ifdef TEST
+#include "termio.h"
+/* Test Harness for the Collision Predictor. Runs without the framework so
+	the time between updates is faked by waiting on the ES tick. */
+int main(void)
+{
+	_HW_Timer_Init(ES_Timer_RATE_10mS);
+	TERMIO_Init();
+	clrScrn();
+	printf("In Test Harness for the Collision Predictor Module\n\r");
+
+	// Kart1 (us) heading right, Kart2 heading left on the same line
+	Kart_t Us = {50, 100, 0, 3, false, false, Flag_Dropped, Straight1};
+	Kart_t Them = {250, 100, 180, 3, false, false, Flag_Dropped, Straight1};
+	for (int i = 0; i < 20; i++) {
+		UpdateCollisionPrediction(1, Us);
+		UpdateCollisionPrediction(2, Them);
+		printf("Predicted = %d, TTC = %d ms, Bias = %d%%\r\n", \
+			IsCollisionPredicted(), GetTimeToCollision(), GetCollisionSpeedBias());
+		Us.KartX += 5;
+		Them.KartX -= 5;
+		// Wait 100ms between updates
+		uint16_t Start = ES_Timer_GetTime();
+		while ((uint16_t)(ES_Timer_GetTime() - Start) < 10)
+			;
+	}
+
+	// Now in contact, back apart, which should clear rather than warn
+	printf("Backing apart\r\n");
+	for (int i = 0; i < 10; i++) {
+		Us.KartX -= 5;
+		Them.KartX += 5;
+		UpdateCollisionPrediction(1, Us);
+		UpdateCollisionPrediction(2, Them);
+		printf("Predicted = %d, TTC = %d ms, Bias = %d%%\r\n", \
+			IsCollisionPredicted(), GetTimeToCollision(), GetCollisionSpeedBias());
+		uint16_t Start = ES_Timer_GetTime();
+		while ((uint16_t)(ES_Timer_GetTime() - Start) < 10)
+			;
+	}
+
+	// Polled faster than the DRS refreshes, the TTC should fall steadily
+	// rather than ripple with the repeated poses
+	printf("Polled every 40ms\r\n");
+	for (int i = 0; i < 25; i++) {
+		if (i % 5 == 0 || i % 5 == 3) {
+			// A new pose every 100ms, 2 or 3 polls apart
+			Us.KartX += 5;
+			Them.KartX -= 5;
+		}
+		UpdateCollisionPrediction(1, Us);
+		UpdateCollisionPrediction(2, Them);
+		printf("Predicted = %d, TTC = %d ms, Bias = %d%%\r\n", \
+			IsCollisionPredicted(), GetTimeToCollision(), GetCollisionSpeedBias());
+		uint16_t Start = ES_Timer_GetTime();
+		while ((uint16_t)(ES_Timer_GetTime() - Start) < 4)
+			;
+	}
+	return 0;
+}
+#endif
+
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -4,6 +4,8 @@ Description:
 	Hardware module for the DRS SPI communication system.
 	Includes functions to initialize the SPI, send a query, and 
 	the End of Transmission (EOT) interrupt response.
+	SSI0 accesses go through HW_Port.h so that the module can also be run
+	against the DRS simulator in Host/.
 Author: Kyle Moy, 2/18/15
 ****************************************************************************/
 
@@ -17,6 +19,7 @@ Author: Kyle Moy, 2/18/15
 // C Libraries
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <cmath>
 
 // Framework Libraries
@@ -37,6 +40,7 @@ Author: Kyle Moy, 2/18/15
 #include "driverlib/ssi.h"
 #include "bitdefs.h"
 #include "driverlib/gpio.h"
+#include "HW_Port.h"
 
 // Module Libraries
 #include "DRS.h"
@@ -44,6 +48,12 @@ Author: Kyle Moy, 2/18/15
 #include "Display.h"
 #include "SM_Master.h"
 #include "KartSwitchAndLED.h"
+#include "CollisionPredictor.h"
+#include "PoseEstimator.h"
+#include "DriveMotorEncoder.h"
+#include "InputRecorder.h"
+#include "FieldCalibration.h"
+#include "GamefieldPositions.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define BitsPerNibble 	4
@@ -65,8 +75,43 @@ Author: Kyle Moy, 2/18/15
 #define TARGET_SUCCESSFUL		0x80	// 1 on Bit 7
 #define INVALID_READ 				0xFF
 
+// Response frame validation
+#define ECHO_BYTE0					0xFF	// Clocked back while the query byte goes out
+#define ECHO_BYTE1					0x00	// Clocked back while the DRS loads the response
+#define FIELD_RANGE_MARGIN	20		// DRS units past the far walls' estimate, see IsOnField
+#define MAX_KART_SPEED			150		// DRS units per second, faster than any Kart
+#define POSE_JUMP_MARGIN		10		// DRS units of allowance for measurement noise
+#define MAX_POSE_AGE				100		// ES ticks, after this long any pose is accepted
+#define MAX_JUMP_REJECTS		3			// Accept a jump after this many in a row
+
+#define MS_PER_TICK					10		// ES_Timer_RATE_10mS
+
+// E_DRS_UPDATED publication. Our pose is only published when it has moved
+// at least PUBLISH_MIN_DISTANCE or turned PUBLISH_MIN_ANGLE since the last
+// publish, no more often than PUBLISH_MIN_INTERVAL, and at least every
+// PUBLISH_MAX_INTERVAL as a heartbeat even if we are sitting still.
+// A PUBLISH_MIN_INTERVAL of 0 turns the rate limit off, which is how we
+// race: our frames come about 4 ticks apart (racesim, 25 a second), so a
+// limit under that never holds one back and one over it would hold back
+// moves the distance and angle thresholds let through.
+#define PUBLISH_MIN_DISTANCE	2		// DRS units
+#define PUBLISH_MIN_ANGLE			3		// Degrees
+#define PUBLISH_MIN_INTERVAL	0		// ES ticks, 0 for no limit
+#define PUBLISH_MAX_INTERVAL	25	// ES ticks (250ms)
+
+// Run functions an E_DRS_UPDATED goes through, in tenths. Master and
+// Playing take every one, Racing and Navigation only in some states.
+// Counted in racesim over 3 laps, seeds 1-6: 2.3-2.6 per pose, with
+// 2160-2460 of 2840-3160 poses a race suppressed, 5000-6300 dispatches
+#define HSM_DISPATCHES_PER_10_POSES	24
+
 
 /*---------------------------- Module Functions ---------------------------*/
+static bool ValidateFrame(void);
+static bool IsOnField(uint16_t X, uint16_t Y);
+static bool ValidatePose(uint8_t KartNumber, uint16_t X, uint16_t Y);
+static uint8_t QueryKartNumber(uint8_t Query);
+static bool ShouldPublishPose(Kart_t *Kart);
 
 
 /*---------------------------- Module Variables ---------------------------*/
@@ -76,6 +121,31 @@ uint8_t CurrentQuery;
 // An 8-byte array to store the SPI data
 static uint8_t DRS_Data[8] =  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
+// The last frame accepted, and the query it answered, to detect stuck frames
+static uint8_t LastFrame[8];
+static uint8_t LastFrameQuery = 0;
+
+// When each Kart's pose was last accepted, and how many jumps in a row were rejected
+static uint16_t LastPoseTime[3];
+static uint8_t JumpRejects[3];
+
+// Timestamps for the query latency, the EOT stamp also dates the frame
+static uint32_t QueryTimestamp;
+static uint32_t EOTTimestamp;
+// Encoder odometers at the EOT, so our pose can be carried forward from it
+static int32_t EOTTicksL;
+static int32_t EOTTicksR;
+
+// The DRS link quality record
+static DRSLinkStats_t LinkStats;
+
+// Our pose as of the last E_DRS_UPDATED
+static bool PosePublished = false;
+static uint16_t PublishedX;
+static uint16_t PublishedY;
+static int16_t PublishedTheta;
+static uint16_t PublishedTime;
+
 
 // Initializes the data structures for the Kart data
 //		uint16_t 						KartX;
@@ -105,6 +175,7 @@ Description:	Initializes the DRS SSI on Tiva Pins A2-A5
 				A5: SSI Module 0 Receive (SDI), output
 ****************************************************************************/
 void InitializeDRS(void) {
+#ifndef HOST_SIM
 		// Enable clock to GPIO Port A
     HWREG(SYSCTL_RCGCGPIO) |= SYSCTL_RCGCGPIO_R0;
     // Enable clock to SSI Module 0
@@ -129,30 +200,33 @@ void InitializeDRS(void) {
     // Wait for the SSI0 to be ready
     while((HWREG(SYSCTL_PRSSI) & SYSCTL_PRSSI_R0) != SYSCTL_PRSSI_R0)
         ;
+#endif
     // Make sure the SSI is disabled before programming mode bits
-    HWREG(SSI0_BASE + SSI_O_CR1) &= ~(SSI_CR1_SSE);
+    SSI0_CLEAR(SSI_O_CR1, SSI_CR1_SSE);
     // Select master mode (MS) 
-    HWREG(SSI0_BASE + SSI_O_CR1) &= ~(SSI_CR1_MS);
+    SSI0_CLEAR(SSI_O_CR1, SSI_CR1_MS);
     // Select TXRIS indicating EOT
-    HWREG(SSI0_BASE + SSI_O_CR1) |= SSI_CR1_EOT;
+    SSI0_SET(SSI_O_CR1, SSI_CR1_EOT);
     // Configure the SSI clock source to the system clock
-    HWREG(SSI0_BASE + SSI_O_CC) |= SSI_CC_CS_SYSPLL;
+    SSI0_SET(SSI_O_CC, SSI_CC_CS_SYSPLL);
     // Configure the clock pre-scaler
-    HWREG(SSI0_BASE + SSI_O_CPSR) |= 0x10;
+    SSI0_SET(SSI_O_CPSR, 0x10);
     // Configure the clock rate (SCR) for 66us period (33us SCK high, 33us SCK low)
 		// Bit Rate = SYSCLK / (CPDVSR*(1+SCR)), SYSCLK = 40MHz, CPDVSR = 16 => SCR = 164
-    HWREG(SSI0_BASE + SSI_O_CR0) |=  164<<8;
+    SSI0_SET(SSI_O_CR0, 164<<8);
     // Configure the phase & polarity (SPH, SPO), mode (FRF), data size (DSS)
-    HWREG(SSI0_BASE + SSI_O_CR0) |= (SSI_CR0_SPH | SSI_CR0_SPO | SSI_CR0_FRF_MOTO | SSI_CR0_DSS_8);
+    SSI0_SET(SSI_O_CR0, (SSI_CR0_SPH | SSI_CR0_SPO | SSI_CR0_FRF_MOTO | SSI_CR0_DSS_8));
     // Locally enable interrupts on TXRIS
-    HWREG(SSI0_BASE + SSI_O_IM) |= SSI_RIS_TXRIS;
+    SSI0_SET(SSI_O_IM, SSI_RIS_TXRIS);
     // Make sure the SSI is enabled for operation
-    HWREG(SSI0_BASE + SSI_O_CR1) |= SSI_CR1_SSE;
+    SSI0_SET(SSI_O_CR1, SSI_CR1_SSE);
+#ifndef HOST_SIM
 		// Enable the SSI0 interrupt in the NVIC
 		// It is interrupt number 7 so appears in EN0 at bit 7
 			HWREG(NVIC_EN0) |= BIT7HI;
 		// make sure interrupts are enabled globally
 			__enable_irq();
+#endif
 		// Print to console if successful initialization
 		printf("DRS Initialized\n\r");
 		
@@ -185,15 +259,19 @@ Description:	End of Transfer (EOT) interrupt response handler
 ****************************************************************************/
 void EOTIntHandler(void) {
 	// Clear the source of the interrupt
-	HWREG(SSI0_BASE+SSI_O_ICR) = SSI_ICR_RORIC;
+	SSI0_WRITE(SSI_O_ICR, SSI_ICR_RORIC);
 	
 	// Check that SPI is not transmitting before reading the receive register
-	if ((HWREG(SSI0_BASE + SSI_O_SR) & SSI_SR_BSY) != SSI_SR_BSY) {
+	if ((SSI0_READ(SSI_O_SR) & SSI_SR_BSY) != SSI_SR_BSY) {
 		// Read the 8 bytes into SPI_Data
 		for (int i = 0; i < 8; i++) {
-			DRS_Data[i] = HWREG(SSI0_BASE + SSI_O_DR);
+			DRS_Data[i] = SSI0_READ(SSI_O_DR);
 		}
 	}
+	RecordInput(INPUT_DRS_FRAME, DRS_Data);
+	EOTTimestamp = HW_TIMESTAMP();
+	EOTTicksL = GetOdometerL();
+	EOTTicksR = GetOdometerR();
 	if (DRS_ConsoleDisplay)
 			printf("DRS_Data = 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x\r\n", \
 				DRS_Data[0], DRS_Data[1], DRS_Data[2], DRS_Data[3], DRS_Data[4], DRS_Data[5], DRS_Data[6], DRS_Data[7]);
@@ -223,18 +301,20 @@ bool SendQuery(uint8_t Query) {
 	CurrentQuery = Query;
 	
 	// Check if the data output FIFO queue is empty
-	if((HWREG(SSI0_BASE + SSI_O_SR) & SSI_SR_TFE) == SSI_SR_TFE) {
+	if((SSI0_READ(SSI_O_SR) & SSI_SR_TFE) == SSI_SR_TFE) {
 		// Unmask the SSI transmit interrupt (SSI_IM_TXIM) to enable EOT interrupt 
-		HWREG(SSI0_BASE + SSI_O_IM) |= SSI_IM_TXIM;
+		SSI0_SET(SSI_O_IM, SSI_IM_TXIM);
 		
 		// Write query byte to the data output register
-		HWREG(SSI0_BASE + SSI_O_DR) = Query;
+		SSI0_WRITE(SSI_O_DR, Query);
 		// Write 0x00 to the data output register 7 times
 		for (int i = 1; i < 8; i++) {
-			HWREG(SSI0_BASE + SSI_O_DR) = 0x00;
+			SSI0_WRITE(SSI_O_DR, 0x00);
 		}	
+		QueryTimestamp = HW_TIMESTAMP();
 		return true;
 	}
+	LinkStats.SendFailures++;
 	return false;
 }
 
@@ -242,13 +322,22 @@ bool SendQuery(uint8_t Query) {
 /****************************************************************************
 Function:			StoreData
 Parameters:		none
-Returns:			bool true if successful
-Description:	Stores the DRS_Data to the appropriate Kart variable
+Returns:			bool true if successful, false if the frame was rejected
+Description:	Validates the DRS_Data and stores it to the appropriate Kart variable
 ****************************************************************************/
 bool StoreData(void) {
 	// Pointer to the Kart struct that will be updated
 	Kart_t *Kart;
 	
+	// Record the latency from the query to the EOT interrupt
+	uint32_t Latency = (EOTTimestamp - QueryTimestamp) / HW_TICKS_PER_US;
+	LinkStats.LastLatencyUS = Latency;
+	LinkStats.AvgLatencyUS += ((int32_t)Latency - (int32_t)LinkStats.AvgLatencyUS) / 8;
+	if (Latency > LinkStats.MaxLatencyUS) LinkStats.MaxLatencyUS = Latency;
+	
+	// Throw out bad frames before they touch the Kart data
+	if (!ValidateFrame()) return false;
+	
 	// Check if the current query is a GAME_STATUS_QUERY
 	if (CurrentQuery == GAME_STATUS_QUERY) {
 		// Process SS1 (match status for Kart1), Response Byte 3
@@ -323,12 +412,25 @@ bool StoreData(void) {
 		// Record the Kart data
 		Kart->KartX = DRS_Data[2]<<8 | DRS_Data[3]; // PXm (Byte 2) | PXl (Byte 3)
 		Kart->KartY = DRS_Data[4]<<8 | DRS_Data[5]; // PYm (Byte 4) | PYl (Byte 5)
-		Kart->KartTheta = (DRS_Data[6]<<8 | DRS_Data[7]) % 360; // Om (Byte 6) | Ol (Byte 7)
+		Kart->KartTheta = DRS_Data[6]<<8 | DRS_Data[7]; // Om (Byte 6) | Ol (Byte 7), range checked
 		if (Kart == MyKart) {
-			ES_Event Event = {E_DRS_UPDATED};
-			PostMasterSM(Event);
+			// Anchor the pose estimate to this frame's EOT
+			SetPoseFix(*Kart, EOTTimestamp, EOTTicksL, EOTTicksR);
+			RecordFieldCalibrationPose(Kart->KartX, Kart->KartY);
+			// Only wake up the HSM chain on meaningful motion, or as a heartbeat
+			if (ShouldPublishPose(Kart)) {
+				ES_Event Event = {E_DRS_UPDATED};
+				PostMasterSM(Event);
+			}
 		};
 		
+		// Project the Karts ahead with the new position to look for collisions
+		switch (CurrentQuery) {
+			case KART1_QUERY: UpdateCollisionPrediction(1, *Kart); break;
+			case KART2_QUERY: UpdateCollisionPrediction(2, *Kart); break;
+			case KART3_QUERY: UpdateCollisionPrediction(3, *Kart); break;
+		}
+		
 		// Check if our gamefield position has changed
 		GamefieldPosition_t NewGamefieldPosition = GetGamefieldPosition(Kart->KartX, Kart->KartY);
 		if (Kart->GamefieldPosition != NewGamefieldPosition) {
@@ -503,6 +605,236 @@ Kart_t GetMyKart(void) {
 	return *MyKart;
 }
 
+/****************************************************************************
+Function:			GetMyKartNumber
+Parameters:		void
+Returns:			uint8_t, our Kart number (1-3)
+Description:	Returns which of the three Karts is ours
+****************************************************************************/
+uint8_t GetMyKartNumber(void) {
+	if (MyKart == &Kart2) return 2;
+	if (MyKart == &Kart3) return 3;
+	return 1;
+}
+
+
+/****************************************************************************
+Function:			RecordDRSTimeout, RecordDRSRetry, RecordDRSAbandoned
+Parameters:		void
+Returns:			void
+Description:	Called by SM_DRS to add to the link quality record
+****************************************************************************/
+void RecordDRSTimeout(void) {
+	LinkStats.Timeouts++;
+}
+
+void RecordDRSRetry(void) {
+	LinkStats.Retries++;
+}
+
+void RecordDRSAbandoned(void) {
+	LinkStats.AbandonedQueries++;
+}
+
+/****************************************************************************
+Function:			GetDRSLinkStats
+Parameters:		void
+Returns:			DRSLinkStats_t, the link quality record
+Description:	Returns the DRS link quality record
+****************************************************************************/
+DRSLinkStats_t GetDRSLinkStats(void) {
+	return LinkStats;
+}
+
+/****************************************************************************
+Function:			PrintDRSLinkStats
+Parameters:		void
+Returns:			void
+Description:	Prints the DRS link quality record to console
+****************************************************************************/
+void PrintDRSLinkStats(void) {
+	printf("DRS Link: Good = %lu, Invalid = %lu, Echo = %lu, Range = %lu, Stuck = %lu, Jump = %lu\r\n", \
+		(unsigned long)LinkStats.GoodFrames, (unsigned long)LinkStats.InvalidFrames, \
+		(unsigned long)LinkStats.EchoErrors, (unsigned long)LinkStats.RangeErrors, \
+		(unsigned long)LinkStats.StuckFrames, (unsigned long)LinkStats.PoseJumps);
+	printf("DRS Link: Send Failures = %lu, Timeouts = %lu, Retries = %lu, Abandoned = %lu\r\n", \
+		(unsigned long)LinkStats.SendFailures, (unsigned long)LinkStats.Timeouts, \
+		(unsigned long)LinkStats.Retries, (unsigned long)LinkStats.AbandonedQueries);
+	printf("DRS Link: Latency Last = %lu us, Avg = %lu us, Max = %lu us\r\n", \
+		(unsigned long)LinkStats.LastLatencyUS, (unsigned long)LinkStats.AvgLatencyUS, \
+		(unsigned long)LinkStats.MaxLatencyUS);
+	printf("DRS Link: Poses Published = %lu, Suppressed = %lu (about %lu HSM dispatches saved)\r\n", \
+		(unsigned long)LinkStats.PosesPublished, (unsigned long)LinkStats.PosesSuppressed, \
+		(unsigned long)LinkStats.PosesSuppressed * HSM_DISPATCHES_PER_10_POSES / 10);
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ValidateFrame
+Parameters:		void
+Returns:			bool, true if DRS_Data is a believable answer to CurrentQuery
+Description:	Rejects frames that are blank (0xFF), have the wrong echo
+							bytes, are stuck (byte for byte the same as the last frame of
+							a different query), or carry a pose that is off the field or
+							further than the Kart could have moved. Counts each reason.
+****************************************************************************/
+static bool ValidateFrame(void) {
+	// The DRS didn't answer at all
+	bool AllInvalid = true;
+	for (int i = 0; i < 8; i++) {
+		if (DRS_Data[i] != INVALID_READ) AllInvalid = false;
+	}
+	if (AllInvalid) {
+		LinkStats.InvalidFrames++;
+		return false;
+	}
+	
+	// The first two bytes are clocked back while the query goes out
+	if (DRS_Data[0] != ECHO_BYTE0 || DRS_Data[1] != ECHO_BYTE1) {
+		LinkStats.EchoErrors++;
+		return false;
+	}
+	
+	// A different query with the exact same response means we read a stale
+	// receive FIFO. All zero payloads are allowed, the DRS reports Karts that
+	// haven't been seen yet as zeros.
+	bool ZeroPayload = true;
+	bool SameAsLast = true;
+	for (int i = 2; i < 8; i++) {
+		if (DRS_Data[i] != 0x00) ZeroPayload = false;
+		if (DRS_Data[i] != LastFrame[i]) SameAsLast = false;
+	}
+	if (SameAsLast && !ZeroPayload && LastFrameQuery != CurrentQuery) {
+		LinkStats.StuckFrames++;
+		return false;
+	}
+	
+	// Range check and sanity check the pose
+	uint8_t KartNumber = QueryKartNumber(CurrentQuery);
+	if (KartNumber != 0) {
+		uint16_t X = DRS_Data[2]<<8 | DRS_Data[3];
+		uint16_t Y = DRS_Data[4]<<8 | DRS_Data[5];
+		uint16_t Theta = DRS_Data[6]<<8 | DRS_Data[7];
+		if (!IsOnField(X, Y) || Theta >= 360) {
+			LinkStats.RangeErrors++;
+			return false;
+		}
+		if (!ValidatePose(KartNumber, X, Y)) {
+			LinkStats.PoseJumps++;
+			return false;
+		}
+	}
+	
+	for (int i = 0; i < 8; i++) LastFrame[i] = DRS_Data[i];
+	LastFrameQuery = CurrentQuery;
+	LinkStats.GoodFrames++;
+	return true;
+}
+
+/****************************************************************************
+Function:			IsOnField
+Parameters:		uint16_t X, uint16_t Y, a pose from the DRS
+Returns:			bool, false if the pose is past the far walls
+Description:	The walls at 0 are the DRS's, the far ones are taken to be as
+							far out from the far bounds as the near bounds are from 0,
+							plus FIELD_RANGE_MARGIN. Follows the geometry the field
+							calibration measured, as the zones do.
+****************************************************************************/
+static bool IsOnField(uint16_t X, uint16_t Y) {
+	const FieldGeometry_t *Field = GetFieldGeometry();
+	uint16_t FarX = (Field->Corner3X > Field->Corner4X) ? Field->Corner3X : Field->Corner4X;
+	uint16_t NearX = (Field->Corner1X > Field->Corner2X) ? Field->Corner1X : Field->Corner2X;
+	uint16_t FarY = (Field->Corner2Y > Field->Corner3Y) ? Field->Corner2Y : Field->Corner3Y;
+	uint16_t NearY = (Field->Corner1Y > Field->Corner4Y) ? Field->Corner1Y : Field->Corner4Y;
+	return (X <= FarX + NearX + FIELD_RANGE_MARGIN) && (Y <= FarY + NearY + FIELD_RANGE_MARGIN);
+}
+
+/****************************************************************************
+Function:			ValidatePose
+Parameters:		uint8_t KartNumber, 1-3
+							uint16_t X, Y, the new position
+Returns:			bool, true if the Kart could have got here since the last pose
+Description:	Rejects a pose that jumped further than MAX_KART_SPEED allows.
+							A Kart that keeps reporting the jump, e.g. after being picked up,
+							is believed after MAX_JUMP_REJECTS frames.
+****************************************************************************/
+static bool ValidatePose(uint8_t KartNumber, uint16_t X, uint16_t Y) {
+	Kart_t Kart = GetKartData(KartNumber);
+	uint16_t Now = ES_Timer_GetTime();
+	uint16_t Elapsed = Now - LastPoseTime[KartNumber - 1];
+	
+	// Only check against a recent, real pose
+	if ((Kart.KartX != 0 || Kart.KartY != 0) && Elapsed < MAX_POSE_AGE &&
+			JumpRejects[KartNumber - 1] < MAX_JUMP_REJECTS) {
+		int32_t DX = (int32_t)X - Kart.KartX;
+		int32_t DY = (int32_t)Y - Kart.KartY;
+		int32_t MaxMove = MAX_KART_SPEED * (Elapsed + 1) * MS_PER_TICK / 1000 + POSE_JUMP_MARGIN;
+		if (DX*DX + DY*DY > MaxMove*MaxMove) {
+			JumpRejects[KartNumber - 1]++;
+			return false;
+		}
+	}
+	JumpRejects[KartNumber - 1] = 0;
+	LastPoseTime[KartNumber - 1] = Now;
+	return true;
+}
+
+/****************************************************************************
+Function:			ShouldPublishPose
+Parameters:		Kart_t *Kart, our Kart with its new pose
+Returns:			bool, true if E_DRS_UPDATED should be posted
+Description:	Applies the publish thresholds and intervals to our new pose
+****************************************************************************/
+static bool ShouldPublishPose(Kart_t *Kart) {
+	uint16_t Now = ES_Timer_GetTime();
+	uint16_t Elapsed = Now - PublishedTime;
+	bool Publish;
+	
+	if (!PosePublished || Elapsed >= PUBLISH_MAX_INTERVAL) {
+		// First pose, or the heartbeat is due
+		Publish = true;
+#if PUBLISH_MIN_INTERVAL > 0
+	} else if (Elapsed < PUBLISH_MIN_INTERVAL) {
+		Publish = false;
+#endif
+	} else {
+		int32_t DX = (int32_t)Kart->KartX - PublishedX;
+		int32_t DY = (int32_t)Kart->KartY - PublishedY;
+		int16_t DTheta = abs(Kart->KartTheta - PublishedTheta);
+		if (DTheta > 180) DTheta = 360 - DTheta;
+		Publish = (DX*DX + DY*DY >= PUBLISH_MIN_DISTANCE*PUBLISH_MIN_DISTANCE) ||
+							(DTheta >= PUBLISH_MIN_ANGLE);
+	}
+	
+	if (Publish) {
+		PosePublished = true;
+		PublishedX = Kart->KartX;
+		PublishedY = Kart->KartY;
+		PublishedTheta = Kart->KartTheta;
+		PublishedTime = Now;
+		LinkStats.PosesPublished++;
+	} else {
+		LinkStats.PosesSuppressed++;
+	}
+	return Publish;
+}
+
+/****************************************************************************
+Function:			QueryKartNumber
+Parameters:		uint8_t Query, a DRS query byte
+Returns:			uint8_t, the Kart (1-3) the query asks about, 0 for game status
+Description:	Maps a query byte to its Kart
+****************************************************************************/
+static uint8_t QueryKartNumber(uint8_t Query) {
+	switch (Query) {
+		case KART1_QUERY: return 1;
+		case KART2_QUERY: return 2;
+		case KART3_QUERY: return 3;
+		default: return 0;
+	}
+}
+
 
 /*------------------------------ Test Harness -----------------------------*/
 #ifdef TEST 
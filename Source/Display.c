@@ -85,6 +85,10 @@ ES_Event RunDisplay(ES_Event ThisEvent) {
 			case E_NEW_DRS_QUERY: printf("(EVENT) E_NEW_DRS_QUERY\r\n"); break;
 			case E_DRS_EOT: printf("(EVENT) E_DRS_EOT\r\n"); break;
 			
+			// Collision Prediction Events
+			case E_COLLISION_WARNING: printf("(EVENT) E_COLLISION_WARNING, TTC = %d ms\r\n", ThisEvent.EventParam); break;
+			case E_COLLISION_CLEARED: printf("(EVENT) E_COLLISION_CLEARED\r\n"); break;
+			
 			// Other Events
 			case E_BUMP_DETECTED: printf("(EVENT) E_BUMP_DETECTED\r\n"); break;
 			//case E_IR_BEACON_DETECTED: printf("(EVENT) E_IR_BEACON_DETECTED\r\n"); break;
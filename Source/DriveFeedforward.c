@@ -0,0 +1,168 @@
+/****************************************************************************
+Module: DriveFeedforward.c
+Description:
+	Feedforward for the drive motor PIDs. Every move used to start the PID
+	from 0 output, so the integrator had to wind up to the duty that holds
+	the new speed before the wheel got there, and that was most of the
+	settling time on every straight.
+	The sweep steps a wheel's duty up FF_DUTY_STEP at a time, lets the
+	speed settle and averages it, which maps duty to steady-state RPM.
+	GetFeedforwardDuty reads the map backwards, interpolating between the
+	points, to give the duty that should hold a target RPM. The PID adds
+	it to its output and only has to correct for what the map gets wrong.
+	Below the stiction duty the map reads 0 RPM, so slow targets get at
+	least the duty of the last point that didn't turn the wheel.
+	The feedforward alone gets the wheel to the target about as fast as
+	the motor and the edge timing let it, so a PID chasing the target
+	itself sees an error all the way there, winds up, and overshoots
+	(25-35% on the model). The PID follows a reference model instead, a
+	first order lag on the target with the time constant the sweep
+	measured, which is where the wheel should be if the map is right.
+	The time constant comes from the area between each point's speed
+	and where it settled, area = tau * rise for a first order response.
+	Runs from the control ISR, integer math only.
+Author: Kyle Moy, 3/12/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+
+// Module Libraries
+#include "DriveFeedforward.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// Time at each point of the sweep, the motors settle in about 5 time
+// constants (60-80ms), then the speed is averaged
+#define SWEEP_SETTLE_MS			500
+#define SWEEP_MEASURE_MS		250
+#define MAX_DUTY						100
+#define Q16_ONE							(1L << 16)
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			GetFeedforwardDuty
+Parameters:		const FeedforwardMap_t *Map, the wheel's map for its direction
+							int32_t TargetRPM, the speed wanted
+Returns:			int32_t, the duty % that should hold TargetRPM, 0 with no map
+Description:	Linear interpolation between the two points either side
+****************************************************************************/
+int32_t GetFeedforwardDuty(const FeedforwardMap_t *Map, int32_t TargetRPM) {
+	if (TargetRPM <= 0) return 0;
+	int32_t LowRPM = 0;
+	for (uint8_t n = 0; n < FF_POINTS; n++) {
+		int32_t HighRPM = Map->RPM[n];
+		if (HighRPM >= TargetRPM && HighRPM > LowRPM) {
+			return n * FF_DUTY_STEP + (TargetRPM - LowRPM) * FF_DUTY_STEP / (HighRPM - LowRPM);
+		}
+		LowRPM = HighRPM;
+	}
+	// Faster than the wheel went in the sweep, or there's no map
+	return (LowRPM == 0) ? 0 : MAX_DUTY;
+}
+
+/****************************************************************************
+Function:			ResetReferenceModel
+Parameters:		int32_t *Model, the wheel's model, RPM in Q16.16
+							int32_t RPM, the speed the wheel is at now
+Returns:			void
+Description:	Restarts the model from RPM
+****************************************************************************/
+void ResetReferenceModel(int32_t *Model, int32_t RPM) {
+	*Model = RPM * Q16_ONE;
+}
+
+/****************************************************************************
+Function:			UpdateReferenceModel
+Parameters:		const FeedforwardMap_t *Map, the wheel's map for its direction
+							int32_t *Model, the wheel's model, RPM in Q16.16
+							int32_t TargetRPM, the profile's target
+Returns:			int32_t, the RPM for the PID to follow, TargetRPM with no map
+Description:	One 1ms step of the first order lag toward TargetRPM
+****************************************************************************/
+int32_t UpdateReferenceModel(const FeedforwardMap_t *Map, int32_t *Model, int32_t TargetRPM) {
+	if (Map->TimeConstantMS == 0) {
+		ResetReferenceModel(Model, TargetRPM);
+		return TargetRPM;
+	}
+	*Model += (TargetRPM * Q16_ONE - *Model) / Map->TimeConstantMS;
+	return *Model >> 16;
+}
+
+/****************************************************************************
+Function:			StartFeedforwardSweep
+Parameters:		FeedforwardSweep_t *Sweep, the wheel's sweep
+							FeedforwardMap_t *Map, where the results go
+Returns:			void
+Description:	Starts the sweep from the first point, set the direction first
+****************************************************************************/
+void StartFeedforwardSweep(FeedforwardSweep_t *Sweep, FeedforwardMap_t *Map) {
+	Sweep->Running = false;
+	Sweep->Map = Map;
+	Sweep->Point = 0;
+	Sweep->Time = 0;
+	Sweep->SumRPM = 0;
+	Sweep->Samples = 0;
+	Sweep->SumSettleRPM = 0;
+	Sweep->SumArea = 0;
+	Sweep->SumRise = 0;
+	Sweep->Running = true;
+}
+
+/****************************************************************************
+Function:			UpdateFeedforwardSweep
+Parameters:		FeedforwardSweep_t *Sweep, the wheel's sweep
+							int32_t RPM, the measured speed
+Returns:			uint8_t, the duty cycle to apply (0-100)
+Description:	Runs one 1ms sample of the sweep
+****************************************************************************/
+uint8_t UpdateFeedforwardSweep(FeedforwardSweep_t *Sweep, int32_t RPM) {
+	if (!Sweep->Running) return 0;
+
+	if (++Sweep->Time > SWEEP_SETTLE_MS) {
+		Sweep->SumRPM += RPM;
+		Sweep->Samples++;
+	} else {
+		Sweep->SumSettleRPM += RPM;
+	}
+	if (Sweep->Time >= SWEEP_SETTLE_MS + SWEEP_MEASURE_MS) {
+		uint16_t Average = Sweep->SumRPM / Sweep->Samples;
+		uint16_t Previous = (Sweep->Point > 0) ? Sweep->Map->RPM[Sweep->Point - 1] : 0;
+		// The area between the speed and where it settled, from the start of
+		// the point, weighted by the size of the step
+		if (Average > Previous && Sweep->SumSettleRPM < (uint32_t)Average * SWEEP_SETTLE_MS) {
+			Sweep->SumArea += (uint32_t)Average * SWEEP_SETTLE_MS - Sweep->SumSettleRPM;
+			Sweep->SumRise += Average - Previous;
+		}
+		// Keep the map rising so it can be read backwards, a point can only
+		// come out low from noise
+		if (Average < Previous) Average = Previous;
+		Sweep->Map->RPM[Sweep->Point] = Average;
+		Sweep->Time = 0;
+		Sweep->SumRPM = 0;
+		Sweep->Samples = 0;
+		Sweep->SumSettleRPM = 0;
+		if (++Sweep->Point >= FF_POINTS) {
+			Sweep->Map->TimeConstantMS = (Sweep->SumRise == 0) ? 0 : Sweep->SumArea / Sweep->SumRise;
+			Sweep->Running = false;
+			return 0;
+		}
+	}
+	return (Sweep->Point + 1) * FF_DUTY_STEP;
+}
+
+/****************************************************************************
+Function:			IsFeedforwardSweepRunning
+Parameters:		const FeedforwardSweep_t *Sweep
+Returns:			bool, true until every point has been measured
+Description:	Lets the ISR tell when to hand the wheel back
+****************************************************************************/
+bool IsFeedforwardSweepRunning(const FeedforwardSweep_t *Sweep) {
+	return Sweep->Running;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
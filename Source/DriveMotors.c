@@ -12,6 +12,7 @@ Author: Kyle Moy, 2/21/15
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 // Framework Libraries
 #include "ES_Configure.h"
@@ -35,6 +36,8 @@ Author: Kyle Moy, 2/21/15
 #include "DriveMotorsService.h"
 #include "DriveMotorPID.h"
 #include "DriveMotorEncoder.h"
+#include "DriveMotorsPosition.h"
+#include "HW_Port.h"
 #include "Display.h"
 #include "SM_Master.h"
 
@@ -49,12 +52,39 @@ Author: Kyle Moy, 2/21/15
 // Set 10KHz frequency, so 100microS period
 #define PeriodInMicroSeconds 100
 
+// Direction pins, Right on PB5 and Left on PB1, high is FORWARD
+#define RIGHT_DIRECTION_PIN BIT5HI
+#define LEFT_DIRECTION_PIN BIT1HI
+
+// Generator A actions, running and at 0% duty. The output is set low on
+// the zero count with no compare actions for 0%, since the CmpADn action
+// (set to one) wins over a compare value of 0
+#define RIGHT_GENA_RUNNING (PWM_0_GENA_ACTCMPAU_ZERO | PWM_0_GENA_ACTCMPAD_ONE)
+#define LEFT_GENA_RUNNING (PWM_1_GENA_ACTCMPAU_ZERO | PWM_1_GENA_ACTCMPAD_ONE)
+#define RIGHT_GENA_OFF PWM_0_GENA_ACTZERO_ZERO
+#define LEFT_GENA_OFF PWM_1_GENA_ACTZERO_ZERO
+
+// A motor being turned around is held off for this many control
+// interrupts before its direction pin changes
+#define REVERSAL_DEAD_TIME 2
+
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint32_t DutyCycleToCompare(uint8_t DutyCycle);
+
 
 /*---------------------------- Module Variables ---------------------------*/
-static uint8_t RightMotorDutyCycle = 0;  // PWM0
-static uint8_t LeftMotorDutyCycle = 0;	 // PWM1
-static bool RightMotorDirection = FORWARD;
-static bool LeftMotorDirection = FORWARD;
+// Both motors' duty cycles and directions, by RIGHT_MOTOR and LEFT_MOTOR.
+// The Set functions stage a command, ApplyMotorCommand puts it out.
+typedef struct {
+	uint8_t DutyCycle[2];
+	uint8_t Direction[2];
+} MotorCommand_t;
+
+static volatile MotorCommand_t StagedCommand = {{0, 0}, {FORWARD, FORWARD}};
+static MotorCommand_t AppliedCommand = {{0, 0}, {FORWARD, FORWARD}};
+// Control interrupts each motor has been held off for a reversal
+static uint8_t ReversalTime[2] = {0, 0};
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -66,6 +96,7 @@ Description: 	Initializes the PWM pins for the DC drive motors on Port B
 							Left Motor Direction is on PB1, Right Motor Direction is on PB5
 ****************************************************************************/
 void InitializeDriveMotors(void) {
+#ifndef HOST_SIM
   // Initialize the PWM
   volatile uint32_t Dummy; // use volatile to avoid over-optimization
   // Start by enabling the clock to the PWM Module (PWM0)
@@ -82,10 +113,8 @@ void InitializeDriveMotors(void) {
   HWREG( PWM0_BASE+PWM_O_0_CTL ) = 0;
   HWREG( PWM0_BASE+PWM_O_1_CTL ) = 0;
   // Program generator A to go to 0 at rising compare A, 1 on falling compare A  
-  HWREG( PWM0_BASE+PWM_O_0_GENA) = 
-    (PWM_0_GENA_ACTCMPAU_ZERO | PWM_0_GENA_ACTCMPAD_ONE );
-  HWREG( PWM0_BASE+PWM_O_1_GENA) = 
-    (PWM_1_GENA_ACTCMPAU_ZERO | PWM_1_GENA_ACTCMPAD_ONE );
+  HWREG( PWM0_BASE+PWM_O_0_GENA) = RIGHT_GENA_RUNNING;
+  HWREG( PWM0_BASE+PWM_O_1_GENA) = LEFT_GENA_RUNNING;
   // Set the PWM period. Since we are counting both up & down, we initialize
   // the load register to 1/2 the desired total period
   HWREG( PWM0_BASE+PWM_O_0_LOAD) = (PeriodInMicroSeconds * PWMTicksPerMicroSecond)>>1;
@@ -94,12 +123,10 @@ void InitializeDriveMotors(void) {
   // to 1/2 the period to count up (or down) 
   HWREG( PWM0_BASE+PWM_O_0_CMPA) = ((PeriodInMicroSeconds * PWMTicksPerMicroSecond)-1)>>2;
   HWREG( PWM0_BASE+PWM_O_1_CMPA) = ((PeriodInMicroSeconds * PWMTicksPerMicroSecond)-1)>>2;
-  // Set changes to the PWM output Enables to be locally syncronized to a 
-  // zero count
-  HWREG(PWM0_BASE+PWM_O_ENUPD) =  (HWREG(PWM0_BASE+PWM_O_ENUPD) & 
-      ~(PWM_ENUPD_ENUPD0_M | PWM_ENUPD_ENUPD1_M)) |
-      (PWM_ENUPD_ENUPD0_LSYNC | PWM_ENUPD_ENUPD1_LSYNC);
-  // Enable the PWM outputs
+  // Enable the PWM outputs, for good. The ball launcher's outputs share
+  // this register and it read-modify-writes them from its service, so the
+  // control interrupt stops a motor with generator A's actions instead.
+  // The left motor is PWM2.
   HWREG( PWM0_BASE+PWM_O_ENABLE) |= (PWM_ENABLE_PWM2EN | PWM_ENABLE_PWM0EN);
   // Now configure the Port B pins to be PWM outputs
   // Start by selecting the alternate function for DC_MOTOR1 (PB4) [LEFT] and DC_MOTOR2 (PB6) [RIGHT]
@@ -114,17 +141,21 @@ void InitializeDriveMotors(void) {
   HWREG(GPIO_PORTB_BASE+GPIO_O_DEN) |= (BIT1HI | BIT4HI | BIT5HI | BIT6HI);
 	// Make pins on Port B into outputs
   HWREG(GPIO_PORTB_BASE+GPIO_O_DIR) |= (BIT1HI | BIT4HI | BIT5HI | BIT6HI);
-	// Set the up/down count mode and enable the PWM generator
-  HWREG(PWM0_BASE+ PWM_O_0_CTL) |= (PWM_0_CTL_MODE | PWM_0_CTL_ENABLE);
-  HWREG(PWM0_BASE+ PWM_O_1_CTL) |= (PWM_1_CTL_MODE | PWM_1_CTL_ENABLE);
+	// Set the up/down count mode, have compare A and the generator A
+	// actions wait for a global sync, and enable the PWM generator
+  HWREG(PWM0_BASE+ PWM_O_0_CTL) |= (PWM_0_CTL_MODE | PWM_0_CTL_CMPAUPD | PWM_0_CTL_GENAUPD_GS | PWM_0_CTL_ENABLE);
+  HWREG(PWM0_BASE+ PWM_O_1_CTL) |= (PWM_1_CTL_MODE | PWM_1_CTL_CMPAUPD | PWM_1_CTL_GENAUPD_GS | PWM_1_CTL_ENABLE);
+	// Restart both counters together so their zero counts line up
+	HWREG(PWM0_BASE+PWM_O_SYNC) = (PWM_SYNC_SYNC0 | PWM_SYNC_SYNC1);
  
-	// Initialize the motor PWMs to default to 0
-	SetMotorPWM(LEFT_MOTOR, 0);
-	SetMotorPWM(RIGHT_MOTOR, 0);
-	
-	// Initialize the motor directions to default to FORWARD
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
+	// Initialize the motors to stopped and FORWARD, the control interrupt
+	// isn't running yet so put it out here
+	HWREG(GPIO_PORTB_BASE + GPIO_O_DATA + ((RIGHT_DIRECTION_PIN | LEFT_DIRECTION_PIN) << 2)) = \
+		(RIGHT_DIRECTION_PIN | LEFT_DIRECTION_PIN);
+#endif
+	SetMotorPWMs(0, 0);
+	SetMotorDirections(FORWARD, FORWARD);
+	ApplyMotorCommand();
 	
 	InitInputCapturePeriod();
 	InitPeriodicInt();
@@ -137,78 +168,120 @@ Function: 		SetMotorPWM
 Parameters: 	uint8_t Motor (#defines are LEFT_MOTOR or RIGHT_MOTOR)
 							uint8_t DutyCycle
 Returns: 			void
-Description: 	Sets the PWM duty cycle for a DC drive motor
+Description: 	Stages the PWM duty cycle for a DC drive motor, it goes out on
+							the next control interrupt
 ****************************************************************************/
 void SetMotorPWM(uint8_t Motor, uint8_t DutyCycle) {
-  switch (Motor) {
-    case RIGHT_MOTOR:
-      RightMotorDutyCycle = DutyCycle;
-      if (RightMotorDutyCycle == 0) {
-				// Set the Duty cycle on A to 0% by programming the compare value
-				// to 0. However, since the CmpADn action (set to one) wins, we also
-				// need to disable the output  
-        HWREG(PWM0_BASE+PWM_O_0_CMPA) = 0;
-        HWREG(PWM0_BASE+PWM_O_ENABLE) &= ~PWM_ENABLE_PWM0EN;
-      } else if (RightMotorDutyCycle == 100) {
-        // Set the Duty cycle on A to 100% by programming the compare value
-        // to the load value. Since the CmpBDn action (set to one) wins, we get 100%
-        HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM0EN;
-        HWREG(PWM0_BASE+PWM_O_0_CMPA) = HWREG(PWM0_BASE+PWM_O_0_LOAD);
-      } else {
-        HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM0EN;
-        uint32_t DutyCycleTicks = (PeriodInMicroSeconds * PWMTicksPerMicroSecond) / 2 * RightMotorDutyCycle / 100;
-        HWREG(PWM0_BASE+PWM_O_0_CMPA) = DutyCycleTicks;
-      }
-      break;
-    case LEFT_MOTOR:
-      LeftMotorDutyCycle = DutyCycle;
-      if (LeftMotorDutyCycle == 0) {
-				// Set the Duty cycle on A to 0% by programming the compare value
-				// to 0. However, since the CmpADn action (set to one) wins, we also
-				// need to disable the output  
-        HWREG(PWM0_BASE+PWM_O_1_CMPA) = 0;
-        HWREG(PWM0_BASE+PWM_O_ENABLE) &= ~PWM_ENABLE_PWM2EN;
-      } else if (LeftMotorDutyCycle == 100) {
-        // Set the Duty cycle on A to 100% by programming the compare value
-        // to the load value. Since the CmpBDn action (set to one) wins, we get 100%
-        HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM2EN;
-        HWREG(PWM0_BASE+PWM_O_1_CMPA) = HWREG(PWM0_BASE+PWM_O_1_LOAD);
-      } else {
-        HWREG(PWM0_BASE+PWM_O_ENABLE) |= PWM_ENABLE_PWM2EN;
-        uint32_t DutyCycleTicks = (PeriodInMicroSeconds * PWMTicksPerMicroSecond) / 2 * LeftMotorDutyCycle / 100;
-        HWREG(PWM0_BASE+PWM_O_1_CMPA) = DutyCycleTicks;
-      }
-      break;
-  }
+	if (DutyCycle > 100) DutyCycle = 100;
+	StagedCommand.DutyCycle[Motor] = DutyCycle;
 }
 
+/****************************************************************************
+Function: 		SetMotorPWMs
+Parameters: 	uint8_t DutyCycleL, DutyCycleR
+Returns: 			void
+Description: 	Stages both duty cycles, they go out together
+****************************************************************************/
+void SetMotorPWMs(uint8_t DutyCycleL, uint8_t DutyCycleR) {
+	EnterCritical();
+	SetMotorPWM(LEFT_MOTOR, DutyCycleL);
+	SetMotorPWM(RIGHT_MOTOR, DutyCycleR);
+	ExitCritical();
+}
 
 /****************************************************************************
 Function: 		SetMotorDirection
 Parameters: 	uint8_t Motor (#defines are LEFT_MOTOR or RIGHT_MOTOR)
 							uint8_t Direction (#defines are FORWARD or BACKWARD)
 Returns: 			void
-Description: 	Sets the direction for a DC drive motor
+Description: 	Stages the direction for a DC drive motor, it goes out on the
+							next control interrupt, after the dead time if it turns around
 ****************************************************************************/
 void SetMotorDirection(uint8_t Motor, uint8_t Direction) {
-  switch (Motor) {
-    case RIGHT_MOTOR:
-			RightMotorDirection = Direction;
-			if (RightMotorDirection == FORWARD) {
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) |= BIT5HI;
-			} else {
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) &= BIT5LO;
-			}
-      break;
-    case LEFT_MOTOR:
-			LeftMotorDirection = Direction;
-      if (LeftMotorDirection == FORWARD) {
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) |= BIT1HI;
-			} else {
-				HWREG(GPIO_PORTB_BASE+(GPIO_O_DATA + ALL_BITS)) &= BIT1LO;
-      }
-			break;
-  }
+	StagedCommand.Direction[Motor] = Direction;
+}
+
+/****************************************************************************
+Function: 		SetMotorDirections
+Parameters: 	uint8_t DirectionL, DirectionR
+Returns: 			void
+Description: 	Stages both directions, they go out together
+****************************************************************************/
+void SetMotorDirections(uint8_t DirectionL, uint8_t DirectionR) {
+	EnterCritical();
+	SetMotorDirection(LEFT_MOTOR, DirectionL);
+	SetMotorDirection(RIGHT_MOTOR, DirectionR);
+	ExitCritical();
+}
+
+/****************************************************************************
+Function: 		ApplyMotorCommand
+Parameters: 	void
+Returns: 			void
+Description: 	Puts the staged command out, called from the control interrupt
+							after everything in it has had its say.
+							Both compare values and output enables are written, then one
+							global sync has both generators load them on the same zero
+							count, so the wheels never run a PWM period on a mix of old
+							and new duties.
+							A motor that has to turn around is put out at 0 duty for
+							REVERSAL_DEAD_TIME interrupts first, so the direction pin only
+							ever changes with the output off, and the new duty only goes
+							out once it has. A duty staged before its direction can't go
+							out the wrong way.
+****************************************************************************/
+void ApplyMotorCommand(void) {
+	MotorCommand_t Command = StagedCommand;
+	for (uint8_t Motor = RIGHT_MOTOR; Motor <= LEFT_MOTOR; Motor++) {
+		if (Command.Direction[Motor] == AppliedCommand.Direction[Motor]) {
+			ReversalTime[Motor] = 0;
+		} else if (ReversalTime[Motor] < REVERSAL_DEAD_TIME) {
+			ReversalTime[Motor]++;
+			Command.Direction[Motor] = AppliedCommand.Direction[Motor];
+			Command.DutyCycle[Motor] = 0;
+		} else {
+			ReversalTime[Motor] = 0;
+		}
+	}
+
+#ifdef HOST_SIM
+	// The motor simulator stands in for the H-bridges and the motors, the
+	// PWM registers below go to the race simulator's
+	MotorSim_SetDrive(RIGHT_MOTOR, Command.DutyCycle[RIGHT_MOTOR], Command.Direction[RIGHT_MOTOR]);
+	MotorSim_SetDrive(LEFT_MOTOR, Command.DutyCycle[LEFT_MOTOR], Command.Direction[LEFT_MOTOR]);
+#else
+	// Both direction pins in one write through the GPIO data mask, the
+	// output of any reversing motor has been off for the dead time
+	if (Command.Direction[RIGHT_MOTOR] != AppliedCommand.Direction[RIGHT_MOTOR] || \
+		Command.Direction[LEFT_MOTOR] != AppliedCommand.Direction[LEFT_MOTOR]) {
+		HWREG(GPIO_PORTB_BASE + GPIO_O_DATA + ((RIGHT_DIRECTION_PIN | LEFT_DIRECTION_PIN) << 2)) = \
+			((Command.Direction[RIGHT_MOTOR] == FORWARD) ? RIGHT_DIRECTION_PIN : 0) | \
+			((Command.Direction[LEFT_MOTOR] == FORWARD) ? LEFT_DIRECTION_PIN : 0);
+	}
+#endif
+
+	// A 0% duty cycle holds the output low through generator A's actions,
+	// these registers are the drive's own, nothing else writes them. The
+	// actions and compares all go out on the same zero count
+	PWM0_WRITE(PWM_O_0_GENA, (Command.DutyCycle[RIGHT_MOTOR] != 0) ? RIGHT_GENA_RUNNING : RIGHT_GENA_OFF);
+	PWM0_WRITE(PWM_O_1_GENA, (Command.DutyCycle[LEFT_MOTOR] != 0) ? LEFT_GENA_RUNNING : LEFT_GENA_OFF);
+	PWM0_WRITE(PWM_O_0_CMPA, DutyCycleToCompare(Command.DutyCycle[RIGHT_MOTOR]));
+	PWM0_WRITE(PWM_O_1_CMPA, DutyCycleToCompare(Command.DutyCycle[LEFT_MOTOR]));
+	// A plain write, a 0 leaves the other generators' sync bits alone
+	PWM0_WRITE(PWM_O_CTL, PWM_CTL_GLOBALSYNC0 | PWM_CTL_GLOBALSYNC1);
+
+	AppliedCommand = Command;
+}
+
+/****************************************************************************
+Function: 		GetMotorDirection
+Parameters: 	uint8_t Motor (#defines are LEFT_MOTOR or RIGHT_MOTOR)
+Returns: 			uint8_t, the direction the motor is being driven (FORWARD or BACKWARD)
+Description: 	Lets the encoder count ticks up or down for odometry, so it's
+							the direction that has gone out, not one still staged
+****************************************************************************/
+uint8_t GetMotorDirection(uint8_t Motor) {
+	return AppliedCommand.Direction[Motor];
 }
 
 /****************************************************************************
@@ -220,9 +293,8 @@ Description: 	Rotates the bot clockwise
 void RotateCW(uint16_t TargetRPM, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Rotating CW, TargetRPM = %d\r\n", TargetRPM);
 	EnablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, BACKWARD);
-	SetTargetRPM(TargetRPM, TargetRPM);
+	SetMotorDirections(FORWARD, BACKWARD);
+	SetManeuverRPM(MANEUVER_TURN, TargetRPM, TargetRPM);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
 	}
@@ -237,14 +309,31 @@ Description: 	Rotates the bot counter-clockwise
 void RotateCCW(uint16_t TargetRPM, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Rotating CCW, TargetRPM = %d\r\n", TargetRPM);
 	EnablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, BACKWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
-	SetTargetRPM(TargetRPM, TargetRPM);
+	SetMotorDirections(BACKWARD, FORWARD);
+	SetManeuverRPM(MANEUVER_TURN, TargetRPM, TargetRPM);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
 	}
 }
 
+/****************************************************************************
+Function: 		RotateAtRPM
+Parameters: 	int16_t TargetRPM, + for CW, the way the DRS's Theta grows,
+							- for CCW
+Returns: 			void
+Description: 	Rotates the bot on the spot, for closed loop turns that update
+							it every few ms, so no timer and no printing. 0 RPM keeps
+							the directions, the encoders count by them and the bot is
+							still coasting round the way it was going.
+****************************************************************************/
+void RotateAtRPM(int16_t TargetRPM) {
+	EnablePIDcontrol();
+	if (TargetRPM != 0) {
+		SetMotorDirections((TargetRPM < 0) ? BACKWARD : FORWARD, (TargetRPM < 0) ? FORWARD : BACKWARD);
+	}
+	SetManeuverRPM(MANEUVER_TURN, abs(TargetRPM), abs(TargetRPM));
+}
+
 
 /****************************************************************************
 Function: 		StopMotors
@@ -255,8 +344,7 @@ Description: 	Stops the bot
 void StopMotors(void) {
 	if (DisplayMotorInfo) printf("Drive Motors: Stopping\r\n");
 	DisablePIDcontrol();
-	SetMotorPWM(LEFT_MOTOR, 0);
-	SetMotorPWM(RIGHT_MOTOR, 0);
+	SetMotorPWMs(0, 0);
 	SetTargetRPM(0, 0);
 }
 
@@ -269,8 +357,7 @@ Description: 	Drive the bot forward
 void DriveForward(uint16_t TargetRPM, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Forward, TargetRPM = %d\r\n", TargetRPM);
 	EnablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
+	SetMotorDirections(FORWARD, FORWARD);
 	SetTargetRPM(TargetRPM, TargetRPM);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
@@ -286,12 +373,11 @@ Description: 	Pivot the bot clockwise
 ****************************************************************************/
 void PivotCWwithSetTicks(uint16_t TargetRPM, uint32_t Ticks) {
 	EnablePIDcontrol();
-	SetPIDgains(0.05, 0.02, 0);
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, BACKWARD);
-	SetTargetRPM(0, TargetRPM);
+	SetMotorDirections(FORWARD, BACKWARD);
+	SetManeuverRPM(MANEUVER_TURN, 0, TargetRPM);
 	if (DisplayMotorInfo) printf("Drive Motors: Pivoting CW, TargetRPM = %d, TargetTicks = %d\r\n", TargetRPM, Ticks);
-	SetTargetTickCount(0, Ticks);
+	// Only the left wheel turns, so it counts the ticks
+	StartPositionMove(Ticks, 0, TargetRPM, 0);
 }
 
 /****************************************************************************
@@ -302,12 +388,11 @@ Description: 	Pivot the bot counter-clockwise
 ****************************************************************************/
 void PivotCCWwithSetTicks(uint16_t TargetRPM, uint32_t Ticks) {
 	EnablePIDcontrol();
-	SetPIDgains(0.05, 0.02, 0);
-	SetMotorDirection(LEFT_MOTOR, BACKWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
-	SetTargetRPM(0, TargetRPM);
+	SetMotorDirections(BACKWARD, FORWARD);
+	SetManeuverRPM(MANEUVER_TURN, 0, TargetRPM);
 	if (DisplayMotorInfo) printf("Drive Motors: Pivoting CCW, TargetRPM = %d, TargetTicks = %d\r\n", TargetRPM, Ticks);
-	SetTargetTickCount(Ticks, 0);
+	// Only the left wheel turns, so it counts the ticks
+	StartPositionMove(Ticks, 0, TargetRPM, 0);
 }
 
 
@@ -319,11 +404,10 @@ Description: 	Drive the bot forward
 ****************************************************************************/
 void DriveForwardWithSetDistance(uint16_t TargetRPM, uint32_t DistanceInMM) {
 	EnablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
-	SetTargetRPM(TargetRPM, TargetRPM);
+	SetMotorDirections(FORWARD, FORWARD);
+	SetManeuverRPM(MANEUVER_DISTANCE, TargetRPM, TargetRPM);
 	uint32_t NumberOfTicks = DistanceInMM / (3.141592 * 94 / 28); // 94mm diameter, 28 pulse/rev
-	SetTargetTickCount(NumberOfTicks, NumberOfTicks);
+	StartPositionMove(NumberOfTicks, NumberOfTicks, TargetRPM, TargetRPM);
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Forward with Set Distance = %d, TargetTicks = %d, TargetRPM = %d\r\n", DistanceInMM, NumberOfTicks, TargetRPM);
 	
 }
@@ -338,10 +422,9 @@ Description: 	Drive the bot forward
 void DriveForwardWithBiasAndSetDistance(uint16_t TargetRPML, uint16_t TargetRPMR, uint32_t DistanceInMM) {
 	EnablePIDcontrol();
 	uint32_t NumberOfTicks = DistanceInMM / (3.141592 * 94 / 28); // 94mm diameter, 28 pulse/rev
-	SetTargetTickCount(NumberOfTicks, NumberOfTicks);
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
-	SetTargetRPM(TargetRPMR, TargetRPML);
+	SetMotorDirections(FORWARD, FORWARD);
+	SetManeuverRPM(MANEUVER_DISTANCE, TargetRPMR, TargetRPML);
+	StartPositionMove(NumberOfTicks, NumberOfTicks, TargetRPML, TargetRPMR);
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Forward with Set Distance = %d, TargetTicks = %d, TargetRPMR = %d, TargetRPML = %d\r\n", DistanceInMM, NumberOfTicks, TargetRPMR, TargetRPML);
 }
 
@@ -354,8 +437,7 @@ Description: 	Drive the bot forward
 void DriveForwardWithBias(uint16_t TargetRPML, uint16_t TargetRPMR, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Forward with Bias, TargetRPML = %d, TargetRPMR = %d\r\n", TargetRPML, TargetRPMR);
 	EnablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
+	SetMotorDirections(FORWARD, FORWARD);
 	SetTargetRPM(TargetRPMR, TargetRPML);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
@@ -371,8 +453,7 @@ Description: 	Drive the bot backwards
 void DriveBackwardsWithBias(uint16_t TargetRPML, uint16_t TargetRPMR, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Backwards with Bias, TargetRPML = %d, TargetRPMR = %d\r\n", TargetRPML, TargetRPMR);
 	EnablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, BACKWARD);
-	SetMotorDirection(RIGHT_MOTOR, BACKWARD);
+	SetMotorDirections(BACKWARD, BACKWARD);
 	SetTargetRPM(TargetRPMR, TargetRPML);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
@@ -389,8 +470,7 @@ Description: 	Drive the bot backward
 void DriveBackward(uint16_t TargetRPM, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Backward, TargetRPM = %d\r\n", TargetRPM);
 	EnablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, BACKWARD);
-	SetMotorDirection(RIGHT_MOTOR, BACKWARD);
+	SetMotorDirections(BACKWARD, BACKWARD);
 	SetTargetRPM(TargetRPM, TargetRPM);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
@@ -406,10 +486,8 @@ Description: 	Rotates the bot clockwise
 void RotateCWwithDuty(uint16_t DutyCycle, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Rotating CW, Duty Cycle = %d\r\n", DutyCycle);
 	DisablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, BACKWARD);
-	SetMotorPWM(LEFT_MOTOR, DutyCycle);
-	SetMotorPWM(RIGHT_MOTOR, DutyCycle);
+	SetMotorDirections(FORWARD, BACKWARD);
+	SetMotorPWMs(DutyCycle, DutyCycle);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
 	}
@@ -424,10 +502,8 @@ Description: 	Rotates the bot counter-clockwise
 void RotateCCWwithDuty(uint16_t DutyCycle, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Rotating CCW, Duty Cycle = %d\r\n", DutyCycle);
 	DisablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, BACKWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
-	SetMotorPWM(LEFT_MOTOR, DutyCycle);
-	SetMotorPWM(RIGHT_MOTOR, DutyCycle);
+	SetMotorDirections(BACKWARD, FORWARD);
+	SetMotorPWMs(DutyCycle, DutyCycle);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
 	}
@@ -442,10 +518,8 @@ Description: 	Drive the bot forward
 void DriveForwardWithDuty(uint16_t Duty, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Forward, Duty Cycle = %d\r\n", Duty);
 	DisablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
-	SetMotorPWM(LEFT_MOTOR, Duty);
-	SetMotorPWM(RIGHT_MOTOR, Duty);
+	SetMotorDirections(FORWARD, FORWARD);
+	SetMotorPWMs(Duty, Duty);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
 	}
@@ -461,10 +535,8 @@ Description: 	Drive the bot forward
 void DriveForwardWithBiasWithDuty(uint16_t DutyL, uint16_t DutyR, uint16_t Duration) {
 	if (DisplayMotorInfo) printf("Drive Motors: Driving Forward with Bias, DutyL = %d, DutyR = %d\r\n", DutyL, DutyR);
 	DisablePIDcontrol();
-	SetMotorDirection(LEFT_MOTOR, FORWARD);
-	SetMotorDirection(RIGHT_MOTOR, FORWARD);
-	SetMotorPWM(LEFT_MOTOR, DutyL);
-	SetMotorPWM(RIGHT_MOTOR, DutyR);
+	SetMotorDirections(FORWARD, FORWARD);
+	SetMotorPWMs(DutyL, DutyR);
 	if (Duration != 0) {
 		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, Duration);
 	}
@@ -472,6 +544,19 @@ void DriveForwardWithBiasWithDuty(uint16_t DutyL, uint16_t DutyR, uint16_t Durat
 
 		
 
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function: 		DutyCycleToCompare
+Parameters: 	uint8_t DutyCycle, 0-100
+Returns: 			uint32_t, the compare A value for it
+Description: 	100% is the load value, the CmpBDn action (set to one) wins
+****************************************************************************/
+static uint32_t DutyCycleToCompare(uint8_t DutyCycle) {
+	if (DutyCycle >= 100) return (PeriodInMicroSeconds * PWMTicksPerMicroSecond) >> 1;
+	return (PeriodInMicroSeconds * PWMTicksPerMicroSecond) / 2 * DutyCycle / 100;
+}
+
+
 /*------------------------------ Test Harness -----------------------------*/
 #ifdef TEST 
 /* Test Harness for the DC Drive Motors Module */ 
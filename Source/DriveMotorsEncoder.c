@@ -1,5 +1,6 @@
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "inc/hw_memmap.h"
 #include "inc/hw_timer.h"
@@ -7,6 +8,7 @@
 #include "inc/hw_nvic.h"
 #include "inc/hw_types.h"
 #include "inc/hw_gpio.h"
+#include "inc/hw_qei.h"
 #include "bitdefs.h"
 
 // Framework Libraries
@@ -14,33 +16,117 @@
 #include "ES_Framework.h"
 
 #include "DriveMotorEncoder.h"
+#include "DriveMotors.h"
+#include "HW_Port.h"
 #include "SM_Master.h"
 #include "DriveMotorsService.h"
+#include "InputRecorder.h"
 
 // 40,000 ticks per mS assumes a 40Mhz clock
 #define TicksPerMS 40000
 #define TicksPerMin 2400000000
 #define PulsesPerRev 28
+// RPM times the period in ticks, one period, so an RPM is one 32 bit divide
+#define RPM_TICKS (TicksPerMin / PulsesPerRev)
+
+// Capture times kept for each wheel, a power of 2
+#define EDGE_HISTORY 8
+// The speed is averaged over as many of the last periods as fit in this
+// window, so a fast wheel is measured over several edges (count based) and
+// a slow one over its last period alone (period based)
+#define SPEED_WINDOW_TICKS (25 * TicksPerMS)
+// Neighbouring period differences the variance is worked out over
+#define VARIANCE_PERIODS 4
+// Held to this so the sum of their squares stays in 32 bits
+#define MAX_DIFFERENCE_RPM 30000
+// A wheel with no edge for this long is stopped (about 14 RPM)
+#define STOPPED_TICKS 6000000
+
+// With USE_QEI (see DriveMotorEncoder.h) both channels of each encoder go
+// to a QEI module instead of one channel to a wide timer capture:
+//   Right wheel, QEI0: channel A on PF0 (PhA0), channel B on PF1 (PhB0)
+//   Left wheel, QEI1:  channel A on PC5 (PhA1), channel B on PC6 (PhB1)
+// The QEI counts every edge of both channels, 4 counts to one of our
+// PulsesPerRev ticks, up or down with the way the wheel really turns.
+// No interrupts, the speed is the count over each velocity period.
+#define QEI_COUNTS_PER_TICK 4
+#define QEI_TICK_SHIFT 2
+#define QEI_VELOCITY_MS 20
+#define QEI_COUNTS_PER_REV (PulsesPerRev * QEI_COUNTS_PER_TICK)
+// RPM for one count in a velocity period, about 27
+#define QEI_RPM_PER_COUNT (60000 / (QEI_VELOCITY_MS * QEI_COUNTS_PER_REV))
+// Set to swap channels A and B if a wheel counts backward driving forward,
+// check each wheel on the bench with GetOdometer
+#define QEI_SWAP_R 0
+#define QEI_SWAP_L 0
 
 //#define TEST
 
-static uint32_t PeriodR;
-static uint32_t PeriodL;
-static uint32_t LastCaptureR;
-static uint32_t LastCaptureL;
-static uint32_t RPMR;
-static uint32_t RPML;
+// Speed measurement for one wheel. The capture ISR only records the edge,
+// UpdateRPMEstimates does the arithmetic once per control interrupt.
+typedef struct {
+	uint32_t Captures[EDGE_HISTORY];
+	volatile uint32_t Edges;				// Edges seen, the newest is Captures[(Edges - 1) % EDGE_HISTORY]
+	uint32_t EstimatedEdges;				// Edges when RPM was last worked out
+	uint32_t Period;								// Mean period over the window, in ticks
+	uint32_t RPM;
+	uint32_t Variance;							// Of RPM, in RPM^2
+	bool Reverse;										// Turning backward, as the QEI sees it
+} WheelSpeed_t;
 
-static uint32_t TickCountR = 0;
-static uint32_t TickCountL = 0;
-static uint32_t TargetTickCountR;
-static uint32_t TargetTickCountL;
+static WheelSpeed_t SpeedR;
+static WheelSpeed_t SpeedL;
+
+static void EstimateRPM(WheelSpeed_t *Wheel, uint32_t Now);
+#ifdef USE_QEI
+static void InitQEI(uint32_t Base, bool Swap);
+static void ReadQEIVelocity(WheelSpeed_t *Wheel, uint32_t Base);
+#endif
 
-static bool TargetTickRHasBeenSet = false;
-static bool TargetTickLHasBeenSet = false;
+// Signed running tick counts for odometry, never reset
+static volatile int32_t OdometerR = 0;
+static volatile int32_t OdometerL = 0;
 
 // we will use Timer A in Wide Timer 0 to capture the input
 void InitInputCapturePeriod( void ){
+#if defined(HOST_SIM)
+	// The motor simulator calls the capture ISRs, nothing to set up
+#elif defined(USE_QEI)
+	// Wide Timer 0B still has to run free for HW_TIMESTAMP()
+  HWREG(SYSCTL_RCGCWTIMER) |= SYSCTL_RCGCWTIMER_R0;
+	HWREG(SYSCTL_RCGCQEI) |= (SYSCTL_RCGCQEI_R0 | SYSCTL_RCGCQEI_R1);
+	HWREG(SYSCTL_RCGCGPIO) |= (SYSCTL_RCGCGPIO_R2 | SYSCTL_RCGCGPIO_R5);
+	while ((HWREG(SYSCTL_PRGPIO) & (SYSCTL_PRGPIO_R2 | SYSCTL_PRGPIO_R5)) != (SYSCTL_PRGPIO_R2 | SYSCTL_PRGPIO_R5))
+		;
+	
+  HWREG(WTIMER0_BASE+TIMER_O_CTL) &= ~TIMER_CTL_TBEN;
+  HWREG(WTIMER0_BASE+TIMER_O_CFG) = TIMER_CFG_16_BIT;
+  HWREG(WTIMER0_BASE+TIMER_O_TBILR) = 0xffffffff;
+  HWREG(WTIMER0_BASE+TIMER_O_TBMR) = 
+      (HWREG(WTIMER0_BASE+TIMER_O_TBMR) & ~TIMER_TBMR_TBMR_M) | 
+        (TIMER_TBMR_TBCDIR | TIMER_TBMR_TBMR_PERIOD);
+  HWREG(WTIMER0_BASE+TIMER_O_CTL) |= (TIMER_CTL_TBEN | TIMER_CTL_TBSTALL);
+	
+	// PF0 is locked as an NMI pin, unlock it to take it over
+	HWREG(GPIO_PORTF_BASE+GPIO_O_LOCK) = GPIO_LOCK_KEY;
+	HWREG(GPIO_PORTF_BASE+GPIO_O_CR) |= (BIT0HI | BIT1HI);
+	HWREG(GPIO_PORTF_BASE+GPIO_O_LOCK) = 0;
+	
+	// PF0, PF1 to PhA0, PhB0 and PC5, PC6 to PhA1, PhB1, mux value 6
+	HWREG(GPIO_PORTF_BASE+GPIO_O_AFSEL) |= (BIT0HI | BIT1HI);
+	HWREG(GPIO_PORTF_BASE+GPIO_O_PCTL) = 
+    (HWREG(GPIO_PORTF_BASE+GPIO_O_PCTL) & 0xffffff00) + (6<<0) + (6<<4);
+	HWREG(GPIO_PORTF_BASE+GPIO_O_DEN) |= (BIT0HI | BIT1HI);
+	HWREG(GPIO_PORTF_BASE+GPIO_O_DIR) &= (BIT0LO & BIT1LO);
+	HWREG(GPIO_PORTC_BASE+GPIO_O_AFSEL) |= (BIT5HI | BIT6HI);
+	HWREG(GPIO_PORTC_BASE+GPIO_O_PCTL) = 
+    (HWREG(GPIO_PORTC_BASE+GPIO_O_PCTL) & 0xf00fffff) + (6<<20) + (6<<24);
+	HWREG(GPIO_PORTC_BASE+GPIO_O_DEN) |= (BIT5HI | BIT6HI);
+	HWREG(GPIO_PORTC_BASE+GPIO_O_DIR) &= (BIT5LO & BIT6LO);
+	
+	InitQEI(QEI0_BASE, QEI_SWAP_R);
+	InitQEI(QEI1_BASE, QEI_SWAP_L);
+#else
   // start by enabling the clock to the timer (Wide Timer 0)
   HWREG(SYSCTL_RCGCWTIMER) |= SYSCTL_RCGCWTIMER_R0;
 	HWREG(SYSCTL_RCGCWTIMER) |= SYSCTL_RCGCWTIMER_R1;
@@ -117,89 +203,214 @@ void InitInputCapturePeriod( void ){
 // stall while stopped by the debugger
   HWREG(WTIMER0_BASE+TIMER_O_CTL) |= (TIMER_CTL_TBEN | TIMER_CTL_TBSTALL);
 	HWREG(WTIMER1_BASE+TIMER_O_CTL) |= (TIMER_CTL_TAEN | TIMER_CTL_TASTALL);
+#endif
 }
 
 void RDriveCaptureResponse( void ){
-  uint32_t ThisCaptureR;
 	//start by clearing the source of the interrupt, the input capture event
-  HWREG(WTIMER0_BASE+TIMER_O_ICR) = TIMER_ICR_CBECINT;
-
-	//now grab the captured value and calculate the period
-  ThisCaptureR = HWREG(WTIMER0_BASE+TIMER_O_TBR);
-	PeriodR = ThisCaptureR - LastCaptureR;
-	RPMR = TicksPerMin / (PeriodR*PulsesPerRev);
-			    
-	//update LastCapture to prepare for the next edge  
-  LastCaptureR = ThisCaptureR;
+  ENCODER_CLEAR_R();
+
+	// Just record the edge, the speed is worked out in UpdateRPMEstimates
+	uint32_t Capture = ENCODER_CAPTURE_R();
+	SpeedR.Captures[SpeedR.Edges % EDGE_HISTORY] = Capture;
+	SpeedR.Edges++;
+	RecordCapture(INPUT_ENCODER_R, ENCODER_TIMER_R() - Capture);
 	
-	// Update the tick count
-	TickCountR++;
-	//printf("TickCountR = %d\r\n", TickCountR);
-	if (TickCountR > TargetTickCountR && TargetTickRHasBeenSet) {
-		ES_Event Event = {E_MOTOR_TICK_TIMEOUT, 0};
-		PostDriveMotorsService(Event);
-		TargetTickRHasBeenSet = false;
-		TargetTickLHasBeenSet = false;
-	}
+	// Update the tick count, distance moves are run from it in DriveMotorsPosition.c
+	if (GetMotorDirection(RIGHT_MOTOR) == FORWARD) OdometerR++; else OdometerR--;
 }
 
 void LDriveCaptureResponse( void ){
-  uint32_t ThisCaptureL;
-  
 	//start by clearing the source of the interrupt, the input capture event
-  HWREG(WTIMER1_BASE+TIMER_O_ICR) = TIMER_ICR_CAECINT;
+  ENCODER_CLEAR_L();
 		
-	//now grab the captured value and calculate the period
-  ThisCaptureL = HWREG(WTIMER1_BASE+TIMER_O_TAR);
-	PeriodL = ThisCaptureL - LastCaptureL;
-	RPML = TicksPerMin / (PeriodL*PulsesPerRev);
-	
-	//update LastCapture to prepare for the next edge  
-  LastCaptureL = ThisCaptureL;
-	
-	// Update the tick count
-	TickCountL++;
-	//printf("TickCountL = %d\r\n", TickCountL);
-	if (TickCountL > TargetTickCountL && TargetTickLHasBeenSet) {
-		ES_Event Event = {E_MOTOR_TICK_TIMEOUT, 0};
-		PostDriveMotorsService(Event);
-		TargetTickLHasBeenSet = false;
-		TargetTickRHasBeenSet = false;
-	}
+	// Just record the edge, the speed is worked out in UpdateRPMEstimates
+	uint32_t Capture = ENCODER_CAPTURE_L();
+	SpeedL.Captures[SpeedL.Edges % EDGE_HISTORY] = Capture;
+	SpeedL.Edges++;
+	RecordCapture(INPUT_ENCODER_L, ENCODER_TIMER_L() - Capture);
 	
+	// Update the tick count, distance moves are run from it in DriveMotorsPosition.c
+	if (GetMotorDirection(LEFT_MOTOR) == FORWARD) OdometerL++; else OdometerL--;
+}
+
+/* Called at the top of the control ISR, each wheel is measured against
+   the timer its captures come from */
+void UpdateRPMEstimates( void ){
+#ifdef USE_QEI
+	ReadQEIVelocity(&SpeedR, QEI0_BASE);
+	ReadQEIVelocity(&SpeedL, QEI1_BASE);
+#else
+	EstimateRPM(&SpeedR, ENCODER_TIMER_R());
+	EstimateRPM(&SpeedL, ENCODER_TIMER_L());
+#endif
 }
 
 uint32_t GetPeriodR( void ){
-  return PeriodR;
+  return SpeedR.Period;
 }
 
 uint32_t GetPeriodL( void ){
-  return PeriodL;
+  return SpeedL.Period;
 }
 
 uint32_t GetRPMR(void){
-	if ((HWREG(WTIMER0_BASE+TIMER_O_TBV) - LastCaptureR) > 6000000){ 
-		return 0;
-	}
-	return RPMR;
+	return SpeedR.RPM;
 }
 
 uint32_t GetRPML(void){	
-	if ((HWREG(WTIMER1_BASE+TIMER_O_TAV) - LastCaptureL) > 6000000){ 
-		return 0;
+	return SpeedL.RPM;
+}
+
+/* How far GetRPM is likely to be off, as a variance in RPM^2. Mostly the
+   uneven spacing of the encoder edges, which matters most at low speed
+   where each estimate only has one period in it */
+uint32_t GetRPMVarianceR(void){
+	return SpeedR.Variance;
+}
+
+uint32_t GetRPMVarianceL(void){
+	return SpeedL.Variance;
+}
+
+/* Signed RPM, negative turning backward. The QEI knows which way the wheel
+   is turning, the captures can only go by the way it is driven */
+int32_t GetVelocityR(void){
+#ifdef USE_QEI
+	bool Reverse = SpeedR.Reverse;
+#else
+	bool Reverse = (GetMotorDirection(RIGHT_MOTOR) == BACKWARD);
+#endif
+	return Reverse ? -(int32_t)SpeedR.RPM : (int32_t)SpeedR.RPM;
+}
+
+int32_t GetVelocityL(void){
+#ifdef USE_QEI
+	bool Reverse = SpeedL.Reverse;
+#else
+	bool Reverse = (GetMotorDirection(LEFT_MOTOR) == BACKWARD);
+#endif
+	return Reverse ? -(int32_t)SpeedL.RPM : (int32_t)SpeedL.RPM;
+}
+
+int32_t GetOdometerR(void){
+#ifdef USE_QEI
+	return (int32_t)HWREG(QEI0_BASE+QEI_O_POS) >> QEI_TICK_SHIFT;
+#else
+	return OdometerR;
+#endif
+}
+
+int32_t GetOdometerL(void){
+#ifdef USE_QEI
+	return (int32_t)HWREG(QEI1_BASE+QEI_O_POS) >> QEI_TICK_SHIFT;
+#else
+	return OdometerL;
+#endif
+}
+
+/****************************************************************************
+Function:			EstimateRPM
+Parameters:		WheelSpeed_t *Wheel, the wheel to measure
+							uint32_t Now, the wheel's capture timer now
+Returns:			void
+Description:	When a new edge has come in, averages the last periods that fit
+							in SPEED_WINDOW_TICKS and works out the variance of that mean
+							from the spread of the last periods. Between edges,
+							a wheel that has gone longer than its period without one is
+							slowing, and can be going no faster than one edge in the time
+							since the last (the M/T bound), so that is used until the
+							next edge or until it counts as stopped.
+****************************************************************************/
+static void EstimateRPM(WheelSpeed_t *Wheel, uint32_t Now){
+	uint32_t Edges = Wheel->Edges;
+	if (Edges < 2) return;
+	uint32_t Newest = Wheel->Captures[(Edges - 1) % EDGE_HISTORY];
+	uint32_t Periods = (Edges - 1 < EDGE_HISTORY - 1) ? Edges - 1 : EDGE_HISTORY - 1;
+
+	if (Edges != Wheel->EstimatedEdges) {
+		Wheel->EstimatedEdges = Edges;
+		// Widen the window an edge at a time while it still fits
+		uint32_t Window = 1;
+		uint32_t Span = Newest - Wheel->Captures[(Edges - 2) % EDGE_HISTORY];
+		while (Window < Periods) {
+			uint32_t Wider = Newest - Wheel->Captures[(Edges - 2 - Window) % EDGE_HISTORY];
+			if (Wider > SPEED_WINDOW_TICKS) break;
+			Span = Wider;
+			Window++;
+		}
+		Wheel->Period = Span / Window;
+		Wheel->RPM = RPM_TICKS * Window / Span;
+
+		// Var(RPM) = Var(RPM of one period) / periods averaged, with the
+		// variance of one period's RPM from the differences of neighbouring
+		// ones, half their mean square, so a wheel speeding up or slowing down
+		// isn't taken as noise. All 32 bit, hardware divides, the 64 bit
+		// library ones were too slow for the ISR.
+		uint32_t Spread = (Periods < VARIANCE_PERIODS + 1) ? Periods : VARIANCE_PERIODS + 1;
+		if (Spread < 2) {
+			Wheel->Variance = 0;
+		} else {
+			uint32_t SumSquares = 0;
+			uint32_t Later = RPM_TICKS / (Newest - Wheel->Captures[(Edges - 2) % EDGE_HISTORY]);
+			for (uint32_t i = 1; i < Spread; i++) {
+				uint32_t Earlier = RPM_TICKS / (Wheel->Captures[(Edges - 1 - i) % EDGE_HISTORY] - \
+					Wheel->Captures[(Edges - 2 - i) % EDGE_HISTORY]);
+				uint32_t Difference = (Later > Earlier) ? Later - Earlier : Earlier - Later;
+				if (Difference > MAX_DIFFERENCE_RPM) Difference = MAX_DIFFERENCE_RPM;
+				SumSquares += Difference * Difference;
+				Later = Earlier;
+			}
+			Wheel->Variance = SumSquares / (2 * (Spread - 1) * Window);
+		}
+	}
+
+	uint32_t Since = Now - Newest;
+	if (Since > STOPPED_TICKS) {
+		Wheel->RPM = 0;
+		Wheel->Variance = 0;
+	} else if (Since > Wheel->Period) {
+		Wheel->RPM = TicksPerMin / (Since * PulsesPerRev);
 	}
-	return RPML;
 }
 
-void SetTargetTickCount(uint32_t NumberOfTicksL, uint32_t NumberOfTicksR) {
-	TickCountR = 0;
-	TickCountL = 0;
-	TargetTickCountR = NumberOfTicksR;
-	TargetTickCountL = NumberOfTicksL;
-	if (NumberOfTicksR != 0) TargetTickRHasBeenSet = true;
-	if (NumberOfTicksL != 0) TargetTickLHasBeenSet = true;
+#ifdef USE_QEI
+/****************************************************************************
+Function:			InitQEI
+Parameters:		uint32_t Base, QEI0_BASE or QEI1_BASE
+							bool Swap, swap channels A and B
+Returns:			void
+Description:	Quadrature counting on both edges of both channels, over the
+							full 32 bits, with the velocity count every QEI_VELOCITY_MS
+****************************************************************************/
+static void InitQEI(uint32_t Base, bool Swap){
+	HWREG(Base+QEI_O_CTL) = 0;
+	HWREG(Base+QEI_O_MAXPOS) = 0xffffffff;
+	HWREG(Base+QEI_O_POS) = 0;
+	HWREG(Base+QEI_O_LOAD) = TicksPerMS * QEI_VELOCITY_MS - 1;
+	HWREG(Base+QEI_O_CTL) = QEI_CTL_CAPMODE | QEI_CTL_VELEN | QEI_CTL_VELDIV_1 | \
+		(Swap ? QEI_CTL_SWAP : 0) | QEI_CTL_ENABLE;
 }
 
+/****************************************************************************
+Function:			ReadQEIVelocity
+Parameters:		WheelSpeed_t *Wheel, the wheel to update
+							uint32_t Base, its QEI
+Returns:			void
+Description:	Speed from the count in the last velocity period. A count is
+							QEI_RPM_PER_COUNT, so the variance is that step's
+							quantization, step^2 / 12, which keeps the PID deadband
+							just clear of it.
+****************************************************************************/
+static void ReadQEIVelocity(WheelSpeed_t *Wheel, uint32_t Base){
+	uint32_t Counts = HWREG(Base+QEI_O_SPEED);
+	Wheel->Reverse = (HWREG(Base+QEI_O_STAT) & QEI_STAT_DIRECTION) != 0;
+	Wheel->RPM = Counts * 60000 / (QEI_VELOCITY_MS * QEI_COUNTS_PER_REV);
+	Wheel->Period = (Counts > 0) ? TicksPerMS * QEI_VELOCITY_MS * QEI_COUNTS_PER_TICK / Counts : 0;
+	Wheel->Variance = QEI_RPM_PER_COUNT * QEI_RPM_PER_COUNT / 12;
+}
+#endif
+
 /*------------------------------- Footnotes -------------------------------*/
 #ifdef TEST
 #include "termio.h"
@@ -207,7 +418,7 @@ int main(void){
 	TERMIO_Init();
 	InitInputCapturePeriod();
 	while (1){
-		printf("\rRPM: %d\r\n", RPMR);
+		printf("\rRPM: %d\r\n", GetRPMR());
 	}
 }
 #endif
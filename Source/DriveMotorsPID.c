@@ -1,6 +1,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 
 #include "inc/hw_memmap.h"
@@ -12,6 +13,18 @@
 #include "DriveMotorEncoder.h"
 #include "DriveMotors.h"
 #include "DriveMotorPID.h"
+#include "PIDController.h"
+#include "DriveMotorsPosition.h"
+#include "MotionProfile.h"
+#include "MotionSequencer.h"
+#include "PoseEstimator.h"
+#include "PIDAutotune.h"
+#include "DriveFeedforward.h"
+#include "EEPROMStorage.h"
+#include "HW_Port.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "DriveMotorsService.h"
 //#include "ADService.h"
 //#include "PWMDemo.h"
 
@@ -21,23 +34,145 @@
 #define TicksPerMicroSecond 40
 #define TicksPerMilliSecond 40000
 
+// DWT cycle counter, for timing the control ISR (read with HW_CYCLES)
+#define DEMCR								0xE000EDFC
+#define DEMCR_TRCENA				BIT24HI
+#define DWT_CTRL						0xE0001000
+#define DWT_CTRL_CYCCNTENA	BIT0HI
+
 //#define TEST
 
 //650 target, p 0.03, i 0.15, 1ms loop time
 //500 target, p 0.03, i 0.15, 1ms loop time
 
-static float SumErrorR=0.0; /* error integrator */
-static float SumErrorL=0.0; /* error integrator */
+// Hand tuned gains, used until the autotune has been run
+#define DEFAULT_P 0.05f
+#define DEFAULT_I 0.02f
+#define DEFAULT_D 0.0f
+
+// The autotune oscillates both wheels forward about this speed, pick one
+// the Kart actually races at, the motors' lag changes with speed
+#define AUTOTUNE_RPM 150
+#define AUTOTUNE_RELAY_DUTY 10
+
+// Bump if TunedGains_t changes, old records are then ignored
+#define PID_GAINS_VERSION 1
+// Bump if FeedforwardMaps_t or FeedforwardMap_t changes
+#define FEEDFORWARD_VERSION 1
+
+// Gains for both wheels, as kept in the EEPROM
+typedef struct {
+	float pR, iR, dR;
+	float pL, iL, dL;
+} TunedGains_t;
+
+// Gain schedule speed bands, by the faster wheel's target
+#define SPEED_BAND_SLOW 0
+#define SPEED_BAND_FAST 1
+#define NUM_SPEED_BANDS 2
+#define FAST_BAND_RPM 300
+
+// One entry of the gain schedule. AUTOTUNED takes each wheel's gains from
+// the last autotune, or the hand tuned defaults if it's never been run,
+// AUTOTUNED_FF adds the feedforward to them. Feedforward adds the
+// calibrated duty map, if there is one, and has the PID follow the
+// wheel's modelled response rather than the target.
+typedef struct {
+	bool Autotuned;
+	float p, i, d;
+	bool Feedforward;
+} GainEntry_t;
+#define AUTOTUNED {true, 0, 0, 0, false}
+#define AUTOTUNED_FF {true, 0, 0, 0, true}
+
+// The gain schedule. Tune here, not in the state machines, every drive
+// command picks its row and the ISR its column. The autotune runs at
+// 150 RPM so it covers the slow band, the 500 RPM straights have always
+// wanted the stiffer gains. Feedforward is on a whole row or not at all,
+// switching it between the bands kicks the wheel. It only pays on the
+// turns (motorsim): the pivots come out on their ticks, where the speed
+// steps and distance moves settle slower with it.
+static const GainEntry_t GainSchedule[NUM_MANEUVERS][NUM_SPEED_BANDS] = {
+	/*													Slow				Fast */
+	/* MANEUVER_DRIVE */		{AUTOTUNED,		{false, 0.1f, 0.5f, 0, false}},
+	/* MANEUVER_DISTANCE */	{AUTOTUNED,		{false, 0.1f, 0.5f, 0, false}},
+	/* MANEUVER_TURN */			{AUTOTUNED_FF,	AUTOTUNED_FF}
+};
+
+// The feedforward sweep spins the Kart on the spot, CW then CCW, which
+// turns each wheel both ways without needing a clear straight
+typedef enum {SWEEP_OFF, SWEEP_CW, SWEEP_CCW} SweepSpin_t;
+
+// Both wheels' duty maps, by direction, as kept in the EEPROM
+typedef struct {
+	FeedforwardMap_t R[2];
+	FeedforwardMap_t L[2];
+} FeedforwardMaps_t;
 
-static float pGain = 0.05;//1.92;
-static float iGain = 0.02;
-static float dGain = 0.00;
+// One loop per wheel, InitPeriodicInt sets the default gains
+static PIDController_t PIDR;
+static PIDController_t PIDL;
 static float TargetRPMR = 100.0;
 static float TargetRPML = 100.0;
+static int32_t BiasedTargetRPMR = 100;	/* targets with the speed bias applied */
+static int32_t BiasedTargetRPML = 100;
+
+// A new command is staged here and taken up by the ISR in one go, so the
+// targets never run for an interrupt on the last command's gains
+static Maneuver_t CommandManeuver = MANEUVER_DRIVE;
+static volatile bool CommandPending = false;
+static int32_t PendingTargetRPMR, PendingTargetRPML;
+static Maneuver_t PendingManeuver;
+
+// The gain schedule in fixed point, per wheel, and the entry in use
+static PIDGains_t ScheduleR[NUM_MANEUVERS][NUM_SPEED_BANDS];
+static PIDGains_t ScheduleL[NUM_MANEUVERS][NUM_SPEED_BANDS];
+static Maneuver_t ActiveManeuver = MANEUVER_DRIVE;
+static uint8_t ActiveBand = SPEED_BAND_SLOW;
+static volatile bool ScheduleChanged = true;
+
+// Feedforward maps, all zeros until calibrated, and each wheel's model of
+// where it should be (RPM, Q16.16)
+static FeedforwardMaps_t FeedforwardMaps;
+static const FeedforwardMap_t NoFeedforward;
+static bool UseFeedforward = false;
+static int32_t ModelR, ModelL;
+
+// Feedforward calibration, drives the PWM while it runs
+static FeedforwardSweep_t SweepR;
+static FeedforwardSweep_t SweepL;
+static volatile SweepSpin_t SweepSpin = SWEEP_OFF;
 static bool PIDcontrolEnabled = true;
+static uint8_t SpeedBias = 100; /* percent of the target RPM to run at */
+
+// The targets are ramped to under the accel and jerk limits, not stepped
+static MotionProfile_t ProfileR;
+static MotionProfile_t ProfileL;
+static uint8_t ProfileDirectionR = FORWARD;
+static uint8_t ProfileDirectionL = FORWARD;
+
+// The AUTOTUNED gains, from the EEPROM or the autotune
+static TunedGains_t TunedGains = {DEFAULT_P, DEFAULT_I, DEFAULT_D, DEFAULT_P, DEFAULT_I, DEFAULT_D};
+
+// Relay autotune, one experiment per wheel, drives the PWM while it runs
+static RelayAutotune_t AutotuneR;
+static RelayAutotune_t AutotuneL;
+static volatile bool AutotuneRunning = false;
+
+// Cycles spent in SetRPMResponse, and the most of them in UpdateRPMEstimates
+static uint32_t LastPIDCycles = 0;
+static uint32_t MaxPIDCycles = 0;
+static uint32_t MaxEstimateCycles = 0;
+
+static void ApplySpeedBias(void);
+static void BuildGainSchedule(void);
+static void UpdateAutotune(void);
+static void UpdateFeedforwardCalibration(void);
+static void PrintFeedforwardMap(const char *Name, const FeedforwardMap_t *Map);
 
 // we will use Timer B in Wide Timer 1 to generate the interrupt
 void InitPeriodicInt( void ){
+#ifndef HOST_SIM
   volatile uint32_t Dummy; // use volatile to avoid over-optimization
   // start by enabling the clock to the timer (Wide Timer 1)
   HWREG(SYSCTL_RCGCWTIMER) |= SYSCTL_RCGCWTIMER_R1;
@@ -46,6 +181,22 @@ void InitPeriodicInt( void ){
   
   // make sure that timer (Timer B) is disabled before configuring
   HWREG(WTIMER1_BASE+TIMER_O_CTL) &= ~TIMER_CTL_TBEN;
+#endif
+  
+	// start the gains at the last autotune's, if the EEPROM has them
+	if (ReadEEPROMRecord(EEPROM_SLOT_PID_GAINS, PID_GAINS_VERSION, &TunedGains, sizeof(TunedGains))) {
+		printf("PID: autotuned gains loaded\r\n");
+	}
+	BuildGainSchedule();
+	ScheduleGains(MANEUVER_DRIVE, 0);
+	if (ReadEEPROMRecord(EEPROM_SLOT_FEEDFORWARD, FEEDFORWARD_VERSION, &FeedforwardMaps, sizeof(FeedforwardMaps))) {
+		printf("PID: feedforward maps loaded\r\n");
+	}
+	
+#ifndef HOST_SIM
+	// turn on the cycle counter so the ISR can time itself
+	HWREG(DEMCR) |= DEMCR_TRCENA;
+	HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
   
 	// set it up in 32bit wide (individual, not concatenated) mode
 	// the constant name derives from the 16/32 bit timer, but this is a 32/64
@@ -72,68 +223,135 @@ void InitPeriodicInt( void ){
 	// now kick the timer off by enabling it and enabling the timer to
 	// stall while stopped by the debugger
   HWREG(WTIMER1_BASE+TIMER_O_CTL) |= (TIMER_CTL_TBEN | TIMER_CTL_TBSTALL);
+#endif
 }
 
 void SetRPMResponse( void ){
-	static float RPMErrorR; /* make static for speed */
-	static float LastErrorR; /* for Derivative Control */
-
-	static float RPMErrorL; /* make static for speed */
-	static float LastErrorL; /* for Derivative Control */
-
-	//static float pGain = 1.26;
+	uint32_t StartCycles = HW_CYCLES();
 
 	// start by clearing the source of the interrupt
-  HWREG(WTIMER1_BASE+TIMER_O_ICR) = TIMER_ICR_TBTOCINT;
-		
-	RPMErrorR = TargetRPMR - GetRPMR();
-	SumErrorR += RPMErrorR;
+  CONTROL_INT_CLEAR();
 	
-	RPMErrorL = TargetRPML - GetRPML();
-	SumErrorL += RPMErrorL;
+	// Wheel speeds from the edges captured since the last interrupt
+	UpdateRPMEstimates();
+	uint32_t EstimateCycles = HW_CYCLES() - StartCycles;
+	if (EstimateCycles > MaxEstimateCycles) MaxEstimateCycles = EstimateCycles;
 	
-	int32_t RequestedDutyR = 
-		(pGain * ((RPMErrorR) + (iGain * SumErrorR) + (dGain * (RPMErrorR - LastErrorR))));
-		
-	int32_t RequestedDutyL = 
-		(pGain * ((RPMErrorL) + (iGain * SumErrorL) + (dGain * (RPMErrorL - LastErrorL))));
-		
-	if (RequestedDutyR > 100) {
-		RequestedDutyR = 100;
-		SumErrorR-=RPMErrorR; /* anti-windup */
-	}
-	else if (RequestedDutyR < 0){
-		RequestedDutyR = 0;
-		SumErrorR-=RPMErrorR; /* anti-windup */
+	// A new command's targets and gains start together. A maneuver sets
+	// its own gains at each step, a speed bias change doesn't override them
+	if (CommandPending) {
+		BiasedTargetRPMR = PendingTargetRPMR;
+		BiasedTargetRPML = PendingTargetRPML;
+		if (!IsMotionSequenceRunning()) {
+			ScheduleGains(PendingManeuver, (abs(BiasedTargetRPMR) > abs(BiasedTargetRPML)) ? \
+				abs(BiasedTargetRPMR) : abs(BiasedTargetRPML));
+		}
+		CommandPending = false;
 	}
 	
-	if (RequestedDutyL > 100) {
-		RequestedDutyL = 100;
-		SumErrorL-=RPMErrorL; /* anti-windup */
+	// A maneuver, or a distance move through the outer position loop, sets
+	// the targets itself
+	int32_t TargetR = BiasedTargetRPMR;
+	int32_t TargetL = BiasedTargetRPML;
+	if (UpdateMotionSequence(&TargetR, &TargetL) || UpdatePositionControl(&TargetR, &TargetL)) {
+		TargetR = TargetR * SpeedBias / 100;
+		TargetL = TargetL * SpeedBias / 100;
 	}
-	else if (RequestedDutyL < 0){
-		RequestedDutyL = 0;
-		SumErrorL-=RPMErrorL; /* anti-windup */
+	
+	// The profiles and models pick up from the wheel speeds while the PID
+	// is off, and start again from a standstill when a wheel is turned around
+	if (!PIDcontrolEnabled) {
+		ResetMotionProfile(&ProfileR, GetRPMR());
+		ResetMotionProfile(&ProfileL, GetRPML());
+		ResetReferenceModel(&ModelR, GetRPMR());
+		ResetReferenceModel(&ModelL, GetRPML());
 	}
-	LastErrorR = RPMErrorR;
-	LastErrorL = RPMErrorL;
+	if (GetMotorDirection(RIGHT_MOTOR) != ProfileDirectionR) {
+		ProfileDirectionR = GetMotorDirection(RIGHT_MOTOR);
+		ResetMotionProfile(&ProfileR, 0);
+		ResetReferenceModel(&ModelR, 0);
+	}
+	if (GetMotorDirection(LEFT_MOTOR) != ProfileDirectionL) {
+		ProfileDirectionL = GetMotorDirection(LEFT_MOTOR);
+		ResetMotionProfile(&ProfileL, 0);
+		ResetReferenceModel(&ModelL, 0);
+	}
+	TargetR = UpdateMotionProfile(&ProfileR, TargetR);
+	TargetL = UpdateMotionProfile(&ProfileL, TargetL);
+	
+	// The feedforward duty for the profile's target, and the PID follows
+	// the model of how the wheel gets there. With no map both drop out.
+	const FeedforwardMap_t *MapR = UseFeedforward ? &FeedforwardMaps.R[ProfileDirectionR] : &NoFeedforward;
+	const FeedforwardMap_t *MapL = UseFeedforward ? &FeedforwardMaps.L[ProfileDirectionL] : &NoFeedforward;
+	int32_t ReferenceR = UpdateReferenceModel(MapR, &ModelR, TargetR);
+	int32_t ReferenceL = UpdateReferenceModel(MapL, &ModelL, TargetL);
+	
+	uint8_t RequestedDutyR = UpdatePIDController(&PIDR, ReferenceR, GetRPMR(), GetRPMVarianceR(), \
+		GetFeedforwardDuty(MapR, TargetR));
+	uint8_t RequestedDutyL = UpdatePIDController(&PIDL, ReferenceL, GetRPML(), GetRPMVarianceL(), \
+		GetFeedforwardDuty(MapL, TargetL));
 	
 	//SetMotorDirection(1,1); //take this away
 	//SetMotorPWM(RIGHT_MOTOR, 100);
 	//SetMotorPWM(LEFT_MOTOR, 100 );
-	if (PIDcontrolEnabled) {
-		SetMotorPWM(RIGHT_MOTOR, RequestedDutyR);
-		SetMotorPWM(LEFT_MOTOR, RequestedDutyL);
+	if (AutotuneRunning) {
+		UpdateAutotune();
+	} else if (SweepSpin != SWEEP_OFF) {
+		UpdateFeedforwardCalibration();
+	} else if (PIDcontrolEnabled) {
+		SetMotorPWMs(RequestedDutyL, RequestedDutyR);
 	}
+	// Both motors' duties and directions go out together
+	ApplyMotorCommand();
+	
+	// Odometry samples for the pose estimate
+	UpdateOdometry();
+	
+	LastPIDCycles = HW_CYCLES() - StartCycles;
+	if (LastPIDCycles > MaxPIDCycles) MaxPIDCycles = LastPIDCycles;
 }
 
+/* A plain drive at an RPM, on the MANEUVER_DRIVE gains */
 void SetTargetRPM(float SetRPMR, float SetRPML){
+	SetManeuverRPM(MANEUVER_DRIVE, SetRPMR, SetRPML);
+}
+
+/* A new RPM target, with the gain schedule row for the kind of maneuver
+   it's for. Ends any maneuver, distance move or calibration */
+void SetManeuverRPM(Maneuver_t Maneuver, float SetRPMR, float SetRPML){
+	StopMotionSequence();
+	StopPositionMove();
+	if (AutotuneRunning || SweepSpin != SWEEP_OFF) {
+		AutotuneRunning = false;
+		SweepSpin = SWEEP_OFF;
+		SetMotorPWMs(0, 0);
+	}
 	TargetRPMR = SetRPMR;
 	TargetRPML = SetRPML;
+	CommandManeuver = Maneuver;
+	ApplySpeedBias();
 }
 
 
 
+/* Scales both target RPMs, e.g. to slow down for a predicted collision
+   without the state machines having to remember the original targets */
+void SetSpeedBias(uint8_t Percent) {
+	if (Percent > 100) Percent = 100;
+	SpeedBias = Percent;
+	ApplySpeedBias();
+}
+
+/* Works out the biased targets here so the ISR stays integer only, and
+   stages them for the ISR. The ISR skips a command that's half written */
+static void ApplySpeedBias(void) {
+	CommandPending = false;
+	PendingTargetRPMR = TargetRPMR * SpeedBias / 100;
+	PendingTargetRPML = TargetRPML * SpeedBias / 100;
+	PendingManeuver = CommandManeuver;
+	CommandPending = true;
+}
+
 void EnablePIDcontrol(void) {
 	PIDcontrolEnabled = true;
 }
@@ -142,15 +360,161 @@ void DisablePIDcontrol(void) {
 }
 
 void ClearSumError(void) {
-	SumErrorR = 0;
-	SumErrorL = 0;
+	ResetPIDController(&PIDR);
+	ResetPIDController(&PIDL);
+}
+
+/* Switches both loops to the gain schedule entry for a maneuver at RPM,
+   bumplessly. Integer only, for the ISR: commands get here through
+   SetManeuverRPM, the MotionSequencer calls it at each step */
+void ScheduleGains(Maneuver_t Maneuver, int32_t RPM) {
+	uint8_t Band = (RPM >= FAST_BAND_RPM) ? SPEED_BAND_FAST : SPEED_BAND_SLOW;
+	if (Maneuver == ActiveManeuver && Band == ActiveBand && !ScheduleChanged) return;
+	SwitchPIDGains(&PIDR, &ScheduleR[Maneuver][Band]);
+	SwitchPIDGains(&PIDL, &ScheduleL[Maneuver][Band]);
+	UseFeedforward = GainSchedule[Maneuver][Band].Feedforward;
+	ActiveManeuver = Maneuver;
+	ActiveBand = Band;
+	ScheduleChanged = false;
+}
+
+/* Runs the relay autotune on both wheels, forward, from a standstill.
+   Give it a couple of meters of clear floor, it takes about 2s and posts
+   E_PID_AUTOTUNE_DONE to the DriveMotorsService at the end */
+void StartPIDAutotune(void) {
+	StopMotionSequence();
+	StopPositionMove();
+	AutotuneRunning = false;
+	SweepSpin = SWEEP_OFF;
+	DisablePIDcontrol();
+	SetMotorDirections(FORWARD, FORWARD);
+	StartRelayAutotune(&AutotuneR, AUTOTUNE_RPM, AUTOTUNE_RELAY_DUTY);
+	StartRelayAutotune(&AutotuneL, AUTOTUNE_RPM, AUTOTUNE_RELAY_DUTY);
+	printf("PID: autotuning at %d RPM\r\n", AUTOTUNE_RPM);
+	AutotuneRunning = true;
+}
+
+/* Works out the gains from the autotune, in the thread since it's float
+   math, and keeps them in the EEPROM. A wheel that didn't oscillate
+   cleanly keeps the gains it had */
+void FinishPIDAutotune(void) {
+	float Ku, Tu;
+	if (GetRelayAutotuneResult(&AutotuneR, &Ku, &Tu)) {
+		RelayAutotuneGains(Ku, Tu, &TunedGains.pR, &TunedGains.iR, &TunedGains.dR);
+		printf("PID: Right Ku = %.3f, Tu = %.1f ms\r\n", Ku, Tu);
+	} else {
+		printf("PID: Right autotune failed\r\n");
+	}
+	if (GetRelayAutotuneResult(&AutotuneL, &Ku, &Tu)) {
+		RelayAutotuneGains(Ku, Tu, &TunedGains.pL, &TunedGains.iL, &TunedGains.dL);
+		printf("PID: Left Ku = %.3f, Tu = %.1f ms\r\n", Ku, Tu);
+	} else {
+		printf("PID: Left autotune failed\r\n");
+	}
+	printf("PID: Right p = %.4f, i = %.4f, d = %.4f, Left p = %.4f, i = %.4f, d = %.4f\r\n", \
+		TunedGains.pR, TunedGains.iR, TunedGains.dR, TunedGains.pL, TunedGains.iL, TunedGains.dL);
+	BuildGainSchedule();
+	ClearSumError();
+	if (!WriteEEPROMRecord(EEPROM_SLOT_PID_GAINS, PID_GAINS_VERSION, &TunedGains, sizeof(TunedGains))) {
+		printf("PID: couldn't save the gains\r\n");
+	}
+}
+
+/* Maps each wheel's duty to speed, both ways, for the feedforward. The
+   Kart spins on the spot for about 15s, CW then CCW, and posts
+   E_FEEDFORWARD_CAL_DONE to the DriveMotorsService at the end */
+void StartFeedforwardCalibration(void) {
+	StopMotionSequence();
+	StopPositionMove();
+	AutotuneRunning = false;
+	SweepSpin = SWEEP_OFF;
+	DisablePIDcontrol();
+	SetMotorDirections(FORWARD, BACKWARD);
+	StartFeedforwardSweep(&SweepL, &FeedforwardMaps.L[FORWARD]);
+	StartFeedforwardSweep(&SweepR, &FeedforwardMaps.R[BACKWARD]);
+	printf("PID: feedforward calibration, spinning CW\r\n");
+	SweepSpin = SWEEP_CW;
+}
+
+/* Prints the new maps and keeps them in the EEPROM */
+void FinishFeedforwardCalibration(void) {
+	PrintFeedforwardMap("Right forward", &FeedforwardMaps.R[FORWARD]);
+	PrintFeedforwardMap("Right backward", &FeedforwardMaps.R[BACKWARD]);
+	PrintFeedforwardMap("Left forward", &FeedforwardMaps.L[FORWARD]);
+	PrintFeedforwardMap("Left backward", &FeedforwardMaps.L[BACKWARD]);
+	ClearSumError();
+	if (!WriteEEPROMRecord(EEPROM_SLOT_FEEDFORWARD, FEEDFORWARD_VERSION, &FeedforwardMaps, sizeof(FeedforwardMaps))) {
+		printf("PID: couldn't save the feedforward maps\r\n");
+	}
 }
 
-void SetPIDgains(double p, double i, double d) {
-	pGain = p;
-	iGain = i;
-	dGain = d;
+void GetPIDCycles(uint32_t *Last, uint32_t *Max) {
+	*Last = LastPIDCycles;
+	*Max = MaxPIDCycles;
+}
+
+void PrintPIDCycles(void) {
+	printf("PID: SetRPMResponse Last = %lu cycles, Max = %lu cycles, RPM estimates Max = %lu cycles\r\n", \
+		(unsigned long)LastPIDCycles, (unsigned long)MaxPIDCycles, (unsigned long)MaxEstimateCycles);
+	MaxPIDCycles = 0;
+	MaxEstimateCycles = 0;
+}
+/* Converts the gain schedule to fixed point for both wheels, the
+   ISR picks the new gains up with its next command */
+static void BuildGainSchedule(void) {
+	for (uint8_t Maneuver = 0; Maneuver < NUM_MANEUVERS; Maneuver++) {
+		for (uint8_t Band = 0; Band < NUM_SPEED_BANDS; Band++) {
+			const GainEntry_t *Entry = &GainSchedule[Maneuver][Band];
+			if (Entry->Autotuned) {
+				ConvertPIDGains(&ScheduleR[Maneuver][Band], TunedGains.pR, TunedGains.iR, TunedGains.dR);
+				ConvertPIDGains(&ScheduleL[Maneuver][Band], TunedGains.pL, TunedGains.iL, TunedGains.dL);
+			} else {
+				ConvertPIDGains(&ScheduleR[Maneuver][Band], Entry->p, Entry->i, Entry->d);
+				ConvertPIDGains(&ScheduleL[Maneuver][Band], Entry->p, Entry->i, Entry->d);
+			}
+		}
+	}
+	ScheduleChanged = true;
+}
+
+/* One sample of the autotune on each wheel, a wheel that has finished
+   sits at 0 duty until the other one is done too */
+static void UpdateAutotune(void) {
+	SetMotorPWMs(UpdateRelayAutotune(&AutotuneL, GetRPML()), UpdateRelayAutotune(&AutotuneR, GetRPMR()));
+	if (IsRelayAutotuneFinished(&AutotuneR) && IsRelayAutotuneFinished(&AutotuneL)) {
+		AutotuneRunning = false;
+		ES_Event Event = {E_PID_AUTOTUNE_DONE, 0};
+		PostDriveMotorsService(Event);
+	}
 }
+
+/* One sample of the feedforward sweep on each wheel. The wheels sweep
+   together, once both are done the Kart turns around for the other
+   direction, then hands back */
+static void UpdateFeedforwardCalibration(void) {
+	SetMotorPWMs(UpdateFeedforwardSweep(&SweepL, GetRPML()), UpdateFeedforwardSweep(&SweepR, GetRPMR()));
+	if (IsFeedforwardSweepRunning(&SweepR) || IsFeedforwardSweepRunning(&SweepL)) return;
+	
+	if (SweepSpin == SWEEP_CW) {
+		SetMotorDirections(BACKWARD, FORWARD);
+		StartFeedforwardSweep(&SweepL, &FeedforwardMaps.L[BACKWARD]);
+		StartFeedforwardSweep(&SweepR, &FeedforwardMaps.R[FORWARD]);
+		SweepSpin = SWEEP_CCW;
+	} else {
+		SweepSpin = SWEEP_OFF;
+		ES_Event Event = {E_FEEDFORWARD_CAL_DONE, 0};
+		PostDriveMotorsService(Event);
+	}
+}
+
+static void PrintFeedforwardMap(const char *Name, const FeedforwardMap_t *Map) {
+	printf("PID: %s, time constant %u ms, RPM", Name, Map->TimeConstantMS);
+	for (uint8_t n = 0; n < FF_POINTS; n++) {
+		printf(" %u", Map->RPM[n]);
+	}
+	printf(" at %d-%d%%\r\n", FF_DUTY_STEP, FF_POINTS * FF_DUTY_STEP);
+}
+
 /*
 uint32_t GetTimeoutCount( void ){
   return TimeoutCount;
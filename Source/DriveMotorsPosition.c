@@ -0,0 +1,289 @@
+/****************************************************************************
+Module: DriveMotorsPosition.c
+Description:
+	Outer position loop for the drive motors, cascaded onto the RPM PID in
+	DriveMotorsPID.c. A distance move used to run the velocity loop at full
+	speed until the encoder ISR saw the tick count go past the target, then
+	cut the motors, so the Kart overshot and the two wheels finished at
+	different times.
+	Now every POSITION_LOOP_MS the ticks each wheel has left cap its RPM
+	target at the speed it can still coast to a stop from (MotionProfile.c),
+	taking the drive off altogether if the wheel is already going faster
+	than that, and a cross-coupling term trades RPM between the wheels to
+	keep them at the same fraction of their moves. Once both wheels are on their ticks and have stopped turning,
+	E_MOTOR_SETTLED is posted to the DriveMotorsService.
+	Runs from the control ISR, integer math only.
+Author: Kyle Moy, 3/8/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+
+// Module Libraries
+#include "DriveMotorsPosition.h"
+#include "DriveMotorsService.h"
+#include "DriveMotorEncoder.h"
+#include "MotionProfile.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// The position loop runs every POSITION_LOOP_DIVIDER control interrupts
+#define POSITION_LOOP_DIVIDER		10
+#define POSITION_LOOP_MS				10		// 1ms control interrupt
+
+#define PulsesPerRev						28
+
+// Close in, the motors coast down slower than the profile's deceleration,
+// so the RPM target is also held to this much per tick left to go
+#define POSITION_GAIN						20
+// Slowest approach speed, enough to keep turning against friction
+#define MIN_APPROACH_RPM				30
+// RPM moved between the wheels per tick one is ahead of the other
+#define SYNC_GAIN								10
+
+// A wheel within this many ticks of its target, either side, is there
+#define SETTLE_TICKS						1
+// Settled once both wheels are there and no tick has come in for this long
+#define SETTLE_TIME_MS					50
+// Given up on once no tick has come in for this long short of the target
+#define STALL_TIME_MS						500
+
+/*---------------------------- Module Functions ---------------------------*/
+static void BeginMove(uint32_t TicksL, uint32_t TicksR, uint16_t CruiseL, uint16_t CruiseR, bool Notify);
+static int32_t WheelCommand(int32_t Remaining, int32_t WheelRPM, int32_t CommandRPM, int32_t CruiseRPM);
+static void Settle(uint16_t Result);
+
+/*---------------------------- Module Variables ---------------------------*/
+typedef enum {MOVE_IDLE, MOVE_RUNNING, MOVE_HOLDING} MoveState_t;
+
+static volatile MoveState_t MoveState = MOVE_IDLE;
+
+// The move
+static int32_t StartTicksL, StartTicksR;
+static int32_t TargetTicksL, TargetTicksR;
+static int32_t CruiseRPML, CruiseRPMR;
+
+// Loop state
+static uint8_t Divider = 0;
+static int32_t CommandRPML = 0, CommandRPMR = 0;
+static int32_t LastTravelledL, LastTravelledR;
+static uint16_t QuietTime;
+static uint16_t MoveTime;
+static bool PostWhenSettled;
+static uint8_t MoveResult = MOVE_ARRIVED;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			StartPositionMove
+Parameters:		uint32_t TicksL, TicksR, how far each wheel should turn
+							uint16_t CruiseL, CruiseR, the RPM of each wheel
+							away from the target
+Returns:			void
+Description:	Starts a distance move. Set the motor directions first, the
+							ticks are counted in whichever direction the wheel turns.
+****************************************************************************/
+void StartPositionMove(uint32_t TicksL, uint32_t TicksR, uint16_t CruiseL, uint16_t CruiseR) {
+	BeginMove(TicksL, TicksR, CruiseL, CruiseR, true);
+}
+
+/****************************************************************************
+Function:			StartPositionStep
+Parameters:		as StartPositionMove
+Returns:			void
+Description:	Starts a distance move that doesn't post E_MOTOR_SETTLED, for
+							the MotionSequencer, which watches GetPositionMoveResult
+****************************************************************************/
+void StartPositionStep(uint32_t TicksL, uint32_t TicksR, uint16_t CruiseL, uint16_t CruiseR) {
+	BeginMove(TicksL, TicksR, CruiseL, CruiseR, false);
+}
+
+/****************************************************************************
+Function:			StopPositionMove
+Parameters:		void
+Returns:			void
+Description:	Hands the RPM targets back to SetTargetRPM
+****************************************************************************/
+void StopPositionMove(void) {
+	MoveState = MOVE_IDLE;
+}
+
+/****************************************************************************
+Function:			IsPositionMoveActive
+Parameters:		void
+Returns:			bool, true while a move is still on its way
+Description:	Tells if a distance move is running
+****************************************************************************/
+bool IsPositionMoveActive(void) {
+	return MoveState == MOVE_RUNNING;
+}
+
+/****************************************************************************
+Function:			GetPositionMoveResult
+Parameters:		void
+Returns:			uint8_t, MOVE_IN_PROGRESS, or how the last move ended
+Description:	Lets a caller poll for the end of a move
+****************************************************************************/
+uint8_t GetPositionMoveResult(void) {
+	return (MoveState == MOVE_RUNNING) ? MOVE_IN_PROGRESS : MoveResult;
+}
+
+/****************************************************************************
+Function:			UpdatePositionControl
+Parameters:		int32_t *TargetRPMR, *TargetRPML, the inner loop targets
+Returns:			bool, true if a move owns the targets and they were written
+Description:	Called from the control ISR every interrupt
+****************************************************************************/
+bool UpdatePositionControl(int32_t *TargetRPMR, int32_t *TargetRPML) {
+	if (MoveState == MOVE_IDLE) return false;
+	if (MoveState == MOVE_HOLDING) {
+		// Hold still until the service stops the motors or gives a new command
+		*TargetRPMR = 0;
+		*TargetRPML = 0;
+		return true;
+	}
+
+	if (++Divider >= POSITION_LOOP_DIVIDER) {
+		Divider = 0;
+		MoveTime += POSITION_LOOP_MS;
+
+		int32_t TravelledL = abs(GetOdometerL() - StartTicksL);
+		int32_t TravelledR = abs(GetOdometerR() - StartTicksR);
+		int32_t RemainingL = TargetTicksL - TravelledL;
+		int32_t RemainingR = TargetTicksR - TravelledR;
+
+		// The velocities are signed, negative for a wheel going BACKWARD,
+		// while the commands and the remaining ticks are speeds and distances
+		CommandRPML = WheelCommand(RemainingL, abs(GetVelocityL()), CommandRPML, CruiseRPML);
+		CommandRPMR = WheelCommand(RemainingR, abs(GetVelocityR()), CommandRPMR, CruiseRPMR);
+
+		// Cross-coupling: how many ticks the left wheel is ahead of the right,
+		// in proportion to their moves, slows the leader and speeds up the other
+		if (TargetTicksL != 0 && TargetTicksR != 0 && CommandRPML != 0 && CommandRPMR != 0) {
+			int32_t Longer = (TargetTicksL > TargetTicksR) ? TargetTicksL : TargetTicksR;
+			int32_t LeadL = (TravelledL * TargetTicksR - TravelledR * TargetTicksL) / Longer;
+			CommandRPML -= SYNC_GAIN * LeadL;
+			CommandRPMR += SYNC_GAIN * LeadL;
+			if (CommandRPML < 0) CommandRPML = 0;
+			if (CommandRPMR < 0) CommandRPMR = 0;
+		}
+
+		// Settle detection
+		if (TravelledL != LastTravelledL || TravelledR != LastTravelledR) {
+			LastTravelledL = TravelledL;
+			LastTravelledR = TravelledR;
+			QuietTime = 0;
+		} else if (QuietTime < STALL_TIME_MS) {
+			QuietTime += POSITION_LOOP_MS;
+		}
+		// Past the target by more than that is an overshoot, and as the loop
+		// never backs up, waiting won't bring it in
+		bool Arrived = (abs(RemainingL) <= SETTLE_TICKS) && (abs(RemainingR) <= SETTLE_TICKS);
+		bool Overshot = (RemainingL < -SETTLE_TICKS) || (RemainingR < -SETTLE_TICKS);
+		if (Arrived && QuietTime >= SETTLE_TIME_MS) {
+			Settle(MOVE_ARRIVED);
+		} else if (Overshot && QuietTime >= SETTLE_TIME_MS) {
+			Settle(MOVE_STALLED);
+		} else if (!Arrived && QuietTime >= STALL_TIME_MS) {
+			Settle(MOVE_STALLED);
+		}
+	}
+
+	*TargetRPMR = (MoveState == MOVE_RUNNING) ? CommandRPMR : 0;
+	*TargetRPML = (MoveState == MOVE_RUNNING) ? CommandRPML : 0;
+	return true;
+}
+
+/****************************************************************************
+Function:			PrintPositionMove
+Parameters:		void
+Returns:			void
+Description:	Prints where the current or last move got to
+****************************************************************************/
+void PrintPositionMove(void) {
+	printf("Position: Ticks L = %ld/%ld, R = %ld/%ld, RPM L = %ld, R = %ld, Time = %d ms%s\r\n", \
+		(long)abs(GetOdometerL() - StartTicksL), (long)TargetTicksL, \
+		(long)abs(GetOdometerR() - StartTicksR), (long)TargetTicksR, \
+		(long)CommandRPML, (long)CommandRPMR, MoveTime, \
+		(MoveState == MOVE_RUNNING) ? ", running" : "");
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			BeginMove
+Parameters:		uint32_t TicksL, TicksR, uint16_t CruiseL, CruiseR, the move
+							bool Notify, post E_MOTOR_SETTLED at the end
+Returns:			void
+Description:	Sets up a distance move for the ISR
+****************************************************************************/
+static void BeginMove(uint32_t TicksL, uint32_t TicksR, uint16_t CruiseL, uint16_t CruiseR, bool Notify) {
+	// Keep the ISR out while the move is set up
+	MoveState = MOVE_IDLE;
+	StartTicksL = GetOdometerL();
+	StartTicksR = GetOdometerR();
+	TargetTicksL = TicksL;
+	TargetTicksR = TicksR;
+	CruiseRPML = (TicksL == 0) ? 0 : CruiseL;
+	CruiseRPMR = (TicksR == 0) ? 0 : CruiseR;
+	LastTravelledL = 0;
+	LastTravelledR = 0;
+	QuietTime = 0;
+	MoveTime = 0;
+	PostWhenSettled = Notify;
+	// Start the first update on the next interrupt at cruise speed
+	Divider = POSITION_LOOP_DIVIDER;
+	CommandRPML = CruiseRPML;
+	CommandRPMR = CruiseRPMR;
+	MoveState = MOVE_RUNNING;
+}
+
+/****************************************************************************
+Function:			WheelCommand
+Parameters:		int32_t Remaining, ticks left for the wheel
+							int32_t WheelRPM, how fast the wheel is turning
+							int32_t CommandRPM, the wheel's last RPM target
+							int32_t CruiseRPM, the wheel's speed away from the target
+Returns:			int32_t, the RPM target for the wheel
+Description:	Cruise, capped at the speed the wheel can still stop from in
+							the ticks it will have left when the next update comes round
+****************************************************************************/
+static int32_t WheelCommand(int32_t Remaining, int32_t WheelRPM, int32_t CommandRPM, int32_t CruiseRPM) {
+	if (Remaining <= 0 || CruiseRPM == 0) return 0;
+	// The wheel lags its falling target, so look ahead at whichever is faster
+	int32_t Speed = (WheelRPM > CommandRPM) ? WheelRPM : CommandRPM;
+	Remaining -= Speed * PulsesPerRev * POSITION_LOOP_MS / 60000;
+	int32_t RPM = (Remaining > 0) ? GetStoppingRPM(Remaining) : 0;
+	// Too fast to stop in time, take the drive off and let it coast
+	if (WheelRPM > RPM + MIN_APPROACH_RPM) return 0;
+	if (RPM > POSITION_GAIN * Remaining) RPM = POSITION_GAIN * Remaining;
+	if (RPM > CruiseRPM) RPM = CruiseRPM;
+	if (RPM < MIN_APPROACH_RPM) RPM = (CruiseRPM < MIN_APPROACH_RPM) ? CruiseRPM : MIN_APPROACH_RPM;
+	return RPM;
+}
+
+/****************************************************************************
+Function:			Settle
+Parameters:		uint16_t Result, MOVE_ARRIVED or MOVE_STALLED
+Returns:			void
+Description:	Ends the move and lets the DriveMotorsService know
+****************************************************************************/
+static void Settle(uint16_t Result) {
+	MoveResult = Result;
+	MoveState = MOVE_HOLDING;
+	if (PostWhenSettled) {
+		ES_Event Event = {E_MOTOR_SETTLED, Result};
+		PostDriveMotorsService(Event);
+	}
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
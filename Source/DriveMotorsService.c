@@ -19,6 +19,8 @@ Author: Kyle Moy, 2/22/15
 #include "DriveMotorsService.h"
 #include "SM_Master.h"
 #include "DriveMotorPID.h"
+#include "DriveMotorsPosition.h"
+#include "Display.h"
 
 
 /*---------------------------- Module Variables ---------------------------*/
@@ -102,13 +104,37 @@ ES_Event RunDriveMotorsService(ES_Event ThisEvent) {
 //			break;
 			
 			
-		case E_MOTOR_TICK_TIMEOUT:
-			printf("E_MOTOR_TICK_TIMEOUT\r\n");
+		// A distance move has come to rest, the state machines treat it
+		// like the end of a timed move
+		case E_MOTOR_SETTLED:
+			if (DisplayMotorInfo) printf("E_MOTOR_SETTLED, %s\r\n", \
+				(ThisEvent.EventParam == MOVE_STALLED) ? "stalled" : "arrived");
 			StopMotors();
 			Event.EventType = E_MOTOR_TIMEOUT;
+			Event.EventParam = ThisEvent.EventParam;
 			PostMasterSM(Event);
 			break;
 		
+		// A maneuver has run all its steps, pass it on to the state machines
+		case E_MOTION_SEQUENCE_DONE:
+			if (DisplayMotorInfo) printf("E_MOTION_SEQUENCE_DONE, %s\r\n", \
+				(ThisEvent.EventParam == MOVE_STALLED) ? "stalled" : "arrived");
+			StopMotors();
+			PostMasterSM(ThisEvent);
+			break;
+		
+		// The relay autotune has finished with the wheels, the gains are
+		// worked out here rather than in the ISR
+		case E_PID_AUTOTUNE_DONE:
+			StopMotors();
+			FinishPIDAutotune();
+			break;
+		
+		case E_FEEDFORWARD_CAL_DONE:
+			StopMotors();
+			FinishFeedforwardCalibration();
+			break;
+		
 		default:
 			break;
 	}
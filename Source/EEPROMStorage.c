@@ -0,0 +1,215 @@
+/****************************************************************************
+Module: EEPROMStorage.c
+Description:
+	Records kept in the TM4C's 2KB EEPROM (32 blocks of 16 words), so
+	tuned settings survive a power cycle instead of living in #defines.
+	A record starts at the first word of its slot's block with a two word
+	header, then its data a word at a time:
+		Word 0: EEPROM_MAGIC in the top half, the record's version below
+		Word 1: the data length in bytes on top, its CRC-16 below
+	A record only reads back if the magic, version and length all match
+	what the caller expects and the CRC checks out, so a blank EEPROM, a
+	record from older firmware or a write cut short by a reset are all
+	just "not there" and the caller carries on with its defaults. Bump a
+	record's version whenever its layout changes.
+	The header is cleared before the data is rewritten and put back last.
+	Blocking, a word takes the EEPROM up to a few ms to write, so keep it
+	out of the ISRs and the race.
+Author: Kyle Moy, 3/11/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Hardware Libraries
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_sysctl.h"
+#include "inc/hw_eeprom.h"
+
+// Module Libraries
+#include "EEPROMStorage.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define EEPROM_BLOCKS				32
+#define WORDS_PER_BLOCK			16
+#define HEADER_WORDS				2
+#define EEPROM_MAGIC				0x4B4DUL
+
+#define CRC_INITIAL					0xFFFF
+#define CRC_POLYNOMIAL			0x1021		// CRC-16-CCITT
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint32_t ReadWord(uint32_t Address);
+static bool WriteWord(uint32_t Address, uint32_t Word);
+static bool WaitForEEPROM(void);
+static uint8_t ReadByte(uint32_t Address, uint16_t Index);
+static uint16_t UpdateCRC16(uint16_t CRC, uint8_t Byte);
+static bool FitsInEEPROM(uint8_t Slot, uint16_t Length);
+
+/*---------------------------- Module Variables ---------------------------*/
+static bool EEPROMReady = false;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			InitializeEEPROMStorage
+Parameters:		void
+Returns:			bool, false if the EEPROM didn't come up
+Description:	Turns the EEPROM on and checks it finished its power up
+****************************************************************************/
+bool InitializeEEPROMStorage(void) {
+	HWREG(SYSCTL_RCGCEEPROM) |= SYSCTL_RCGCEEPROM_R0;
+	while ((HWREG(SYSCTL_PREEPROM) & SYSCTL_PREEPROM_R0) == 0)
+		;
+
+	// The EEPROM finishes off any write a reset interrupted before it's
+	// ready, and flags it in EESUPP if it couldn't
+	EEPROMReady = WaitForEEPROM() && \
+		((HWREG(EEPROM_EESUPP) & (EEPROM_EESUPP_PRETRY | EEPROM_EESUPP_ERETRY)) == 0);
+	if (!EEPROMReady) printf("EEPROM: failed to start, settings won't be kept\r\n");
+	return EEPROMReady;
+}
+
+/****************************************************************************
+Function:			ReadEEPROMRecord
+Parameters:		uint8_t Slot, the record's EEPROM_SLOT_
+							uint16_t Version, the layout the caller expects
+							void *Data, uint16_t Length, where the record goes
+Returns:			bool, true if a good record was read into Data
+Description:	Data is left alone unless the whole record checks out
+****************************************************************************/
+bool ReadEEPROMRecord(uint8_t Slot, uint16_t Version, void *Data, uint16_t Length) {
+	if (!EEPROMReady || !FitsInEEPROM(Slot, Length)) return false;
+	uint32_t Address = Slot * WORDS_PER_BLOCK;
+
+	uint32_t Header = ReadWord(Address);
+	uint32_t Check = ReadWord(Address + 1);
+	if (Header != ((EEPROM_MAGIC << 16) | Version)) return false;
+	if ((Check >> 16) != Length) return false;
+
+	// Check the CRC before touching Data, then read it again into Data
+	uint16_t CRC = CRC_INITIAL;
+	for (uint16_t i = 0; i < Length; i++) {
+		CRC = UpdateCRC16(CRC, ReadByte(Address, i));
+	}
+	if (CRC != (Check & 0xFFFF)) return false;
+	for (uint16_t i = 0; i < Length; i++) {
+		((uint8_t *)Data)[i] = ReadByte(Address, i);
+	}
+	return true;
+}
+
+/****************************************************************************
+Function:			WriteEEPROMRecord
+Parameters:		uint8_t Slot, the record's EEPROM_SLOT_
+							uint16_t Version, the record's layout
+							const void *Data, uint16_t Length, the record
+Returns:			bool, true if the record was written
+Description:	Writes a record, blocks until the EEPROM is done
+****************************************************************************/
+bool WriteEEPROMRecord(uint8_t Slot, uint16_t Version, const void *Data, uint16_t Length) {
+	if (!EEPROMReady || !FitsInEEPROM(Slot, Length)) return false;
+	uint32_t Address = Slot * WORDS_PER_BLOCK;
+	const uint8_t *Bytes = Data;
+
+	// Invalidate the old record first, a reset part way through then
+	// leaves no record rather than a mix of old and new
+	if (!WriteWord(Address, 0)) return false;
+	uint16_t CRC = CRC_INITIAL;
+	for (uint16_t i = 0; i < Length; i += 4) {
+		uint32_t Word = 0;
+		for (uint8_t j = 0; j < 4 && i + j < Length; j++) {
+			Word |= (uint32_t)Bytes[i + j] << (8 * j);
+			CRC = UpdateCRC16(CRC, Bytes[i + j]);
+		}
+		if (!WriteWord(Address + HEADER_WORDS + i / 4, Word)) return false;
+	}
+	if (!WriteWord(Address + 1, ((uint32_t)Length << 16) | CRC)) return false;
+	return WriteWord(Address, (EEPROM_MAGIC << 16) | Version);
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ReadWord
+Parameters:		uint32_t Address, the word's index from the start of the EEPROM
+Returns:			uint32_t, the word
+Description:	The offset register only counts within a block, so the block
+							is set for every word
+****************************************************************************/
+static uint32_t ReadWord(uint32_t Address) {
+	HWREG(EEPROM_EEBLOCK) = Address / WORDS_PER_BLOCK;
+	HWREG(EEPROM_EEOFFSET) = Address % WORDS_PER_BLOCK;
+	return HWREG(EEPROM_EERDWR);
+}
+
+/****************************************************************************
+Function:			WriteWord
+Parameters:		uint32_t Address, the word's index from the start of the EEPROM
+							uint32_t Word, what to write there
+Returns:			bool, false if the EEPROM reported an error
+Description:	Writes a word, skipping it if it's already there to save wear
+****************************************************************************/
+static bool WriteWord(uint32_t Address, uint32_t Word) {
+	if (ReadWord(Address) == Word) return true;
+	HWREG(EEPROM_EERDWR) = Word;
+	return WaitForEEPROM();
+}
+
+/****************************************************************************
+Function:			WaitForEEPROM
+Parameters:		void
+Returns:			bool, false if the last operation failed
+Description:	Waits for the EEPROM to finish what it's doing
+****************************************************************************/
+static bool WaitForEEPROM(void) {
+	uint32_t Done;
+	while ((Done = HWREG(EEPROM_EEDONE)) & EEPROM_EEDONE_WORKING)
+		;
+	return (Done & (EEPROM_EEDONE_WRBUSY | EEPROM_EEDONE_NOPERM | EEPROM_EEDONE_INVPL)) == 0;
+}
+
+/****************************************************************************
+Function:			ReadByte
+Parameters:		uint32_t Address, the record's first word
+							uint16_t Index, the byte of the record's data
+Returns:			uint8_t, the byte
+Description:	Data is packed little endian, four bytes to a word
+****************************************************************************/
+static uint8_t ReadByte(uint32_t Address, uint16_t Index) {
+	return ReadWord(Address + HEADER_WORDS + Index / 4) >> (8 * (Index % 4));
+}
+
+/****************************************************************************
+Function:			UpdateCRC16
+Parameters:		uint16_t CRC, the CRC so far, CRC_INITIAL to start
+							uint8_t Byte, the next byte
+Returns:			uint16_t, the CRC-16-CCITT including Byte
+Description:	Bit at a time, the records are short and rarely read
+****************************************************************************/
+static uint16_t UpdateCRC16(uint16_t CRC, uint8_t Byte) {
+	CRC ^= (uint16_t)Byte << 8;
+	for (uint8_t Bit = 0; Bit < 8; Bit++) {
+		CRC = (CRC & 0x8000) ? (CRC << 1) ^ CRC_POLYNOMIAL : CRC << 1;
+	}
+	return CRC;
+}
+
+/****************************************************************************
+Function:			FitsInEEPROM
+Parameters:		uint8_t Slot, uint16_t Length, the record
+Returns:			bool, true if the record doesn't run off the end
+Description:	Checks a record's slot and length
+****************************************************************************/
+static bool FitsInEEPROM(uint8_t Slot, uint16_t Length) {
+	uint32_t Words = HEADER_WORDS + (Length + 3) / 4;
+	return (uint32_t)Slot * WORDS_PER_BLOCK + Words <= EEPROM_BLOCKS * WORDS_PER_BLOCK;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -17,12 +17,16 @@
  -------------- ---     --------
  08/13/13 12:42 jec     moved the hardware specific aspects of the timer here
  08/06/13 13:17 jec     Began moving the stuff from the V2 framework files
+ 03/15/15       km      added _HW_DelayTick
+ 03/15/15       km      added the host keyboard, _HW_PushKey
+ 03/05/15       km      added the HOST_SIM virtual clock port
  03/05/14 13:20	joa		Began port for TM4C123G
  03/13/14 10:30	joa		Updated files to use with Cortex M4 processor core.
  	 	 	 	 	 	Specifically, this was tested on a TI TM4C123G mcu.
 ****************************************************************************/
 #include <stdint.h>
 #include <stdbool.h>
+#ifndef HOST_SIM
 #include "inc/hw_memmap.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
@@ -31,6 +35,7 @@
 #include "driverlib/systick.h"
 #include "driverlib/gpio.h"
 #include "utils/uartstdio.h"
+#endif
 #include "ES_Port.h"
 #include "ES_Types.h"
 #include "ES_Timers.h"
@@ -54,6 +59,20 @@ static volatile uint8_t TickCount;
 // 8 and 16 bit processors
 static volatile uint16_t SysTickCounter = 0;
 
+#ifdef HOST_SIM
+// Virtual time advanced on each pass of the framework loop
+#define HOST_US_PER_PASS	100
+static uint32_t HostMicros = 0;
+static uint32_t HostTickPeriodUS = 0;
+static uint32_t HostNextTickUS = 0;
+static uint32_t HostTickDelayUS = 0;
+static HostStepHook_t HostStepHook = 0;
+static bool HostKeyReady = false;
+static char HostKey;
+#endif
+
+#ifndef HOST_SIM
+
 /****************************************************************************
  Function
      _HW_Timer_Init
@@ -79,6 +98,7 @@ void _HW_Timer_Init(TimerRate_t Rate)
 	IntMasterEnable();				/* Make sure interrupts are enabled */
 
 }
+#endif
 
 /****************************************************************************
  Function
@@ -148,6 +168,7 @@ uint16_t _HW_GetTickCount(void)
  Author
      J. Edward Carryer, 08/13/13 13:27
 ****************************************************************************/
+#ifndef HOST_SIM
 bool _HW_Process_Pending_Ints( void )
 {
    while (TickCount > 0)
@@ -158,6 +179,7 @@ bool _HW_Process_Pending_Ints( void )
    }
    return true; // always return true to allow loop test in ES_Run to proceed
 }
+#endif
 
 /****************************************************************************
  Function
@@ -173,6 +195,7 @@ bool _HW_Process_Pending_Ints( void )
  Author
      John Alabi, 03/05/14 15:07
  ****************************************************************************/
+#ifndef HOST_SIM
 void ConsoleInit(void)
 {
 	// Enable designated port that will be used for the UART
@@ -193,6 +216,7 @@ void ConsoleInit(void)
 	UARTStdioConfig(UART_PORT, UART_BAUD, SRC_CLK_FREQ);
 
 }
+#endif
 
 
 
@@ -273,3 +297,84 @@ inline void CPUsetFAULTMASK(uint32_t newFAULTMASK)
   }
 }
 #endif
+
+#ifdef HOST_SIM
+/****************************************************************************
+ Host simulation port
+
+ Replaces SysTick with a virtual clock so the framework, and the services
+ under test, can run on a PC against the simulators in Host/. Time advances
+ HOST_US_PER_PASS on every call to _HW_Process_Pending_Ints, which ES_Run
+ makes on every pass of its loop, so a run is deterministic for a given
+ sequence of events.
+****************************************************************************/
+void _HW_Timer_Init(TimerRate_t Rate)
+{
+  // Rate is in 40MHz clocks - 1, convert to microseconds
+  HostTickPeriodUS = (Rate + 1) / 40;
+  HostNextTickUS = HostMicros + HostTickPeriodUS;
+}
+
+bool _HW_Process_Pending_Ints( void )
+{
+  HostMicros += HOST_US_PER_PASS;
+  if ((HostTickPeriodUS != 0) && \
+      ((int32_t)(HostMicros - HostNextTickUS - HostTickDelayUS) >= 0))
+  {
+    // Ticks that came due while this one was held off are lost
+    do
+    {
+      HostNextTickUS += HostTickPeriodUS;
+    } while ((int32_t)(HostMicros - HostNextTickUS) >= 0);
+    HostTickDelayUS = 0;
+    SysTickIntHandler();
+  }
+  // Let the simulators raise any interrupts that are now due
+  if (HostStepHook != 0)
+  {
+    HostStepHook(HostMicros);
+  }
+  while (TickCount > 0)
+  {
+    ES_Timer_Tick_Resp();
+    TickCount--;
+  }
+  return true;
+}
+
+uint32_t _HW_GetMicros(void)
+{
+  return HostMicros;
+}
+
+void _HW_SetStepHook(HostStepHook_t Hook)
+{
+  HostStepHook = Hook;
+}
+
+void _HW_DelayTick(uint32_t DelayUS)
+{
+  HostTickDelayUS = DelayUS;
+}
+
+void _HW_PushKey(char Key)
+{
+  HostKey = Key;
+  HostKeyReady = true;
+}
+
+bool _HW_IsNewKeyReady(void)
+{
+  return HostKeyReady;
+}
+
+char _HW_GetNewKey(void)
+{
+  HostKeyReady = false;
+  return HostKey;
+}
+
+void ConsoleInit(void)
+{
+}
+#endif
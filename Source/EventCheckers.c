@@ -13,6 +13,7 @@ Author: Kyle Moy, 2/18/15
 #include "EventCheckers.h"
 #include "BumpSensor.h"
 #include "BeaconSensor.h"
+#include "InputRecorder.h"
 
 
 /*------------------------------ Module Code ------------------------------*/
@@ -34,8 +35,10 @@ bool Check4Keystroke(void) {
   if (IsNewKeyReady()) // New key waiting?
   {
     ES_Event ThisEvent;
+    uint8_t Key = GetNewKey();
+    RecordInput(INPUT_KEY, &Key);
     ThisEvent.EventType = ES_NEW_KEY;
-    ThisEvent.EventParam = GetNewKey();
+    ThisEvent.EventParam = Key;
     PostMapKeys( ThisEvent );
     return true;
   }
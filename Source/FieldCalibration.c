@@ -0,0 +1,255 @@
+/****************************************************************************
+Module: FieldCalibration.c
+Description:
+	Measures the gamefield's geometry on race day, instead of a rebuild
+	and reflash to change the bounds in GamefieldPositions.h. 'E' starts
+	it, then for each reference point (FieldPoint_t) the Kart is put on
+	the point and 'H' pressed, and the next FIELD_CAL_FRAMES DRS frames of
+	our Kart are averaged for where it is.
+	The four inside corners give the island's edges, which are the
+	straights' bounds. The corners' bounds keep the margins the defaults
+	have from the straights', so they move with the island, and the
+	divider and the middles of the straights give the rest. A geometry
+	that comes out the wrong way round is thrown away, otherwise it is
+	used from then on and kept in the EEPROM, which InitializeFieldCalibration
+	loads it from at power up. 'Q' goes back to the defaults.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Module Libraries
+#include "FieldCalibration.h"
+#include "GamefieldPositions.h"
+#include "EEPROMStorage.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// Bump when FieldGeometry_t changes
+#define FIELD_GEOMETRY_VERSION	1
+
+// Where a bound may be, the DRS's units
+#define FIELD_MAX_UNITS					255
+
+typedef enum {
+	FIELD_CAL_IDLE,
+	FIELD_CAL_WAITING,					// For 'H' at the next point
+	FIELD_CAL_SAMPLING					// Averaging the DRS frames
+} FieldCalState_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void PromptFieldPoint(void);
+static bool DeriveFieldGeometry(FieldGeometry_t *Geometry);
+static bool SetBound(uint16_t *Bound, int32_t Value);
+static void SaveFieldGeometry(const FieldGeometry_t *Geometry);
+
+/*---------------------------- Module Variables ---------------------------*/
+static FieldCalState_t State = FIELD_CAL_IDLE;
+static FieldPoint_t CurrentPoint;
+static uint8_t Frames;
+static uint32_t SumX, SumY;
+// Where each reference point was seen
+static uint16_t PointX[NUM_FIELD_POINTS];
+static uint16_t PointY[NUM_FIELD_POINTS];
+
+static const char *PointNames[NUM_FIELD_POINTS] = {
+	"the inside corner of Corner1",
+	"the inside corner of Corner2",
+	"the inside corner of Corner3",
+	"the inside corner of Corner4",
+	"the line between the ball launching and obstacle areas",
+	"the middle of Straight2",
+	"the middle of Straight3"
+};
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			InitializeFieldCalibration
+Parameters:		void
+Returns:			void
+Description:	Looks the zones up by the last calibration, if the EEPROM has
+							one, after InitializeEEPROMStorage
+****************************************************************************/
+void InitializeFieldCalibration(void) {
+	FieldGeometry_t Geometry;
+	if (ReadEEPROMRecord(EEPROM_SLOT_FIELD_GEOMETRY, FIELD_GEOMETRY_VERSION, &Geometry, sizeof(Geometry))) {
+		SetFieldGeometry(&Geometry);
+		printf("Field: calibrated geometry loaded\r\n");
+	}
+}
+
+/****************************************************************************
+Function:			StartFieldCalibration
+Parameters:		void
+Returns:			void
+Description:	Starts over at the first reference point
+****************************************************************************/
+void StartFieldCalibration(void) {
+	CurrentPoint = FIELD_POINT_CORNER1;
+	State = FIELD_CAL_WAITING;
+	printf("Field: calibrating, %d points\r\n", NUM_FIELD_POINTS);
+	PromptFieldPoint();
+}
+
+/****************************************************************************
+Function:			MarkFieldPoint
+Parameters:		void
+Returns:			void
+Description:	The Kart is on the current point, average where the DRS sees it
+****************************************************************************/
+void MarkFieldPoint(void) {
+	if (State != FIELD_CAL_WAITING) {
+		printf("Field: not waiting for a point, 'E' to calibrate\r\n");
+		return;
+	}
+	Frames = 0;
+	SumX = 0;
+	SumY = 0;
+	State = FIELD_CAL_SAMPLING;
+}
+
+/****************************************************************************
+Function:			RecordFieldCalibrationPose
+Parameters:		uint16_t X, uint16_t Y, our Kart in a new DRS frame
+Returns:			void
+Description:	Called from StoreData for our Kart's frames, takes them while
+							sampling a point and moves on to the next once it has enough
+****************************************************************************/
+void RecordFieldCalibrationPose(uint16_t X, uint16_t Y) {
+	if (State != FIELD_CAL_SAMPLING) return;
+	SumX += X;
+	SumY += Y;
+	if (++Frames < FIELD_CAL_FRAMES) return;
+
+	PointX[CurrentPoint] = (SumX + FIELD_CAL_FRAMES / 2) / FIELD_CAL_FRAMES;
+	PointY[CurrentPoint] = (SumY + FIELD_CAL_FRAMES / 2) / FIELD_CAL_FRAMES;
+	printf("Field: %s at X = %d, Y = %d\r\n", PointNames[CurrentPoint], PointX[CurrentPoint], PointY[CurrentPoint]);
+	if (++CurrentPoint < NUM_FIELD_POINTS) {
+		State = FIELD_CAL_WAITING;
+		PromptFieldPoint();
+		return;
+	}
+
+	State = FIELD_CAL_IDLE;
+	FieldGeometry_t Geometry;
+	if (!DeriveFieldGeometry(&Geometry)) {
+		printf("Field: the points don't make a gamefield, keeping the old geometry\r\n");
+		return;
+	}
+	SetFieldGeometry(&Geometry);
+	SaveFieldGeometry(&Geometry);
+	PrintFieldGeometry();
+}
+
+/****************************************************************************
+Function:			ClearFieldCalibration
+Parameters:		void
+Returns:			void
+Description:	Back to the default geometry, and keeps that in the EEPROM
+****************************************************************************/
+void ClearFieldCalibration(void) {
+	const FieldGeometry_t Defaults = FIELD_GEOMETRY_DEFAULTS;
+	State = FIELD_CAL_IDLE;
+	SetFieldGeometry(&Defaults);
+	SaveFieldGeometry(&Defaults);
+	printf("Field: back to the default geometry\r\n");
+}
+
+/****************************************************************************
+Function:			PrintFieldGeometry
+Parameters:		void
+Returns:			void
+Description:	Prints the bounds the zones are looked up by
+****************************************************************************/
+void PrintFieldGeometry(void) {
+	const FieldGeometry_t *Geometry = GetFieldGeometry();
+	printf("Field: Corner1 X < %d, Y < %d, Corner2 X < %d, Y > %d, Corner3 X > %d, Y > %d, Corner4 X > %d, Y < %d\r\n", \
+		Geometry->Corner1X, Geometry->Corner1Y, Geometry->Corner2X, Geometry->Corner2Y, \
+		Geometry->Corner3X, Geometry->Corner3Y, Geometry->Corner4X, Geometry->Corner4Y);
+	printf("Field: Straight1 Y < %d, Straight2 X < %d, Straight3 Y > %d, Straight4 X > %d, ball launching X < %d\r\n", \
+		Geometry->Straight1Y, Geometry->Straight2X, Geometry->Straight3Y, Geometry->Straight4X, \
+		Geometry->BallLaunchingObstacleX);
+	printf("Field: Straight2 center Y = %d, Straight3 center X = %d\r\n", \
+		Geometry->Straight2MidY, Geometry->Straight3MidX);
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			PromptFieldPoint
+Parameters:		void
+Returns:			void
+Description:	Says where to put the Kart next
+****************************************************************************/
+static void PromptFieldPoint(void) {
+	printf("Field: put the Kart on %s and press 'H'\r\n", PointNames[CurrentPoint]);
+}
+
+/****************************************************************************
+Function:			DeriveFieldGeometry
+Parameters:		FieldGeometry_t *Geometry, filled in from the points
+Returns:			bool, false if the points are the wrong way round or off
+							the gamefield
+Description:	Works the bounds out from where the reference points were seen
+****************************************************************************/
+static bool DeriveFieldGeometry(FieldGeometry_t *Geometry) {
+	// The island's edges, rounded to the nearest unit
+	int32_t Left = (PointX[FIELD_POINT_CORNER1] + PointX[FIELD_POINT_CORNER2] + 1) / 2;
+	int32_t Right = (PointX[FIELD_POINT_CORNER3] + PointX[FIELD_POINT_CORNER4] + 1) / 2;
+	int32_t Bottom = (PointY[FIELD_POINT_CORNER1] + PointY[FIELD_POINT_CORNER4] + 1) / 2;
+	int32_t Top = (PointY[FIELD_POINT_CORNER2] + PointY[FIELD_POINT_CORNER3] + 1) / 2;
+	int32_t Divider = PointX[FIELD_POINT_DIVIDER];
+	int32_t Straight2Mid = PointY[FIELD_POINT_STRAIGHT2_MID];
+	int32_t Straight3Mid = PointX[FIELD_POINT_STRAIGHT3_MID];
+	if (Left >= Divider || Divider >= Right || Bottom >= Top || \
+		Straight2Mid <= Bottom || Straight2Mid >= Top || Straight3Mid <= Left || Straight3Mid >= Right) {
+		return false;
+	}
+
+	return SetBound(&Geometry->Straight1Y, Bottom) && \
+		SetBound(&Geometry->Straight2X, Left) && \
+		SetBound(&Geometry->Straight3Y, Top) && \
+		SetBound(&Geometry->Straight4X, Right) && \
+		SetBound(&Geometry->Corner1X, Left + (Corner1XBound - Straight2XBound)) && \
+		SetBound(&Geometry->Corner1Y, Bottom + (Corner1YBound - Straight1YBound)) && \
+		SetBound(&Geometry->Corner2X, Left + (Corner2XBound - Straight2XBound)) && \
+		SetBound(&Geometry->Corner2Y, Top + (Corner2YBound - Straight3YBound)) && \
+		SetBound(&Geometry->Corner3X, Right + (Corner3XBound - Straight4XBound)) && \
+		SetBound(&Geometry->Corner3Y, Top + (Corner3YBound - Straight3YBound)) && \
+		SetBound(&Geometry->Corner4X, Right + (Corner4XBound - Straight4XBound)) && \
+		SetBound(&Geometry->Corner4Y, Bottom + (Corner4YBound - Straight1YBound)) && \
+		SetBound(&Geometry->BallLaunchingObstacleX, Divider) && \
+		SetBound(&Geometry->Straight2MidY, Straight2Mid) && \
+		SetBound(&Geometry->Straight3MidX, Straight3Mid);
+}
+
+/****************************************************************************
+Function:			SetBound
+Parameters:		uint16_t *Bound, to set
+							int32_t Value
+Returns:			bool, false if Value is off the gamefield
+Description:	Sets a bound that is on the gamefield
+****************************************************************************/
+static bool SetBound(uint16_t *Bound, int32_t Value) {
+	if (Value <= 0 || Value >= FIELD_MAX_UNITS) return false;
+	*Bound = Value;
+	return true;
+}
+
+/****************************************************************************
+Function:			SaveFieldGeometry
+Parameters:		const FieldGeometry_t *Geometry
+Returns:			void
+Description:	Keeps the geometry in the EEPROM for the next power up
+****************************************************************************/
+static void SaveFieldGeometry(const FieldGeometry_t *Geometry) {
+	if (!WriteEEPROMRecord(EEPROM_SLOT_FIELD_GEOMETRY, FIELD_GEOMETRY_VERSION, Geometry, sizeof(*Geometry))) {
+		printf("Field: couldn't save the geometry\r\n");
+	}
+}
+
+/*------------------------------ End of file ------------------------------*/
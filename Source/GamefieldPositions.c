@@ -4,17 +4,35 @@ Description: This module defines the ten zones of the gamefield:
 						 Straight1, Corner1, Straight2, Corner2,
 						 Straight3, Corner3, Straight4, Corner4,
 						 BallShootingZone, and ObstacleZone
+						 A point's zone is looked up in a grid of the gamefield, the
+						 zone of each cell packed two to a byte in flash
+						 (GamefieldZoneTable.h). Only the cells a bound crosses, and
+						 points off the grid, go through the bounds. The bounds are
+						 the defaults in GamefieldPositions.h until the gamefield is
+						 calibrated, when the grid is built again in RAM.
 Author: Kyle Moy, 2/21/15
 ****************************************************************************/
 
 /*----------------------------- Include Files -----------------------------*/
 #include <math.h>
+#include <string.h>
 #include "GamefieldPositions.h"
+#include "GamefieldZoneTable.h"
 
 
 /*----------------------------- Module Defines ----------------------------*/
 #define PI 3.14159265
 
+/*---------------------------- Module Functions ---------------------------*/
+static void BuildZoneTable(uint8_t *Table);
+
+/*---------------------------- Module Variables ---------------------------*/
+static const FieldGeometry_t DefaultGeometry = FIELD_GEOMETRY_DEFAULTS;
+static FieldGeometry_t Geometry = FIELD_GEOMETRY_DEFAULTS;
+// The grid for Geometry, the one in flash for the defaults
+static const uint8_t *ZoneTable = GamefieldZoneTable;
+static uint8_t CalibratedZoneTable[ZONE_TABLE_BYTES];
+
 /*------------------------------ Module Code ------------------------------*/
 
 /****************************************************************************
@@ -22,43 +40,89 @@ Function: 		GetGamefieldPosition
 Parameters:		uint8_t Xcoord, the X coordinate
 						  uint8_t Ycoord, the Y coordinate
 Returns:			GamefieldPosition_t, the gamefield position the point is in
-Description:	Return the gamefield position that a point is in
+Description:	Return the gamefield position that a point is in, from the
+							zone grid
 ****************************************************************************/
 GamefieldPosition_t GetGamefieldPosition(uint16_t Xcoord, uint16_t Ycoord) {
+	if (Xcoord < 256 && Ycoord < 256) {
+		uint16_t Cell = (Ycoord >> ZONE_CELL_SHIFT) * ZONE_GRID_CELLS + (Xcoord >> ZONE_CELL_SHIFT);
+		uint8_t Zone = (ZoneTable[Cell >> 1] >> ((Cell & 1) << 2)) & 0x0F;
+		if (Zone != ZONE_SPLIT)
+			return (GamefieldPosition_t)Zone;
+	}
+	return GetGamefieldPositionByBounds(Xcoord, Ycoord);
+}
+
+/****************************************************************************
+Function: 		GetGamefieldPositionByBounds
+Parameters:		uint8_t Xcoord, the X coordinate
+						  uint8_t Ycoord, the Y coordinate
+Returns:			GamefieldPosition_t, the gamefield position the point is in
+Description:	Return the gamefield position that a point is in, by the
+							bounding lines
+****************************************************************************/
+GamefieldPosition_t GetGamefieldPositionByBounds(uint16_t Xcoord, uint16_t Ycoord) {
 	if (Xcoord == 0 && Ycoord == 0)
 		return Undefined;
 	
-	else if (Xcoord < (Corner1XBound) && Ycoord < (Corner1YBound))
+	else if (Xcoord < Geometry.Corner1X && Ycoord < Geometry.Corner1Y)
 		return Corner1;
 	
-	else if (Xcoord < (Corner2XBound) && Ycoord > (Corner2YBound))
+	else if (Xcoord < Geometry.Corner2X && Ycoord > Geometry.Corner2Y)
 		return Corner2;
 	
-	else if (Xcoord > (Corner3XBound) && Ycoord > (Corner3YBound))
+	else if (Xcoord > Geometry.Corner3X && Ycoord > Geometry.Corner3Y)
 		return Corner3;
 	
-	else if (Xcoord > (Corner4XBound) && Ycoord < (Corner4YBound))
+	else if (Xcoord > Geometry.Corner4X && Ycoord < Geometry.Corner4Y)
 		return Corner4;
 	
-	else if (Xcoord < Straight2XBound)
+	else if (Xcoord < Geometry.Straight2X)
 		return Straight2;
 	
-	else if (Xcoord > Straight4XBound)
+	else if (Xcoord > Geometry.Straight4X)
 		return Straight4;
 	
-	else if (Ycoord < Straight1YBound)
+	else if (Ycoord < Geometry.Straight1Y)
 		return Straight1;
 	
-	else if (Ycoord > Straight3YBound)
+	else if (Ycoord > Geometry.Straight3Y)
 		return Straight3;
 	
-	else if (Xcoord < BallLaunchingObstacleBound)
+	else if (Xcoord < Geometry.BallLaunchingObstacleX)
 		return BallLaunchingArea;
 	
 	else
 		return ObstacleCrossingArea;
 }
 
+/****************************************************************************
+Function: 		GetFieldGeometry
+Parameters:		void
+Returns:			const FieldGeometry_t *, the bounds the zones are looked up by
+Description:	Return the gamefield's geometry
+****************************************************************************/
+const FieldGeometry_t *GetFieldGeometry(void) {
+	return &Geometry;
+}
+
+/****************************************************************************
+Function: 		SetFieldGeometry
+Parameters:		const FieldGeometry_t *NewGeometry
+Returns:			void
+Description:	Looks the zones up by a new geometry from now on, building its
+							grid unless it is the default one
+****************************************************************************/
+void SetFieldGeometry(const FieldGeometry_t *NewGeometry) {
+	Geometry = *NewGeometry;
+	if (memcmp(&Geometry, &DefaultGeometry, sizeof(Geometry)) == 0) {
+		ZoneTable = GamefieldZoneTable;
+	} else {
+		BuildZoneTable(CalibratedZoneTable);
+		ZoneTable = CalibratedZoneTable;
+	}
+}
+
 /****************************************************************************
 Function: 		GetAngle
 Parameters:		uint8_t Xcoord, the X coordinate
@@ -93,3 +157,30 @@ const char * GamefieldPositionString(GamefieldPosition_t GamefieldPosition) {
 	}
 }
 
+/****************************************************************************
+Function: 		BuildZoneTable
+Parameters:		uint8_t *Table, ZONE_TABLE_BYTES to fill in
+Returns:			void
+Description:	Gives each cell of the grid its zone by the bounds, as
+							Host/ZoneGenMain.c does for the flash table, ZONE_SPLIT
+							if a bound crosses it. Checks every point of the gamefield,
+							a few ms, so only at startup and calibration.
+****************************************************************************/
+static void BuildZoneTable(uint8_t *Table) {
+	memset(Table, 0, ZONE_TABLE_BYTES);
+	for (uint16_t Cell = 0; Cell < ZONE_GRID_CELLS * ZONE_GRID_CELLS; Cell++) {
+		uint16_t X0 = (Cell % ZONE_GRID_CELLS) << ZONE_CELL_SHIFT;
+		uint16_t Y0 = (Cell / ZONE_GRID_CELLS) << ZONE_CELL_SHIFT;
+		uint8_t Zone = GetGamefieldPositionByBounds(X0, Y0);
+		for (uint16_t Y = Y0; Y < Y0 + (1 << ZONE_CELL_SHIFT) && Zone != ZONE_SPLIT; Y++) {
+			for (uint16_t X = X0; X < X0 + (1 << ZONE_CELL_SHIFT); X++) {
+				if (GetGamefieldPositionByBounds(X, Y) != Zone) {
+					Zone = ZONE_SPLIT;
+					break;
+				}
+			}
+		}
+		Table[Cell >> 1] |= Zone << ((Cell & 1) << 2);
+	}
+}
+
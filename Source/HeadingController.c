@@ -0,0 +1,109 @@
+/****************************************************************************
+Module: HeadingController.c
+Description:
+	Closed loop turns on the spot for SM_Navigation's ORIENTING state. It
+	used to start the Kart rotating at a fixed speed and stop the motors on
+	the first E_DRS_UPDATED within 15 degrees of the target. The DRS heading
+	is stale by the time it arrives and the Kart coasts on after the stop,
+	so it overshot, and a turn that started near the target could go all
+	the way round.
+	The heading error is taken the short way round, and the turn command is
+	a PD on it: KP on the error, less KD on the yaw rate. The yaw rate comes
+	from the encoders (GetYawRate), it's far quicker and cleaner than
+	differencing the headings, and putting the D on the measurement rather
+	than the error keeps a new target from kicking the wheels.
+	The command is a wheel RPM, both wheels run at its size in opposite
+	directions. It's in the DRS's frame, where Theta grows clockwise seen
+	from above, so positive turns the Kart clockwise (to the right) and
+	increases Theta, and the yaw rate is clockwise too, as GetYawRate
+	gives it.
+	A turn ends once the Kart is inside the tolerance and would coast to
+	rest inside it too, the coast taken as a first order decay of the yaw
+	rate. That hands on to DRIVING before the Kart has stopped, without
+	depending on the coast estimate from full speed where it's least
+	accurate. A turn also ends at its time limit, so a stuck Kart can't
+	hold up the race.
+	Hardware free, runs from the thread off the pose estimate.
+Author: Kyle Moy, 3/13/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+// Module Libraries
+#include "HeadingController.h"
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			StartHeadingController
+Parameters:		HeadingController_t *Heading, the turn
+							float TargetTheta, the heading to turn to, degrees
+							float Tolerance, how close is close enough, degrees
+							uint16_t TimeLimitMS, when to give up
+Returns:			void
+Description:	Starts a turn, the first update sets the wheels going
+****************************************************************************/
+void StartHeadingController(HeadingController_t *Heading, float TargetTheta, float Tolerance, uint16_t TimeLimitMS) {
+	Heading->TargetTheta = TargetTheta;
+	Heading->Tolerance = Tolerance;
+	Heading->TimeLimitMS = TimeLimitMS;
+	Heading->ElapsedMS = 0;
+}
+
+/****************************************************************************
+Function:			UpdateHeadingController
+Parameters:		HeadingController_t *Heading, the turn
+							float Theta, the Kart's heading now, degrees
+							float YawRate, how fast it's turning, degrees/s clockwise
+							uint16_t PeriodMS, time since the last update
+							int16_t *TurnRPM, set to the wheel RPM, + for clockwise
+Returns:			HeadingResult_t, TurnRPM is 0 unless HEADING_TURNING
+Description:	One step of the heading loop
+****************************************************************************/
+HeadingResult_t UpdateHeadingController(HeadingController_t *Heading, float Theta, float YawRate, \
+	uint16_t PeriodMS, int16_t *TurnRPM) {
+	float Error = GetHeadingError(Heading->TargetTheta, Theta);
+	*TurnRPM = 0;
+
+	// How much further the Kart would turn if the motors were cut now
+	float Coast = YawRate * HEADING_COAST_MS / 1000;
+	if (fabsf(Error) < Heading->Tolerance && fabsf(Error - Coast) < Heading->Tolerance) return HEADING_ARRIVED;
+	Heading->ElapsedMS += PeriodMS;
+	if (Heading->ElapsedMS >= Heading->TimeLimitMS) return HEADING_TIMED_OUT;
+
+	float Command = HEADING_KP * Error - HEADING_KD * YawRate;
+	if (Command > MAX_TURN_RPM) Command = MAX_TURN_RPM;
+	if (Command < -MAX_TURN_RPM) Command = -MAX_TURN_RPM;
+	// Outside the tolerance it has to keep moving, but only ever toward the
+	// target, the D term can brake it down to a stop and no further
+	if (Error > 0) {
+		if (Command < 0) Command = 0;
+		else if (Command < MIN_TURN_RPM) Command = MIN_TURN_RPM;
+	} else {
+		if (Command > 0) Command = 0;
+		else if (Command > -MIN_TURN_RPM) Command = -MIN_TURN_RPM;
+	}
+	*TurnRPM = (int16_t)Command;
+	return HEADING_TURNING;
+}
+
+/****************************************************************************
+Function:			GetHeadingError
+Parameters:		float TargetTheta, float Theta, degrees
+Returns:			float, TargetTheta - Theta the short way round, -180 to 180
+Description:	+ means the Kart has to turn clockwise, Theta up, to get there
+****************************************************************************/
+float GetHeadingError(float TargetTheta, float Theta) {
+	float Error = fmodf(TargetTheta - Theta, 360.0f);
+	if (Error >= 180.0f) Error -= 360.0f;
+	if (Error < -180.0f) Error += 360.0f;
+	return Error;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,329 @@
+/****************************************************************************
+Module: InputRecorder.c
+Description:
+	Records every input from outside the Kart with when it came in, so a
+	run can be replayed on a PC through the same ISRs and event checkers
+	(Host/ReplayMain.c) and a problem at the track seen again.
+	Each record is a byte with the type in the top nibble and the low 3 bits
+	of the microseconds since the record before, a continuation bit (3) for
+	the rest of them as a varint, then the payload. A capture's payload is
+	how many ticks its ISR came after the edge, as a varint, measured on the
+	capture's own timer, so the captures replay on any clock.
+	Recording is from InitializeInputRecorder, call it first in main. The
+	log is a ring, INPUT_LOG_WRAP chooses whether a full one drops its
+	oldest records or stops. Either way records that don't make it in are
+	counted as lost. A wrapping log is frozen by FreezeInputRecorder, from
+	'R' in MapKeys before it dumps the log and from a turn that timed out,
+	so it holds the seconds that led up to it. A gap of more than a timer wrap, 107s, between two
+	records loses the whole wraps.
+Author: Kyle Moy, 3/15/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Framework Libraries
+#include "ES_Port.h"
+
+// Module Libraries
+#include "InputRecorder.h"
+#include "HW_Port.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define TYPE_SHIFT				4
+#define MORE_BIT					0x08
+#define FIRST_BITS				3
+#define FIRST_MASK				0x07
+#define VARINT_MORE				0x80
+#define VARINT_MASK				0x7f
+#define VARINT_BITS				7
+#define BYTES_PER_LINE		32
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t EncodeRecord(uint8_t *Out, InputType_t Type, uint32_t DeltaUS, uint32_t Age, const uint8_t *Payload);
+static uint8_t PutVarint(uint8_t *Out, uint32_t Value);
+static uint8_t GetVarint(const uint8_t *Bytes, uint32_t Length, uint32_t *Value);
+static void AddRecord(InputType_t Type, uint32_t Age, const uint8_t *Payload);
+static void DropOldest(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+// Payload bytes of each type, past the capture's age
+static const uint8_t PayloadLength[NUM_INPUT_TYPES] = {8, 0, 0, 0, 1, 1, 1};
+
+static uint8_t Log[INPUT_LOG_SIZE];
+static uint32_t Head;						// Where the next record goes
+static uint32_t Tail;						// The oldest record
+static uint32_t Used;
+static uint32_t Records;
+static uint32_t Lost;
+static bool Wrapped;
+static bool Stopped = true;
+static uint32_t LastTicks;			// HW_TIMESTAMP() of the record before, to the us
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			InitializeInputRecorder
+Parameters:		void
+Returns:			void
+Description:	Empties the log and starts recording
+****************************************************************************/
+void InitializeInputRecorder(void) {
+	EnterCritical();
+	Head = 0;
+	Tail = 0;
+	Used = 0;
+	Records = 0;
+	Lost = 0;
+	Wrapped = false;
+	LastTicks = HW_TIMESTAMP();
+#ifdef RECORD_INPUTS
+	Stopped = false;
+#endif
+	ExitCritical();
+}
+
+#ifdef RECORD_INPUTS
+/****************************************************************************
+Function:			RecordCapture
+Parameters:		InputType_t Type, INPUT_ENCODER_R, INPUT_ENCODER_L or INPUT_BEACON
+							uint32_t Age, ticks from the capture to now on its timer
+Returns:			void
+Description:	Records an input capture, called from its ISR
+****************************************************************************/
+void RecordCapture(InputType_t Type, uint32_t Age) {
+	AddRecord(Type, Age, 0);
+}
+
+/****************************************************************************
+Function:			RecordInput
+Parameters:		InputType_t Type, any but the captures
+							const uint8_t *Payload, as many bytes as the type has
+Returns:			void
+Description:	Records an input, from an ISR or the event checkers
+****************************************************************************/
+void RecordInput(InputType_t Type, const uint8_t *Payload) {
+	AddRecord(Type, 0, Payload);
+}
+#endif
+
+/****************************************************************************
+Function:			StopInputRecorder
+Parameters:		void
+Returns:			void
+Description:	Stops recording, keeping the log
+****************************************************************************/
+void StopInputRecorder(void) {
+	Stopped = true;
+}
+
+/****************************************************************************
+Function:			FreezeInputRecorder
+Parameters:		void
+Returns:			void
+Description:	Something went wrong, stops a wrapping log so it keeps what led
+							up to it. A log from reset records on, it has all of that.
+****************************************************************************/
+void FreezeInputRecorder(void) {
+	if (INPUT_LOG_WRAP) Stopped = true;
+}
+
+/****************************************************************************
+Function:			GetInputLog
+Parameters:		uint8_t *Log, filled in with the log, oldest record first
+							uint32_t Length, room in it
+Returns:			uint32_t, the bytes copied
+Description:	For the host simulations, the Kart dumps it with PrintInputLog
+****************************************************************************/
+uint32_t GetInputLog(uint8_t *Out, uint32_t Length) {
+	EnterCritical();
+	uint32_t Count = (Used < Length) ? Used : Length;
+	for (uint32_t i = 0; i < Count; i++) {
+		Out[i] = Log[(Tail + i) % INPUT_LOG_SIZE];
+	}
+	ExitCritical();
+	return Count;
+}
+
+/****************************************************************************
+Function:			PrintInputLog
+Parameters:		void
+Returns:			void
+Description:	Dumps the log as hex for Host/ReplayMain.c to read back.
+							Recording is held off while it prints, anything that comes
+							in meanwhile is lost.
+****************************************************************************/
+void PrintInputLog(void) {
+	bool WasStopped = Stopped;
+	Stopped = true;
+	printf("INPUT LOG %lu bytes, %lu records, %lu lost%s\r\n", (unsigned long)Used, \
+		(unsigned long)Records, (unsigned long)Lost, Wrapped ? ", wrapped" : "");
+	for (uint32_t i = 0; i < Used; i++) {
+		printf("%02x", Log[(Tail + i) % INPUT_LOG_SIZE]);
+		if ((i % BYTES_PER_LINE) == BYTES_PER_LINE - 1 || i == Used - 1) printf("\r\n");
+	}
+	printf("END INPUT LOG\r\n");
+	Stopped = WasStopped;
+}
+
+/****************************************************************************
+Function:			DecodeInputRecord
+Parameters:		const uint8_t *Bytes, the start of a record
+							uint32_t Length, bytes left in the log
+							InputRecord_t *Record, filled in
+Returns:			uint8_t, the record's length, 0 if it is cut off or not one
+Description:	Reads one record back
+****************************************************************************/
+uint8_t DecodeInputRecord(const uint8_t *Bytes, uint32_t Length, InputRecord_t *Record) {
+	if (Length == 0) return 0;
+	uint8_t Type = Bytes[0] >> TYPE_SHIFT;
+	if (Type >= NUM_INPUT_TYPES) return 0;
+	Record->Type = (InputType_t)Type;
+	Record->DeltaUS = Bytes[0] & FIRST_MASK;
+	Record->Age = 0;
+	uint8_t Index = 1;
+
+	if (Bytes[0] & MORE_BIT) {
+		uint32_t Rest;
+		uint8_t Size = GetVarint(&Bytes[Index], Length - Index, &Rest);
+		if (Size == 0) return 0;
+		Record->DeltaUS |= Rest << FIRST_BITS;
+		Index += Size;
+	}
+	if (Type == INPUT_ENCODER_R || Type == INPUT_ENCODER_L || Type == INPUT_BEACON) {
+		uint8_t Size = GetVarint(&Bytes[Index], Length - Index, &Record->Age);
+		if (Size == 0) return 0;
+		Index += Size;
+	}
+	if (Length - Index < PayloadLength[Type]) return 0;
+	for (uint8_t i = 0; i < PayloadLength[Type]; i++) {
+		Record->Payload[i] = Bytes[Index++];
+	}
+	return Index;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			AddRecord
+Parameters:		InputType_t Type, what came in
+							uint32_t Age, the capture types
+							const uint8_t *Payload, the other types
+Returns:			void
+Description:	Timestamps the record and puts it in the log, with interrupts
+							off so the ISRs' records go in whole and in order
+****************************************************************************/
+static void AddRecord(InputType_t Type, uint32_t Age, const uint8_t *Payload) {
+	uint8_t Record[INPUT_RECORD_MAX];
+	EnterCritical();
+	if (Stopped) {
+		Lost++;
+		ExitCritical();
+		return;
+	}
+	// Whole microseconds, the remainder is carried to the next record
+	uint32_t DeltaUS = (HW_TIMESTAMP() - LastTicks) / HW_TICKS_PER_US;
+	uint8_t Length = EncodeRecord(Record, Type, DeltaUS, Age, Payload);
+
+	if (Used + Length > INPUT_LOG_SIZE) {
+		if (!INPUT_LOG_WRAP) {
+			Stopped = true;
+			Lost++;
+			ExitCritical();
+			return;
+		}
+		while (Used + Length > INPUT_LOG_SIZE) DropOldest();
+		Wrapped = true;
+	}
+	for (uint8_t i = 0; i < Length; i++) {
+		Log[Head] = Record[i];
+		Head = (Head + 1) % INPUT_LOG_SIZE;
+	}
+	Used += Length;
+	Records++;
+	LastTicks += DeltaUS * HW_TICKS_PER_US;
+	ExitCritical();
+}
+
+/****************************************************************************
+Function:			DropOldest
+Parameters:		void
+Returns:			void
+Description:	Makes room by dropping the oldest record
+****************************************************************************/
+static void DropOldest(void) {
+	uint8_t Bytes[INPUT_RECORD_MAX];
+	InputRecord_t Record;
+	uint8_t Count = (Used < INPUT_RECORD_MAX) ? Used : INPUT_RECORD_MAX;
+	for (uint8_t i = 0; i < Count; i++) {
+		Bytes[i] = Log[(Tail + i) % INPUT_LOG_SIZE];
+	}
+	uint8_t Length = DecodeInputRecord(Bytes, Count, &Record);
+	if (Length == 0) Length = Used;
+	Tail = (Tail + Length) % INPUT_LOG_SIZE;
+	Used -= Length;
+	Records--;
+}
+
+/****************************************************************************
+Function:			EncodeRecord
+Parameters:		uint8_t *Out, room for INPUT_RECORD_MAX bytes
+							InputType_t Type, uint32_t DeltaUS, uint32_t Age,
+							const uint8_t *Payload, the record
+Returns:			uint8_t, its length
+Description:	Packs a record, see the top of the file
+****************************************************************************/
+static uint8_t EncodeRecord(uint8_t *Out, InputType_t Type, uint32_t DeltaUS, uint32_t Age, const uint8_t *Payload) {
+	uint8_t Index = 1;
+	Out[0] = (Type << TYPE_SHIFT) | (DeltaUS & FIRST_MASK);
+	if (DeltaUS >> FIRST_BITS) {
+		Out[0] |= MORE_BIT;
+		Index += PutVarint(&Out[Index], DeltaUS >> FIRST_BITS);
+	}
+	if (Type == INPUT_ENCODER_R || Type == INPUT_ENCODER_L || Type == INPUT_BEACON) {
+		Index += PutVarint(&Out[Index], Age);
+	}
+	for (uint8_t i = 0; i < PayloadLength[Type]; i++) {
+		Out[Index++] = Payload[i];
+	}
+	return Index;
+}
+
+/****************************************************************************
+Function:			PutVarint
+Parameters:		uint8_t *Out, room for 5 bytes
+							uint32_t Value
+Returns:			uint8_t, the bytes written
+Description:	7 bits a byte, least significant first, the top bit set on
+							all but the last
+****************************************************************************/
+static uint8_t PutVarint(uint8_t *Out, uint32_t Value) {
+	uint8_t Index = 0;
+	while (Value > VARINT_MASK) {
+		Out[Index++] = (Value & VARINT_MASK) | VARINT_MORE;
+		Value >>= VARINT_BITS;
+	}
+	Out[Index++] = Value;
+	return Index;
+}
+
+/****************************************************************************
+Function:			GetVarint
+Parameters:		const uint8_t *Bytes, uint32_t Length, where to read it
+							uint32_t *Value, filled in
+Returns:			uint8_t, the bytes read, 0 if it is cut off
+Description:	Reads back what PutVarint wrote
+****************************************************************************/
+static uint8_t GetVarint(const uint8_t *Bytes, uint32_t Length, uint32_t *Value) {
+	*Value = 0;
+	for (uint8_t Index = 0; Index < 5 && Index < Length; Index++) {
+		*Value |= (uint32_t)(Bytes[Index] & VARINT_MASK) << (VARINT_BITS * Index);
+		if (!(Bytes[Index] & VARINT_MORE)) return Index + 1;
+	}
+	return 0;
+}
+
+/*------------------------------ End of file ------------------------------*/
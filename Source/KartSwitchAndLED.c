@@ -21,12 +21,14 @@ Author: Kyle Moy, 3/1/15
 #include "inc/hw_sysctl.h"
 #include "termio.h"
 #include "ES_Port.h"
+#include "HW_Port.h"
 #include "driverlib/gpio.h"
 #include "driverlib/interrupt.h"
 #include "utils/uartstdio.h"
 
 // Module Libraries
 #include "KartSwitchAndLED.h"
+#include "InputRecorder.h"
 
 
 /*----------------------------- Module Defines ----------------------------*/
@@ -41,6 +43,7 @@ Returns:			void
 Description:	Initializes the hardware for the Kart switch and LED.
 ****************************************************************************/
 void InitializeKartSwitchAndLED(void) { 
+#ifndef HOST_SIM
 	// Initialization of the Kart switch (Pins E1, E2, and E3)
 	HWREG(SYSCTL_RCGCGPIO) |= SYSCTL_RCGCGPIO_R4; // Port E
 	HWREG(GPIO_PORTE_BASE+GPIO_O_DEN) |= (GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_0); // Enable Pin E1, E2, E0 for Digital I/O
@@ -51,6 +54,7 @@ void InitializeKartSwitchAndLED(void) {
 	HWREG(SYSCTL_RCGCGPIO) |= SYSCTL_RCGCGPIO_R5; // Port F
 	HWREG(GPIO_PORTF_BASE+GPIO_O_DEN) |= GPIO_PIN_2; // Enable Pin F2 for Digital I/O
 	HWREG(GPIO_PORTF_BASE+GPIO_O_DIR) |= GPIO_PIN_2; // Enable Pin F2 as Output
+#endif
 }
 
 
@@ -61,11 +65,11 @@ Returns:			void
 Description:	Returns an integer (1-3) for the Kart that is switched on
 ****************************************************************************/
 uint8_t ReadKartSwitch(void) {
-	if ((HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) & (GPIO_PIN_0)) \
-		&& (HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) & (GPIO_PIN_1)))
+	uint8_t Pins = GPIO_READ(GPIO_PORTE_BASE);
+	RecordInput(INPUT_KART_SWITCH, &Pins);
+	if ((Pins & GPIO_PIN_0) && (Pins & GPIO_PIN_1))
 		return 2;
-	else if ((HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) & (GPIO_PIN_1)) \
-		&& (HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) & (GPIO_PIN_2)))
+	else if ((Pins & GPIO_PIN_1) && (Pins & GPIO_PIN_2))
 		return 3;
 	else
 		return 1;
@@ -78,7 +82,7 @@ Returns:			void
 Description:	Turns the race LED (on pin F1) on
 ****************************************************************************/
 void TurnOnRaceLED(void) {
-	HWREG(GPIO_PORTF_BASE+(GPIO_O_DATA + ALL_BITS)) |= GPIO_PIN_2;
+	GPIO_SET(GPIO_PORTF_BASE, GPIO_PIN_2);
 }
 
 /****************************************************************************
@@ -88,7 +92,7 @@ Returns:			void
 Description:	Turns the race LED (on pin F1) off
 ****************************************************************************/
 void TurnOffRaceLED(void) {
-	HWREG(GPIO_PORTF_BASE+(GPIO_O_DATA + ALL_BITS)) &= ~GPIO_PIN_2;
+	GPIO_CLEAR(GPIO_PORTF_BASE, GPIO_PIN_2);
 }
 
 
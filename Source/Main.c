@@ -25,6 +25,9 @@ Author: Kyle Moy, 2/18/15
 #include "BallLauncher.h"
 #include "BumpSensor.h"
 #include "KartSwitchAndLED.h"
+#include "EEPROMStorage.h"
+#include "InputRecorder.h"
+#include "FieldCalibration.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define clrScrn() 	puts("\x1b[2J")
@@ -50,8 +53,12 @@ int main (void)
 	printf("%s %s\n",__TIME__, __DATE__);
 	printf("\r\n");
     
-	// Hardware initialization functions can go here
+	// Hardware initialization functions can go here, the input recorder
+	// first so it sees the Kart switch
+	InitializeInputRecorder();
 	InitializeKartSwitchAndLED();
+	InitializeEEPROMStorage();
+	InitializeFieldCalibration();
 	InitializeDRS();
 	InitBeaconSensingCapture();
 	InitializeDriveMotors();
@@ -15,6 +15,11 @@ Author: Kyle Moy, 2/18/15
 #include "DRS.h"
 #include "DriveMotors.h"
 #include "BallLauncher.h"
+#include "PoseEstimator.h"
+#include "DriveMotorPID.h"
+#include "DriveMotorsPosition.h"
+#include "InputRecorder.h"
+#include "FieldCalibration.h"
 
 
 /*---------------------------- Module Variables ---------------------------*/
@@ -63,6 +68,11 @@ ES_Event RunMapKeys(ES_Event ThisEvent) {
 			case 'D': PivotCWwithSetTicks(150, 18); break; // RotateCWwithDuty(40, 5); break; //DriveForwardWithBias(70, 30, 50); break; //RotateCW(150, 5); break;
 			case 'A': PivotCCWwithSetTicks(150, 18); break;// RotateCCWwithDuty(40, 5); break; //DriveForwardWithBias(30, 70, 50); break; //RotateCCW(150, 5); break;
 			case ' ': StopMotors(); break;
+			case 'T': StartPIDAutotune(); break;
+			case 'Y': StartFeedforwardCalibration(); break;
+			case 'E': StartFieldCalibration(); break;
+			case 'H': MarkFieldPoint(); break;
+			case 'Q': ClearFieldCalibration(); break;
 			
 			// Shooter Motor Command Triggers
 			case 'U': TurnOnShooter(); break; //SetShooterPWM(100); break;
@@ -105,6 +115,11 @@ ES_Event RunMapKeys(ES_Event ThisEvent) {
 					GetKartData(3).ObstacleCompleted, GetKartData(3).TargetSuccess, \
 					GamefieldPositionString(GetKartData(3).GamefieldPosition));
 				break;
+			case 'L': PrintDRSLinkStats(); break;
+			case 'K': PrintPoseEstimate(); break;
+			case 'M': PrintPIDCycles(); break;
+			case 'J': PrintPositionMove(); break;
+			case 'R': FreezeInputRecorder(); PrintInputLog(); break;
 		}
 		PostMasterSM(ThisEvent);
 	}
@@ -0,0 +1,153 @@
+/****************************************************************************
+Module: MotionProfile.c
+Description:
+	Acceleration and jerk limited (S-curve) ramps between RPM targets for
+	the drive motors. Every drive primitive used to step the PID target
+	from 0 straight to its RPM, which saturated the loop and spun the
+	wheels, so the tick counted distances came out long.
+	SetRPMResponse now passes each wheel's target through its profile
+	every control interrupt. The acceleration ramps up and down at the jerk
+	limit, up to the acceleration limit, and eases off in time to land on
+	the target without overshooting it.
+	GetStoppingRPM gives the fastest a wheel can be going and still coast
+	to a stop in the ticks it has left. The position loop caps its targets
+	with it so distance moves end at zero speed right on their ticks.
+	Runs from the control ISR, integer math only.
+Author: Kyle Moy, 3/9/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+
+// Module Libraries
+#include "MotionProfile.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define CONTROL_RATE_HZ			1000		// Control interrupts per second
+#define PulsesPerRev				28
+
+#define Q16_ONE							(1L << 16)
+// Limits per control interrupt, in Q16.16
+#define ACCEL_STEP(Accel)		((int32_t)((int64_t)(Accel) * Q16_ONE / CONTROL_RATE_HZ))
+#define DECEL_STEP(Decel)		((int32_t)((int64_t)(Decel) * Q16_ONE / CONTROL_RATE_HZ))
+#define JERK_STEP(Jerk)			((int32_t)((int64_t)(Jerk) * Q16_ONE / CONTROL_RATE_HZ / CONTROL_RATE_HZ))
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint32_t SquareRoot(uint32_t Value);
+
+/*---------------------------- Module Variables ---------------------------*/
+// The limits in use, PROFILE_MAX_* unless SetMotionProfileLimits has
+// changed them
+static int32_t AccelStep = ACCEL_STEP(PROFILE_MAX_ACCEL);
+static int32_t DecelStep = DECEL_STEP(PROFILE_MAX_DECEL);
+static int32_t JerkStep = JERK_STEP(PROFILE_MAX_JERK);
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			ResetMotionProfile
+Parameters:		MotionProfile_t *Profile, the profile to reset
+							int32_t RPM, the speed the wheel is at now
+Returns:			void
+Description:	Restarts the profile from RPM with no acceleration
+****************************************************************************/
+void ResetMotionProfile(MotionProfile_t *Profile, int32_t RPM) {
+	Profile->Velocity = RPM * Q16_ONE;
+	Profile->Accel = 0;
+}
+
+/****************************************************************************
+Function:			UpdateMotionProfile
+Parameters:		MotionProfile_t *Profile, the wheel's profile
+							int32_t GoalRPM, where the wheel has been asked to go
+Returns:			int32_t, the RPM target for this control interrupt
+Description:	Takes one control interrupt's step toward GoalRPM
+****************************************************************************/
+int32_t UpdateMotionProfile(MotionProfile_t *Profile, int32_t GoalRPM) {
+	int32_t Goal = GoalRPM * Q16_ONE;
+	int32_t Error = Goal - Profile->Velocity;
+	int32_t Velocity;
+
+	if (Error < 0) {
+		// Slowing down only takes the drive off and the motors coast, so there
+		// is nothing to slip and no jerk limit, just the deceleration limit
+		Velocity = Profile->Velocity - DecelStep;
+		if (Velocity < Goal) Velocity = Goal;
+		Profile->Accel = 0;
+	} else {
+		// The speed still to come if the acceleration is eased off to zero
+		// from here at the jerk limit is a^2 / 2j. Push the acceleration up
+		// while that falls short of the goal, and ease it off once it would reach.
+		int32_t Accel = Profile->Accel;
+		if ((int64_t)Error * 2 * JerkStep > (int64_t)Accel * Accel) {
+			Accel += JerkStep;
+			if (Accel > AccelStep) Accel = AccelStep;
+		} else {
+			Accel -= JerkStep;
+			if (Accel < 0) Accel = 0;
+		}
+		// Land on the goal rather than step past it
+		Velocity = Profile->Velocity + Accel;
+		if (Velocity >= Goal) {
+			Velocity = Goal;
+			Accel = 0;
+		}
+		Profile->Accel = Accel;
+	}
+	Profile->Velocity = Velocity;
+	return Velocity >> 16;
+}
+
+/****************************************************************************
+Function:			GetStoppingRPM
+Parameters:		uint32_t Ticks, encoder ticks left to go
+Returns:			uint32_t, the fastest a wheel can go and still stop in Ticks
+Description:	v = sqrt(2ad) at PROFILE_COAST_DECEL, with d in RPM seconds
+							(ticks * 60 / PulsesPerRev)
+****************************************************************************/
+uint32_t GetStoppingRPM(uint32_t Ticks) {
+	return SquareRoot(Ticks * (2 * PROFILE_COAST_DECEL * 60 / PulsesPerRev));
+}
+
+/****************************************************************************
+Function:			SetMotionProfileLimits
+Parameters:		uint32_t Accel, Decel, RPM per second
+							uint32_t Jerk, RPM per second per second
+Returns:			void
+Description:	Changes the limits from PROFILE_MAX_*, for tuning them without
+							a rebuild. Takes effect on the next control interrupt.
+****************************************************************************/
+void SetMotionProfileLimits(uint32_t Accel, uint32_t Decel, uint32_t Jerk) {
+	AccelStep = ACCEL_STEP(Accel);
+	DecelStep = DECEL_STEP(Decel);
+	JerkStep = JERK_STEP(Jerk);
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			SquareRoot
+Parameters:		uint32_t Value
+Returns:			uint32_t, floor(sqrt(Value))
+Description:	Integer square root, bit by bit
+****************************************************************************/
+static uint32_t SquareRoot(uint32_t Value) {
+	uint32_t Root = 0;
+	uint32_t Bit = 1UL << 30;
+	while (Bit > Value) Bit >>= 2;
+	while (Bit != 0) {
+		if (Value >= Root + Bit) {
+			Value -= Root + Bit;
+			Root = (Root >> 1) + Bit;
+		} else {
+			Root >>= 1;
+		}
+		Bit >>= 2;
+	}
+	return Root;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,201 @@
+/****************************************************************************
+Module: MotionSequencer.c
+Description:
+	Runs multi-step maneuvers (back up, pivot, back up, ...) for the state
+	machines. They used to run each step off an E_MOTOR_TIMEOUT ladder, so
+	every step stopped the motors, went through the DriveMotorsService and
+	the whole state machine chain, and only then started the next one.
+	A maneuver is now a const table of MotionStep_t ending in MOTION_END.
+	StartMotionSequence hands it to the control ISR, which starts each step
+	on the interrupt the last one finishes, and posts E_MOTION_SEQUENCE_DONE
+	to the DriveMotorsService at the end, with MOVE_STALLED if any pivot
+	stalled short of its ticks.
+	Any other drive command (SetTargetRPM, StopMotors) ends the sequence.
+Author: Kyle Moy, 3/10/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+
+// Framework Libraries
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+
+// Module Libraries
+#include "MotionSequencer.h"
+#include "DriveMotors.h"
+#include "DriveMotorPID.h"
+#include "DriveMotorsPosition.h"
+#include "DriveMotorsService.h"
+
+/*---------------------------- Module Functions ---------------------------*/
+static void BeginStep(int32_t *TargetRPMR, int32_t *TargetRPML);
+static void SetDirections(uint8_t DirectionL, uint8_t DirectionR);
+static void Coast(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static const MotionStep_t *Steps;
+static volatile bool Running = false;
+static bool StepStarted;
+static uint8_t StepIndex;
+static uint16_t StepTime;
+static int32_t StepRPMR, StepRPML;
+static bool Stalled;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			StartMotionSequence
+Parameters:		const MotionStep_t *Sequence, the steps, ending in MOTION_END
+Returns:			void
+Description:	Starts the sequence on the next control interrupt
+****************************************************************************/
+void StartMotionSequence(const MotionStep_t *Sequence) {
+	// Keep the ISR out while the sequence is set up, and clear out whatever
+	// the motors were doing
+	Running = false;
+	StopPositionMove();
+	ES_Timer_StopTimer(DRIVE_MOTOR_TIMER);
+	Steps = Sequence;
+	StepIndex = 0;
+	StepStarted = false;
+	Stalled = false;
+	Running = true;
+}
+
+/****************************************************************************
+Function:			StopMotionSequence
+Parameters:		void
+Returns:			void
+Description:	Abandons the sequence, no event is posted
+****************************************************************************/
+void StopMotionSequence(void) {
+	Running = false;
+}
+
+/****************************************************************************
+Function:			IsMotionSequenceRunning
+Parameters:		void
+Returns:			bool, true until the sequence ends or is stopped
+Description:	Tells if a sequence owns the drive motors
+****************************************************************************/
+bool IsMotionSequenceRunning(void) {
+	return Running;
+}
+
+/****************************************************************************
+Function:			UpdateMotionSequence
+Parameters:		int32_t *TargetRPMR, *TargetRPML, the inner loop targets
+Returns:			bool, true if a sequence owns the targets and they were written
+Description:	Called from the control ISR every interrupt
+****************************************************************************/
+bool UpdateMotionSequence(int32_t *TargetRPMR, int32_t *TargetRPML) {
+	if (!Running) return false;
+	if (!StepStarted) {
+		BeginStep(TargetRPMR, TargetRPML);
+		return true;
+	}
+
+	const MotionStep_t *Step = &Steps[StepIndex];
+	if (Step->Primitive == MOTION_PIVOT_CW || Step->Primitive == MOTION_PIVOT_CCW) {
+		UpdatePositionControl(TargetRPMR, TargetRPML);
+		uint8_t Result = GetPositionMoveResult();
+		if (Result == MOVE_IN_PROGRESS) return true;
+		if (Result == MOVE_STALLED) Stalled = true;
+	} else {
+		*TargetRPMR = StepRPMR;
+		*TargetRPML = StepRPML;
+		if (++StepTime < Step->Amount) return true;
+	}
+
+	// On to the next step straight away
+	StepIndex++;
+	BeginStep(TargetRPMR, TargetRPML);
+	return true;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			BeginStep
+Parameters:		int32_t *TargetRPMR, *TargetRPML, the inner loop targets
+Returns:			void
+Description:	Sets the motors up for Steps[StepIndex], or ends the sequence
+****************************************************************************/
+static void BeginStep(int32_t *TargetRPMR, int32_t *TargetRPML) {
+	const MotionStep_t *Step = &Steps[StepIndex];
+	StepStarted = true;
+	StepTime = 0;
+	StepRPMR = 0;
+	StepRPML = 0;
+
+	switch (Step->Primitive) {
+		case MOTION_STOP:
+			Coast();
+			break;
+
+		case MOTION_FORWARD:
+		case MOTION_BACKWARD:
+			SetDirections((Step->Primitive == MOTION_FORWARD) ? FORWARD : BACKWARD, \
+				(Step->Primitive == MOTION_FORWARD) ? FORWARD : BACKWARD);
+			StepRPMR = Step->RPMR;
+			StepRPML = Step->RPML;
+			ScheduleGains(MANEUVER_DRIVE, (StepRPMR > StepRPML) ? StepRPMR : StepRPML);
+			EnablePIDcontrol();
+			break;
+
+		case MOTION_PIVOT_CW:
+		case MOTION_PIVOT_CCW:
+			// Only the left wheel turns, so it counts the ticks
+			SetDirections((Step->Primitive == MOTION_PIVOT_CW) ? FORWARD : BACKWARD, \
+				(Step->Primitive == MOTION_PIVOT_CW) ? BACKWARD : FORWARD);
+			StepRPML = Step->RPML;
+			ScheduleGains(MANEUVER_TURN, StepRPML);
+			StartPositionStep(Step->Amount, 0, Step->RPML, 0);
+			EnablePIDcontrol();
+			break;
+
+		case MOTION_END:
+		default:
+			Coast();
+			Running = false;
+			ES_Event Event = {E_MOTION_SEQUENCE_DONE, Stalled ? MOVE_STALLED : MOVE_ARRIVED};
+			PostDriveMotorsService(Event);
+			break;
+	}
+	*TargetRPMR = StepRPMR;
+	*TargetRPML = StepRPML;
+}
+
+/****************************************************************************
+Function:			SetDirections
+Parameters:		uint8_t DirectionL, DirectionR, FORWARD or BACKWARD
+Returns:			void
+Description:	Sets the wheel directions. The PID loops start from scratch if
+							a wheel turns around, a wheel carrying on the same way keeps
+							its integral so there is no dip between steps.
+****************************************************************************/
+static void SetDirections(uint8_t DirectionL, uint8_t DirectionR) {
+	if (GetMotorDirection(LEFT_MOTOR) != DirectionL || GetMotorDirection(RIGHT_MOTOR) != DirectionR) {
+		ClearSumError();
+	}
+	SetMotorDirections(DirectionL, DirectionR);
+}
+
+/****************************************************************************
+Function:			Coast
+Parameters:		void
+Returns:			void
+Description:	StopMotors without the printing, safe from the ISR
+****************************************************************************/
+static void Coast(void) {
+	StopPositionMove();
+	DisablePIDcontrol();
+	SetMotorPWMs(0, 0);
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
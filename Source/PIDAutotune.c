@@ -0,0 +1,208 @@
+/****************************************************************************
+Module: PIDAutotune.c
+Description:
+	Relay feedback (Astrom-Hagglund) autotuning for the drive motor PIDs.
+	The gains were tuned by hand and drift as the batteries sag, so this
+	measures the wheel instead.
+	The duty is first ramped up until the wheel reaches the set point, which
+	gives the bias duty that roughly holds it there. Then the duty is
+	switched RelayDuty above the bias while the wheel is under the set point
+	and RelayDuty below it while it is over (with a little hysteresis for
+	the edge noise), which makes the wheel oscillate about the set point at
+	the frequency where the loop's phase lag is 180 degrees. The bias is
+	nudged each cycle to keep the high and low halves even. After a few
+	cycles to settle, the period and swing of the oscillation are averaged:
+		Ku = 4 * RelayDuty / (pi * sqrt(a^2 - h^2)), Tu = the period
+	with a half the peak to peak swing and h the hysteresis, and the gains
+	come from Ku and Tu.
+	UpdateRelayAutotune runs from the control ISR and is integer only, the
+	float result is worked out afterwards in the thread.
+	Hardware free so it can be run against a motor model on a PC (see
+	Host/AutotuneMain.c).
+Author: Kyle Moy, 3/11/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+// Module Libraries
+#include "PIDAutotune.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// The ramp to the set point, 1% more duty every RAMP_STEP_MS
+#define RAMP_STEP_MS				20
+#define RAMP_MAX_DUTY				100
+// Cycles thrown away while the oscillation settles, then the ones averaged
+#define SETTLE_CYCLES				2
+#define MEASURE_CYCLES			6
+// Given up on if it hasn't finished by then, e.g. the wheel is stuck
+#define AUTOTUNE_TIMEOUT_MS	8000
+// Switching band either side of the set point, RPM
+#define HYSTERESIS_RPM			5
+
+// Gains from Ku and Tu. Ziegler-Nichols PI (0.45 Ku, Tu / 1.2) overshoots
+// 40-90% on the model, the speeds are edge timed so the loop's lag is
+// mostly measurement and the oscillation is lumpy. A third of the ZN gain
+// with the integral time at Tu settles in about half the time of the
+// hand tuned gains with little overshoot. The derivative is left off, on
+// edge timed speeds it only amplifies the noise.
+#define KP_PER_KU						0.15f
+#define TI_PER_TU						1.0f
+
+#define PI									3.141592f
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t Relay(RelayAutotune_t *Tune);
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			StartRelayAutotune
+Parameters:		RelayAutotune_t *Tune, the wheel's experiment
+							int32_t SetpointRPM, the speed to oscillate about
+							int32_t RelayDuty, duty % either side of the bias
+Returns:			void
+Description:	Starts the ramp to the set point from a standstill
+****************************************************************************/
+void StartRelayAutotune(RelayAutotune_t *Tune, int32_t SetpointRPM, int32_t RelayDuty) {
+	Tune->State = AUTOTUNE_IDLE;
+	Tune->SetpointRPM = SetpointRPM;
+	Tune->HysteresisRPM = HYSTERESIS_RPM;
+	Tune->RelayDuty = RelayDuty;
+	Tune->BiasDuty = 0;
+	Tune->High = true;
+	Tune->Time = 0;
+	Tune->Cycles = 0;
+	Tune->SumPeriod = 0;
+	Tune->SumPeakToPeak = 0;
+	Tune->State = AUTOTUNE_RAMPING;
+}
+
+/****************************************************************************
+Function:			UpdateRelayAutotune
+Parameters:		RelayAutotune_t *Tune, the wheel's experiment
+							int32_t RPM, the measured speed
+Returns:			uint8_t, the duty cycle to apply (0-100)
+Description:	Runs one 1ms sample of the experiment
+****************************************************************************/
+uint8_t UpdateRelayAutotune(RelayAutotune_t *Tune, int32_t RPM) {
+	if (Tune->State != AUTOTUNE_RAMPING && Tune->State != AUTOTUNE_RELAY) return 0;
+	if (++Tune->Time > AUTOTUNE_TIMEOUT_MS) {
+		Tune->State = AUTOTUNE_FAILED;
+		return 0;
+	}
+
+	if (Tune->State == AUTOTUNE_RAMPING) {
+		if (RPM < Tune->SetpointRPM) {
+			if (Tune->Time % RAMP_STEP_MS == 0 && Tune->BiasDuty < RAMP_MAX_DUTY) Tune->BiasDuty++;
+			return Tune->BiasDuty;
+		}
+		// At the set point, the speed lags the duty so back off a little
+		// from where the ramp got to and start switching low
+		Tune->BiasDuty -= Tune->RelayDuty / 2;
+		if (Tune->BiasDuty < Tune->RelayDuty) Tune->BiasDuty = Tune->RelayDuty;
+		Tune->High = false;
+		Tune->RiseTime = Tune->Time;
+		Tune->FallTime = Tune->Time;
+		Tune->Max = RPM;
+		Tune->Min = RPM;
+		Tune->State = AUTOTUNE_RELAY;
+		return Relay(Tune);
+	}
+
+	if (RPM > Tune->Max) Tune->Max = RPM;
+	if (RPM < Tune->Min) Tune->Min = RPM;
+
+	if (Tune->High && RPM > Tune->SetpointRPM + Tune->HysteresisRPM) {
+		Tune->High = false;
+		Tune->FallTime = Tune->Time;
+	} else if (!Tune->High && RPM < Tune->SetpointRPM - Tune->HysteresisRPM) {
+		// A full cycle is rise to rise, the first rise only starts one
+		if (Tune->Cycles > 0 || Tune->RiseTime != Tune->FallTime) {
+			uint32_t HighTime = Tune->FallTime - Tune->RiseTime;
+			uint32_t LowTime = Tune->Time - Tune->FallTime;
+			if (Tune->Cycles >= SETTLE_CYCLES) {
+				Tune->SumPeriod += HighTime + LowTime;
+				Tune->SumPeakToPeak += Tune->Max - Tune->Min;
+			}
+			Tune->Cycles++;
+			// Even up the halves, a long high half means the bias is short
+			Tune->BiasDuty += (int32_t)(HighTime - LowTime) * Tune->RelayDuty / (int32_t)(2 * (HighTime + LowTime));
+			if (Tune->BiasDuty < Tune->RelayDuty) Tune->BiasDuty = Tune->RelayDuty;
+			if (Tune->BiasDuty > 100 - Tune->RelayDuty) Tune->BiasDuty = 100 - Tune->RelayDuty;
+			if (Tune->Cycles >= SETTLE_CYCLES + MEASURE_CYCLES) {
+				Tune->State = AUTOTUNE_DONE;
+				return 0;
+			}
+		}
+		Tune->High = true;
+		Tune->RiseTime = Tune->Time;
+		Tune->Max = RPM;
+		Tune->Min = RPM;
+	}
+	return Relay(Tune);
+}
+
+/****************************************************************************
+Function:			IsRelayAutotuneFinished
+Parameters:		const RelayAutotune_t *Tune
+Returns:			bool, true once the experiment is done or has failed
+Description:	Lets the ISR tell when to hand the wheel back
+****************************************************************************/
+bool IsRelayAutotuneFinished(const RelayAutotune_t *Tune) {
+	return Tune->State == AUTOTUNE_DONE || Tune->State == AUTOTUNE_FAILED;
+}
+
+/****************************************************************************
+Function:			GetRelayAutotuneResult
+Parameters:		const RelayAutotune_t *Tune
+							float *Ku, the ultimate gain, duty % per RPM
+							float *TuMS, the ultimate period, ms
+Returns:			bool, false if the experiment didn't finish
+Description:	Works out Ku and Tu from the averaged cycles
+****************************************************************************/
+bool GetRelayAutotuneResult(const RelayAutotune_t *Tune, float *Ku, float *TuMS) {
+	if (Tune->State != AUTOTUNE_DONE) return false;
+	float Amplitude = (float)Tune->SumPeakToPeak / (2 * MEASURE_CYCLES);
+	float Hysteresis = (float)Tune->HysteresisRPM;
+	if (Amplitude <= Hysteresis) return false;
+	*Ku = 4 * Tune->RelayDuty / (PI * sqrtf(Amplitude * Amplitude - Hysteresis * Hysteresis));
+	*TuMS = (float)Tune->SumPeriod / MEASURE_CYCLES;
+	return true;
+}
+
+/****************************************************************************
+Function:			RelayAutotuneGains
+Parameters:		float Ku, TuMS, from GetRelayAutotuneResult
+							float *p, *i, *d, gains in the p, i, d form of the gain schedule
+Returns:			void
+Description:	Duty = p * (Error + i * SumError + d * dError) with the sums
+							per 1ms sample, so i is one over the integral time in ms
+****************************************************************************/
+void RelayAutotuneGains(float Ku, float TuMS, float *p, float *i, float *d) {
+	*p = KP_PER_KU * Ku;
+	*i = 1 / (TI_PER_TU * TuMS);
+	*d = 0;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			Relay
+Parameters:		RelayAutotune_t *Tune
+Returns:			uint8_t, the duty for the side the relay is on
+Description:	The bias plus or minus the relay duty
+****************************************************************************/
+static uint8_t Relay(RelayAutotune_t *Tune) {
+	int32_t Duty = Tune->BiasDuty + (Tune->High ? Tune->RelayDuty : -Tune->RelayDuty);
+	if (Duty < 0) Duty = 0;
+	if (Duty > 100) Duty = 100;
+	return Duty;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,173 @@
+/****************************************************************************
+Module: PIDController.c
+Description:
+	Fixed-point PID for the 1kHz drive motor loop. The control law is the
+	one the float loop used,
+		Duty = p * (Error + i * SumError + d * dError)
+	with four changes:
+	- Everything in the update is integer math. Gains are Q8.24 so a small
+	  p*i product still has resolution, products are done in 64 bits and
+	  every sum saturates instead of wrapping.
+	- The integrator holds the integral term itself (Ki * SumError) in duty
+	  units. It is clamped to the duty range, and stops integrating in the
+	  direction the output is already saturated (anti-windup).
+	- The derivative acts on the measured RPM rather than the error, so a
+	  new target doesn't kick the output.
+	- An error inside the noise of the RPM measurement (PID_DEADBAND_SIGMAS
+	  standard deviations, from the variance the encoder reports) counts as
+	  none, so the loop doesn't chase edge spacing noise at low speed.
+	A feedforward duty, from the motor's duty to speed map, is added to the
+	output ahead of the saturation, so the integrator only has to make up
+	what the map gets wrong rather than wind up to the whole duty.
+	SwitchPIDGains changes gains part way through a move without a bump:
+	the integral term takes up the step the new p would make in the output.
+	Hardware free so it can be checked on a PC (see Host/PIDCompareMain.c).
+	Its cost in cycles hasn't been measured on the Kart, the host has no
+	cycle counter. 'M' prints the DWT count for the whole control ISR.
+Author: Kyle Moy, 3/7/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+
+// Module Libraries
+#include "PIDController.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define GAIN_ONE					(1L << PID_GAIN_SHIFT)
+#define OUTPUT_MAX				((int32_t)PID_DUTY_MAX << PID_OUTPUT_SHIFT)
+// A gain times an RPM is Q24, the output is Q16
+#define PRODUCT_SHIFT			(PID_GAIN_SHIFT - PID_OUTPUT_SHIFT)
+
+/*---------------------------- Module Functions ---------------------------*/
+static int32_t ToGain(float Gain);
+static int32_t Saturate(int64_t Value, int32_t Min, int32_t Max);
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			SetPIDControllerGains
+Parameters:		PIDController_t *PID, the loop to set
+							float p, i, d, gains in the p, i, d form the drive code has always used
+Returns:			void
+Description:	Converts the gains to fixed point. The integral term is kept,
+							so changing i on the fly doesn't bump the output.
+****************************************************************************/
+void SetPIDControllerGains(PIDController_t *PID, float p, float i, float d) {
+	PID->Kp = ToGain(p);
+	PID->Ki = ToGain(p * i);
+	PID->Kd = ToGain(p * d);
+}
+
+/****************************************************************************
+Function:			ConvertPIDGains
+Parameters:		PIDGains_t *Gains, where the fixed point gains go
+							float p, i, d, as SetPIDControllerGains
+Returns:			void
+Description:	Does the float conversion once, outside the ISR
+****************************************************************************/
+void ConvertPIDGains(PIDGains_t *Gains, float p, float i, float d) {
+	Gains->Kp = ToGain(p);
+	Gains->Ki = ToGain(p * i);
+	Gains->Kd = ToGain(p * d);
+}
+
+/****************************************************************************
+Function:			SwitchPIDGains
+Parameters:		PIDController_t *PID, the loop to change
+							const PIDGains_t *Gains, the new gains
+Returns:			void
+Description:	Bumpless transfer, integer only so it can run from the ISR.
+							The integral term is already in duty so a new Ki leaves it be,
+							a new Kp would step the output by (Kp new - old) * Error, so
+							the integral is moved the other way by as much.
+****************************************************************************/
+void SwitchPIDGains(PIDController_t *PID, const PIDGains_t *Gains) {
+	PID->Integral = Saturate((int64_t)PID->Integral + \
+		((((int64_t)PID->Kp - Gains->Kp) * PID->LastError) >> PRODUCT_SHIFT), -OUTPUT_MAX, OUTPUT_MAX);
+	PID->Kp = Gains->Kp;
+	PID->Ki = Gains->Ki;
+	PID->Kd = Gains->Kd;
+}
+
+/****************************************************************************
+Function:			ResetPIDController
+Parameters:		PIDController_t *PID, the loop to reset
+Returns:			void
+Description:	Clears the integrator and the derivative history
+****************************************************************************/
+void ResetPIDController(PIDController_t *PID) {
+	PID->Integral = 0;
+	PID->LastRPM = 0;
+	PID->LastError = 0;
+}
+
+/****************************************************************************
+Function:			UpdatePIDController
+Parameters:		PIDController_t *PID, the loop to run
+							int32_t TargetRPM, the set point
+							int32_t RPM, the measured speed
+							uint32_t RPMVariance, the variance of RPM, 0 for no deadband
+							int32_t FeedforwardDuty, duty % to add to the output, 0 for none
+Returns:			uint8_t, the duty cycle to apply (0-100)
+Description:	Runs one sample of the loop
+****************************************************************************/
+uint8_t UpdatePIDController(PIDController_t *PID, int32_t TargetRPM, int32_t RPM, uint32_t RPMVariance, \
+	int32_t FeedforwardDuty) {
+	int32_t Error = TargetRPM - RPM;
+	// Compared squared, no square root needed for the deadband
+	if ((int64_t)Error * Error <= (int64_t)PID_DEADBAND_SIGMAS * PID_DEADBAND_SIGMAS * RPMVariance) {
+		Error = 0;
+	}
+	PID->LastError = Error;
+	int32_t Change = RPM - PID->LastRPM;
+	PID->LastRPM = RPM;
+
+	int32_t LastIntegral = PID->Integral;
+	PID->Integral = Saturate((int64_t)PID->Integral + (((int64_t)PID->Ki * Error) >> PRODUCT_SHIFT), \
+		-OUTPUT_MAX, OUTPUT_MAX);
+
+	int64_t Output = (((int64_t)PID->Kp * Error) >> PRODUCT_SHIFT) + PID->Integral \
+		- (((int64_t)PID->Kd * Change) >> PRODUCT_SHIFT) + ((int64_t)FeedforwardDuty << PID_OUTPUT_SHIFT);
+
+	// Anti-windup, don't integrate further into a saturated output
+	if ((Output > OUTPUT_MAX && Error > 0) || (Output < 0 && Error < 0)) {
+		Output -= PID->Integral - LastIntegral;
+		PID->Integral = LastIntegral;
+	}
+
+	return Saturate(Output, 0, OUTPUT_MAX) >> PID_OUTPUT_SHIFT;
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			ToGain
+Parameters:		float Gain
+Returns:			int32_t, the gain in Q8.24, saturated
+Description:	Converts a gain to fixed point, rounding to nearest
+****************************************************************************/
+static int32_t ToGain(float Gain) {
+	float Scaled = Gain * GAIN_ONE;
+	if (Scaled >= INT32_MAX) return INT32_MAX;
+	if (Scaled <= INT32_MIN) return INT32_MIN;
+	return (int32_t)(Scaled + (Scaled >= 0 ? 0.5f : -0.5f));
+}
+
+/****************************************************************************
+Function:			Saturate
+Parameters:		int64_t Value, int32_t Min, int32_t Max
+Returns:			int32_t, Value clamped to Min..Max
+Description:	Saturating narrow from 64 to 32 bits
+****************************************************************************/
+static int32_t Saturate(int64_t Value, int32_t Min, int32_t Max) {
+	if (Value > Max) return Max;
+	if (Value < Min) return Min;
+	return (int32_t)Value;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
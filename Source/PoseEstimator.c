@@ -0,0 +1,371 @@
+/****************************************************************************
+Module: PoseEstimator.c
+Description:
+	Pose for our Kart from the drive encoders, corrected by the DRS.
+	The control ISR calls UpdateOdometry, which queues the encoder odometers
+	and HW_TIMESTAMP() every ODOMETRY_DIVIDER interrupts (100Hz). On the
+	thread side the queued samples are dead reckoned into a raw odometry
+	pose that is kept, with its samples, in a short history.
+	The raw odometry is smooth and quick but drifts with tire wear and wheel
+	slip, the DRS doesn't drift but is slow, coarse and stale by the time it
+	reaches us. They are blended with a complementary filter: the estimate is
+	the odometry pose moved by a correction transform, and every DRS frame
+	(stamped at its EOT interrupt along with the odometers, see DRS.c)
+	pulls the estimate at that stamp part of the way to the DRS pose by
+	adjusting the correction. The odometry carries the estimate between
+	frames and the DRS slowly takes out its drift.
+	The ISR side is integer only, the floats are all done in the thread.
+	Headings are in the DRS's frame, where Theta grows clockwise seen from
+	above, so a left turn, the right wheel going further, takes Theta down.
+Author: Kyle Moy, 3/6/15
+****************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+// C Libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <math.h>
+
+// Hardware Libraries
+#include "HW_Port.h"
+
+// Module Libraries
+#include "PoseEstimator.h"
+#include "DRS.h"
+#include "DriveMotorEncoder.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// UpdateOdometry queues a sample every ODOMETRY_DIVIDER control interrupts
+#define ODOMETRY_DIVIDER		10
+// Samples queued by the ISR for the thread, 160ms worth
+#define SAMPLE_QUEUE_LENGTH	16
+// Dead reckoned samples kept to look up the odometry at a DRS stamp
+#define HISTORY_LENGTH			16
+// The DRS refreshes its poses every 100ms, the same pose read again after
+// that long is a new measurement that agrees with the last
+#define FIX_REFRESH_US			100000
+
+// Share of the difference between the DRS and our estimate taken out on
+// each new DRS pose. The DRS positions are a unit (8mm) coarse and up to a
+// refresh stale, so they are only trusted a little at a time. The DRS
+// headings are good to a degree and the odometry heading is what drifts,
+// so they are trusted more.
+#define POSITION_GAIN				0.2f
+#define HEADING_GAIN				0.5f
+
+// Wheel geometry, 94mm diameter and 28 pulses/rev
+#define TICKS_PER_REV				28
+#define MM_PER_TICK					(3.141592f * 94 / TICKS_PER_REV)
+// Center to center distance of the drive wheels
+#define WHEEL_BASE_MM				200.0f
+// Size of a DRS unit on the field
+#define MM_PER_DRS_UNIT			8.0f
+
+#define DEG_PER_RAD					(180.0f / 3.141592f)
+
+/*---------------------------- Module Functions ---------------------------*/
+static void IntegrateSamples(void);
+static Pose_t OdometryAtTime(uint32_t Timestamp);
+static Pose_t OdometryAtTicks(uint32_t Timestamp, int32_t TicksL, int32_t TicksR);
+static Pose_t Correct(Pose_t Odometry);
+static Pose_t Integrate(Pose_t Start, float DeltaL, float DeltaR);
+static float WrapAngle(float Degrees);
+
+/*---------------------------- Module Variables ---------------------------*/
+// Encoder odometers at a point in time
+typedef struct {
+	uint32_t	Timestamp;
+	int32_t		TicksL;
+	int32_t		TicksR;
+} OdometrySample_t;
+
+// Written by the ISR, SampleCount only ever counts up
+static OdometrySample_t SampleQueue[SAMPLE_QUEUE_LENGTH];
+static volatile uint32_t SampleCount = 0;
+static uint8_t Divider = 0;
+
+// Dead reckoned odometry pose at each sample, oldest first from HistoryHead
+typedef struct {
+	OdometrySample_t	Sample;
+	Pose_t						Odometry;
+} OdometryHistory_t;
+
+static OdometryHistory_t History[HISTORY_LENGTH];
+static uint8_t HistoryHead = 0;		// Next slot to write
+static uint8_t HistoryCount = 0;
+static uint32_t IntegratedCount = 0;
+static OdometryHistory_t Latest;	// The newest entry, the odometry starts at the origin
+
+// The correction transform, the estimate is the odometry pose rotated by
+// CorrectionTheta about the origin then moved by CorrectionX, CorrectionY
+static bool FixValid = false;
+static float CorrectionX, CorrectionY, CorrectionTheta;
+
+// The last DRS pose of our Kart and when it was stamped
+static Kart_t Fix;
+static uint32_t FixTimestamp;
+
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+Function:			UpdateOdometry
+Parameters:		void
+Returns:			void
+Description:	Called from the control ISR every interrupt, queues an odometry
+							sample every ODOMETRY_DIVIDER of them
+****************************************************************************/
+void UpdateOdometry(void) {
+	if (++Divider < ODOMETRY_DIVIDER) return;
+	Divider = 0;
+	OdometrySample_t *Sample = &SampleQueue[SampleCount % SAMPLE_QUEUE_LENGTH];
+	Sample->Timestamp = HW_TIMESTAMP();
+	Sample->TicksL = GetOdometerL();
+	Sample->TicksR = GetOdometerR();
+	SampleCount++;
+}
+
+/****************************************************************************
+Function:			SetPoseFix
+Parameters:		Kart_t Kart, our Kart as just reported by the DRS
+							uint32_t Timestamp, HW_TIMESTAMP() at the EOT of the frame
+							int32_t TicksL, TicksR, the encoder odometers at the EOT
+Returns:			void
+Description:	Corrects the estimate with a DRS pose. The DRS refreshes its
+							positions slower than we poll, so an unchanged pose within
+							FIX_REFRESH_US is the same measurement read again and is only
+							used once. Later than that it is used again, or a Kart that
+							has stopped would never be pulled onto its DRS pose. The
+							first fix is taken as it is.
+****************************************************************************/
+void SetPoseFix(Kart_t Kart, uint32_t Timestamp, int32_t TicksL, int32_t TicksR) {
+	if (FixValid && Fix.KartX == Kart.KartX && Fix.KartY == Kart.KartY && Fix.KartTheta == Kart.KartTheta && \
+		Timestamp - FixTimestamp < FIX_REFRESH_US * HW_TICKS_PER_US) return;
+	Fix = Kart;
+	FixTimestamp = Timestamp;
+
+	IntegrateSamples();
+	Pose_t Odometry = OdometryAtTicks(Timestamp, TicksL, TicksR);
+	float PositionGain = FixValid ? POSITION_GAIN : 1.0f;
+	float HeadingGain = FixValid ? HEADING_GAIN : 1.0f;
+	Pose_t Estimate = Correct(Odometry);
+
+	// Turn the correction part of the way toward the DRS heading, then move
+	// it so the estimate at the stamp lands part of the way to the DRS position
+	CorrectionTheta = WrapAngle(CorrectionTheta + HeadingGain * WrapAngle(Kart.KartTheta - Estimate.Theta));
+	float TargetX = Estimate.X + PositionGain * (Kart.KartX - Estimate.X);
+	float TargetY = Estimate.Y + PositionGain * (Kart.KartY - Estimate.Y);
+	float Cos = cosf(CorrectionTheta / DEG_PER_RAD);
+	float Sin = sinf(CorrectionTheta / DEG_PER_RAD);
+	CorrectionX = TargetX - (Odometry.X * Cos - Odometry.Y * Sin);
+	CorrectionY = TargetY - (Odometry.X * Sin + Odometry.Y * Cos);
+	FixValid = true;
+}
+
+/****************************************************************************
+Function:			HasPoseFix
+Parameters:		void
+Returns:			bool, true once the DRS has reported our Kart
+Description:	Tells if the estimates are anchored to a DRS pose yet
+****************************************************************************/
+bool HasPoseFix(void) {
+	return FixValid;
+}
+
+/****************************************************************************
+Function:			GetPoseAtTime
+Parameters:		uint32_t Timestamp, an HW_TIMESTAMP() value
+Returns:			Pose_t, our estimated pose at that time
+Description:	The corrected odometry at Timestamp. Times older than the
+							history return its oldest pose, times after now return the
+							current pose.
+****************************************************************************/
+Pose_t GetPoseAtTime(uint32_t Timestamp) {
+	if (!FixValid) {
+		// Nothing to correct the odometry with, fall back on whatever the DRS has
+		Kart_t MyKart = GetMyKart();
+		Pose_t Pose = {MyKart.KartX, MyKart.KartY, MyKart.KartTheta};
+		return Pose;
+	}
+	IntegrateSamples();
+	return Correct(OdometryAtTime(Timestamp));
+}
+
+/****************************************************************************
+Function:			GetCurrentPose
+Parameters:		void
+Returns:			Pose_t, our estimated pose right now
+Description:	Use this instead of GetMyKart() for navigation decisions
+****************************************************************************/
+Pose_t GetCurrentPose(void) {
+	return GetPoseAtTime(HW_TIMESTAMP());
+}
+
+/****************************************************************************
+Function:			GetYawRate
+Parameters:		void
+Returns:			float, how fast our Kart is turning, degrees/s clockwise, the way
+							the DRS Theta grows
+Description:	From the wheel speeds the encoder periods give, the correction
+							doesn't change the rate. Differencing the odometers instead
+							is a tick, 3 degrees, a window, which over the 30ms a turn
+							can afford to look back is 100 degrees/s steps.
+****************************************************************************/
+float GetYawRate(void) {
+	// Wheel RPM to mm/s
+	float SpeedL = GetVelocityL() * MM_PER_TICK * TICKS_PER_REV / 60;
+	float SpeedR = GetVelocityR() * MM_PER_TICK * TICKS_PER_REV / 60;
+	return (SpeedL - SpeedR) / WHEEL_BASE_MM * DEG_PER_RAD;
+}
+
+/****************************************************************************
+Function:			PrintPoseEstimate
+Parameters:		void
+Returns:			void
+Description:	Prints the DRS pose next to the estimate and the correction
+****************************************************************************/
+void PrintPoseEstimate(void) {
+	Kart_t MyKart = GetMyKart();
+	Pose_t Pose = GetCurrentPose();
+	uint32_t AgeMS = (HW_TIMESTAMP() - FixTimestamp) / (HW_TICKS_PER_US * 1000);
+	printf("Pose: DRS X = %d, Y = %d, Theta = %d, Estimate X = %.1f, Y = %.1f, Theta = %.1f, Fix Age = %lu ms\r\n", \
+		MyKart.KartX, MyKart.KartY, MyKart.KartTheta, Pose.X, Pose.Y, Pose.Theta, (unsigned long)AgeMS);
+	printf("Pose: Correction X = %.1f, Y = %.1f, Theta = %.1f\r\n", CorrectionX, CorrectionY, CorrectionTheta);
+}
+
+
+/*------------------------- Private Function Code -------------------------*/
+/****************************************************************************
+Function:			IntegrateSamples
+Parameters:		void
+Returns:			void
+Description:	Dead reckons the samples the ISR has queued since the last call
+							into the history. If the thread has fallen too far behind the
+							queue the samples it missed are skipped, nothing is lost,
+							the odometry just takes one longer arc.
+****************************************************************************/
+static void IntegrateSamples(void) {
+	uint32_t Count = SampleCount;
+	// Stay a slot clear of the one the ISR writes next
+	if (Count - IntegratedCount > SAMPLE_QUEUE_LENGTH - 1) {
+		IntegratedCount = Count - (SAMPLE_QUEUE_LENGTH - 1);
+	}
+	for (; IntegratedCount != Count; IntegratedCount++) {
+		OdometrySample_t Sample = SampleQueue[IntegratedCount % SAMPLE_QUEUE_LENGTH];
+		if (HistoryCount == 0) {
+			// The first sample is where the odometry starts from
+			Latest.Odometry = (Pose_t){0, 0, 0};
+		} else {
+			Latest.Odometry = Integrate(Latest.Odometry, Sample.TicksL - Latest.Sample.TicksL, \
+				Sample.TicksR - Latest.Sample.TicksR);
+		}
+		Latest.Sample = Sample;
+		History[HistoryHead] = Latest;
+		HistoryHead = (HistoryHead + 1) % HISTORY_LENGTH;
+		if (HistoryCount < HISTORY_LENGTH) HistoryCount++;
+	}
+}
+
+/****************************************************************************
+Function:			OdometryAtTime
+Parameters:		uint32_t Timestamp, an HW_TIMESTAMP() value
+Returns:			Pose_t, the raw odometry pose at that time
+Description:	Interpolates the odometers at Timestamp between the samples,
+							or up to the live odometers for anything after the newest
+****************************************************************************/
+static Pose_t OdometryAtTime(uint32_t Timestamp) {
+	// Start from the live odometers and walk back through the history
+	OdometrySample_t Newer = {HW_TIMESTAMP(), GetOdometerL(), GetOdometerR()};
+	if ((int32_t)(Timestamp - Newer.Timestamp) >= 0) {
+		return OdometryAtTicks(Newer.Timestamp, Newer.TicksL, Newer.TicksR);
+	}
+
+	for (uint8_t i = 1; i <= HistoryCount; i++) {
+		OdometrySample_t *Older = &History[(HistoryHead + HISTORY_LENGTH - i) % HISTORY_LENGTH].Sample;
+		int32_t Span = (int32_t)(Newer.Timestamp - Older->Timestamp);
+		int32_t Into = (int32_t)(Timestamp - Older->Timestamp);
+		if (Into >= 0) {
+			float Fraction = (Span > 0) ? (float)Into / Span : 1.0f;
+			return Integrate(History[(HistoryHead + HISTORY_LENGTH - i) % HISTORY_LENGTH].Odometry, \
+				Fraction * (Newer.TicksL - Older->TicksL), Fraction * (Newer.TicksR - Older->TicksR));
+		}
+		Newer = *Older;
+	}
+
+	// Older than the history, the closest we have is the oldest sample
+	return (HistoryCount > 0) ? History[(HistoryHead + HISTORY_LENGTH - HistoryCount) % HISTORY_LENGTH].Odometry : Latest.Odometry;
+}
+
+/****************************************************************************
+Function:			OdometryAtTicks
+Parameters:		uint32_t Timestamp, when the odometers were read
+							int32_t TicksL, TicksR, the odometers then
+Returns:			Pose_t, the raw odometry pose at those odometers
+Description:	Integrates from the newest sample at or before Timestamp
+****************************************************************************/
+static Pose_t OdometryAtTicks(uint32_t Timestamp, int32_t TicksL, int32_t TicksR) {
+	for (uint8_t i = 1; i <= HistoryCount; i++) {
+		OdometryHistory_t *Entry = &History[(HistoryHead + HISTORY_LENGTH - i) % HISTORY_LENGTH];
+		if ((int32_t)(Timestamp - Entry->Sample.Timestamp) >= 0 || i == HistoryCount) {
+			return Integrate(Entry->Odometry, TicksL - Entry->Sample.TicksL, TicksR - Entry->Sample.TicksR);
+		}
+	}
+	// Nothing queued yet, the odometry starts here
+	return Latest.Odometry;
+}
+
+/****************************************************************************
+Function:			Correct
+Parameters:		Pose_t Odometry, a raw odometry pose
+Returns:			Pose_t, the estimate, the odometry pose in DRS coordinates
+Description:	Applies the correction transform
+****************************************************************************/
+static Pose_t Correct(Pose_t Odometry) {
+	float Cos = cosf(CorrectionTheta / DEG_PER_RAD);
+	float Sin = sinf(CorrectionTheta / DEG_PER_RAD);
+	Pose_t Pose;
+	Pose.X = CorrectionX + Odometry.X * Cos - Odometry.Y * Sin;
+	Pose.Y = CorrectionY + Odometry.X * Sin + Odometry.Y * Cos;
+	Pose.Theta = WrapAngle(Odometry.Theta + CorrectionTheta);
+	if (Pose.Theta < 0) Pose.Theta += 360.0f;
+	return Pose;
+}
+
+/****************************************************************************
+Function:			Integrate
+Parameters:		Pose_t Start, the pose to move from
+							float DeltaL, DeltaR, encoder ticks driven by each wheel
+Returns:			Pose_t, the pose after driving the arc
+Description:	Differential drive dead reckoning over a single arc
+****************************************************************************/
+static Pose_t Integrate(Pose_t Start, float DeltaL, float DeltaR) {
+	float DistanceL = DeltaL * MM_PER_TICK / MM_PER_DRS_UNIT;
+	float DistanceR = DeltaR * MM_PER_TICK / MM_PER_DRS_UNIT;
+	float Distance = (DistanceL + DistanceR) / 2;
+	float Turn = (DistanceL - DistanceR) / (WHEEL_BASE_MM / MM_PER_DRS_UNIT); // radians, clockwise
+	float Heading = Start.Theta / DEG_PER_RAD + Turn / 2;
+
+	Pose_t Pose;
+	Pose.X = Start.X + Distance * cosf(Heading);
+	Pose.Y = Start.Y + Distance * sinf(Heading);
+	Pose.Theta = fmodf(Start.Theta + Turn * DEG_PER_RAD, 360.0f);
+	if (Pose.Theta < 0) Pose.Theta += 360.0f;
+	return Pose;
+}
+
+/****************************************************************************
+Function:			WrapAngle
+Parameters:		float Degrees
+Returns:			float, the same angle between -180 and 180 degrees
+Description:	Keeps heading differences the short way round
+****************************************************************************/
+static float WrapAngle(float Degrees) {
+	Degrees = fmodf(Degrees, 360.0f);
+	if (Degrees >= 180.0f) Degrees -= 360.0f;
+	if (Degrees < -180.0f) Degrees += 360.0f;
+	return Degrees;
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+
+/*------------------------------ End of file ------------------------------*/
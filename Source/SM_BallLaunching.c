@@ -21,6 +21,7 @@ Author: Kyle Moy, 2/25/15
 #include "SM_Master.h"
 #include "BallLauncher.h"
 #include "DriveMotorPID.h"
+#include "MotionSequencer.h"
 
 /*---------------------------- Module Functions ---------------------------*/
 static ES_Event DuringBallLaunchingEntry(ES_Event Event);
@@ -30,6 +31,24 @@ static ES_Event DuringBallLaunchingExit(ES_Event Event);
 
 
 /*---------------------------- Module Variables ---------------------------*/
+// Come to a standstill, pivot, back up against the wall to square up on
+// it, then pull forward to where the beacon can be seen
+static const MotionStep_t EntryManeuver[] = {
+	{MOTION_STOP,         0,   0, 1000},
+	{MOTION_PIVOT_CCW,   40,   0,   18},
+	{MOTION_BACKWARD,   100, 100, 1500},
+	{MOTION_STOP,         0,   0,  500},
+	{MOTION_FORWARD,    100, 100, 1080},
+	{MOTION_END}
+};
+
+// Back off the wall at the end of the launch area and pivot onto the track
+static const MotionStep_t ExitManeuver[] = {
+	{MOTION_BACKWARD,   100, 100,  250},
+	{MOTION_PIVOT_CCW,  150,   0,   12},
+	{MOTION_END}
+};
+
 static BallLaunchingState_t CurrentState;
 static uint8_t MotorTimeoutCase = 0;
 
@@ -59,29 +78,10 @@ ES_Event RunBallLaunchingSM(ES_Event CurrentEvent) {
 			if (CurrentEvent.EventType != ES_NO_EVENT) { // If an event is active
 				switch (CurrentEvent.EventType) {
 					
-					case E_MOTOR_TIMEOUT:
-						if (MotorTimeoutCase == 0) {
-							SetPIDgains(0.05, 0.02, 0);
-							PivotCCWwithSetTicks(40, 18);
-							MotorTimeoutCase = 1;
-						} else if (MotorTimeoutCase == 1) {
-							DriveBackwardsWithBias(100, 100, 150);
-							MotorTimeoutCase = 2;
-						} else if (MotorTimeoutCase == 2) {
-							StopMotors();
-							ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, 50);
-							MotorTimeoutCase = 3;
-						} else if (MotorTimeoutCase == 3) {
-							StopMotors();
-							DriveForwardWithBias(100, 100, 108);
-							MotorTimeoutCase = 4;
-						} else {
-							StopMotors();
-							MotorTimeoutCase = 0;
-							NextState = BALL_LAUNCHING_IR_ALIGN;
-							MakeTransition = true;
-							ReturnEvent.EventType = ES_NO_EVENT;
-						}
+					case E_MOTION_SEQUENCE_DONE:
+						NextState = BALL_LAUNCHING_IR_ALIGN;
+						MakeTransition = true;
+						ReturnEvent.EventType = ES_NO_EVENT;
 						break;
 				}
 			}
@@ -159,21 +159,14 @@ ES_Event RunBallLaunchingSM(ES_Event CurrentEvent) {
 			if (CurrentEvent.EventType != ES_NO_EVENT) { // If an event is active
 				switch (CurrentEvent.EventType) {
 					case E_BUMP_DETECTED:
-						DriveBackwardsWithBias(100, 100, 25);
-						MotorTimeoutCase = 0;
+						StartMotionSequence(ExitManeuver);
 						break;
 					
-					case E_MOTOR_TIMEOUT:
-						if (MotorTimeoutCase == 0) {
-							PivotCCWwithSetTicks(150, 12);
-							MotorTimeoutCase = 1;
-						} else {
-							StopMotors();
-							ES_Event Event = {E_BALL_LAUNCHING_EXIT, 0};
-							PostMasterSM(Event);
-							MotorTimeoutCase = 0;
-						}
+					case E_MOTION_SEQUENCE_DONE: {
+						ES_Event Event = {E_BALL_LAUNCHING_EXIT, 0};
+						PostMasterSM(Event);
 						break;
+					}
 				}
 			}
 			break;
@@ -225,8 +218,7 @@ static ES_Event DuringBallLaunchingEntry(ES_Event Event) {
 	if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY)) {
 		if(DisplayEntryStateTransitions && DisplaySM_Racing) printf("SM3_Ball_Launching: BALL_LAUNCHING_ENTRY1\r\n");
 		StopMotors();
-		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, 100);
-		MotorTimeoutCase = 0;
+		StartMotionSequence(EntryManeuver);
 	} else if ( Event.EventType == ES_EXIT ) {
 	} else {
 	}
@@ -251,6 +243,7 @@ static ES_Event DuringBallLaunchingLaunch(ES_Event Event) {
 	if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY)) {
 		if(DisplayEntryStateTransitions && DisplaySM_Racing) printf("SM3_Ball_Launching: BALL_LAUNCHING_LAUNCH\r\n");
 		RotateCCW(30, 10);
+		MotorTimeoutCase = 0;
 	} else if ( Event.EventType == ES_EXIT ) {
 	} else {
 	}
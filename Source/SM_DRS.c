@@ -35,7 +35,14 @@ Author: Kyle Moy, 2/16/15
 
 // If a command takes longer than this duration, then something is probably wrong
 // We'll timeout and go back to the waiting state
-#define COMMAND_TIMEOUT 50 *10 // For debugging, * 100
+// A transfer takes about 4.3ms (8 bytes at 66us per bit), so 50ms is plenty
+#define COMMAND_TIMEOUT 5
+
+// A failed query is retried with the interval doubling each time, up to
+// MAX_BACKOFF. After MAX_RETRIES we give up on it and move on to the next
+// query, so one bad Kart can't stall the updates for the others.
+#define MAX_RETRIES 3
+#define MAX_BACKOFF 8
 
 
 /*---------------------------- Module Functions ---------------------------*/
@@ -43,6 +50,8 @@ static uint8_t GetNextQuery(void);
 static ES_Event DuringWaitingForQuery(ES_Event Event);
 static ES_Event DuringQuerying(ES_Event Event);
 static ES_Event DuringReading(ES_Event Event);
+static void RetryQuery(void);
+static void QuerySucceeded(void);
 
 
 /*---------------------------- Module Variables ---------------------------*/
@@ -51,6 +60,8 @@ static DRSState_t CurrentState;
 
 static uint8_t CurrentQuery;	// Keep track of the current query
 static uint8_t LastQuery;		// Save the last query in case of transfer failure
+static uint8_t RetryCount = 0;	// Retries of the current query
+static uint16_t WaitInterval = COMMAND_INTERVAL;	// Time until the next query
 
 
 /*------------------------------ Module Code ------------------------------*/
@@ -143,7 +154,7 @@ ES_Event RunDRS_SM (ES_Event CurrentEvent) {
 						{
 							// Query was unsuccessful, transition back to WAITING_FOR_QUERY
 							if (DisplaySM_DRS) printf("DRS query unsuccessful\r\n");
-							CurrentQuery = LastQuery;
+							RetryQuery();
 							NextState = WAITING_FOR_QUERY;
 							MakeTransition = true;
 						}
@@ -154,8 +165,8 @@ ES_Event RunDRS_SM (ES_Event CurrentEvent) {
 						if (DisplaySM_DRS) printf("ES_TIMEOUT during QUERYING\r\n");
 						NextState = WAITING_FOR_QUERY;
 						MakeTransition = true;
-						// Reset current query to last successful query
-						CurrentQuery = LastQuery;
+						RecordDRSTimeout();
+						RetryQuery();
 						break;
 				}
 			}
@@ -172,14 +183,15 @@ ES_Event RunDRS_SM (ES_Event CurrentEvent) {
 						if(StoreData()) {
 							if (DRS_ConsoleDisplay) PrintKartDataTableFormat();
 							// Data was successfully stored, transitioning to WAITING_FOR_QUERY
+							QuerySucceeded();
 							NextState = WAITING_FOR_QUERY;
 							MakeTransition = true;
 						} else {
 							// Data was invalid, transitioning to WAITING_FOR_QUERY and retrying the query
+							if (DisplaySM_DRS) printf("DRS frame rejected\r\n");
 							NextState = WAITING_FOR_QUERY;
 							MakeTransition = true;
-							// Reset current query to last successful query
-							CurrentQuery = LastQuery;
+							RetryQuery();
 						}
 						break;
 						
@@ -188,8 +200,8 @@ ES_Event RunDRS_SM (ES_Event CurrentEvent) {
 						if (DisplaySM_DRS) printf("ES_TIMEOUT during READING\r\n");
 						NextState = WAITING_FOR_QUERY;
 						MakeTransition = true;
-						// Reset current query to last successful query
-						CurrentQuery = LastQuery;
+						RecordDRSTimeout();
+						RetryQuery();
 						break;
 				}
 			}
@@ -255,6 +267,41 @@ static uint8_t GetNextQuery(void) {
 }
 
 
+/****************************************************************************
+Function:			RetryQuery
+Parameters:		none
+Returns:			none
+Description:	Sets up a retry of the failed query after a backoff interval.
+							Gives up after MAX_RETRIES and moves on to the next query.
+****************************************************************************/
+static void RetryQuery(void) {
+	RetryCount++;
+	if (RetryCount > MAX_RETRIES) {
+		// Leave CurrentQuery alone so GetNextQuery moves past it
+		if (DisplaySM_DRS) printf("DRS query %#02x abandoned\r\n", CurrentQuery);
+		RecordDRSAbandoned();
+		RetryCount = 0;
+		WaitInterval = COMMAND_INTERVAL;
+	} else {
+		// Reset current query to last successful query, so it is sent again
+		RecordDRSRetry();
+		CurrentQuery = LastQuery;
+		WaitInterval = COMMAND_INTERVAL << RetryCount;
+		if (WaitInterval > MAX_BACKOFF) WaitInterval = MAX_BACKOFF;
+	}
+}
+
+/****************************************************************************
+Function:			QuerySucceeded
+Parameters:		none
+Returns:			none
+Description:	Clears the retry backoff after a good frame
+****************************************************************************/
+static void QuerySucceeded(void) {
+	RetryCount = 0;
+	WaitInterval = COMMAND_INTERVAL;
+}
+
 /****************************************************************************
 Function:			DuringWaitingForQuery
 Parameters:		ES_Event Event
@@ -266,7 +313,7 @@ static ES_Event DuringWaitingForQuery(ES_Event Event) {
 	if (Event.EventType == ES_ENTRY) {
 		if (DisplayEntryStateTransitions && DisplaySM_DRS) printf("SM1_DRS: WAITING_FOR_QUERY\r\n");
 		// Start a timer to create a time interval between commands
-		ES_Timer_InitTimer(DRS_TIMER, COMMAND_INTERVAL);
+		ES_Timer_InitTimer(DRS_TIMER, WaitInterval);
 	} else if (Event.EventType == ES_EXIT) {
 		// On exit, create a E_NEW_DRS_QUERY event
 		ES_Event NewEvent = {E_NEW_DRS_QUERY, 0};
@@ -19,6 +19,7 @@ Author: Kyle Moy, 2/18/15
 #include "BallLauncher.h"
 #include "KartSwitchAndLED.h"
 #include "DriveMotorPID.h"
+#include "DRS.h"
 
 /*---------------------------- Module Functions ---------------------------*/
 static ES_Event DuringWaitingStart(ES_Event Event);
@@ -268,6 +269,8 @@ static ES_Event DuringWaitingFinish(ES_Event Event) {
 		if(DisplayEntryStateTransitions && DisplaySM_Master) printf("SM1_Master: WAITING_FINISHED\r\n");
 		StopMotors();
 		TurnOffShooter();
+		// Report how the DRS link held up over the race
+		PrintDRSLinkStats();
 	} else if (Event.EventType == ES_EXIT) {
 	} else {
 	}
@@ -4,7 +4,12 @@ Description:
 	A sub-level state machine for our robot that controls the point-destination
 	driving navigation system. Used in the RACING state machine to get from
 	corner to corner.
-	Contains eight states: ORIENTING, DRIVING
+	Contains three states: ORIENTING, DRIVING, WAITING
+	ORIENTING turns on the spot under the heading controller
+	(HeadingController.c), updated every HEADING_PERIOD on HEADING_TIMER.
+	SM_Racing's CORNER runs it to turn onto the next straight. When the
+	turn ends it stops in WAITING and hands E_HEADING_REACHED up to the
+	machine running it, with the HeadingResult_t as the parameter.
 	
 Author: Kyle Moy, 2/24/15
 ****************************************************************************/
@@ -23,11 +28,21 @@ Author: Kyle Moy, 2/24/15
 #include "DriveMotors.h"
 #include "DRS.h"
 #include "GamefieldPositions.h"
+#include "PoseEstimator.h"
+#include "HeadingController.h"
+#include "InputRecorder.h"
 
 
 /*----------------------------- Module Defines ----------------------------*/
 #define ENTRY_STATE DRIVING
 
+// The heading loop runs on HEADING_TIMER, in 10ms ES ticks
+#define HEADING_PERIOD					2
+#define MS_PER_TICK							10
+// Default tolerance on the heading, and the longest a turn may take
+#define DEFAULT_HEADING_TOLERANCE	5		// Degrees
+#define HEADING_TIME_LIMIT			2000	// ms
+
 /*---------------------------- Module Functions ---------------------------*/
 static ES_Event DuringOrienting(ES_Event Event);
 static ES_Event DuringDriving(ES_Event Event);
@@ -35,13 +50,16 @@ static ES_Event DuringWaiting(ES_Event Event);
 
 
 /*---------------------------- Module Variables ---------------------------*/
-static NavigationState_t CurrentState;
+static NavigationState_t CurrentState = WAITING;
 static uint8_t TargetX;
 static uint8_t TargetY;
 static uint16_t TargetTheta;
 static uint8_t Xold = 0;
 static uint8_t Yold = 0;
 static double CalculatedTheta;
+static HeadingController_t Heading;
+static uint8_t HeadingTolerance = DEFAULT_HEADING_TOLERANCE;
+static HeadingResult_t LastHeadingResult = HEADING_ARRIVED;
 
 
 /*------------------------------ Module Code ------------------------------*/
@@ -68,21 +86,39 @@ ES_Event RunNavigationSM(ES_Event CurrentEvent) {
 			// Process any events
 			if (CurrentEvent.EventType != ES_NO_EVENT) { // If an event is active
 				// Variables to store current values
-				int16_t CurrentTheta;
+				float CurrentTheta;
+				int16_t TurnRPM;
+				HeadingResult_t Result;
 				
 				switch (CurrentEvent.EventType) {
-					case E_DRS_UPDATED:
-						CurrentTheta = GetMyKart().KartTheta;
-						PrintMyKartStatus();
-					
-						if (abs(CurrentTheta - TargetTheta) < 15 || abs(CurrentTheta - TargetTheta - 360) < 15 || abs(CurrentTheta - TargetTheta + 360) < 15) {
-							printf("CurrentTheta = %d, Target Theta = %d has been reached, transition to driving\r\n", CurrentTheta, TargetTheta);
+					case ES_TIMEOUT:
+						if (CurrentEvent.EventParam != HEADING_TIMER) break;
+						// Use the latency compensated pose, the DRS pose is already stale
+						CurrentTheta = GetCurrentPose().Theta;
+						Result = UpdateHeadingController(&Heading, CurrentTheta, GetYawRate(), \
+							HEADING_PERIOD * MS_PER_TICK, &TurnRPM);
+						if (Result == HEADING_TURNING) {
+							RotateAtRPM(TurnRPM);
+							ES_Timer_InitTimer(HEADING_TIMER, HEADING_PERIOD);
+						} else {
+							printf("CurrentTheta = %.1f, Target Theta = %d %s, transition to waiting\r\n", CurrentTheta, \
+								TargetTheta, (Result == HEADING_ARRIVED) ? "has been reached" : "timed out");
 							StopMotors();
-							NextState = DRIVING;
+							// A turn that can't get there is how the Kart gets stuck,
+							// keep the input log of the lead up to it
+							if (Result == HEADING_TIMED_OUT) FreezeInputRecorder();
+							LastHeadingResult = Result;
+							NextState = WAITING;
 							MakeTransition = true;
-							ReturnEvent.EventType = ES_NO_EVENT;
+							// Let the machine running us know the turn is over
+							ReturnEvent.EventType = E_HEADING_REACHED;
+							ReturnEvent.EventParam = Result;
 						}
 						break;
+					
+					case E_DRS_UPDATED:
+						PrintMyKartStatus();
+						break;
 				}
 			}
 			break;
@@ -95,6 +131,7 @@ ES_Event RunNavigationSM(ES_Event CurrentEvent) {
 				// Variables to store current values
 				uint8_t CurrentX;
 				uint8_t CurrentY;
+				Pose_t Pose;
 				//int16_t DeltaY;
 				//int16_t DeltaRPM;
 				//uint16_t RPMR;
@@ -108,8 +145,10 @@ ES_Event RunNavigationSM(ES_Event CurrentEvent) {
 						break;
 					
 					case E_DRS_UPDATED:
-						CurrentX = GetMyKart().KartX;
-						CurrentY = GetMyKart().KartY;
+						// Use the latency compensated pose, the DRS pose is already stale
+						Pose = GetCurrentPose();
+						CurrentX = Pose.X + 0.5f;
+						CurrentY = Pose.Y + 0.5f;
 						//printf("CurrentX = %d and CurrentY = %d, TargetX = %d and TargetY = %d\r\n", CurrentX, CurrentY, TargetX, TargetY);
 						//DeltaY = CurrentY- TargetY;
 						//DeltaRPM = DeltaY * 1.5;
@@ -183,6 +222,17 @@ NavigationState_t QueryNavigationSM(void) {
 }
 
 	
+/****************************************************************************
+Function:			QueryHeadingResult
+Parameters:		None
+Returns:			HeadingResult_t, how the last ORIENTING turn ended
+Description:	HEADING_ARRIVED or HEADING_TIMED_OUT, once a turn has ended
+****************************************************************************/
+HeadingResult_t QueryHeadingResult(void) {
+	return(LastHeadingResult);
+}
+
+	
 /****************************************************************************
 Function:			SetTargetPosition
 Parameters:		uint8_t X, the target X coordinate
@@ -194,10 +244,37 @@ void SetTargetPosition(uint8_t X, uint8_t Y) {
 	TargetX = X;
 	TargetY = Y;
 }
+
+/****************************************************************************
+Function:			SetTargetTheta
+Parameters:		uint16_t Theta, the heading ORIENTING turns to, DRS degrees
+Returns:			void
+Description:	Takes effect from the next turn
+****************************************************************************/
 void SetTargetTheta(uint16_t Theta) {
 	TargetTheta = Theta;
 }
 
+/****************************************************************************
+Function:			GetTargetTheta
+Parameters:		void
+Returns:			uint16_t, the heading ORIENTING turns to, DRS degrees
+Description:	For checking where a turn ended up against where it was aimed
+****************************************************************************/
+uint16_t GetTargetTheta(void) {
+	return TargetTheta;
+}
+
+/****************************************************************************
+Function:			SetHeadingTolerance
+Parameters:		uint8_t Degrees, how close ORIENTING has to get to TargetTheta
+Returns:			void
+Description:	Takes effect from the next turn
+****************************************************************************/
+void SetHeadingTolerance(uint8_t Degrees) {
+	HeadingTolerance = Degrees;
+}
+
 /*------------------------- Private Function Code -------------------------*/
 
 static ES_Event DuringOrienting(ES_Event Event) {
@@ -216,8 +293,12 @@ static ES_Event DuringOrienting(ES_Event Event) {
 		}
 		Xold = GetMyKart().KartX;
 		Yold = GetMyKart().KartY;
-	} else if ( Event.EventType == ES_EXIT ) {
 		
+		// Turn under closed loop control, the first update starts the wheels
+		StartHeadingController(&Heading, TargetTheta, HeadingTolerance, HEADING_TIME_LIMIT);
+		ES_Timer_InitTimer(HEADING_TIMER, HEADING_PERIOD);
+	} else if ( Event.EventType == ES_EXIT ) {
+		ES_Timer_StopTimer(HEADING_TIMER);
 	} else {
 	}
 	return(ReturnEvent);
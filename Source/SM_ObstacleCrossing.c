@@ -19,6 +19,7 @@ Author: Kyle Moy, 2/25/15
 #include "GamefieldPositions.h"
 #include "SM_Master.h"
 #include "DriveMotorPID.h"
+#include "MotionSequencer.h"
 
 
 /*---------------------------- Module Functions ---------------------------*/
@@ -28,8 +29,23 @@ static ES_Event DuringObstacleExit(ES_Event Event);
 
 
 /*---------------------------- Module Variables ---------------------------*/
+// Come to a standstill, pivot to face the obstacle, then back up against
+// the wall to square up on it
+static const MotionStep_t EntryManeuver[] = {
+	{MOTION_STOP,         0,   0, 1000},
+	{MOTION_PIVOT_CCW,  150,   0,   18},
+	{MOTION_BACKWARD,   100, 100, 1500},
+	{MOTION_END}
+};
+
+// Back off the wall at the end of the obstacle and pivot onto the track
+static const MotionStep_t ExitManeuver[] = {
+	{MOTION_BACKWARD,   100, 100,  250},
+	{MOTION_PIVOT_CCW,  150,   0,   12},
+	{MOTION_END}
+};
+
 static ObstacleCrossingState_t CurrentState;
-static uint8_t MotorTimeoutCase = 0;
 
 
 /*------------------------------ Module Code ------------------------------*/
@@ -57,21 +73,10 @@ ES_Event RunObstacleCrossingSM(ES_Event CurrentEvent) {
 			if (CurrentEvent.EventType != ES_NO_EVENT) { // If an event is active
 				switch (CurrentEvent.EventType) {
 					
-					case E_MOTOR_TIMEOUT:
-						if (MotorTimeoutCase == 0) {
-							SetPIDgains(0.05, 0.02, 0);
-							MotorTimeoutCase = 1;
-							PivotCCWwithSetTicks(150, 18);
-						} else if (MotorTimeoutCase == 1) {
-							DriveBackwardsWithBias(100, 100, 150);
-							MotorTimeoutCase = 2;
-						} else {
-							StopMotors();
-							MotorTimeoutCase = 0;
-							NextState = CROSSING;
-							MakeTransition = true;
-							ReturnEvent.EventType = ES_NO_EVENT;
-						}
+					case E_MOTION_SEQUENCE_DONE:
+						NextState = CROSSING;
+						MakeTransition = true;
+						ReturnEvent.EventType = ES_NO_EVENT;
 						break;
 				}
 			}
@@ -100,17 +105,11 @@ ES_Event RunObstacleCrossingSM(ES_Event CurrentEvent) {
 			// Process any events
 			if (CurrentEvent.EventType != ES_NO_EVENT) { // If an event is active
 				switch (CurrentEvent.EventType) {
-					case E_MOTOR_TIMEOUT:
-						if (MotorTimeoutCase == 0) {
-							PivotCCWwithSetTicks(150, 12);
-							MotorTimeoutCase = 1;
-						} else {
-							StopMotors();
-							MotorTimeoutCase = 0;
-							ES_Event Event = {E_OBSTACLE_CROSSING_EXIT, 0};
-							PostMasterSM(Event);
-						}
+					case E_MOTION_SEQUENCE_DONE: {
+						ES_Event Event = {E_OBSTACLE_CROSSING_EXIT, 0};
+						PostMasterSM(Event);
 						break;
+					}
 				}
 			}
 			break;
@@ -163,9 +162,7 @@ static ES_Event DuringObstacleEntry(ES_Event Event) {
 	// Process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
 	if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY)) {
 		if(DisplayEntryStateTransitions && DisplaySM_Racing) printf("SM3_Obstacle_Crossing: OBSTACLE_ENTRY\r\n");StopMotors();
-		// A timer to allow bot to come to a standstill
-		ES_Timer_InitTimer(DRIVE_MOTOR_TIMER, 100);
-		MotorTimeoutCase = 0;
+		StartMotionSequence(EntryManeuver);
 	} else if ( Event.EventType == ES_EXIT ) {
 	} else {
 		
@@ -192,8 +189,7 @@ static ES_Event DuringObstacleExit(ES_Event Event) {
 	// Process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
 	if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY)) {
 		if(DisplayEntryStateTransitions && DisplaySM_Racing) printf("SM3_Obstacle_Crossing: OBSTACLE_EXIT\r\n");
-		// Drive backwards a little bit
-		DriveBackwardsWithBias(100, 100, 25);
+		StartMotionSequence(ExitManeuver);
 	} else if ( Event.EventType == ES_EXIT ) {
 	} else {
 	}
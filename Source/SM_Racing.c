@@ -20,23 +20,50 @@ Author: Kyle Moy, 2/19/15
 #include "SM_Master.h"
 #include "DRS.h"
 #include "DriveMotorPID.h"
+#include "CollisionPredictor.h"
+#include "MotionSequencer.h"
 
 
 /*----------------------------- Module Defines ----------------------------*/
 #define ENTRY_STATE STRAIGHT
 
+// Where CORNER is in turning the corner
+typedef enum {CORNER_BACKING_OFF, CORNER_TURNING, CORNER_SQUARING_UP} CornerPhase_t;
+
 /*---------------------------- Module Functions ---------------------------*/
 static ES_Event DuringStraight(ES_Event Event);
 static ES_Event DuringCorner(ES_Event Event);
+static GamefieldPosition_t NextStraight(GamefieldPosition_t Straight);
 
 
 
 /*---------------------------- Module Variables ---------------------------*/
+// After bumping the wall at the end of a straight: back off, turn onto
+// the next straight under the heading controller (SM_Navigation's
+// ORIENTING), then back up against the wall to square up on it. The
+// turn starts from rest, the encoders count by the way the wheels are
+// driven and would count a wheel still rolling back as turning
+static const MotionStep_t CornerBackOff[] = {
+	{MOTION_BACKWARD,   100, 100,  250},
+	{MOTION_STOP,         0,   0,  200},
+	{MOTION_END}
+};
+static const MotionStep_t CornerSquareUp[] = {
+	{MOTION_BACKWARD,   100, 100, 1500},
+	{MOTION_END}
+};
+
+// The DRS heading down each straight, Theta grows clockwise so each
+// corner's left turn takes it down a quarter turn
+static const uint16_t StraightTheta[] = {
+	[Straight1] = 180, [Straight2] = 90, [Straight3] = 0, [Straight4] = 270
+};
+
 static RacingState_t CurrentState;
 static bool WillCrossObstacle = true;
 static bool WillBallLaunch = true;
-static uint8_t MotorTimeoutCase = 0;
 static GamefieldPosition_t CurrentStraight;
+static CornerPhase_t CornerPhase;
 
 
 /*------------------------------ Module Code ------------------------------*/
@@ -83,10 +110,19 @@ ES_Event RunRacingSM(ES_Event CurrentEvent) {
 						// This is for the standard case where we timeout for a encoder movement 
 						// on any any straight, to slow down before a corner
 						} else {
-							SetPIDgains(0.05, 0.02, 0);
 							DriveForwardWithBias(105, 100, 0);
 						}
 						break;
+					
+					case E_COLLISION_WARNING:
+						// Slow down ahead of a predicted collision with another Kart,
+						// so we can let them pass rather than bump and recover
+						SetSpeedBias(GetCollisionSpeedBias());
+						break;
+					
+					case E_COLLISION_CLEARED:
+						SetSpeedBias(100);
+						break;
 						
 					case E_BUMP_DETECTED:
 						printf("Bump is detected\r\n");
@@ -128,29 +164,27 @@ ES_Event RunRacingSM(ES_Event CurrentEvent) {
 			if (CurrentEvent.EventType != ES_NO_EVENT) { // If an event is active
 				switch (CurrentEvent.EventType) {
 					
-					case E_MOTOR_TIMEOUT:
-						if (MotorTimeoutCase == 0) {
-							PivotCCWwithSetTicks(150, 18);
-							MotorTimeoutCase = 1;
-						} else if (MotorTimeoutCase == 1) {
-							DriveBackwardsWithBias(100, 100, 150);
-							ClearSumError();
-							MotorTimeoutCase = 2;
-						} else {
-							StopMotors();
-							MotorTimeoutCase = 0;
-							// Update to the next straight
-							switch (CurrentStraight) {
-								case Straight1: CurrentStraight = Straight2; break;
-								case Straight2: CurrentStraight = Straight3; break;
-								case Straight3: CurrentStraight = Straight4; break;
-								case Straight4: CurrentStraight = Straight1; break;
-							}
-							NextState = STRAIGHT;
-							MakeTransition = true;
-							ReturnEvent.EventType = ES_NO_EVENT;
-							
+					case E_MOTION_SEQUENCE_DONE:
+						// Backed off the wall, turn to face down the next straight
+						if (CornerPhase == CORNER_BACKING_OFF) {
+							CornerPhase = CORNER_TURNING;
+							SetTargetTheta(StraightTheta[NextStraight(CurrentStraight)]);
+							StartNavigationSM(EntryEventKind);
+							break;
 						}
+						if (CornerPhase != CORNER_SQUARING_UP) break;
+						// Squared up, update to the next straight
+						CurrentStraight = NextStraight(CurrentStraight);
+						NextState = STRAIGHT;
+						MakeTransition = true;
+						ReturnEvent.EventType = ES_NO_EVENT;
+						break;
+					
+					case E_HEADING_REACHED:
+						// Square up whether the turn got there or timed out, backing
+						// into the wall takes out what's left
+						CornerPhase = CORNER_SQUARING_UP;
+						StartMotionSequence(CornerSquareUp);
 						break;
 				}
 			}
@@ -228,28 +262,29 @@ static ES_Event DuringStraight(ES_Event Event) {
 		// then let's not trip the ball launch again
 		if (WillBallLaunch && Event.EventType == ES_ENTRY_HISTORY && CurrentStraight == Straight2) {
 			WillBallLaunch = false;
-			//SetPIDgains(0.1, 0.5, 0);
 			//DriveForwardWithSetDistance(500, 400);
 			
-			SetPIDgains(0.05, 0.02, 0);
 			DriveForwardWithBias(105, 100, 0);
 			
 		// If we are triggering a encoder movement to ball launch
 		} else if (CurrentStraight == Straight2 && WillBallLaunch) {
-			SetPIDgains(0.05, 0.02, 0);
 			DriveForwardWithSetDistance(200, 1000);
 			
 		// If we are triggering a encoder movement towards the obstacle
 		} else if (CurrentStraight == Straight3 && WillCrossObstacle) {
-			SetPIDgains(0.05, 0.02, 0);
 			DriveForwardWithSetDistance(200, 1250);
 			
 		// Standard encoder movement for any other lap leg
 		} else {
-			SetPIDgains(0.1, 0.5, 0);
 			DriveForwardWithSetDistance(500, 1000);
 		}
+		
+		// The bias was taken off for the corner, a warning still standing
+		// isn't posted again, so pick it back up here
+		SetSpeedBias(GetCollisionSpeedBias());
 	} else if ( Event.EventType == ES_EXIT ) {
+		// Don't carry a collision slow down into the corner maneuvers
+		SetSpeedBias(100);
 	} else {
 	}
 	return(ReturnEvent);
@@ -260,11 +295,31 @@ static ES_Event DuringCorner(ES_Event Event) {
 	// Process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
 	if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY)) {
 		if(DisplayEntryStateTransitions && DisplaySM_Racing) printf("SM3_Racing: CORNER (%s)\r\n", GamefieldPositionString(CurrentStraight));
-		// Drive backwards a little bit
-		DriveBackwardsWithBias(100, 100, 25);
-		MotorTimeoutCase = 0;
+		// Back off the wall, turn the corner and square up on the next wall
+		CornerPhase = CORNER_BACKING_OFF;
+		StartMotionSequence(CornerBackOff);
 	} else if ( Event.EventType == ES_EXIT ) {
+		// Stop a turn we leave part way through
+		if (CornerPhase == CORNER_TURNING) RunNavigationSM(Event);
 	} else {
+		// The navigation machine runs the turn, it hands E_HEADING_REACHED
+		// back when it's done
+		if (CornerPhase == CORNER_TURNING) ReturnEvent = RunNavigationSM(Event);
 	}
 	return(ReturnEvent);
 }
+
+/****************************************************************************
+Function:			NextStraight
+Parameters:		GamefieldPosition_t Straight, one of Straight1-4
+Returns:			GamefieldPosition_t, the straight after it round the track
+Description:	Straight4 comes round to Straight1
+****************************************************************************/
+static GamefieldPosition_t NextStraight(GamefieldPosition_t Straight) {
+	switch (Straight) {
+		case Straight1: return Straight2;
+		case Straight2: return Straight3;
+		case Straight3: return Straight4;
+		case Straight4: default: return Straight1;
+	}
+}